@@ -5,15 +5,31 @@
     
     - CAN BE NUMA AWARE IF SPEFICIED
 
+    - BY DEFAULT CACHES ARE MAPPED WITH MAP_POPULATE. IN COMMIT ON DEMAND MODE , CACHES ARE ONLY RESERVED AND THEY ARE COMMITTED IN CHUNKS AS THEY ARE HANDED OUT.
+      COMMITTED CHUNKS CAN OPTIONALLY BE PREFAULTED FOR LATENCY CRITICAL USES. HUGE PAGE AND NUMA ARENAS ALWAYS USE THE DEFAULT MODE
+
+    - WHEN THE CACHE CAN'T SERVE A REQUEST , A NEW CHUNK IS ADDED. GROWTH CHUNKS START FROM 2MB AND DOUBLE UP TO THE INITIAL CACHE CAPACITY.
+      Tails of older chunks stay usable for smaller requests. A chunk's unused tail is released with a single call when it is evicted
+
+    - ALIGNED ALLOCATIONS ALIGN THE BUMP POINTER OF A CHUNK. THE SKIPPED PAGES ARE KEPT IN AN ADDRESS ORDERED GAP LIST AND SERVED TO LATER REQUESTS
+
+    - BY DEFAULT RELEASED PAGES ARE UNMAPPED. WITH ADVISE_DONTNEED AND ADVISE_FREE RELEASE POLICIES , THEIR PHYSICAL PAGES ARE RETURNED WITH MADVISE AND THE RANGES ARE KEPT AS GAPS.
+      Later segment grows reuse them without new mappings , which avoids VMA churn and mmap_lock contention. ADVISE_FREE pages may keep their old contents
+
+    - trim RETURNS PHYSICAL PAGES OF UNUSED CHUNK TAILS AND GAPS TO THE OS. Where discarded pages read back as zeroes they are discarded and kept for later requests ,
+      otherwise they are unmapped
+
     - LINUX ALLOCATION GRANULARITY IS 4KB (4096) , OTH IT IS 64KB ( 16 * 4096 ) ON WINDOWS .
       REGARDING WINDOWS PAGE ALLOCATION GRANULARITY : https://devblogs.microsoft.com/oldnewthing/20031008-00/?p=42223
 */
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 
 #include "compiler/unused.h"
+#include "compiler/hints_branch_predictor.h"
 
 #include "os/assert_msg.h"
 #include "os/virtual_memory.h"
@@ -29,12 +45,23 @@
 #include <cstdio>
 #endif // VOLTRON_EXCLUDE
 
+enum class PageReleasePolicy : uint8_t
+{
+    UNMAP,              // munmap / VirtualFree
+    ADVISE_DONTNEED,    // MADV_DONTNEED , the range stays in the arena
+    ADVISE_FREE         // MADV_FREE , the range stays in the arena and the OS reclaims its pages only under memory pressure
+};
+
 struct ArenaOptions
 {
     std::size_t cache_capacity = 1024*1024*1024;
     std::size_t page_alignment = 65536;
     bool use_huge_pages = false;
     int numa_node = -1; // -1 means no NUMA
+    bool commit_on_demand = false;          // Reserves the cache and commits it in chunks instead of populating all of it at once
+    std::size_t commit_chunk_size = 2097152;
+    bool prefault_commits = true;           // Applies to commit on demand mode
+    PageReleasePolicy page_release_policy = PageReleasePolicy::UNMAP;
 };
 
 class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED CACHE THEREFORE WE NEED LOCKING
@@ -67,10 +94,16 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             m_page_alignment = arena_options.page_alignment;
             m_use_huge_pages = arena_options.use_huge_pages;
             m_numa_node = arena_options.numa_node;
+            m_commit_on_demand = arena_options.commit_on_demand && arena_options.use_huge_pages == false && arena_options.numa_node < 0;
+            m_commit_chunk_size = AlignmentAndSizeUtils::get_next_pow2_multiple_of(arena_options.commit_chunk_size > 0 ? arena_options.commit_chunk_size : 1, m_vm_page_size);
+            m_prefault_commits = arena_options.prefault_commits;
+            m_page_release_policy = arena_options.page_release_policy;
+            m_max_growth_chunk_size = round_up_to_page_alignment(arena_options.cache_capacity > MIN_GROWTH_CHUNK_SIZE ? arena_options.cache_capacity : MIN_GROWTH_CHUNK_SIZE);
+            m_next_growth_chunk_size = round_up_to_page_alignment(MIN_GROWTH_CHUNK_SIZE);
 
             this->enter_concurrent_context();
             //////////////////////////////////////////////////
-            auto ret =  build_cache(arena_options.cache_capacity);
+            auto ret =  build_chunk(round_up_to_page_alignment(arena_options.cache_capacity)) != nullptr;
             //////////////////////////////////////////////////
             this->leave_concurrent_context();
 
@@ -79,65 +112,116 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
 
         [[nodiscard]] char* allocate(std::size_t size)
         {
-            this->enter_concurrent_context();
-            //////////////////////////////////////////////////
-            if (size + m_page_alignment > (m_cache_size - m_cache_used_size))
-            {
-                destroy();
-
-                if (!build_cache(size))
-                {
-                    this->leave_concurrent_context();
-                    return nullptr;
-                }
-            }
-
-            auto ret = m_cache_buffer + m_cache_used_size;
-            m_cache_used_size += size;
-            //////////////////////////////////////////////////
-            this->leave_concurrent_context();
+            auto ret = allocate_with_alignment(size, m_page_alignment);
 
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, m_page_alignment), "Arena should not return an address which is not aligned to its page alignment setting.");
+            llmalloc_assert_msg(ret == nullptr || AlignmentAndSizeUtils::is_address_aligned(ret, m_page_alignment), "Arena should not return an address which is not aligned to its page alignment setting.");
 
             return ret;
         }
 
+        // Pages skipped to reach the alignment are kept as gaps and served to later requests
         [[nodiscard]] char* allocate_aligned(std::size_t size, std::size_t alignment)
         {
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(alignment), "Special alignment value requested from Arena should be a multiple of OS page allocation granularity.");
 
-            if(alignment == m_page_alignment)
+            if(m_page_alignment % alignment == 0)
             {
                 return allocate(size);
             }
             else
             {
-                llmalloc_assert_msg(AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(m_page_alignment), "Special alignment value requested from Arena should be a multiple of Arena's page alignment value.");
+                llmalloc_assert_msg(alignment % m_page_alignment == 0, "Special alignment value requested from Arena should be a multiple of Arena's page alignment value.");
 
-                auto ptr = reinterpret_cast<uint64_t>(allocate(size + alignment));
+                auto ret = allocate_with_alignment(size, alignment);
 
-                if(ptr == 0)
-                {
-                    return nullptr;
-                }
+                llmalloc_assert_msg(ret == nullptr || AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Arena failed to meet the requested alignment.");
 
-                std::size_t remainder = ptr - ((ptr / alignment) * alignment);
-                std::size_t offset = alignment - remainder;
-                return reinterpret_cast<char*>(ptr + offset);
+                return ret;
             }
         }
 
         std::size_t page_size()const { return m_vm_page_size; }
         std::size_t page_alignment() const { return m_page_alignment; }
 
+        // Can be called from any thread. Depending on the release policy , the range is either unmapped or kept as a gap after its physical pages are discarded
         void release_to_system(void* address, std::size_t size)
         {
-            #ifdef NDEBUG
-            VirtualMemory::deallocate(address, size);
-            #else
-            auto release_success = VirtualMemory::deallocate(address, size);
-            llmalloc_assert_msg(release_success, "Failure to release pages can lead to system wide issues\n");
-            #endif
+            m_allocated_size.fetch_sub(size, std::memory_order_relaxed);
+
+            if (m_page_release_policy != PageReleasePolicy::UNMAP && VirtualMemory::discard(address, size, m_page_release_policy == PageReleasePolicy::ADVISE_FREE))
+            {
+                this->enter_concurrent_context();
+                //////////////////////////////////////////////////
+                add_gap(static_cast<char*>(address), size);
+                //////////////////////////////////////////////////
+                this->leave_concurrent_context();
+                return;
+            }
+
+            // Discards can fail , ex: for huge pages
+            unmap(address, size);
+        }
+
+        // Returns released bytes. Chunk tails and gaps stay in the arena if discarding them keeps never used pages zeroed , otherwise they are unmapped
+        std::size_t trim()
+        {
+            std::size_t released_size{ 0 };
+            bool can_discard = VirtualMemory::are_discarded_pages_zeroed(false);
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            for (std::size_t i = 0; i < m_chunk_count; i++)
+            {
+                // Only committed parts can have physical pages
+                std::size_t tail_size = m_chunks[i].m_committed_size > m_chunks[i].m_used_size ? m_chunks[i].m_committed_size - m_chunks[i].m_used_size : 0;
+
+                if (can_discard)
+                {
+                    released_size += tail_size > 0 && VirtualMemory::discard(m_chunks[i].m_buffer + m_chunks[i].m_used_size, tail_size, false) ? tail_size : 0;
+                }
+                else
+                {
+                    released_size += m_chunks[i].m_size - m_chunks[i].m_used_size;
+                    release_unused_tail(&m_chunks[i]);
+                }
+            }
+
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                if (can_discard)
+                {
+                    released_size += VirtualMemory::discard(m_gaps[i].m_address, m_gaps[i].m_size, false) ? m_gaps[i].m_size : 0;
+                }
+                else
+                {
+                    released_size += m_gaps[i].m_size;
+                    unmap(m_gaps[i].m_address, m_gaps[i].m_size);
+                }
+            }
+
+            if (can_discard == false)
+            {
+                m_chunk_count = 0;
+                m_gap_count = 0;
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return released_size;
+        }
+
+        // Bytes handed out and not released yet
+        std::size_t get_allocated_size() const { return m_allocated_size.load(std::memory_order_relaxed); }
+
+        #ifdef ENABLE_STATS
+        // Chunks built to grow the arena after its initial one
+        std::size_t get_built_chunk_count() const { return m_built_chunk_count.load(std::memory_order_relaxed); }
+        #endif
+
+        // Never used pages are zeroed , released ones may not be depending on the release policy
+        bool are_reused_pages_zeroed() const
+        {
+            return m_page_release_policy == PageReleasePolicy::UNMAP || VirtualMemory::are_discarded_pages_zeroed(m_page_release_policy == PageReleasePolicy::ADVISE_FREE);
         }
 
         class MetadataAllocator
@@ -155,20 +239,59 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
                 }
         };
 
+        #ifdef UNIT_TEST
+        std::size_t get_chunk_count() const { return m_chunk_count; }
+        std::size_t get_gap_count() const { return m_gap_count; }
+        #endif
+
     private:
+
+        struct ArenaChunk
+        {
+            char* m_buffer = nullptr;
+            std::size_t m_size = 0;
+            std::size_t m_used_size = 0;
+            std::size_t m_committed_size = 0;
+        };
+
+        struct ArenaGap
+        {
+            char* m_address = nullptr;
+            std::size_t m_size = 0;
+        };
+
+        static constexpr std::size_t MAX_CHUNK_COUNT = 8;
+        static constexpr std::size_t MAX_GAP_COUNT = 64;
+        static constexpr std::size_t MIN_GROWTH_CHUNK_SIZE = 2097152; // 2MB
+
         std::size_t m_vm_page_size = 0;
         std::size_t m_page_alignment = 0;
-        char* m_cache_buffer = nullptr;
-        std::size_t m_cache_size = 0;
-        std::size_t m_cache_used_size = 0;
+        ArenaChunk m_chunks[MAX_CHUNK_COUNT]; // Only chunks with unused space , the most recent one is the last
+        std::size_t m_chunk_count = 0;
+        ArenaGap m_gaps[MAX_GAP_COUNT]; // Address ordered , pages skipped by aligned allocations and pages released with madvise
+        std::size_t m_gap_count = 0;
+        std::size_t m_next_growth_chunk_size = 0;
+        std::size_t m_max_growth_chunk_size = 0;
         bool m_use_huge_pages = false;
         int m_numa_node = -1;
+        bool m_commit_on_demand = false;
+        std::size_t m_commit_chunk_size = 0;
+        bool m_prefault_commits = true;
+        PageReleasePolicy m_page_release_policy = PageReleasePolicy::UNMAP;
+        std::atomic<std::size_t> m_allocated_size = 0;
+        #ifdef ENABLE_STATS
+        std::atomic<std::size_t> m_built_chunk_count = 0; // Written under the lock
+        #endif
 
         void* allocate_from_system(std::size_t size)
         {
             void* ret = nullptr;
             
-            if(m_use_huge_pages)
+            if(m_commit_on_demand)
+            {
+                ret = VirtualMemory::reserve(size);
+            }
+            else if(m_use_huge_pages)
             {
                 ret = static_cast<char*>(VirtualMemory::allocate(size, true, m_numa_node, nullptr));
 
@@ -186,13 +309,207 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             return ret;
         }
 
-        [[nodiscard]] bool build_cache(std::size_t size)
+        std::size_t round_up_to_page_alignment(std::size_t size) const
+        {
+            return ((size + m_page_alignment - 1) / m_page_alignment) * m_page_alignment;
+        }
+
+        static char* align_up(char* address, std::size_t alignment)
+        {
+            return reinterpret_cast<char*>(((reinterpret_cast<std::size_t>(address) + alignment - 1) / alignment) * alignment);
+        }
+
+        [[nodiscard]] char* allocate_with_alignment(std::size_t size, std::size_t alignment)
+        {
+            // Keeping all chunk offsets aligned
+            size = round_up_to_page_alignment(size);
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            char* ret = allocate_from_gaps(size, alignment);
+
+            if (ret == nullptr)
+            {
+                ArenaChunk* chunk = find_chunk(size, alignment);
+
+                if (llmalloc_unlikely(chunk == nullptr))
+                {
+                    // New chunks are only page aligned
+                    chunk = build_chunk(get_next_growth_chunk_size(size + alignment - m_page_alignment));
+
+                    #ifdef ENABLE_STATS
+                    m_built_chunk_count.store(m_built_chunk_count.load(std::memory_order_relaxed) + (chunk != nullptr ? 1 : 0), std::memory_order_relaxed);
+                    #endif
+                }
+
+                if (chunk != nullptr)
+                {
+                    ret = allocate_from_chunk(chunk, size, alignment);
+                }
+            }
+
+            if (ret != nullptr)
+            {
+                m_allocated_size.fetch_add(size, std::memory_order_relaxed);
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return ret;
+        }
+
+        // First fit , older chunks are tried first so that their tails get used up
+        ArenaChunk* find_chunk(std::size_t size, std::size_t alignment)
+        {
+            for (std::size_t i = 0; i < m_chunk_count; i++)
+            {
+                char* aligned_start = align_up(m_chunks[i].m_buffer + m_chunks[i].m_used_size, alignment);
+                char* end = m_chunks[i].m_buffer + m_chunks[i].m_size;
+
+                if (aligned_start <= end && static_cast<std::size_t>(end - aligned_start) >= size)
+                {
+                    return &m_chunks[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        char* allocate_from_chunk(ArenaChunk* chunk, std::size_t size, std::size_t alignment)
+        {
+            char* start = chunk->m_buffer + chunk->m_used_size;
+            char* ret = align_up(start, alignment);
+            std::size_t new_used_size = static_cast<std::size_t>(ret - chunk->m_buffer) + size;
+
+            // Gaps are committed as well as they will be handed out later
+            if (new_used_size > chunk->m_committed_size && commit_chunk(chunk, new_used_size) == false)
+            {
+                return nullptr;
+            }
+
+            chunk->m_used_size = new_used_size;
+
+            if (chunk->m_used_size == chunk->m_size)
+            {
+                remove_chunk(chunk);
+            }
+
+            add_gap(start, static_cast<std::size_t>(ret - start));
+
+            return ret;
+        }
+
+        char* allocate_from_gaps(std::size_t size, std::size_t alignment)
+        {
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                char* gap_end = m_gaps[i].m_address + m_gaps[i].m_size;
+                char* ret = align_up(m_gaps[i].m_address, alignment);
+
+                if (ret < gap_end && static_cast<std::size_t>(gap_end - ret) >= size)
+                {
+                    if (ret == m_gaps[i].m_address)
+                    {
+                        m_gaps[i].m_address += size;
+                        m_gaps[i].m_size -= size;
+
+                        if (m_gaps[i].m_size == 0)
+                        {
+                            remove_gap(i);
+                        }
+                    }
+                    else
+                    {
+                        // Splitting the gap , the leading part stays in place
+                        m_gaps[i].m_size = static_cast<std::size_t>(ret - m_gaps[i].m_address);
+                        add_gap(ret + size, static_cast<std::size_t>(gap_end - ret - size));
+                    }
+
+                    return ret;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Keeps the gap list address ordered and merges adjacent gaps. If the list is full , the gap is released to the system
+        void add_gap(char* address, std::size_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+
+            std::size_t index = 0;
+
+            while (index < m_gap_count && m_gaps[index].m_address < address)
+            {
+                index++;
+            }
+
+            bool merges_with_previous = index > 0 && m_gaps[index - 1].m_address + m_gaps[index - 1].m_size == address;
+            bool merges_with_next = index < m_gap_count && address + size == m_gaps[index].m_address;
+
+            if (merges_with_previous && merges_with_next)
+            {
+                m_gaps[index - 1].m_size += size + m_gaps[index].m_size;
+                remove_gap(index);
+            }
+            else if (merges_with_previous)
+            {
+                m_gaps[index - 1].m_size += size;
+            }
+            else if (merges_with_next)
+            {
+                m_gaps[index].m_address = address;
+                m_gaps[index].m_size += size;
+            }
+            else if (m_gap_count == MAX_GAP_COUNT)
+            {
+                unmap(address, size);
+            }
+            else
+            {
+                for (std::size_t i = m_gap_count; i > index; i--)
+                {
+                    m_gaps[i] = m_gaps[i - 1];
+                }
+
+                m_gaps[index].m_address = address;
+                m_gaps[index].m_size = size;
+                m_gap_count++;
+            }
+        }
+
+        void remove_gap(std::size_t index)
+        {
+            for (std::size_t i = index + 1; i < m_gap_count; i++)
+            {
+                m_gaps[i - 1] = m_gaps[i];
+            }
+
+            m_gap_count--;
+        }
+
+        std::size_t get_next_growth_chunk_size(std::size_t size)
+        {
+            std::size_t chunk_size = m_next_growth_chunk_size;
+
+            if (m_next_growth_chunk_size < m_max_growth_chunk_size)
+            {
+                m_next_growth_chunk_size = m_next_growth_chunk_size * 2 < m_max_growth_chunk_size ? m_next_growth_chunk_size * 2 : m_max_growth_chunk_size;
+            }
+
+            return chunk_size > size ? chunk_size : size;
+        }
+
+        [[nodiscard]] ArenaChunk* build_chunk(std::size_t size)
         {
             char* buffer = allocate_aligned_from_system(size, m_page_alignment);
 
             if (buffer == nullptr)
             {
-                return false;
+                return nullptr;
             }
 
             #ifdef ENABLE_PERF_TRACES
@@ -204,13 +521,74 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             arena_initialised = true;
             #endif
 
-            m_cache_buffer = buffer;
-            m_cache_used_size = 0;
-            m_cache_size = size;
+            if (m_chunk_count == MAX_CHUNK_COUNT)
+            {
+                evict_chunk();
+            }
+
+            ArenaChunk* chunk = &m_chunks[m_chunk_count++];
+            chunk->m_buffer = buffer;
+            chunk->m_used_size = 0;
+            chunk->m_size = size;
+            chunk->m_committed_size = m_commit_on_demand ? 0 : size;
+
+            return chunk;
+        }
+
+        // Commits commit chunks up to the required size , the last commit chunk can be partial
+        [[nodiscard]] bool commit_chunk(ArenaChunk* chunk, std::size_t required_size)
+        {
+            std::size_t target_size = ((required_size + m_commit_chunk_size - 1) / m_commit_chunk_size) * m_commit_chunk_size;
+            target_size = target_size > chunk->m_size ? chunk->m_size : target_size;
 
+            if (VirtualMemory::commit(chunk->m_buffer + chunk->m_committed_size, target_size - chunk->m_committed_size, m_prefault_commits) == false)
+            {
+                return false;
+            }
+
+            chunk->m_committed_size = target_size;
             return true;
         }
 
+        void remove_chunk(ArenaChunk* chunk)
+        {
+            std::size_t index = static_cast<std::size_t>(chunk - m_chunks);
+
+            for (std::size_t i = index + 1; i < m_chunk_count; i++)
+            {
+                m_chunks[i - 1] = m_chunks[i];
+            }
+
+            m_chunk_count--;
+        }
+
+        // Slow path removal function
+        void evict_chunk()
+        {
+            // Evicting the chunk with the least unused space
+            std::size_t eviction_index = 0;
+
+            for (std::size_t i = 1; i < m_chunk_count; i++)
+            {
+                if (m_chunks[i].m_size - m_chunks[i].m_used_size < m_chunks[eviction_index].m_size - m_chunks[eviction_index].m_used_size)
+                {
+                    eviction_index = i;
+                }
+            }
+
+            release_unused_tail(&m_chunks[eviction_index]);
+            remove_chunk(&m_chunks[eviction_index]);
+        }
+
+        // ARENA IS RESPONSIBLE OF CLEARING ONLY NEVER-REQUESTED PAGES.
+        void release_unused_tail(ArenaChunk* chunk)
+        {
+            if (chunk->m_size > chunk->m_used_size)
+            {
+                unmap(chunk->m_buffer + chunk->m_used_size, chunk->m_size - chunk->m_used_size);
+            }
+        }
+
         char* allocate_aligned_from_system(std::size_t size, std::size_t alignment)
         {
             std::size_t actual_size = size + alignment;
@@ -230,13 +608,14 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             {
                 // WE NEED PADDING FOR SPECIFIED PAGE ALIGNMENT
                 delta = alignment - remainder;
-                // RELEASING PADDING PAGE
-                release_to_system(buffer, delta);
+                // RELEASING PADDING PAGES BEFORE AND AFTER THE ALIGNED RANGE
+                unmap(buffer, delta);
+                unmap(buffer + delta + size, alignment - delta);
             }
             else
             {
                 // PADDING IS NOT NEEDED, HENCE THE EXTRA ALLOCATED PAGE IS EXCESS
-                release_to_system(buffer + actual_size - alignment, alignment);
+                unmap(buffer + actual_size - alignment, alignment);
             }
             auto ret = buffer + delta;
 
@@ -245,22 +624,29 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             return ret;
         }
         
+        void unmap(void* address, std::size_t size)
+        {
+            #ifdef NDEBUG
+            VirtualMemory::deallocate(address, size);
+            #else
+            auto release_success = VirtualMemory::deallocate(address, size);
+            llmalloc_assert_msg(release_success, "Failure to release pages can lead to system wide issues\n");
+            #endif
+        }
+
         void destroy()
         {
-            if (m_cache_size > m_cache_used_size)
+            for (std::size_t i = 0; i < m_chunk_count; i++)
             {
-                // ARENA IS RESPONSIBLE OF CLEARING ONLY NEVER-REQUESTED PAGES.
-                std::size_t release_start_address = reinterpret_cast<std::size_t>(m_cache_buffer + m_cache_used_size);
-                std::size_t release_end_address = reinterpret_cast<std::size_t>(m_cache_buffer + m_cache_size);
-
-                for (; release_start_address < release_end_address; release_start_address += m_vm_page_size)
-                {
-                    release_to_system(reinterpret_cast<void *>(release_start_address), m_vm_page_size);
-                }
+                release_unused_tail(&m_chunks[i]);
+            }
 
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                unmap(m_gaps[i].m_address, m_gaps[i].m_size);
             }
-            m_cache_size = 0;
-            m_cache_used_size = 0;
-            m_cache_buffer = nullptr;
+
+            m_chunk_count = 0;
+            m_gap_count = 0;
         }
 };
\ No newline at end of file
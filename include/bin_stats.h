@@ -0,0 +1,22 @@
+/*
+    PER SIZE CLASS STATISTICS OF HEAPS
+
+    - COUNTERS ARE KEPT ONLY WITH ENABLE_STATS. Heaps increment them without atomic read-modify-writes where they are the only writers
+
+    - PAGE SIZES ARE ALWAYS MEASURED , BY THE OWNERS OF THREAD LOCAL HEAPS. See HeapPow2::add_bin_stats
+*/
+#pragma once
+
+#include <cstddef>
+
+struct BinStats
+{
+    std::size_t allocation_count = 0;
+    std::size_t deallocation_count = 0;                 // Frees of chunks of the heap's own logical pages
+    std::size_t cross_thread_deallocation_count = 0;    // Frees of chunks of other heaps' logical pages
+    std::size_t queue_overflow_count = 0;               // Frees rejected by full deallocation queues , callers pass them to the central heap
+    std::size_t segment_grow_count = 0;
+    std::size_t recycled_logical_page_count = 0;
+    std::size_t resident_size = 0;                      // Logical page headers and chunks carved at least once
+    std::size_t virtual_size = 0;                       // All logical pages
+};
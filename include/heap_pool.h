@@ -12,6 +12,7 @@
 
 #include "utilities/bounded_queue.h"
 #include "utilities/lockable.h"
+#include "utilities/queue_utilities.h"
 #include "utilities/alignment_and_size_utils.h"
 
 #include "arena.h"
@@ -91,6 +92,7 @@ class HeapPool
             }
             
             m_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            m_logical_page_size = params.logical_page_size;
 
             return true;
         }
@@ -165,6 +167,74 @@ class HeapPool
             }
         }
 
+        // Returns the number of allocated objects , can be less than count only if the pool is exhausted
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
+        {
+            std::size_t allocated{ 0 };
+
+            m_potential_pending_max_deallocation_count += count;
+
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count.load() >= m_deallocation_queue_processing_threshold))
+            {
+                void* ptr = allocate_by_processing_deallocation_queue(size);
+
+                if (ptr == nullptr)
+                {
+                    return 0;
+                }
+
+                out[allocated++] = ptr;
+            }
+
+            allocated += QueueUtilities::pop_batch(m_non_recyclable_deallocation_queue, count - allocated, out + allocated);
+            allocated += QueueUtilities::pop_batch(m_recyclable_deallocation_queue, count - allocated, out + allocated);
+
+            if (allocated < count)
+            {
+                allocated += m_segment.allocate_batch(size, count - allocated, out + allocated);
+            }
+
+            return allocated;
+        }
+
+        // Consecutive pointers of the same logical page are classified after a single page header access
+        // Returns the number of leading pointers this pool accepted , the caller should pass the first rejected one elsewhere
+        std::size_t deallocate_batch(void** ptrs, std::size_t count, bool is_small_object = false)
+        {
+            LLMALLOC_UNUSED(is_small_object);
+
+            LogicalPage* current_logical_page = nullptr;
+            bool is_owned = false;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto target_logical_page = SegmentType::get_logical_page_from_address(ptrs[i], m_logical_page_size);
+
+                if (target_logical_page != current_logical_page)
+                {
+                    current_logical_page = target_logical_page;
+                    is_owned = target_logical_page->get_segment_id() == m_segment.get_id();
+                }
+
+                auto& target_queue = is_owned ? m_recyclable_deallocation_queue : m_non_recyclable_deallocation_queue;
+
+                if (llmalloc_unlikely(target_queue.try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                {
+                    return i;
+                }
+            }
+
+            return count;
+        }
+
+        // ScalableAllocator encloses owner calls with these , pools are never accessed by other threads so they are no-ops
+        LLMALLOC_FORCE_INLINE void enter_owner_call() {}
+        LLMALLOC_FORCE_INLINE void leave_owner_call() {}
+
+        // Pools don't keep statistics
+        void count_central_heap_fallbacks(std::size_t count) { LLMALLOC_UNUSED(count); }
+        std::size_t get_central_heap_fallback_count() const { return 0; }
+
         static std::size_t get_segment_count()
         {
             return 1;
@@ -181,10 +251,12 @@ class HeapPool
         #endif
 
     private:
+
         SegmentType m_segment;
         ArenaType* m_arena = nullptr;
         std::atomic<std::size_t> m_potential_pending_max_deallocation_count = 0;
         std::size_t m_deallocation_queue_processing_threshold = 65536;
+        std::size_t m_logical_page_size = 0;
         DeallocationQueueType m_recyclable_deallocation_queue;
         DeallocationQueueType m_non_recyclable_deallocation_queue;
 
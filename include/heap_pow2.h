@@ -1,43 +1,33 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 
 #include "compiler/hints_hot_code.h"
 #include "compiler/builtin_functions.h"
+#include "compiler/unused.h"
 
 #include "cpu/alignment_constants.h"
 #include "os/assert_msg.h"
+#include "os/thread_utilities.h"
 
 #include "utilities/bounded_queue.h"
 #include "utilities/lockable.h"
+#include "utilities/queue_utilities.h"
 #include "utilities/alignment_and_size_utils.h"
 
 #include "arena.h"
+#include "bin_stats.h"
 #include "segment.h"
-
-class CompileTimePow2Utils
-{
-    public :
-
-        template <std::size_t N>
-        static constexpr std::size_t compile_time_pow2()
-        {
-            static_assert(N>=0); // To ensure that it is called in compile time only
-            return 1 << N;
-        }
-
-        template<unsigned int n>
-        static constexpr unsigned int compile_time_log2()
-        {
-            return (n <= 1) ? 0 : 1 + compile_time_log2<n / 2>();
-        }
-};
+#include "logical_page_pool.h"
+#include "size_classes.h"
 
 // Template defaults are for thread local or single threaded cases
-template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK> 
+// Size classes are pow2 by default , see size_classes.h and HeapQuarterPow2 below for finer grained size classes
+template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK, typename SizeClasses = Pow2SizeClasses> 
 class HeapPow2
 {
     public:
@@ -49,14 +39,16 @@ class HeapPow2
         HeapPow2(HeapPow2&& other) = delete;
         HeapPow2& operator=(HeapPow2&& other) = delete;
 
-        static constexpr std::size_t BIN_COUNT = 15; // Small : 16 32 64 128 256 512 1024 2048 4096 8192 16384 32768 , Medium: 65536 131072 262144
-        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
-        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 12;
-        static constexpr inline std::size_t LARGEST_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<BIN_COUNT + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
-        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<MIN_MEDIUM_OBJECT_BIN_INDEX + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+        using SizeClassesType = SizeClasses;
 
-        static constexpr std::size_t MIN_SIZE_CLASS = 16;
-        static constexpr inline std::size_t LOG2_MIN_SIZE_CLASS = CompileTimePow2Utils::compile_time_log2<MIN_SIZE_CLASS>();
+        static constexpr std::size_t BIN_COUNT = SizeClasses::BIN_COUNT;
+        static constexpr std::size_t SIZE_CLASS_GROUP_COUNT = SizeClasses::GROUP_COUNT; // Creation params are per pow2 size class group
+        static constexpr std::size_t MAX_BIN_INDEX = SizeClasses::MAX_BIN_INDEX;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = SizeClasses::MIN_MEDIUM_OBJECT_BIN_INDEX;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = SizeClasses::LARGEST_SIZE_CLASS;
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = SizeClasses::LARGEST_SMALL_OBJECT_SIZE_CLASS;
+
+        static constexpr std::size_t MIN_SIZE_CLASS = SizeClasses::MIN_SIZE_CLASS;
 
         using ArenaType = Arena;
         using SegmentType = Segment<segment_lock_policy>;
@@ -66,15 +58,21 @@ class HeapPow2
             // SIZES AND CAPACITIES
             std::size_t small_object_logical_page_size = 65536; // 64 KB
             std::size_t medium_object_logical_page_size = 524288; // 512 KB
-            std::size_t logical_page_counts[BIN_COUNT] = { 1,1,1,1,1, 1,1,2,4,8, 16,32,8,16,32 };
+            std::size_t logical_page_counts[SIZE_CLASS_GROUP_COUNT] = { 1,1,1,1,1, 1,1,2,4,8, 16,32,8,16,32 };
             // RECYCLING AND GROWING
             std::size_t page_recycling_threshold_per_size_class = 1024;
             bool segments_can_grow = true;
             double segment_grow_coefficient = 2.0;
+            std::size_t cache_color_count = 1; // See Segment , 1 disables cache coloring
+            std::size_t logical_page_pool_capacity = 16; // Emptied small object logical pages are kept for bins of any size class up to this count , 0 disables pooling
             // DEALLOCATION QUEUES
             std::size_t deallocation_queues_processing_threshold = 1024;
-            std::size_t recyclable_deallocation_queue_sizes[BIN_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
-            std::size_t non_recyclable_deallocation_queue_sizes[BIN_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
+            std::size_t recyclable_deallocation_queue_sizes[SIZE_CLASS_GROUP_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
+            std::size_t non_recyclable_deallocation_queue_sizes[SIZE_CLASS_GROUP_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
+            bool use_remote_free_lists = false; // If true, pointers of other heaps go back to their logical pages instead of non recyclable deallocation queues
+            // OTHERS
+            PageMapType* page_map = nullptr; // Optional, segments will register their logical pages to it
+            PagePurger* page_purger = nullptr; // Optional, segments will hand recycled logical pages to it
         };
 
         [[nodiscard]] bool create(const HeapCreationParams& params, ArenaType* arena)
@@ -97,24 +95,26 @@ class HeapPow2
             m_small_object_logical_page_size = params.small_object_logical_page_size;
             m_medium_object_logical_page_size = params.medium_object_logical_page_size;
 
+            if (m_small_object_logical_page_pool.create(m_small_object_logical_page_size, params.logical_page_pool_capacity, arena, params.page_purger) == false)
+            {
+                return false;
+            }
+
             //////////////////////////////////////////////////////////////////////////////////////////////
             // 2. CALCULATE REQUIRED BUFFER SIZE
             std::size_t small_objects_required_buffer_size{ 0 };
             std::size_t medium_objects_required_buffer_size{ 0 };
-            std::size_t size_class = MIN_SIZE_CLASS;
 
             for (std::size_t i = 0; i < BIN_COUNT; i++)
             {
                 if(i<MIN_MEDIUM_OBJECT_BIN_INDEX)
                 {
-                    small_objects_required_buffer_size += (params.logical_page_counts[i] * m_small_object_logical_page_size);
+                    small_objects_required_buffer_size += (get_bin_share(params.logical_page_counts, i) * m_small_object_logical_page_size);
                 }
                 else
                 {
-                    medium_objects_required_buffer_size += (params.logical_page_counts[i] * m_medium_object_logical_page_size);
+                    medium_objects_required_buffer_size += (get_bin_share(params.logical_page_counts, i) * m_medium_object_logical_page_size);
                 }
-
-                size_class = size_class << 1;
             }
 
             //////////////////////////////////////////////////////////////////////////////////////////////
@@ -130,20 +130,23 @@ class HeapPow2
             // 4. DISTRIBUTE BUFFER TO BINS ,  NEED TO PLACE LOGICAL PAGE HEADERS TO START OF PAGES !
 
             std::size_t buffer_index{ 0 };
-            size_class = MIN_SIZE_CLASS;
 
             SegmentCreationParameters segment_params;
             segment_params.m_page_recycling_threshold = params.page_recycling_threshold_per_size_class;
             segment_params.m_can_grow = params.segments_can_grow;
             segment_params.m_grow_coefficient = params.segment_grow_coefficient;
+            segment_params.m_cache_color_count = params.cache_color_count;
+            segment_params.m_page_map = params.page_map;
+            segment_params.m_page_purger = params.page_purger;
 
             for (std::size_t i = 0; i < MIN_MEDIUM_OBJECT_BIN_INDEX; i++)
             {
-                auto required_logical_page_count = params.logical_page_counts[i];
-                segment_params.m_size_class = static_cast<uint32_t>(size_class);
+                auto required_logical_page_count = get_bin_share(params.logical_page_counts, i);
+                segment_params.m_size_class = static_cast<uint32_t>(SizeClasses::get_size_class(i));
                 segment_params.m_logical_page_count = required_logical_page_count;
 
                 segment_params.m_logical_page_size = m_small_object_logical_page_size;
+                segment_params.m_logical_page_pool = &m_small_object_logical_page_pool;
                 auto bin_buffer_size = required_logical_page_count * m_small_object_logical_page_size;
 
                 bool success = m_segments[i].create(reinterpret_cast<char*>(small_objects_buffer_address) + buffer_index, arena, segment_params);
@@ -154,18 +157,18 @@ class HeapPow2
                 }
 
                 buffer_index += bin_buffer_size;
-                size_class = size_class << 1;
             }
 
             buffer_index = 0;
 
             for (std::size_t i = MIN_MEDIUM_OBJECT_BIN_INDEX; i < BIN_COUNT; i++)
             {
-                auto required_logical_page_count = params.logical_page_counts[i];
-                segment_params.m_size_class = static_cast<uint32_t>(size_class);
+                auto required_logical_page_count = get_bin_share(params.logical_page_counts, i);
+                segment_params.m_size_class = static_cast<uint32_t>(SizeClasses::get_size_class(i));
                 segment_params.m_logical_page_count = required_logical_page_count;
 
                 segment_params.m_logical_page_size = m_medium_object_logical_page_size;
+                segment_params.m_logical_page_pool = nullptr; // Medium object bins have few pages , their recycling threshold applies as it is
                 auto bin_buffer_size = required_logical_page_count * m_medium_object_logical_page_size;
 
                 bool success = m_segments[i].create(medium_objects_buffer_address + buffer_index, arena, segment_params);
@@ -176,23 +179,24 @@ class HeapPow2
                 }
 
                 buffer_index += bin_buffer_size;
-                size_class = size_class << 1;
             }
             //////////////////////////////////////////////////////////////////////////////////////////////
             // 5. DEALLOCATION QUEUES
-            m_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            m_configured_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            m_deallocation_queue_processing_threshold.store(m_configured_deallocation_queue_processing_threshold, std::memory_order_relaxed);
+            m_use_remote_free_lists = params.use_remote_free_lists;
 
             for (std::size_t i = 0; i < BIN_COUNT; i++)
             {
-                if( params.non_recyclable_deallocation_queue_sizes[i] > 0 )
+                if( params.non_recyclable_deallocation_queue_sizes[SizeClasses::get_group_index(i)] > 0 )
                 {
-                    if (m_non_recyclable_deallocation_queues[i].create(params.non_recyclable_deallocation_queue_sizes[i]) == false)
+                    if (m_non_recyclable_deallocation_queues[i].create(get_bin_share(params.non_recyclable_deallocation_queue_sizes, i)) == false)
                     {
                         return false;
                     }
                 }
 
-                if (m_recyclable_deallocation_queues[i].create(params.recyclable_deallocation_queue_sizes[i]) == false)
+                if (m_recyclable_deallocation_queues[i].create(get_bin_share(params.recyclable_deallocation_queue_sizes, i)) == false)
                 {
                     return false;
                 }
@@ -201,33 +205,48 @@ class HeapPow2
             return true;
         }
 
+        // Creation params are per pow2 size class group , see size_classes.h for how bins of a group share them
+        static std::size_t get_bin_share(const std::size_t* group_values, std::size_t bin_index)
+        {
+            auto group_value = group_values[SizeClasses::get_group_index(bin_index)];
+            auto group_bin_count = SizeClasses::get_group_bin_count(SizeClasses::get_group_index(bin_index));
+            auto share = group_value / group_bin_count + (SizeClasses::get_index_in_group(bin_index) < group_value % group_bin_count ? 1 : 0);
+            return share > 0 ? share : 1;
+        }
+
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
         void* allocate(std::size_t size = 0)
         {
-            size = size < MIN_SIZE_CLASS ? MIN_SIZE_CLASS : size;
-            size = get_first_pow2_of(size);
-            auto bin_index = get_pow2_bin_index_from_size(size);
-
-            m_potential_pending_max_deallocation_count++;
+            auto bin_index = SizeClasses::get_bin_index(size);
+            void* ret = allocate_from_bin(bin_index, SizeClasses::get_size_class(bin_index), nullptr);
 
-            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold))
+            #ifdef ENABLE_STATS
+            // Failed ones are counted by the heap which serves them
+            if (ret != nullptr)
             {
-                return allocate_by_processing_deallocation_queues(bin_index, size);
+                increment_counter(m_bin_counters[bin_index].allocation_count);
             }
+            #endif
 
-            uint64_t pointer{ 0 };
+            return ret;
+        }
 
-            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
-            {
-                return reinterpret_cast<void*>(pointer);
-            }
+        // Same as allocate , also reports whether the returned chunk is known to be zeroed. Only never used chunks of logical pages are
+        [[nodiscard]] void* allocate(std::size_t size, bool& is_zeroed)
+        {
+            is_zeroed = false;
 
-            if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            auto bin_index = SizeClasses::get_bin_index(size);
+            void* ret = allocate_from_bin(bin_index, SizeClasses::get_size_class(bin_index), &is_zeroed);
+
+            #ifdef ENABLE_STATS
+            if (ret != nullptr)
             {
-                return reinterpret_cast<void*>(pointer);
+                increment_counter(m_bin_counters[bin_index].allocation_count);
             }
+            #endif
 
-            return m_segments[bin_index].allocate(size);
+            return ret;
         }
 
         // Slow path removal function
@@ -240,6 +259,16 @@ class HeapPow2
 
             m_potential_pending_max_deallocation_count = 0;
 
+            if (llmalloc_unlikely(m_pending_requests.load(std::memory_order_relaxed) != 0))
+            {
+                serve_pending_requests();
+            }
+
+            if (m_use_remote_free_lists)
+            {
+                m_segments[bin_index].reclaim_remote_frees();
+            }
+
             auto ret = process_recyclable_deallocation_queue(bin_index);
 
             if(ret != nullptr)
@@ -267,16 +296,294 @@ class HeapPow2
 
             llmalloc_assert_msg(size_class >= MIN_SIZE_CLASS, "HeapPow2 deallocate : Found size class is invalid. The pointer may not have been allocated by this allocator.");
             
-            auto bin_index = get_pow2_bin_index_from_size(size_class);
+            auto bin_index = SizeClasses::get_bin_index_from_size_class(size_class);
 
             if (m_segments[bin_index].get_id() == target_logical_page->get_segment_id())
             {
+                #ifdef ENABLE_STATS
+                return on_deallocation(bin_index, m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr)), m_bin_counters[bin_index].deallocation_count);
+                #else
                 return m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                #endif
+            }
+            else if (m_use_remote_free_lists)
+            {
+                // Owner heap will reclaim it in its allocation slow path , so that the logical page can be recycled
+                SegmentType::deallocate_remotely(target_logical_page, ptr, ptr);
+
+                #ifdef ENABLE_STATS
+                increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                #endif
+
+                return true;
             }
             else
             {
+                #ifdef ENABLE_STATS
+                return on_deallocation(bin_index, m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr)), m_bin_counters[bin_index].cross_thread_deallocation_count);
+                #else
                 return m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                #endif
+            }
+        }
+
+        // Resolves the bin once , then drains the deallocation queues and carves the rest from the segment
+        // Returns the number of allocated objects , can be less than count only if the heap is exhausted
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
+        {
+            auto bin_index = SizeClasses::get_bin_index(size);
+            size = SizeClasses::get_size_class(bin_index);
+
+            std::size_t allocated{ 0 };
+
+            m_potential_pending_max_deallocation_count += count;
+
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold.load(std::memory_order_relaxed)))
+            {
+                void* ptr = allocate_by_processing_deallocation_queues(bin_index, size);
+
+                if (ptr == nullptr)
+                {
+                    return 0;
+                }
+
+                out[allocated++] = ptr;
+            }
+
+            allocated += QueueUtilities::pop_batch(m_non_recyclable_deallocation_queues[bin_index], count - allocated, out + allocated);
+            allocated += QueueUtilities::pop_batch(m_recyclable_deallocation_queues[bin_index], count - allocated, out + allocated);
+
+            if (allocated < count)
+            {
+                allocated += m_segments[bin_index].allocate_batch(size, count - allocated, out + allocated);
+            }
+
+            #ifdef ENABLE_STATS
+            increment_counter(m_bin_counters[bin_index].allocation_count, allocated);
+            #endif
+
+            return allocated;
+        }
+
+        // Consecutive pointers of the same logical page are handled after a single page header access
+        // Returns the number of leading pointers this heap accepted , the caller should pass the first rejected one elsewhere
+        std::size_t deallocate_batch(void** ptrs, std::size_t count, bool is_small_object)
+        {
+            auto logical_page_size = is_small_object ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
+
+            LogicalPage* current_logical_page = nullptr;
+            std::size_t bin_index{ 0 };
+            bool is_owned = false;
+            void* remote_chain_head = nullptr; // Remote frees of the current page are linked and pushed with a single CAS
+            void* remote_chain_tail = nullptr;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto target_logical_page = SegmentType::get_logical_page_from_address(ptrs[i], logical_page_size);
+
+                if (target_logical_page != current_logical_page)
+                {
+                    if (remote_chain_head)
+                    {
+                        SegmentType::deallocate_remotely(current_logical_page, remote_chain_head, remote_chain_tail);
+                        remote_chain_head = nullptr;
+                    }
+
+                    current_logical_page = target_logical_page;
+                    auto size_class = target_logical_page->get_size_class();
+
+                    llmalloc_assert_msg(size_class >= MIN_SIZE_CLASS, "HeapPow2 deallocate_batch : Found size class is invalid. The pointer may not have been allocated by this allocator.");
+
+                    bin_index = SizeClasses::get_bin_index_from_size_class(size_class);
+                    is_owned = m_segments[bin_index].get_id() == target_logical_page->get_segment_id();
+                }
+
+                if (is_owned)
+                {
+                    if (llmalloc_unlikely(m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                    {
+                        #ifdef ENABLE_STATS
+                        increment_counter(m_bin_counters[bin_index].queue_overflow_count);
+                        #endif
+                        return i;
+                    }
+
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].deallocation_count);
+                    #endif
+                }
+                else if (m_use_remote_free_lists)
+                {
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                    #endif
+
+                    if (remote_chain_head == nullptr)
+                    {
+                        remote_chain_head = ptrs[i];
+                    }
+                    else
+                    {
+                        reinterpret_cast<LogicalPage::NodeType*>(remote_chain_tail)->m_next = reinterpret_cast<LogicalPage::NodeType*>(ptrs[i]);
+                    }
+
+                    remote_chain_tail = ptrs[i];
+                }
+                else
+                {
+                    if (llmalloc_unlikely(m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                    {
+                        #ifdef ENABLE_STATS
+                        increment_counter(m_bin_counters[bin_index].queue_overflow_count);
+                        #endif
+                        return i;
+                    }
+
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                    #endif
+                }
+            }
+
+            if (remote_chain_head)
+            {
+                SegmentType::deallocate_remotely(current_logical_page, remote_chain_head, remote_chain_tail);
+            }
+
+            return count;
+        }
+
+        // Returns memory of empty logical pages to the arena
+        // Thread local heaps should be trimmed by their owners or by other threads during external access , otherwise other threads can use request_trim
+        void trim()
+        {
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                flush_deallocation_queues(i);
+                m_segments[i].release_empty_logical_pages();
+            }
+
+            m_small_object_logical_page_pool.release_all();
+        }
+
+        // Chunks in deallocation queues are flushed first so that they are not counted as used
+        // Thread local heaps should be measured by their owners or by other threads during external access , otherwise other threads can use request_used_size_snapshot
+        std::size_t get_used_size()
+        {
+            std::size_t used_size{ 0 };
+
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                flush_deallocation_queues(i);
+                used_size += m_segments[i].get_used_size();
+            }
+
+            return used_size;
+        }
+
+        // Thread local heaps should be flushed by their owners or by other threads during external access
+        void flush_deallocation_queues()
+        {
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                flush_deallocation_queues(i);
+            }
+        }
+
+        // Can be called from any thread
+        std::size_t get_pooled_size() const
+        {
+            return m_small_object_logical_page_pool.get_page_count() * m_small_object_logical_page_size;
+        }
+
+        // Owners of thread local heaps enclose their calls with these. With ENABLE_EXTERNAL_HEAP_ACCESS , other threads can access the heap while the owner is outside of it.
+        // Plain stores and only a compiler barrier here , other threads pay for the process wide barrier instead. Without it they are no-ops
+        LLMALLOC_FORCE_INLINE void enter_owner_call()
+        {
+            #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+            m_owner_in_call.store(true, std::memory_order_relaxed);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            if (llmalloc_unlikely(m_external_access.load(std::memory_order_acquire)))
+            {
+                wait_for_external_access();
             }
+            #endif
+        }
+
+        LLMALLOC_FORCE_INLINE void leave_owner_call()
+        {
+            #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+            m_owner_in_call.store(false, std::memory_order_release);
+            #endif
+        }
+
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        // Should be followed by ThreadUtilities::issue_process_wide_memory_barrier. Then if is_owner_in_call returns false ,
+        // the heap can be accessed as the owner can't enter until end_external_access. Otherwise external access should be ended right away
+        void begin_external_access() { m_external_access.store(true); }
+        bool is_owner_in_call() const { return m_owner_in_call.load(std::memory_order_acquire); }
+        bool is_externally_accessed() const { return m_external_access.load(std::memory_order_relaxed); }
+        void end_external_access() { m_external_access.store(false, std::memory_order_release); }
+        #endif
+
+        // Can be called from any thread. Requests are served by the owner in its next allocation , which they route to the slow path
+        void request_trim() { add_request(REQUEST_TRIM); }
+        void request_used_size_snapshot() { add_request(REQUEST_USED_SIZE_SNAPSHOT); }
+
+        // Used size published by the owner when it served the last snapshot request
+        std::size_t get_published_used_size() const { return m_published_used_size.load(std::memory_order_relaxed); }
+
+        // Thread local heaps should publish their page sizes by themselves , other threads can use request_page_sizes_snapshot
+        void publish_page_sizes()
+        {
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                std::size_t virtual_size{ 0 };
+                std::size_t resident_size{ 0 };
+
+                m_segments[i].get_page_sizes(virtual_size, resident_size);
+
+                m_published_page_sizes[i].virtual_size.store(virtual_size, std::memory_order_relaxed);
+                m_published_page_sizes[i].resident_size.store(resident_size, std::memory_order_relaxed);
+            }
+        }
+
+        void request_page_sizes_snapshot() { add_request(REQUEST_PAGE_SIZES_SNAPSHOT); }
+
+        // Can be called from any thread , adds counters and last published page sizes of the bin to the passed stats
+        void add_bin_stats(std::size_t bin_index, BinStats& stats) const
+        {
+            #ifdef ENABLE_STATS
+            stats.allocation_count += m_bin_counters[bin_index].allocation_count.load(std::memory_order_relaxed);
+            stats.deallocation_count += m_bin_counters[bin_index].deallocation_count.load(std::memory_order_relaxed);
+            stats.cross_thread_deallocation_count += m_bin_counters[bin_index].cross_thread_deallocation_count.load(std::memory_order_relaxed);
+            stats.queue_overflow_count += m_bin_counters[bin_index].queue_overflow_count.load(std::memory_order_relaxed);
+            stats.segment_grow_count += m_segments[bin_index].get_grow_count();
+            stats.recycled_logical_page_count += m_segments[bin_index].get_recycled_logical_page_count();
+            #endif
+            stats.resident_size += m_published_page_sizes[bin_index].resident_size.load(std::memory_order_relaxed);
+            stats.virtual_size += m_published_page_sizes[bin_index].virtual_size.load(std::memory_order_relaxed);
+        }
+
+        // ScalableAllocator counts allocations it passes to the central heap on the thread local heap , or on the central heap for threads without one
+        void count_central_heap_fallbacks(std::size_t count)
+        {
+            #ifdef ENABLE_STATS
+            increment_counter(m_central_heap_fallback_count, count);
+            #else
+            LLMALLOC_UNUSED(count);
+            #endif
+        }
+
+        // Can be called from any thread , zero without ENABLE_STATS
+        std::size_t get_central_heap_fallback_count() const
+        {
+            #ifdef ENABLE_STATS
+            return m_central_heap_fallback_count.load(std::memory_order_relaxed);
+            #else
+            return 0;
+            #endif
         }
 
         SegmentType* get_segment(std::size_t bin_index)
@@ -304,18 +611,168 @@ class HeapPow2
         {
             return m_segments[bin_index].get_logical_page_count();
         }
+
+        std::size_t get_pooled_logical_page_count() const
+        {
+            return m_small_object_logical_page_pool.get_page_count();
+        }
         #endif
 
     private:
+
         std::size_t m_small_object_logical_page_size = 0;
         std::size_t m_medium_object_logical_page_size = 0;
+        LogicalPagePool m_small_object_logical_page_pool;
         std::array<SegmentType, BIN_COUNT> m_segments;
 
         std::size_t m_potential_pending_max_deallocation_count = 0; // Not thread safe but doesn't need to be
-        std::size_t m_deallocation_queue_processing_threshold = 0;
+        std::atomic<std::size_t> m_deallocation_queue_processing_threshold = 0; // Other threads lower it to 0 to route the owner to the slow path , relaxed loads are plain loads
+        std::size_t m_configured_deallocation_queue_processing_threshold = 0;
+        std::atomic<uint32_t> m_pending_requests = 0;
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        std::atomic<bool> m_owner_in_call = false;
+        std::atomic<bool> m_external_access = false;
+        #endif
+        std::atomic<std::size_t> m_published_used_size = 0;
+        bool m_use_remote_free_lists = false;
         std::array<DeallocationQueueType, BIN_COUNT> m_recyclable_deallocation_queues;
         std::array<DeallocationQueueType, BIN_COUNT> m_non_recyclable_deallocation_queues;
 
+        struct PublishedPageSizes
+        {
+            std::atomic<std::size_t> resident_size = 0;
+            std::atomic<std::size_t> virtual_size = 0;
+        };
+
+        std::array<PublishedPageSizes, BIN_COUNT> m_published_page_sizes;
+
+        #ifdef ENABLE_STATS
+        struct BinCounters
+        {
+            std::atomic<std::size_t> allocation_count = 0;
+            std::atomic<std::size_t> deallocation_count = 0;
+            std::atomic<std::size_t> cross_thread_deallocation_count = 0;
+            std::atomic<std::size_t> queue_overflow_count = 0;
+        };
+
+        std::array<BinCounters, BIN_COUNT> m_bin_counters;
+        std::atomic<std::size_t> m_central_heap_fallback_count = 0;
+
+        // Thread local heaps are the only writers of their counters , so they are incremented with plain loads and stores. Central heap ones have concurrent writers
+        static void increment_counter(std::atomic<std::size_t>& counter, std::size_t value = 1)
+        {
+            if constexpr (segment_lock_policy == LockPolicy::NO_LOCK)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+            else
+            {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }
+        }
+
+        bool on_deallocation(std::size_t bin_index, bool pushed, std::atomic<std::size_t>& counter)
+        {
+            increment_counter(pushed ? counter : m_bin_counters[bin_index].queue_overflow_count);
+            return pushed;
+        }
+        #endif
+
+        static constexpr uint32_t REQUEST_TRIM = 0x0001;
+        static constexpr uint32_t REQUEST_USED_SIZE_SNAPSHOT = 0x0002;
+        static constexpr uint32_t REQUEST_PAGE_SIZES_SNAPSHOT = 0x0004;
+
+        void add_request(uint32_t request)
+        {
+            m_pending_requests.fetch_or(request);
+            m_deallocation_queue_processing_threshold.store(0);
+        }
+
+        // Chunks in the recyclable queue go back to their logical pages and chunks of other heaps in the non recyclable one
+        // are freed remotely to their logical pages , so that their owners can recycle them
+        void flush_deallocation_queues(std::size_t bin_index)
+        {
+            auto logical_page_size = bin_index < MIN_MEDIUM_OBJECT_BIN_INDEX ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
+            uint64_t pointer{ 0 };
+
+            while (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                m_segments[bin_index].deallocate(reinterpret_cast<void*>(pointer));
+            }
+
+            while (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                SegmentType::deallocate_remotely(SegmentType::get_logical_page_from_address(reinterpret_cast<void*>(pointer), logical_page_size), reinterpret_cast<void*>(pointer), reinterpret_cast<void*>(pointer));
+            }
+        }
+
+        LLMALLOC_FORCE_INLINE void* allocate_from_bin(std::size_t bin_index, std::size_t size, bool* is_zeroed)
+        {
+            m_potential_pending_max_deallocation_count++;
+
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold.load(std::memory_order_relaxed)))
+            {
+                return allocate_by_processing_deallocation_queues(bin_index, size);
+            }
+
+            uint64_t pointer{ 0 };
+
+            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                return reinterpret_cast<void*>(pointer);
+            }
+
+            if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                return reinterpret_cast<void*>(pointer);
+            }
+
+            return m_segments[bin_index].allocate(size, is_zeroed);
+        }
+
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        // Slow path removal function
+        void wait_for_external_access()
+        {
+            do
+            {
+                m_owner_in_call.store(false, std::memory_order_release);
+
+                while (m_external_access.load(std::memory_order_acquire))
+                {
+                    ThreadUtilities::yield();
+                }
+
+                m_owner_in_call.store(true, std::memory_order_relaxed);
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            }
+            while (m_external_access.load(std::memory_order_acquire));
+        }
+        #endif
+
+        // Slow path removal function
+        void serve_pending_requests()
+        {
+            // Restoring the threshold before taking the requests , so that a request added in between lowers it again
+            m_deallocation_queue_processing_threshold.store(m_configured_deallocation_queue_processing_threshold);
+            auto requests = m_pending_requests.exchange(0);
+
+            if (requests & REQUEST_TRIM)
+            {
+                trim();
+            }
+
+            if (requests & REQUEST_USED_SIZE_SNAPSHOT)
+            {
+                m_published_used_size.store(get_used_size(), std::memory_order_relaxed);
+            }
+
+            if (requests & REQUEST_PAGE_SIZES_SNAPSHOT)
+            {
+                publish_page_sizes();
+            }
+        }
+
         void* process_recyclable_deallocation_queue(std::size_t bin_index)
         {
             void* ret = nullptr;
@@ -344,34 +801,8 @@ class HeapPow2
             return ret;
         }
 
-        // Reference : https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
-        LLMALLOC_FORCE_INLINE std::size_t get_first_pow2_of(std::size_t input)
-        {
-            assert(input>= MIN_SIZE_CLASS);
-
-            /* 
-            No need for the if check below , as the caller will pass a miniumum of MIN_SIZE_CLASS which is > 1
-            if (llmalloc_unlikely(input <= 1))
-            {
-                return 1;
-            }
-            */
-
-            input--;
-            input |= input >> 1;
-            input |= input >> 2;
-            input |= input >> 4;
-            input |= input >> 8;
-            input |= input >> 16;
-
-            return input + 1;
-        }
+};
 
-        // IMPLEMENTATION IS FOR 64 BIT ONLY
-        LLMALLOC_FORCE_INLINE std::size_t get_pow2_bin_index_from_size(std::size_t size)
-        {
-            std::size_t index = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size))) - LOG2_MIN_SIZE_CLASS;
-            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
-            return index;
-        }
-};
\ No newline at end of file
+// 4 size classes per pow2 to reduce internal fragmentation , at the cost of a few more instructions per allocation
+template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK>
+using HeapQuarterPow2 = HeapPow2<DeallocationQueueType, segment_lock_policy, QuarterPow2SizeClasses>;
\ No newline at end of file
@@ -0,0 +1,350 @@
+/*
+    - CACHES FREED LARGE OBJECT MAPPINGS SO THAT SUBSEQUENT LARGE ALLOCATIONS OF SIMILAR SIZES DON'T PAY FOR MMAP/MUNMAP SYSCALLS AND PAGE FAULTS
+
+    - MAPPING SIZES ARE ROUNDED UP TO GEOMETRIC BUCKETS , 4 PER POW2 : 320KB 384KB 448KB 512KB , 640KB 768KB 896KB 1MB , ... , 1GB
+      Any cached mapping of a bucket can serve any request of the same bucket. Rounding up costs up to 25% of virtual memory per object
+
+    - THE CACHE HAS A SINGLE BYTE BUDGET FOR ALL BUCKETS AS CACHED MAPPINGS ARE POPULATED. WHEN A NEW MAPPING DOESN'T FIT INTO IT ,
+      THE OLDEST MAPPINGS OF ITS BUCKET ARE RELEASED TO THE OS. If that is not enough , the new mapping is not cached
+
+    - DECAY : MAPPINGS WHICH STAY IN THE CACHE LONGER THAN THE DECAY PERIOD ARE RELEASED TO THE OS. With background sweeping , only release_expired_mappings
+      calls of a background thread release them so that frees don't pay for munmaps. Otherwise expired mappings of a bucket are released during its
+      deallocations and all buckets are swept at most once per decay period during cache operations , so cached memory stays until the next large object operation
+
+    - BUCKETS ARE LIFO STACKS PROTECTED BY SPINLOCKS. MOST RECENTLY CACHED MAPPINGS ARE REUSED FIRST AS THEY ARE MORE LIKELY TO BE IN CPU CACHES AND TLBS.
+      Stacks are also ordered by cache times , so the oldest mappings are at the bottom. Mappings are released to the OS after locks are released
+
+    - CACHED MAPPINGS ARE NOT ZEROED
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "compiler/hints_hot_code.h"
+#include "compiler/hints_branch_predictor.h"
+#include "compiler/builtin_functions.h"
+#include "cpu/alignment_constants.h"
+#include "os/virtual_memory.h"
+#include "os/time_utilities.h"
+#include "utilities/userspace_spinlock.h"
+
+struct LargeObjectCacheOptions
+{
+    std::size_t max_object_size = 33554432;     // Mappings of bigger objects are not cached , 0 disables the cache
+    std::size_t capacity = 67108864;            // Byte budget of all buckets , 0 disables the cache
+    uint64_t decay_period = 1000;               // In milliseconds , 0 disables the decay so that mappings are released only by the budget
+    bool background_sweeping = false;           // Expired mappings are released only by release_expired_mappings calls
+};
+
+class LargeObjectCache
+{
+    public:
+
+        static constexpr std::size_t LOG2_MIN_OBJECT_SIZE = 18;        // Objects up to 256KB are served by heaps
+        static constexpr std::size_t LOG2_MAX_OBJECT_SIZE = 30;
+        static constexpr std::size_t BUCKET_COUNT = (LOG2_MAX_OBJECT_SIZE - LOG2_MIN_OBJECT_SIZE) * 4;
+        static constexpr std::size_t MAX_MAPPING_COUNT_PER_BUCKET = 32;
+
+        LargeObjectCache() = default;
+        ~LargeObjectCache() = default;
+
+        LargeObjectCache(const LargeObjectCache& other) = delete;
+        LargeObjectCache& operator= (const LargeObjectCache& other) = delete;
+        LargeObjectCache(LargeObjectCache&& other) = delete;
+        LargeObjectCache& operator=(LargeObjectCache&& other) = delete;
+
+        bool create(const LargeObjectCacheOptions& options)
+        {
+            constexpr std::size_t max_object_size_limit = static_cast<std::size_t>(1) << LOG2_MAX_OBJECT_SIZE;
+
+            m_max_object_size = options.max_object_size > options.capacity ? options.capacity : options.max_object_size;
+            m_max_object_size = m_max_object_size > max_object_size_limit ? max_object_size_limit : m_max_object_size;
+            m_capacity = options.capacity;
+            m_decay_period = options.decay_period;
+            m_background_sweeping = options.background_sweeping;
+            m_cached_size.store(0, std::memory_order_relaxed);
+
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                m_buckets[i].m_lock.initialise();
+                m_buckets[i].m_mapping_count = 0;
+            }
+
+            m_next_sweep_time.store(TimeUtilities::get_monotonic_time_in_milliseconds() + m_decay_period, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        // Cachable sizes are rounded up to their bucket sizes , so that their mappings can be reused by any request of the same bucket
+        std::size_t get_mapping_size(std::size_t size) const
+        {
+            if (size <= MIN_OBJECT_SIZE || size > m_max_object_size)
+            {
+                return size;
+            }
+
+            return get_bucket_size(get_bucket_index(size));
+        }
+
+        // Returns nullptr if there is no cached mapping , mapping_size should be the one returned from get_mapping_size
+        void* allocate(std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
+            {
+                return nullptr;
+            }
+
+            void* ret = nullptr;
+            Bucket& bucket = m_buckets[get_bucket_index(mapping_size)];
+
+            bucket.m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            if (bucket.m_mapping_count > 0)
+            {
+                ret = bucket.m_mappings[--bucket.m_mapping_count].m_address;
+                m_cached_size.fetch_sub(mapping_size, std::memory_order_relaxed);
+            }
+            ////////////////////////////////////////////////////////////////////
+            bucket.m_lock.unlock();
+
+            if (m_background_sweeping == false)
+            {
+                sweep_if_needed(TimeUtilities::get_monotonic_time_in_milliseconds());
+            }
+
+            return ret;
+        }
+
+        // Returns false if the mapping can't be cached , then the caller should release it to the OS
+        bool deallocate(void* address, std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
+            {
+                return false;
+            }
+
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+            Bucket& bucket = m_buckets[get_bucket_index(mapping_size)];
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+
+            bucket.m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            // Passing 0 as the current time skips the decay
+            std::size_t released_mapping_count = remove_expired_mappings(bucket, m_background_sweeping ? 0 : now, MAX_MAPPING_COUNT_PER_BUCKET - 1, released_mappings, mapping_size);
+            bool reserved = try_reserve(mapping_size);
+
+            while (reserved == false && bucket.m_mapping_count > 0)
+            {
+                released_mapping_count += remove_expired_mappings(bucket, 0, bucket.m_mapping_count - 1, released_mappings + released_mapping_count, mapping_size);
+                reserved = try_reserve(mapping_size);
+            }
+
+            if (reserved)
+            {
+                bucket.m_mappings[bucket.m_mapping_count].m_address = address;
+                bucket.m_mappings[bucket.m_mapping_count].m_cache_time = now;
+                bucket.m_mapping_count++;
+            }
+            ////////////////////////////////////////////////////////////////////
+            bucket.m_lock.unlock();
+
+            release_mappings(released_mappings, released_mapping_count, mapping_size);
+
+            if (m_background_sweeping == false)
+            {
+                sweep_if_needed(now);
+            }
+
+            return reserved;
+        }
+
+        // Releases expired mappings of all buckets to the OS
+        void release_expired_mappings()
+        {
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                Bucket& bucket = m_buckets[i];
+
+                bucket.m_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                std::size_t released_mapping_count = remove_expired_mappings(bucket, now, MAX_MAPPING_COUNT_PER_BUCKET, released_mappings, get_bucket_size(i));
+                ////////////////////////////////////////////////////////////////////
+                bucket.m_lock.unlock();
+
+                release_mappings(released_mappings, released_mapping_count, get_bucket_size(i));
+            }
+        }
+
+        // Releases all cached mappings to the OS regardless of their cache times , returns released bytes
+        std::size_t release_all_mappings()
+        {
+            std::size_t released_size{ 0 };
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                Bucket& bucket = m_buckets[i];
+
+                bucket.m_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                std::size_t released_mapping_count = remove_expired_mappings(bucket, 0, 0, released_mappings, get_bucket_size(i));
+                ////////////////////////////////////////////////////////////////////
+                bucket.m_lock.unlock();
+
+                release_mappings(released_mappings, released_mapping_count, get_bucket_size(i));
+                released_size += released_mapping_count * get_bucket_size(i);
+            }
+
+            return released_size;
+        }
+
+        // Total size of cached mappings
+        std::size_t get_cached_size() const
+        {
+            return m_cached_size.load(std::memory_order_relaxed);
+        }
+
+        std::size_t get_cached_mapping_count(std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
+            {
+                return 0;
+            }
+
+            return m_buckets[get_bucket_index(mapping_size)].m_mapping_count;
+        }
+
+    private:
+
+        static constexpr std::size_t MIN_OBJECT_SIZE = static_cast<std::size_t>(1) << LOG2_MIN_OBJECT_SIZE;
+
+        struct CachedMapping
+        {
+            void* m_address = nullptr;
+            uint64_t m_cache_time = 0;
+        };
+
+        struct Bucket
+        {
+            UserspaceSpinlock<AlignmentConstants::CPU_CACHE_LINE_SIZE> m_lock;
+            std::size_t m_mapping_count = 0;
+            CachedMapping m_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+        };
+
+        Bucket m_buckets[BUCKET_COUNT];
+        std::size_t m_max_object_size = 0;
+        std::size_t m_capacity = 0;
+        uint64_t m_decay_period = 0;
+        bool m_background_sweeping = false;
+        std::atomic<std::size_t> m_cached_size{ 0 };
+        std::atomic<uint64_t> m_next_sweep_time{ 0 };
+
+        // Buckets have separate locks , so the budget is shared with a CAS loop
+        bool try_reserve(std::size_t mapping_size)
+        {
+            std::size_t cached_size = m_cached_size.load(std::memory_order_relaxed);
+
+            do
+            {
+                if (cached_size + mapping_size > m_capacity)
+                {
+                    return false;
+                }
+            }
+            while (m_cached_size.compare_exchange_weak(cached_size, cached_size + mapping_size, std::memory_order_relaxed, std::memory_order_relaxed) == false);
+
+            return true;
+        }
+
+        // Mapping sizes which are not bucket sizes ( ex: remapped objects ) are not cached
+        bool is_cachable(std::size_t mapping_size) const
+        {
+            if (mapping_size <= MIN_OBJECT_SIZE || mapping_size > m_max_object_size)
+            {
+                return false;
+            }
+
+            return get_bucket_size(get_bucket_index(mapping_size)) == mapping_size;
+        }
+
+        // 2^log2 < size <= 2^(log2+1) , then find which quarter of that range the size is in
+        static std::size_t get_bucket_index(std::size_t size)
+        {
+            std::size_t log2 = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size - 1)));
+            return ((log2 - LOG2_MIN_OBJECT_SIZE) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+        }
+
+        static std::size_t get_bucket_size(std::size_t bucket_index)
+        {
+            std::size_t log2 = LOG2_MIN_OBJECT_SIZE + (bucket_index >> 2);
+            return (static_cast<std::size_t>(1) << log2) + ((bucket_index & 3) + 1) * (static_cast<std::size_t>(1) << (log2 - 2));
+        }
+
+        // Should be called while holding the lock of the bucket. Removes expired mappings and the oldest ones that exceed the count from the bottom of the stack
+        std::size_t remove_expired_mappings(Bucket& bucket, uint64_t now, std::size_t capacity, CachedMapping* released_mappings, std::size_t mapping_size)
+        {
+            std::size_t released_mapping_count = bucket.m_mapping_count > capacity ? bucket.m_mapping_count - capacity : 0;
+
+            if (m_decay_period > 0)
+            {
+                while (released_mapping_count < bucket.m_mapping_count && bucket.m_mappings[released_mapping_count].m_cache_time + m_decay_period <= now)
+                {
+                    released_mapping_count++;
+                }
+            }
+
+            if (released_mapping_count == 0)
+            {
+                return 0;
+            }
+
+            for (std::size_t i = 0; i < released_mapping_count; i++)
+            {
+                released_mappings[i] = bucket.m_mappings[i];
+            }
+
+            for (std::size_t i = released_mapping_count; i < bucket.m_mapping_count; i++)
+            {
+                bucket.m_mappings[i - released_mapping_count] = bucket.m_mappings[i];
+            }
+
+            bucket.m_mapping_count -= released_mapping_count;
+            m_cached_size.fetch_sub(released_mapping_count * mapping_size, std::memory_order_relaxed);
+
+            return released_mapping_count;
+        }
+
+        void release_mappings(CachedMapping* mappings, std::size_t count, std::size_t mapping_size)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                VirtualMemory::deallocate(mappings[i].m_address, mapping_size);
+            }
+        }
+
+        // Only one thread sweeps per decay period
+        void sweep_if_needed(uint64_t now)
+        {
+            if (m_decay_period == 0)
+            {
+                return;
+            }
+
+            uint64_t next_sweep_time = m_next_sweep_time.load(std::memory_order_relaxed);
+
+            if (llmalloc_likely(now < next_sweep_time))
+            {
+                return;
+            }
+
+            if (m_next_sweep_time.compare_exchange_strong(next_sweep_time, now + m_decay_period, std::memory_order_relaxed))
+            {
+                release_expired_mappings();
+            }
+        }
+};
\ No newline at end of file
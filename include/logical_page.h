@@ -1,11 +1,18 @@
 /*
     - IT IS A FIRST-IN-LAST-OUT FREELIST IMPLEMENTATION. IT CAN HOLD ONLY ONE SIZE CLASS.
 
+    - NEVER USED CHUNKS ARE NOT THREADED TO THE FREELIST AT CREATION. THEY ARE CARVED FROM THE END OF THE BUFFER WITH A BUMP POINTER WHEN THE FREELIST IS EMPTY ,
+      so creating a logical page doesn't touch its memory
+
+    - NOT THREAD SAFE EXCEPT deallocate_remotely WHICH CAN BE CALLED FROM ANY THREAD. REMOTELY FREED CHUNKS ARE PUSHED TO A SEPARATE LOCK FREE STACK
+      AND THEY BECOME AVAILABLE TO THE OWNER AFTER reclaim_remote_frees
+
     - IF THE PASSED BUFFER IS START OF A VIRTUAL PAGE AND THE PASSED SIZE IS A VM PAGE SIZE , THEN IT WILL BE CORRESPONDING TO AN ACTUAL VM PAGE
       IDEAL USE CASE IS ITS CORRESPONDING TO A VM PAGE / BEING VM PAGE ALIGNED. SO THAT A SINGLE PAYLOAD WILL NOT SPREAD TO DIFFERENT VM PAGES.
 */
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include "compiler/unused.h"
@@ -59,18 +66,17 @@ class LogicalPage
             }
 
             #ifndef UNIT_TEST
-            // Segment should place us to a start of aligned vm page + size of header
-            void* buffer_start_including_header = reinterpret_cast<void*>(reinterpret_cast<std::size_t>(buffer) - sizeof(*this));
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(buffer_start_including_header) == true, "LogicalPage : Segments or heaps should pass buffers which are aligned to OS page allocation granularity.");
-            LLMALLOC_UNUSED(buffer_start_including_header);
+            // Segment should place us to a start of aligned vm page , chunks can start later than the end of the header due to cache coloring
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(this) == true, "LogicalPage : Segments or heaps should place logical pages to addresses which are aligned to OS page allocation granularity.");
+            llmalloc_assert_msg(reinterpret_cast<std::size_t>(buffer) >= reinterpret_cast<std::size_t>(this) + sizeof(*this), "LogicalPage : Chunks can't overlap with the logical page header.");
             #endif
 
             this->m_page_header.initialise();
             this->m_page_header.m_size_class = size_class;
             this->m_page_header.m_logical_page_start_address = reinterpret_cast<uint64_t>(buffer);
-            this->m_page_header.m_logical_page_size = buffer_size;
-
-            grow(buffer, buffer_size);
+            this->m_page_header.m_logical_page_size = static_cast<uint32_t>(buffer_size);
+            // Bump pointer starts from the end of the last whole chunk
+            this->m_page_header.m_last_used_node = reinterpret_cast<uint64_t>(buffer) + (buffer_size / size_class) * size_class;
 
             return true;
         }
@@ -84,7 +90,37 @@ class LogicalPage
 
             if (llmalloc_unlikely(free_node == nullptr))
             {
-                return nullptr;
+                free_node = carve();
+
+                if (free_node == nullptr)
+                {
+                    return nullptr;
+                }
+            }
+
+            this->m_page_header.m_used_size += this->m_page_header.m_size_class;
+
+            return  reinterpret_cast<void*>(free_node);
+        }
+
+        // Also reports whether the chunk is known to be zeroed. That is the case for never used chunks unless the page is dirty , as segments get their memory fresh from the OS
+        void* allocate(const std::size_t size, bool& is_zeroed)
+        {
+            LLMALLOC_UNUSED(size);
+
+            NodeType* free_node = pop();
+            is_zeroed = false;
+
+            if (llmalloc_unlikely(free_node == nullptr))
+            {
+                free_node = carve();
+
+                if (free_node == nullptr)
+                {
+                    return nullptr;
+                }
+
+                is_zeroed = is_dirty() == false; // Carved chunks were never written
             }
 
             this->m_page_header.m_used_size += this->m_page_header.m_size_class;
@@ -92,6 +128,42 @@ class LogicalPage
             return  reinterpret_cast<void*>(free_node);
         }
 
+        // Pops up to count chunks in one pass and updates the header once , returns the number of popped chunks
+        std::size_t allocate_batch(const std::size_t size, std::size_t count, void** out)
+        {
+            LLMALLOC_UNUSED(size);
+
+            std::size_t allocated{ 0 };
+
+            while (allocated < count)
+            {
+                NodeType* free_node = pop();
+
+                if (llmalloc_unlikely(free_node == nullptr))
+                {
+                    break;
+                }
+
+                out[allocated++] = reinterpret_cast<void*>(free_node);
+            }
+
+            while (allocated < count)
+            {
+                NodeType* free_node = carve();
+
+                if (free_node == nullptr)
+                {
+                    break;
+                }
+
+                out[allocated++] = reinterpret_cast<void*>(free_node);
+            }
+
+            this->m_page_header.m_used_size += static_cast<uint32_t>(allocated * this->m_page_header.m_size_class);
+
+            return allocated;
+        }
+
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
         void deallocate(void* ptr)
         {
@@ -99,19 +171,110 @@ class LogicalPage
             push(static_cast<NodeType*>(ptr));
         }
 
+        // Can be called from any thread
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* ptr)
+        {
+            deallocate_remotely(ptr, ptr);
+        }
+
+        // Can be called from any thread , pushes an already linked chain of chunks ( first->...->last ) with a single CAS
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* first, void* last)
+        {
+            deallocate_remotely(first, last, []() {});
+        }
+
+        // Same as above , on_first_remote_free is called before pushing to an empty stack. The logical page can't be recycled at that point
+        // as the chain is not pushed yet , so the callback can publish the logical page to its owner
+        template <typename Callback>
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* first, void* last, Callback&& on_first_remote_free)
+        {
+            auto remote_free_head = get_remote_free_head();
+            NodeType* last_node = static_cast<NodeType*>(last);
+            uint64_t old_head = remote_free_head->load(std::memory_order_relaxed);
+            bool notified = false;
+
+            do
+            {
+                if (llmalloc_unlikely(old_head == 0 && notified == false))
+                {
+                    on_first_remote_free();
+                    notified = true;
+                }
+
+                last_node->m_next = reinterpret_cast<NodeType*>(old_head);
+            }
+            while (!remote_free_head->compare_exchange_weak(old_head, reinterpret_cast<uint64_t>(first), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Should be called by the owner , moves remotely freed chunks to the freelist. Returns false if there was none
+        bool reclaim_remote_frees()
+        {
+            auto remote_free_head = get_remote_free_head();
+
+            if (llmalloc_likely(remote_free_head->load(std::memory_order_relaxed) == 0))
+            {
+                return false;
+            }
+
+            // Taking the whole stack at once so no ABA risk
+            NodeType* iter = reinterpret_cast<NodeType*>(remote_free_head->exchange(0, std::memory_order_acquire));
+
+            while (iter)
+            {
+                NodeType* next = iter->m_next;
+                deallocate(iter);
+                iter = next;
+            }
+
+            return true;
+        }
+
         std::size_t get_usable_size(void* ptr) 
         { 
             LLMALLOC_UNUSED(ptr);
             return  static_cast<std::size_t>(this->m_page_header.m_size_class); 
         }
 
+        // Returns start address of the chunk that holds the passed address
+        LLMALLOC_FORCE_INLINE void* get_chunk_start_address(void* ptr) const
+        {
+            uint64_t start = m_page_header.m_logical_page_start_address;
+            uint64_t size_class = static_cast<uint64_t>(m_page_header.m_size_class);
+            uint64_t offset = reinterpret_cast<uint64_t>(ptr) - start;
+
+            if (llmalloc_likely((size_class & (size_class - 1)) == 0))
+            {
+                offset &= ~(size_class - 1);
+            }
+            else
+            {
+                offset = (offset / size_class) * size_class; // Non pow2 size classes , see size_classes.h
+            }
+
+            return reinterpret_cast<void*>(start + offset);
+        }
+
         bool can_be_recycled() { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_USED>() == false; }
 
         void mark_as_used() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_USED>();  }
         void mark_as_non_used() { m_page_header.clear_flag<LogicalPageHeaderFlags::IS_USED>(); }
 
+        bool is_full() const { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+        void mark_as_full() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+        void mark_as_non_full() { m_page_header.clear_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+
+        bool is_dirty() const { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_DIRTY>(); }
+        void mark_as_dirty() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_DIRTY>(); }
+
         uint64_t get_used_size() const { return m_page_header.m_used_size; }
         uint32_t get_size_class() { return m_page_header.m_size_class; }
+
+        // Bytes of chunks handed out at least once , never used ones are below the bump pointer
+        uint64_t get_carved_size() const
+        {
+            auto chunks_end = m_page_header.m_logical_page_start_address + (m_page_header.m_logical_page_size / m_page_header.m_size_class) * m_page_header.m_size_class;
+            return chunks_end - m_page_header.m_last_used_node;
+        }
         
         uint16_t get_segment_id() { return m_page_header.m_segment_id; }
         void set_segment_id(const uint16_t id) { m_page_header.m_segment_id = id; }
@@ -130,15 +293,24 @@ class LogicalPage
 
         LogicalPageHeader m_page_header;
 
-        void grow(void* buffer, std::size_t buffer_size)
+        // Taking address of a packed member directly would trigger unaligned pointer warnings , the field itself is 8 byte aligned
+        LLMALLOC_FORCE_INLINE std::atomic<uint64_t>* get_remote_free_head()
         {
-            const std::size_t chunk_count = buffer_size / this->m_page_header.m_size_class;
+            static_assert(offsetof(LogicalPageHeader, m_remote_free_head) % sizeof(uint64_t) == 0);
+            static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t));
+            return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(&m_page_header) + offsetof(LogicalPageHeader, m_remote_free_head));
+        }
 
-            for (std::size_t i = 0; i < chunk_count; ++i)
+        // Hands out never used chunks in descending address order , returns nullptr if all chunks were handed out at least once
+        LLMALLOC_FORCE_INLINE NodeType* carve()
+        {
+            if (llmalloc_unlikely(this->m_page_header.m_last_used_node - this->m_page_header.m_logical_page_start_address < this->m_page_header.m_size_class))
             {
-                std::size_t address = reinterpret_cast<std::size_t>(buffer) + i * this->m_page_header.m_size_class;
-                push(reinterpret_cast<NodeType*>(address));
+                return nullptr;
             }
+
+            this->m_page_header.m_last_used_node -= this->m_page_header.m_size_class;
+            return reinterpret_cast<NodeType*>(this->m_page_header.m_last_used_node);
         }
 
         LLMALLOC_FORCE_INLINE void push(NodeType* new_node)
@@ -3,7 +3,7 @@
     LOGICAL PAGE HEADERS WILL BE PLACED TO THE FIRST 64 BYTES OF EVERY LOGICAL PAGE
 
     PAHOLE OUTPUT :
-                            size: 64, cachelines: 1, members: 10
+                            size: 64, cachelines: 1, members: 11
                             last cacheline: 64 bytes
 */
 #pragma once
@@ -13,7 +13,9 @@
 
 enum class LogicalPageHeaderFlags : uint16_t
 {
-    IS_USED = 0x0001
+    IS_USED = 0x0001,
+    IS_FULL = 0x0002,   // Set by segments when they move the logical page behind the ones which have free chunks
+    IS_DIRTY = 0x0004   // Set by segments when the logical page is built on a reused page , so its never used chunks may not be zeroed
 };
 
 LLMALLOC_PACKED
@@ -26,18 +28,20 @@ LLMALLOC_PACKED
         uint64_t m_next_logical_page_ptr;  // To be used by an upper layer abstraction (ex: segment span etc ) to navigate between logical pages
         // 8 BYTES
         uint64_t m_prev_logical_page_ptr;  // Same as above
-        // 2 BYTES
-        uint16_t m_page_flags;             // See enum class LogicalPageHeaderFlags
-        // 4 BYTES
-        uint32_t m_size_class;             // Used to distinguish non-big size class pages, since logical pages won't be holding objects > page size, 2 bytes will be sufficient
         // 8 BYTES
-        uint64_t m_used_size;
+        uint64_t m_remote_free_head;       // Freelist of chunks freed by non-owner threads, accessed atomically therefore it has to stay 8 byte aligned
         // 8 BYTES
         uint64_t m_logical_page_start_address;
         // 8 BYTES
-        uint64_t m_logical_page_size;
-        // 8 BYTES
-        uint64_t m_last_used_node;
+        uint64_t m_last_used_node;         // Bump pointer , lowest chunk address handed out so far. Chunks below it have never been used and are not in the freelist
+        // 4 BYTES
+        uint32_t m_used_size;              // Logical pages are at most 1GB huge pages
+        // 4 BYTES
+        uint32_t m_logical_page_size;
+        // 4 BYTES
+        uint32_t m_size_class;             // Used to distinguish non-big size class pages, since logical pages won't be holding objects > page size, 2 bytes will be sufficient
+        // 2 BYTES
+        uint16_t m_page_flags;             // See enum class LogicalPageHeaderFlags
         // 2 BYTES
         uint16_t m_segment_id;
 
@@ -49,12 +53,13 @@ LLMALLOC_PACKED
             m_head = 0;
             m_next_logical_page_ptr = 0;
             m_prev_logical_page_ptr = 0;
-            m_page_flags = 0;
-            m_size_class = 0;
-            m_used_size = 0;
+            m_remote_free_head = 0;
             m_logical_page_start_address = 0;
-            m_logical_page_size = 0;
             m_last_used_node = 0;
+            m_used_size = 0;
+            m_logical_page_size = 0;
+            m_size_class = 0;
+            m_page_flags = 0;
             m_segment_id = 0;
         }
 
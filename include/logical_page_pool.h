@@ -0,0 +1,194 @@
+/*
+    - HOLDS EMPTIED LOGICAL PAGES OF A HEAP SO THAT SEGMENTS OF ANY SIZE CLASS CAN GROW INTO THEM BEFORE ASKING THE ARENA FOR NEW MEMORY.
+      Logical pages of all size classes that share a logical page size can be pooled together as segments recreate them with LogicalPage::create
+
+    - PAGES ARE LINKED THROUGH THEIR OWN FIRST BYTES AND THE MOST RECENTLY ADDED PAGE IS REUSED FIRST AS ITS MEMORY IS MORE LIKELY TO BE IN CACHES
+
+    - HYSTERESIS : WHEN AN ADDED PAGE EXCEEDS THE CAPACITY , THE POOL RELEASES ITS OLDER HALF TO THE OS.
+      So that a heap hovering around its page recycling thresholds doesn't map and unmap a page on every swing
+
+    - POOLED PAGES ARE NOT ZEROED. SEGMENTS MARK LOGICAL PAGES BUILT ON THEM AS DIRTY
+
+    - THREAD SAFE AS SEGMENTS OF A CENTRAL HEAP ARE LOCKED SEPARATELY. IT IS ACCESSED ONLY IN SEGMENT SLOW PATHS
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "os/assert_msg.h"
+#include "utilities/lockable.h"
+
+#include "arena.h"
+#include "page_purger.h"
+
+class LogicalPagePool : public Lockable<LockPolicy::USERSPACE_LOCK>
+{
+    public:
+
+        LogicalPagePool() = default;
+
+        ~LogicalPagePool()
+        {
+            destroy();
+        }
+
+        LogicalPagePool(const LogicalPagePool& other) = delete;
+        LogicalPagePool& operator= (const LogicalPagePool& other) = delete;
+        LogicalPagePool(LogicalPagePool&& other) = delete;
+        LogicalPagePool& operator=(LogicalPagePool&& other) = delete;
+
+        // Capacity is in logical pages , 0 disables pooling. Released pages go to the page purger if specified , otherwise to the arena
+        [[nodiscard]] bool create(std::size_t logical_page_size, std::size_t capacity, Arena* arena, PagePurger* page_purger = nullptr)
+        {
+            if (logical_page_size < sizeof(PooledPage) || arena == nullptr)
+            {
+                return false;
+            }
+
+            m_logical_page_size = logical_page_size;
+            m_capacity = capacity;
+            m_arena = arena;
+            m_page_purger = page_purger;
+
+            return true;
+        }
+
+        // Returns false if pooling is disabled , the caller should release the page then
+        bool add(void* address)
+        {
+            if (m_capacity == 0)
+            {
+                return false;
+            }
+
+            PooledPage* page = static_cast<PooledPage*>(address);
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            page->m_next = m_head;
+            m_head = page;
+            m_page_count++;
+
+            PooledPage* pages_to_release = nullptr;
+
+            if (m_page_count > m_capacity)
+            {
+                pages_to_release = detach_older_half();
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            // Releasing outside of the lock as it may enter the kernel
+            release_pages(pages_to_release);
+
+            return true;
+        }
+
+        // Returns nullptr if the pool is empty
+        void* get()
+        {
+            PooledPage* page = nullptr;
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            page = m_head;
+
+            if (page)
+            {
+                m_head = page->m_next;
+                m_page_count--;
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return page;
+        }
+
+        // Releases all pooled pages directly to the arena , ex: for malloc_trim
+        void release_all()
+        {
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            PooledPage* pages = m_head;
+            m_head = nullptr;
+            m_page_count = 0;
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            release_pages(pages, false);
+        }
+
+        std::size_t get_page_count() const { return m_page_count; }
+        std::size_t get_logical_page_size() const { return m_logical_page_size; }
+
+    private:
+
+        struct PooledPage
+        {
+            PooledPage* m_next;
+        };
+
+        PooledPage* m_head = nullptr;   // Most recently added first
+        std::size_t m_page_count = 0;
+        std::size_t m_capacity = 0;
+        std::size_t m_logical_page_size = 0;
+        Arena* m_arena = nullptr;
+        PagePurger* m_page_purger = nullptr;
+
+        // Keeps the most recently added half , returns the rest as a linked list
+        PooledPage* detach_older_half()
+        {
+            std::size_t kept_count = m_capacity / 2;
+
+            if (kept_count == 0)
+            {
+                PooledPage* ret = m_head;
+                m_head = nullptr;
+                m_page_count = 0;
+                return ret;
+            }
+
+            PooledPage* last_kept = m_head;
+
+            for (std::size_t i = 1; i < kept_count; i++)
+            {
+                last_kept = last_kept->m_next;
+            }
+
+            PooledPage* ret = last_kept->m_next;
+            last_kept->m_next = nullptr;
+            m_page_count = kept_count;
+
+            return ret;
+        }
+
+        void release_pages(PooledPage* page, bool use_page_purger = true)
+        {
+            while (page)
+            {
+                PooledPage* next = page->m_next;
+
+                if (m_page_purger && use_page_purger)
+                {
+                    m_page_purger->add(page, m_logical_page_size, m_arena);
+                }
+                else
+                {
+                    m_arena->release_to_system(page, m_logical_page_size);
+                }
+
+                page = next;
+            }
+        }
+
+        void destroy()
+        {
+            PooledPage* pages = m_head;
+            m_head = nullptr;
+            m_page_count = 0;
+
+            // Like segments , going directly to the arena on destruction
+            release_pages(pages, false);
+        }
+};
@@ -1,6 +1,9 @@
 /*  
     Standard C++ thread_local keyword does not allow you to specify thread specific destructors
-    and also can't be applied to class members
+    and also can't be applied to non-static class members
+
+    Therefore this class is used only for getting thread exit callbacks. Hot paths should cache their per thread data in
+    LLMALLOC_THREAD_LOCAL variables which won't cost a function call unlike pthread_getspecific/FlsGetValue
 */
 #pragma once
 
@@ -13,6 +16,14 @@
 #include <fibersapi.h>
 #endif // VOLTRON_EXCLUDE
 
+// Initial-exec TLS model resolves thread locals with a single fs-relative load instead of __tls_get_addr calls in shared objects.
+// It is safe only for executables and shared objects loaded at startup ( LD_PRELOAD ) as dlopen'ed libraries may fail to load with it
+#if defined(__GNUC__) && defined(ENABLE_INITIAL_EXEC_TLS)
+#define LLMALLOC_THREAD_LOCAL thread_local __attribute__((tls_model("initial-exec")))
+#else
+#define LLMALLOC_THREAD_LOCAL thread_local
+#endif
+
 class ThreadLocalStorage
 {
     public:
@@ -5,6 +5,10 @@
                 static unsigned int get_number_of_physical_cores()
                 static bool is_hyper_threading()
                 static inline void yield()
+                static bool create_detached_thread(ThreadFunction function, void* argument)
+                static void set_current_thread_priority_to_low()
+                static bool register_fork_handlers(ForkHandler prepare, ForkHandler parent, ForkHandler child)
+                static bool issue_process_wide_memory_barrier()
 
 */
 #pragma once
@@ -13,6 +17,9 @@
 #include <pthread.h>
 #include <sched.h>
 #include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
 #include <fcntl.h>
 #include <time.h>
 #elif _WIN32            // VOLTRON_EXCLUDE
@@ -34,6 +41,14 @@ class ThreadUtilities
 {
     public:
 
+        #ifdef __linux__
+        using ThreadFunction = void* (*)(void*);
+        #elif _WIN32
+        using ThreadFunction = LPTHREAD_START_ROUTINE;
+        #endif
+
+        using ForkHandler = void (*)();
+
         static unsigned int get_number_of_logical_cores()
         {
             unsigned int num_cores{0};
@@ -106,5 +121,79 @@ class ThreadUtilities
             #endif
         }
 
+        // Avoids std::thread as it allocates
+        static bool create_detached_thread(ThreadFunction function, void* argument)
+        {
+            bool ret = false;
+            #ifdef __linux__
+            pthread_attr_t attributes;
+
+            if (pthread_attr_init(&attributes) != 0)
+            {
+                return false;
+            }
+
+            pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+            pthread_t thread;
+            ret = pthread_create(&thread, &attributes, function, argument) == 0;
+
+            pthread_attr_destroy(&attributes);
+            #elif _WIN32
+            HANDLE thread = CreateThread(nullptr, 0, function, argument, 0, nullptr);
+
+            if (thread != nullptr)
+            {
+                CloseHandle(thread);
+                ret = true;
+            }
+            #endif
+            return ret;
+        }
+
+        // Lowers the priority within the normal scheduling policy , unlike SCHED_IDLE the thread can't be starved by busy threads
+        static void set_current_thread_priority_to_low()
+        {
+            #ifdef __linux__
+            // Nice values are per thread on Linux
+            setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), LOW_PRIORITY_NICE_VALUE);
+            #elif _WIN32
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+            #endif
+        }
+
+        // Handlers run around fork calls , the child one runs in the child process. No-op on Windows as there is no fork
+        static bool register_fork_handlers(ForkHandler prepare, ForkHandler parent, ForkHandler child)
+        {
+            #ifdef __linux__
+            return pthread_atfork(prepare, parent, child) == 0;
+            #elif _WIN32
+            return true;
+            #endif
+        }
+
+        // Executes a full memory barrier on all running threads of the process , so that the other side of a Dekker style handshake can use only compiler barriers
+        static bool issue_process_wide_memory_barrier()
+        {
+            #ifdef __linux__
+            if (syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0)
+            {
+                return true;
+            }
+
+            // Needs Linux 4.14 and a registration once per process
+            if (syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) != 0)
+            {
+                return false;
+            }
+
+            return syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0;
+            #elif _WIN32
+            FlushProcessWriteBuffers();
+            return true;
+            #endif
+        }
+
     private:
+        static constexpr int LOW_PRIORITY_NICE_VALUE = 10;
 };
\ No newline at end of file
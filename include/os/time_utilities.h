@@ -0,0 +1,47 @@
+/*
+    Provides :
+
+                static uint64_t get_monotonic_time_in_milliseconds()
+                static void sleep_in_milliseconds(uint64_t milliseconds)
+
+*/
+#pragma once
+
+#ifdef __linux__        // VOLTRON_EXCLUDE
+#include <time.h>
+#elif _WIN32            // VOLTRON_EXCLUDE
+#include <windows.h>
+#endif                    // VOLTRON_EXCLUDE
+
+#include <cstdint>
+
+class TimeUtilities
+{
+    public:
+
+        // Coarse clocks are enough for decay periods and they don't need a syscall ( vDSO on Linux )
+        static uint64_t get_monotonic_time_in_milliseconds()
+        {
+            uint64_t ret{ 0 };
+            #ifdef __linux__
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            ret = static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+            #elif _WIN32
+            ret = static_cast<uint64_t>(GetTickCount64());
+            #endif
+            return ret;
+        }
+
+        static void sleep_in_milliseconds(uint64_t milliseconds)
+        {
+            #ifdef __linux__
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(milliseconds / 1000);
+            ts.tv_nsec = static_cast<long>((milliseconds % 1000) * 1000000);
+            nanosleep(&ts, nullptr);
+            #elif _WIN32
+            Sleep(static_cast<DWORD>(milliseconds));
+            #endif
+        }
+};
\ No newline at end of file
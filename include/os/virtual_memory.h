@@ -253,7 +253,120 @@ class VirtualMemory
             #endif
             return ret;
         }
-        
+
+        // Returns physical pages of a range while keeping it mapped. With lazy discards the OS reclaims them only under memory pressure
+        // Linux : MADV_DONTNEED pages read back as zeroes , MADV_FREE ( lazy ) pages may keep their old contents
+        // Windows : MEM_RESET in both cases , contents are undefined
+        static bool discard(void* address, std::size_t size, bool lazy)
+        {
+            bool ret{ false };
+            #ifdef __linux__
+            #ifdef MADV_FREE
+            if (lazy && madvise(address, size, MADV_FREE) == 0)
+            {
+                return true;
+            }
+            #else
+            LLMALLOC_UNUSED(lazy);
+            #endif
+            // Kernels older than 4.5 don't support MADV_FREE
+            ret = madvise(address, size, MADV_DONTNEED) == 0 ? true : false;
+            #elif _WIN32
+            LLMALLOC_UNUSED(lazy);
+            ret = VirtualAlloc(address, size, MEM_RESET, PAGE_READWRITE) != nullptr ? true : false;
+            #endif
+            return ret;
+        }
+
+        // Whether pages read back as zeroes after a discard
+        static bool are_discarded_pages_zeroed(bool lazy)
+        {
+            #ifdef __linux__
+            return lazy == false;
+            #elif _WIN32
+            LLMALLOC_UNUSED(lazy);
+            return false;
+            #endif
+        }
+
+        // Resizes a mapping which may move to another address. Returns nullptr on failure and when not supported ( Windows has no mremap equivalent )
+        // Contents are preserved up to the smaller size and the old mapping becomes invalid on success
+        static void* reallocate(void* address, std::size_t old_size, std::size_t new_size)
+        {
+            void* ret{ nullptr };
+            #ifdef __linux__
+            ret = mremap(address, old_size, new_size, MREMAP_MAYMOVE);
+
+            if (ret == MAP_FAILED)
+            {
+                ret = nullptr;
+            }
+            #elif _WIN32
+            LLMALLOC_UNUSED(address);
+            LLMALLOC_UNUSED(old_size);
+            LLMALLOC_UNUSED(new_size);
+            #endif
+            return ret;
+        }
+
+        // Reserves address space without committing memory. Pages can't be accessed before they are committed and they can be released with deallocate
+        static void* reserve(std::size_t size, void* hint_address = nullptr)
+        {
+            void* ret = nullptr;
+            #ifdef __linux__
+            // MAP_NORESERVE so that reservations are not accounted against overcommit limits
+            ret = mmap(hint_address, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+            if (ret == MAP_FAILED)
+            {
+                ret = nullptr;
+            }
+            #elif _WIN32
+            ret = VirtualAlloc(hint_address, size, MEM_RESERVE, PAGE_NOACCESS);
+            #endif
+            return ret;
+        }
+
+        // Commits pages of a reserved range. They come zeroed and get backed by physical memory on first touch unless they are prefaulted
+        static bool commit(void* address, std::size_t size, bool prefault)
+        {
+            bool ret{ false };
+            #ifdef __linux__
+            ret = mprotect(address, size, PROT_READ | PROT_WRITE) == 0 ? true : false;
+            #elif _WIN32
+            ret = VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr ? true : false;
+            #endif
+
+            if (ret && prefault)
+            {
+                VirtualMemory::prefault(address, size);
+            }
+
+            return ret;
+        }
+
+        // Equivalent of MAP_POPULATE for already mapped ranges. Should be called only for committed pages which are not handed out yet
+        static void prefault(void* address, std::size_t size)
+        {
+            #ifdef __linux__
+            constexpr int MADV_POPULATE_WRITE_ADVICE = 23; // MADV_POPULATE_WRITE , Linux 5.14+
+
+            if (madvise(address, size, MADV_POPULATE_WRITE_ADVICE) == 0)
+            {
+                return;
+            }
+            #endif
+
+            // Older kernels and Windows , touching a byte per page
+            auto page_size = get_page_size();
+
+            for (std::size_t offset = 0; offset < size; offset += page_size)
+            {
+                volatile char* page = static_cast<volatile char*>(address) + offset;
+                *page = *page;
+            }
+        }
+
         #ifdef __linux__
         // THP stands for "transparent huge page". A Linux mechanism
         // It affects how we handle allocation of huge pages on Linux
@@ -0,0 +1,210 @@
+/*
+    - COLLECTS EMPTIED LOGICAL PAGES FROM SEGMENTS AND RELEASES THEM TO THE OS AFTER A DECAY PERIOD , SO THAT THREADS CALLING FREE DON'T ENTER THE KERNEL
+
+    - ANY THREAD CAN ADD PAGES WITH A SINGLE CAS. PAGES ARE LINKED THROUGH THEIR OWN FIRST BYTES AS THEY ARE NO LONGER USED BY ANY HEAP
+
+    - purge IS MEANT TO BE CALLED PERIODICALLY BY A LOW PRIORITY BACKGROUND THREAD. IT RELEASES EXPIRED PAGES OLDEST FIRST UP TO A BYTE BUDGET PER CALL
+      so that releases and TLB shootdowns are rate limited
+
+    - IF PENDING PAGES EXCEED A BOUND , THE ADDING THREAD RELEASES THE OLDEST ONES ITSELF REGARDLESS OF THEIR DECAY.
+      So pages don't pile up when the background thread doesn't get CPU time or doesn't exist , ex: in a child process before its thread is restarted
+
+    - PAGES CAN BE ADDED WITH THEIR ARENAS SO THAT THEY ARE RELEASED ACCORDING TO THE ARENA'S PAGE RELEASE POLICY. Otherwise they are unmapped
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "compiler/hints_branch_predictor.h"
+#include "os/assert_msg.h"
+#include "os/virtual_memory.h"
+#include "os/time_utilities.h"
+#include "utilities/userspace_spinlock.h"
+#include "arena.h"
+
+struct PagePurgerOptions
+{
+    uint64_t decay_period = 1000;               // In milliseconds , pages are released at least this long after they were added
+    std::size_t max_bytes_per_purge = 67108864; // Release budget per purge call , 0 means no limit
+    std::size_t max_pending_size = 268435456;   // Adding threads release pages synchronously beyond this , 0 means no limit
+};
+
+class PagePurger
+{
+    public:
+
+        PagePurger() = default;
+        ~PagePurger() = default;
+
+        PagePurger(const PagePurger& other) = delete;
+        PagePurger& operator= (const PagePurger& other) = delete;
+        PagePurger(PagePurger&& other) = delete;
+        PagePurger& operator=(PagePurger&& other) = delete;
+
+        bool create(const PagePurgerOptions& options)
+        {
+            m_decay_period = options.decay_period;
+            m_max_bytes_per_purge = options.max_bytes_per_purge;
+            m_max_pending_size = options.max_pending_size;
+            m_lock.initialise();
+            return true;
+        }
+
+        // Can be called from any thread , the page should not be accessed by anything else afterwards
+        void add(void* address, std::size_t size, Arena* arena = nullptr)
+        {
+            llmalloc_assert_msg(size >= sizeof(DirtyPage), "PagePurger: Pages should be big enough to hold their links.");
+
+            DirtyPage* page = static_cast<DirtyPage*>(address);
+            page->m_size = size;
+            page->m_add_time = TimeUtilities::get_monotonic_time_in_milliseconds();
+            page->m_arena = arena;
+
+            DirtyPage* old_head = m_incoming_pages.load(std::memory_order_relaxed);
+
+            do
+            {
+                page->m_next = old_head;
+            }
+            while (!m_incoming_pages.compare_exchange_weak(old_head, page, std::memory_order_release, std::memory_order_relaxed));
+
+            std::size_t pending_size = m_pending_size.fetch_add(size, std::memory_order_relaxed) + size;
+
+            if (m_max_pending_size > 0 && pending_size > m_max_pending_size)
+            {
+                release_excess_pages();
+            }
+        }
+
+        // Returns released bytes. If ignore_decay is true , all pages are released without any budget
+        std::size_t purge(bool ignore_decay = false)
+        {
+            std::size_t released_size{ 0 };
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+
+            m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            collect_incoming_pages();
+
+            while (m_oldest_page)
+            {
+                if (ignore_decay == false)
+                {
+                    if (m_oldest_page->m_add_time + m_decay_period > now)
+                    {
+                        break; // The rest is newer
+                    }
+
+                    if (m_max_bytes_per_purge > 0 && released_size + m_oldest_page->m_size > m_max_bytes_per_purge && released_size > 0)
+                    {
+                        break;
+                    }
+                }
+
+                released_size += release_oldest_page();
+            }
+            ////////////////////////////////////////////////////////////////////
+            m_lock.unlock();
+
+            m_pending_size.fetch_sub(released_size, std::memory_order_relaxed);
+
+            return released_size;
+        }
+
+        std::size_t get_pending_size() const { return m_pending_size.load(std::memory_order_relaxed); }
+
+    private:
+
+        struct DirtyPage
+        {
+            DirtyPage* m_next;
+            std::size_t m_size;
+            uint64_t m_add_time;
+            Arena* m_arena;
+        };
+
+        std::atomic<DirtyPage*> m_incoming_pages = nullptr;   // Newest first
+        std::atomic<std::size_t> m_pending_size = 0;
+        DirtyPage* m_oldest_page = nullptr;                   // Oldest first , accessed only under the lock
+        DirtyPage* m_newest_page = nullptr;
+        UserspaceSpinlock<> m_lock;
+        uint64_t m_decay_period = 1000;
+        std::size_t m_max_bytes_per_purge = 0;
+        std::size_t m_max_pending_size = 0;
+
+        // Takes all incoming pages with a single exchange and appends them to the pending list in the order they were added
+        void collect_incoming_pages()
+        {
+            DirtyPage* iter = m_incoming_pages.exchange(nullptr, std::memory_order_acquire);
+            DirtyPage* oldest_incoming = nullptr;
+            DirtyPage* newest_incoming = iter;
+
+            while (iter)
+            {
+                DirtyPage* next = iter->m_next;
+                iter->m_next = oldest_incoming;
+                oldest_incoming = iter;
+                iter = next;
+            }
+
+            if (oldest_incoming == nullptr)
+            {
+                return;
+            }
+
+            if (m_newest_page)
+            {
+                m_newest_page->m_next = oldest_incoming;
+            }
+            else
+            {
+                m_oldest_page = oldest_incoming;
+            }
+
+            m_newest_page = newest_incoming;
+        }
+
+        // Should be called under the lock
+        std::size_t release_oldest_page()
+        {
+            DirtyPage* page = m_oldest_page;
+            std::size_t page_size = page->m_size;
+            m_oldest_page = page->m_next;
+
+            if (m_oldest_page == nullptr)
+            {
+                m_newest_page = nullptr;
+            }
+
+            if (page->m_arena)
+            {
+                page->m_arena->release_to_system(page, page_size);
+            }
+            else
+            {
+                VirtualMemory::deallocate(page, page_size);
+            }
+
+            return page_size;
+        }
+
+        // Releases oldest pages until the pending size is within the bound. Skipped if another thread is already purging
+        void release_excess_pages()
+        {
+            if (m_lock.try_lock() == false)
+            {
+                return;
+            }
+            ////////////////////////////////////////////////////////////////////
+            collect_incoming_pages();
+
+            while (m_oldest_page && m_pending_size.load(std::memory_order_relaxed) > m_max_pending_size)
+            {
+                m_pending_size.fetch_sub(release_oldest_page(), std::memory_order_relaxed);
+            }
+            ////////////////////////////////////////////////////////////////////
+            m_lock.unlock();
+        }
+};
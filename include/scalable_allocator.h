@@ -4,23 +4,44 @@
     - ALLOCATIONS INITIALLY WILL BE FROM LOCAL ( EITHER THREAD LOCAL ) HEAPS. IF LOCAL HEAPS ARE EXHAUSTED , THEN CENTRAL HEAP WILL BE USED.
 
     - USES CONFIGURABLE METADATA ( DEFAULT 256KB ) TO STORE THREAD LOCAL HEAPS. ALSO INITIALLY USES 64KB METADATA TO STORE THE CENTRAL HEAP
+
+    - TRIMS AND USAGE QUERIES ASK THREAD LOCAL HEAPS OF OTHER THREADS TO TRIM THEMSELVES OR TO PUBLISH THEIR SIZES IN THEIR NEXT ALLOCATIONS ,
+      and their usages are reported as of their last snapshots. Snapshot requests are rate limited
+
+    - WITH ENABLE_EXTERNAL_HEAP_ACCESS , TRIMS AND USAGE QUERIES HANDLE THREAD LOCAL HEAPS OF OTHER THREADS DIRECTLY IF THEIR OWNERS ARE OUTSIDE OF THE ALLOCATOR , ex: blocked threads.
+      Owners mark their calls with plain stores and the querying thread issues a process wide memory barrier , so fast paths don't pay for fences.
+      Owners calling the allocator meanwhile wait until the query or the trim finishes. It is opt-in as every call pays for the marking
+
+    - HEAPS OF EXITED THREADS ARE KEPT AS IDLE HEAPS WITH THEIR LOGICAL PAGES AND HANDED TO NEW THREADS BEFORE CREATING NEW HEAPS.
+      So thread churn neither grows memory nor exhausts the metadata buffer. Idle heaps are trimmed and measured directly as no thread owns them
+
+    - BACKGROUND THREADS OF WRAPPERS , EX: THE PURGING THREAD OF SCALABLE MALLOC , ENCLOSE THEIR WORK WITH enter/leave_background_task.
+      Shutdown sets the shutdown flag so that they stop , and waits for the ones in progress before destroying heaps
+
+    - WITH ENABLE_STATS , HEAPS COUNT THEIR EVENTS PER SIZE CLASS. Counters are only aggregated when get_stats is called , page sizes follow the same snapshot scheme as used sizes
 */
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
 #include "compiler/hints_hot_code.h"
 #include "compiler/hints_branch_predictor.h"
+#include "compiler/unused.h"
 
 #include "cpu/alignment_constants.h"
 #include "os/thread_local_storage.h"
+#include "os/thread_utilities.h"
+#include "os/time_utilities.h"
 
 #include "utilities/alignment_and_size_utils.h"
 #include "utilities/lockable.h"
 
 #include "arena.h"
+#include "bin_stats.h"
 
 #ifdef ENABLE_PERF_TRACES // VOLTRON_EXCLUDE
 #include <cstdio>
@@ -33,6 +54,15 @@ public:
 
     using ArenaType = Arena;
 
+    static constexpr std::size_t DEFAULT_METADATA_BUFFER_SIZE = 262144; // 256KB
+
+    struct Stats
+    {
+        std::array<BinStats, LocalHeapType::BIN_COUNT> bins; // Central and thread local heaps together
+        std::size_t central_heap_fallback_count = 0;        // Allocations served by the central heap as the thread local heap was exhausted or not available
+        std::size_t arena_chunk_build_count = 0;
+    };
+
     // THIS CLASS IS INTENDED TO BE USED DIRECTLY IN MALLOC REPLACEMENTS
     // SINCE THIS ONE IS A TEMPLATE CLASS , WE HAVE TO ENSURE A SINGLE ONLY STATIC VARIABLE INITIALISATION
     LLMALLOC_FORCE_INLINE  static ScalableAllocator& get_instance()
@@ -41,7 +71,7 @@ public:
         return instance;
     }
 
-    [[nodiscard]] bool create(const typename CentralHeapType::HeapCreationParams& params_central, const typename LocalHeapType::HeapCreationParams& params_local, const ArenaOptions& arena_options, std::size_t metadata_buffer_size = 262144)
+    [[nodiscard]] bool create(const typename CentralHeapType::HeapCreationParams& params_central, const typename LocalHeapType::HeapCreationParams& params_local, const ArenaOptions& arena_options, std::size_t metadata_buffer_size = DEFAULT_METADATA_BUFFER_SIZE)
     {
         if (arena_options.cache_capacity <= 0 || arena_options.page_alignment <= 0 || metadata_buffer_size <= 0 || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(arena_options.page_alignment) || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(metadata_buffer_size))
         {
@@ -108,7 +138,9 @@ public:
 
         if (local_heap != nullptr)
         {
+            local_heap->enter_owner_call();
             ret = local_heap->allocate(size);
+            local_heap->leave_owner_call();
         }
 
         if (ret == nullptr)
@@ -118,6 +150,10 @@ public:
             fprintf(stderr, "\033[0;31m" "scalable allocator , central heap hit count=%zu , sizeclass=%zu\n" "\033[0m", m_central_heap_hit_count, size);
             #endif
 
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, 1);
+            #endif
+
             //If the local one is exhausted , failover to the central one
             ret = m_central_heap->allocate(size);
         }
@@ -125,6 +161,32 @@ public:
         return ret;
     }
 
+    // Same as allocate , also reports whether the returned memory is known to be zeroed so that callers can skip zeroing it
+    [[nodiscard]] void* allocate(const std::size_t size, bool& is_zeroed)
+    {
+        void* ret{ nullptr };
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            ret = local_heap->allocate(size, is_zeroed);
+            local_heap->leave_owner_call();
+        }
+
+        if (ret == nullptr)
+        {
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, 1);
+            #endif
+
+            //If the local one is exhausted , failover to the central one
+            ret = m_central_heap->allocate(size, is_zeroed);
+        }
+
+        return ret;
+    }
+
     LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
     void deallocate(void* ptr, bool is_small_object = true)
     {
@@ -134,7 +196,9 @@ public:
 
         if (local_heap != nullptr)
         {
+            local_heap->enter_owner_call();
             returned_to_local_heap = local_heap->deallocate(ptr, is_small_object);
+            local_heap->leave_owner_call();
         }
 
         if(returned_to_local_heap == false)
@@ -143,11 +207,203 @@ public:
         }
     }
 
+    // Resolves the thread local heap once for all objects , returns the number of allocated objects
+    std::size_t allocate_batch(const std::size_t size, std::size_t count, void** out)
+    {
+        std::size_t allocated{ 0 };
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            allocated = local_heap->allocate_batch(size, count, out);
+            local_heap->leave_owner_call();
+        }
+
+        if (allocated < count)
+        {
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, count - allocated);
+            #endif
+
+            //If the local one is exhausted , failover to the central one
+            allocated += m_central_heap->allocate_batch(size, count - allocated, out + allocated);
+        }
+
+        return allocated;
+    }
+
+    void deallocate_batch(void** ptrs, std::size_t count, bool is_small_object = true)
+    {
+        std::size_t deallocated{ 0 };
+        auto local_heap = get_thread_local_heap();
+
+        while (deallocated < count)
+        {
+            if (local_heap != nullptr)
+            {
+                local_heap->enter_owner_call();
+                deallocated += local_heap->deallocate_batch(ptrs + deallocated, count - deallocated, is_small_object);
+                local_heap->leave_owner_call();
+            }
+
+            if (deallocated < count)
+            {
+                // Rejected by the local heap , only that one goes to the central heap and the rest is tried locally again
+                m_central_heap->deallocate(ptrs[deallocated], is_small_object);
+                deallocated++;
+            }
+        }
+    }
+
+    // Returns memory of empty logical pages to the arena , see the notes at the top for thread local heaps of other threads
+    void trim()
+    {
+        auto own_heap = m_thread_local_heap;
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        flush_deallocation_queues(own_heap);
+
+        for_each_local_heap([this, own_heap](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->trim();
+            }
+            else
+            {
+                local_heap->request_trim();
+            }
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
+        m_central_heap->trim();
+    }
+
+    // Used size includes chunks waiting in deallocation queues. Pooled size is the size of emptied logical pages kept by heaps
+    void get_heap_usage(std::size_t& used_size, std::size_t& pooled_size)
+    {
+        auto own_heap = m_thread_local_heap;
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        flush_deallocation_queues(own_heap);
+
+        used_size = m_central_heap->get_used_size();
+        pooled_size = m_central_heap->get_pooled_size();
+        bool can_request_snapshots = can_request_snapshots_now();
+
+        for_each_local_heap([this, own_heap, can_request_snapshots, &used_size, &pooled_size](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                used_size += local_heap->get_used_size();
+            }
+            else
+            {
+                used_size += local_heap->get_published_used_size();
+
+                if (can_request_snapshots)
+                {
+                    local_heap->request_used_size_snapshot();
+                }
+            }
+
+            pooled_size += local_heap->get_pooled_size();
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+    }
+
+    // Counters are zero without ENABLE_STATS , see the notes at the top for page sizes of thread local heaps of other threads
+    void get_stats(Stats& stats)
+    {
+        stats = Stats();
+
+        if (m_initialised_successfully.load() == false)
+        {
+            return;
+        }
+
+        auto own_heap = m_thread_local_heap;
+
+        m_central_heap->publish_page_sizes();
+
+        for (std::size_t i = 0; i < CentralHeapType::BIN_COUNT; i++)
+        {
+            m_central_heap->add_bin_stats(i, stats.bins[i]);
+        }
+
+        stats.central_heap_fallback_count = m_central_heap->get_central_heap_fallback_count();
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        bool can_request_snapshots = can_request_snapshots_now();
+
+        for_each_local_heap([this, own_heap, can_request_snapshots, &stats](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->publish_page_sizes();
+            }
+            else if (can_request_snapshots)
+            {
+                local_heap->request_page_sizes_snapshot();
+            }
+
+            for (std::size_t i = 0; i < LocalHeapType::BIN_COUNT; i++)
+            {
+                local_heap->add_bin_stats(i, stats.bins[i]);
+            }
+
+            stats.central_heap_fallback_count += local_heap->get_central_heap_fallback_count();
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
+        #ifdef ENABLE_STATS
+        stats.arena_chunk_build_count = m_objects_arena.get_built_chunk_count();
+        #endif
+    }
+
+    // Returns false after shutdown started , the task should not run and the thread should exit
+    bool enter_background_task()
+    {
+        m_background_task_count.fetch_add(1);
+
+        if (m_shutdown_started.load() == true)
+        {
+            m_background_task_count.fetch_sub(1);
+            return false;
+        }
+
+        return true;
+    }
+
+    void leave_background_task()
+    {
+        m_background_task_count.fetch_sub(1);
+    }
+
     CentralHeapType* get_central_heap() { return m_central_heap; }
+    ArenaType* get_arena() { return &m_objects_arena; }
 
     #ifdef UNIT_TEST
     std::size_t get_observed_unique_thread_count() const { return m_observed_unique_thread_count; }
     std::size_t get_max_thread_local_heap_count() const { return m_max_thread_local_heap_count; }
+    std::size_t get_active_local_heap_count() const { return m_active_local_heap_count; }
+    std::size_t get_idle_local_heap_count() const { return m_idle_local_heap_count; }
     #endif
 
 private:
@@ -155,15 +411,22 @@ private:
     CentralHeapType* m_central_heap = nullptr;
     ArenaType m_objects_arena;
     char* m_metadata_buffer = nullptr;
-    std::size_t m_metadata_buffer_size = 262144;       // Default 256KB
-    std::size_t m_active_local_heap_count = 0;
+    std::size_t m_metadata_buffer_size = DEFAULT_METADATA_BUFFER_SIZE;
+    std::size_t m_active_local_heap_count = 0;        // Heaps handed to threads so far , including idle ones
     std::size_t m_max_thread_local_heap_count = 0;    // Used for only thread local heaps
     std::size_t m_cached_thread_local_heap_count = 0; // Used for only thread local heaps , its number of available passive heaps
+    LocalHeapType** m_idle_local_heaps = nullptr;     // Heaps of exited threads , used as a LIFO so that the most recently used pages are reused first
+    std::size_t m_idle_local_heap_count = 0;
+    std::size_t m_idle_local_heaps_buffer_size = 0;
     bool m_fast_shutdown = true;
     typename LocalHeapType::HeapCreationParams m_local_heap_creation_params;
 
     static inline std::atomic<bool> m_initialised_successfully = false;
     static inline std::atomic<bool> m_shutdown_started = false;
+    std::atomic<std::size_t> m_background_task_count = 0;
+    uint64_t m_last_snapshot_request_time = 0; // Accessed only in the concurrent context
+    static constexpr uint64_t SNAPSHOT_REQUEST_INTERVAL = 100; // Milliseconds
+    static inline LLMALLOC_THREAD_LOCAL LocalHeapType* m_thread_local_heap = nullptr;
 
     #ifdef UNIT_TEST
     std::size_t m_observed_unique_thread_count = 0;
@@ -179,6 +442,9 @@ private:
 
     ~ScalableAllocator()
     {
+        // Stops background threads also in fast shutdowns , no need to move logical pages between heaps either
+        m_shutdown_started.store(true);
+
         if(m_fast_shutdown)
         {
             return;
@@ -186,8 +452,11 @@ private:
 
         if(m_initialised_successfully.load() == true )
         {
-            // We call it here it in case not called earlier and there are still running threads which are not destructed , no need to move logical pages between heaps
-            m_shutdown_started.store(true);
+            // Background tasks which entered before the flag was set may still be touching heap memory
+            while (m_background_task_count.load() > 0)
+            {
+                ThreadUtilities::yield();
+            }
 
             destroy_heaps();
 
@@ -202,21 +471,128 @@ private:
     
     static void thread_specific_destructor(void* arg)
     {
-        if(get_instance().get_enable_fast_shutdown() == false)
+        // Same as the pthread key/FLS value which is cleared before this callback, further allocations of this thread will get a heap again
+        m_thread_local_heap = nullptr;
+
+        if( m_initialised_successfully.load() == true && m_shutdown_started.load() == false )
         {
-            if( m_initialised_successfully.load() == true && m_shutdown_started.load() == false )
+            // The heap keeps its logical pages and its deallocation queues , the next thread starts with warm pages
+            get_instance().add_idle_local_heap(reinterpret_cast<LocalHeapType*>(arg));
+        }
+    }
+
+    // Should be called in the concurrent context. With ENABLE_EXTERNAL_HEAP_ACCESS , owners of other threads' heaps which are outside of the allocator can't enter
+    // until release_local_heaps , so those heaps become accessible. A single process wide barrier covers all heaps
+    void acquire_local_heaps(LocalHeapType* own_heap)
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        bool has_other_heaps = false;
+
+        for_each_local_heap([this, own_heap, &has_other_heaps](LocalHeapType* local_heap)
+        {
+            if (local_heap != own_heap && is_idle_local_heap(local_heap) == false)
             {
-                auto central_heap = get_instance().get_central_heap();
-                auto segment_count = CentralHeapType::get_segment_count();
+                local_heap->begin_external_access();
+                has_other_heaps = true;
+            }
+        });
 
-                auto thread_local_heap = reinterpret_cast<LocalHeapType*>(arg);
+        if (has_other_heaps == false)
+        {
+            return;
+        }
 
-                for(std::size_t i =0; i<segment_count; i++)
-                {
-                    central_heap->get_segment(i)->transfer_logical_pages_from( thread_local_heap->get_segment(i)->get_head_logical_page() );
-                }
+        bool barrier_issued = ThreadUtilities::issue_process_wide_memory_barrier();
+
+        for_each_local_heap([barrier_issued](LocalHeapType* local_heap)
+        {
+            if (local_heap->is_externally_accessed() && (barrier_issued == false || local_heap->is_owner_in_call()))
+            {
+                local_heap->end_external_access(); // Its owner is inside the allocator , it can only serve requests
+            }
+        });
+        #else
+        LLMALLOC_UNUSED(own_heap);
+        #endif
+    }
+
+    // Should be called in the concurrent context
+    void release_local_heaps()
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        for_each_local_heap([](LocalHeapType* local_heap)
+        {
+            if (local_heap->is_externally_accessed())
+            {
+                local_heap->end_external_access();
             }
+        });
+        #endif
+    }
+
+    // Should be called in the concurrent context after acquire_local_heaps
+    bool is_accessible_local_heap(LocalHeapType* local_heap, LocalHeapType* own_heap) const
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        if (local_heap->is_externally_accessed())
+        {
+            return true;
         }
+        #endif
+
+        return local_heap == own_heap || is_idle_local_heap(local_heap);
+    }
+
+    // Should be called in the concurrent context. Snapshot requests make owners walk all their segments , so they are rate limited
+    bool can_request_snapshots_now()
+    {
+        uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+
+        if (m_last_snapshot_request_time != 0 && now - m_last_snapshot_request_time < SNAPSHOT_REQUEST_INTERVAL)
+        {
+            return false;
+        }
+
+        m_last_snapshot_request_time = now;
+        return true;
+    }
+
+    // Should be called in the concurrent context after acquire_local_heaps.
+    // Flushing can free chunks remotely to logical pages of other heaps , so queues of all accessible heaps are flushed before any of them is measured or trimmed
+    void flush_deallocation_queues(LocalHeapType* own_heap)
+    {
+        m_central_heap->flush_deallocation_queues();
+
+        for_each_local_heap([this, own_heap](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->flush_deallocation_queues();
+            }
+        });
+    }
+
+    void add_idle_local_heap(LocalHeapType* local_heap)
+    {
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        m_idle_local_heaps[m_idle_local_heap_count++] = local_heap;
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+    }
+
+    // Should be called in the concurrent context
+    bool is_idle_local_heap(LocalHeapType* local_heap) const
+    {
+        for (std::size_t i = 0; i < m_idle_local_heap_count; i++)
+        {
+            if (m_idle_local_heaps[i] == local_heap)
+            {
+                return true;
+            }
+        }
+
+        return false;
     }
 
     std::size_t get_created_heap_count()
@@ -225,6 +601,33 @@ private:
         return heap_count;
     }
 
+    #ifdef ENABLE_STATS
+    // Counted per heap so that thread local heaps are the only writers of their counters , get_stats adds them up
+    void count_central_heap_fallbacks(LocalHeapType* local_heap, std::size_t count)
+    {
+        if (local_heap != nullptr)
+        {
+            local_heap->count_central_heap_fallbacks(count);
+        }
+        else
+        {
+            m_central_heap->count_central_heap_fallbacks(count);
+        }
+    }
+    #endif
+
+    // Should be called in the concurrent context
+    template <typename Function>
+    void for_each_local_heap(Function function)
+    {
+        auto heap_count = get_created_heap_count();
+
+        for (std::size_t i = 0; i < heap_count; i++)
+        {
+            function(reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (i * sizeof(LocalHeapType))));
+        }
+    }
+
     void destroy_heaps()
     {
         if (m_metadata_buffer)
@@ -244,6 +647,11 @@ private:
         {
             ArenaType::MetadataAllocator::deallocate(m_central_heap_buffer, 65536);
         }
+
+        if (m_idle_local_heaps)
+        {
+            ArenaType::MetadataAllocator::deallocate(m_idle_local_heaps, m_idle_local_heaps_buffer_size);
+        }
     }
 
     LocalHeapType* get_thread_local_heap()
@@ -253,22 +661,40 @@ private:
 
     LLMALLOC_FORCE_INLINE LocalHeapType* get_thread_local_heap_internal()
     {
-        auto thread_local_heap = reinterpret_cast<LocalHeapType*>(ThreadLocalStorage::get_instance().get());
+        // Fast path : a single TLS load , ThreadLocalStorage is used only to get thread exit callbacks
+        auto thread_local_heap = m_thread_local_heap;
 
-        if (thread_local_heap == nullptr)
+        if (llmalloc_likely(thread_local_heap != nullptr))
         {
-            // LOCKING HERE WILL HAPPEN ONLY ONCE FOR EACH THREAD , AT THEIR START
-            // AS THERE ARE SHARED VARIABLES FOR THREAD-LOCAL HEAP CREATION
-            this->enter_concurrent_context();
+            return thread_local_heap;
+        }
 
-            #ifdef UNIT_TEST
-            m_observed_unique_thread_count++;
-            #endif
+        return get_thread_local_heap_by_assigning();
+    }
 
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Slow path removal function
+    LocalHeapType* get_thread_local_heap_by_assigning()
+    {
+        LocalHeapType* thread_local_heap = nullptr;
+
+        // LOCKING HERE WILL HAPPEN ONLY ONCE FOR EACH THREAD , AT THEIR START
+        // AS THERE ARE SHARED VARIABLES FOR THREAD-LOCAL HEAP CREATION
+        this->enter_concurrent_context();
+
+        #ifdef UNIT_TEST
+        m_observed_unique_thread_count++;
+        #endif
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        if (m_idle_local_heap_count > 0)
+        {
+            thread_local_heap = m_idle_local_heaps[--m_idle_local_heap_count];
+        }
+        else
+        {
             if (m_active_local_heap_count + 1 >= m_max_thread_local_heap_count)
             {
-                // If we are here , it means that metadata buffer size is not sufficient to handle all threads of the application
+                // If we are here , it means that metadata buffer size is not sufficient to handle all running threads of the application
                 this->leave_concurrent_context();
                 return nullptr;
             }
@@ -283,11 +709,13 @@ private:
             }
 
             m_active_local_heap_count++;
-            ThreadLocalStorage::get_instance().set(thread_local_heap);
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-            this->leave_concurrent_context();
         }
 
+        ThreadLocalStorage::get_instance().set(thread_local_heap); // Needed for the thread exit callback
+        m_thread_local_heap = thread_local_heap;
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
         return thread_local_heap;
     }
 
@@ -305,6 +733,14 @@ private:
             m_cached_thread_local_heap_count = m_max_thread_local_heap_count;
         }
 
+        m_idle_local_heaps_buffer_size = AlignmentAndSizeUtils::get_next_pow2_multiple_of(m_max_thread_local_heap_count * sizeof(LocalHeapType*), VirtualMemory::PAGE_ALLOCATION_GRANULARITY);
+        m_idle_local_heaps = reinterpret_cast<LocalHeapType**>(ArenaType::MetadataAllocator::allocate(m_idle_local_heaps_buffer_size));
+
+        if (m_idle_local_heaps == nullptr)
+        {
+            return false;
+        }
+
         for (std::size_t i{ 0 }; i < m_cached_thread_local_heap_count; i++)
         {
             auto local_heap = create_local_heap(i);
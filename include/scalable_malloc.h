@@ -14,16 +14,21 @@
 
 #include "utilities/alignment_and_size_utils.h"
 #include "utilities/bounded_queue.h"
-#include "utilities/mpmc_bounded_queue.h"
+#include "utilities/intrusive_lifo_queue.h"
+#include "utilities/mpmc_pointer_queue.h"
 #include "utilities/mpmc_dictionary.h"
+#include "utilities/page_map.h"
 #include "utilities/userspace_spinlock.h"
 #include "utilities/lockable.h"
 
 #include "arena.h"
 #include "heap_pow2.h"
+#include "large_object_cache.h"
+#include "page_purger.h"
 #include "scalable_allocator.h"
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <new>
 
@@ -31,34 +36,68 @@ struct ScalableMallocOptions
 {
     // SIZE AND CAPACITIES
     std::size_t arena_initial_size = 2147483648;
+    bool arena_commit_on_demand = false; // Opt-in , arena is reserved and committed in chunks as it is used rather than populating all of it at startup
+    std::size_t arena_commit_chunk_size = 2097152;
+    bool arena_prefault_commits = true; // Committed chunks are prefaulted , latency critical uses avoid page faults while memory footprint grows only by chunks
     std::size_t central_logical_page_counts_per_size_class[HeapPow2<>::BIN_COUNT] = {1,1,1,1,1,1,1,2,4,8,16,32,8,16,32};
     std::size_t local_logical_page_counts_per_size_class[HeapPow2<>::BIN_COUNT] = {1,1,1,1,1,1,1,2,4,8,16,32,8,16,32};
     // RECYCLING & GROWING
     std::size_t page_recycling_threshold = 10;
+    PageReleasePolicy page_release_policy = PageReleasePolicy::UNMAP; // Recycled logical pages can be discarded with madvise and kept in the arena for later grows
+    std::size_t logical_page_pool_capacity = 16; // Per heap , recycled small object logical pages are kept for bins of any size class before being released , 0 disables
     bool local_heaps_can_grow = true;
     double grow_coefficient = 2.0;
+    std::size_t cache_color_count = 1; // Chunks of consecutive logical pages start at different cache line offsets , 1 disables coloring
     // DEALLOCATION QUEUES
     std::size_t deallocation_queues_processing_threshold = 409600;
+    // Queue sizes apply only to the central heap , thread local heaps link freed chunks through themselves without any capacity limit
     std::size_t recyclable_deallocation_queue_sizes[HeapPow2<>::BIN_COUNT] = {65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536};
     std::size_t non_recyclable_deallocation_queue_sizes[HeapPow2<>::BIN_COUNT] = {65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536};
+    bool use_remote_free_lists = false; // Cross thread frees go back to the logical pages of their owner heaps , costs a CAS per cross thread free
+    // REALLOCATIONS
+    double reallocation_shrink_ratio = 0.5; // Reallocations move objects to new chunks if the new size is below this fraction of the current capacity , 0 disables
+    // LARGE OBJECT CACHE
+    std::size_t large_object_cache_max_object_size = 33554432; // Freed mappings of large objects up to this size are cached for reuse , 0 disables the cache
+    std::size_t large_object_cache_capacity = 67108864; // Byte budget of all cached mappings
+    std::size_t large_object_cache_decay_period = 1000; // Cached mappings are released to the OS after this many milliseconds , 0 disables the decay
+    // BACKGROUND PURGING
+    bool background_purging = false; // Recycled logical pages are released by a low priority thread after a decay period instead of inside free calls
+    std::size_t background_purging_decay_period = 1000; // In milliseconds
+    std::size_t background_purging_max_bytes_per_period = 67108864; // Rate limit of releases , 0 means no limit
+    std::size_t background_purging_max_pending_size = 268435456; // Freeing threads release pages themselves beyond this , 0 means no limit
     // OTHERS
     bool use_huge_pages = false;
     int numa_node=-1;
     std::size_t thread_local_cached_heap_count = 0;
     #ifndef USE_ALLOC_HEADERS
-    std::size_t non_small_and_aligned_objects_map_size = 655360; // Applies to no alloc headers
+    std::size_t non_small_and_aligned_objects_map_size = 655360; // Applies to no alloc headers, holds only large objects as others are found via the page map
     #endif
 
     ScalableMallocOptions()
     {
         // SIZE AND CAPACITIES
         arena_initial_size = EnvironmentVariable::get_variable("llmalloc_arena_initial_size", arena_initial_size); // Default 2 GB      
+
+        int numeric_arena_commit_on_demand = EnvironmentVariable::get_variable("llmalloc_arena_commit_on_demand", 0);
+        arena_commit_on_demand = numeric_arena_commit_on_demand == 1 ? true : false;
+
+        arena_commit_chunk_size = EnvironmentVariable::get_variable("llmalloc_arena_commit_chunk_size", arena_commit_chunk_size);
+
+        int numeric_arena_prefault_commits = EnvironmentVariable::get_variable("llmalloc_arena_prefault_commits", 1);
+        arena_prefault_commits = numeric_arena_prefault_commits == 1 ? true : false;
+
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(local_logical_page_counts_per_size_class, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_local_logical_page_counts_per_size_class", "1,1,1,1,1,1,1,2,4,8,16,32,8,16,32"));
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(central_logical_page_counts_per_size_class, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_central_logical_page_counts_per_size_class", "1,1,1,1,1,1,1,2,4,8,16,32,8,16,32"));
 
         // RECYCLING & GROWING
         page_recycling_threshold = EnvironmentVariable::get_variable("llmalloc_page_recycling_threshold", page_recycling_threshold);
+
+        int numeric_page_release_policy = EnvironmentVariable::get_variable("llmalloc_page_release_policy", 0);
+        page_release_policy = numeric_page_release_policy == 2 ? PageReleasePolicy::ADVISE_FREE : (numeric_page_release_policy == 1 ? PageReleasePolicy::ADVISE_DONTNEED : PageReleasePolicy::UNMAP);
+
+        logical_page_pool_capacity = EnvironmentVariable::get_variable("llmalloc_logical_page_pool_capacity", logical_page_pool_capacity);
         grow_coefficient = EnvironmentVariable::get_variable("llmalloc_grow_coefficient", grow_coefficient);
+        cache_color_count = EnvironmentVariable::get_variable("llmalloc_cache_color_count", cache_color_count);
 
         int numeric_local_heaps_can_grow = EnvironmentVariable::get_variable("llmalloc_local_heaps_can_grow", 1);
         local_heaps_can_grow = numeric_local_heaps_can_grow == 1 ? true : false;
@@ -68,6 +107,25 @@ struct ScalableMallocOptions
         
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(recyclable_deallocation_queue_sizes, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_recyclable_deallocation_queue_sizes", "65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536"));
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(non_recyclable_deallocation_queue_sizes, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_non_recyclable_deallocation_queue_sizes", "65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536"));
+
+        int numeric_use_remote_free_lists = EnvironmentVariable::get_variable("llmalloc_use_remote_free_lists", 0);
+        use_remote_free_lists = numeric_use_remote_free_lists == 1 ? true : false;
+
+        // REALLOCATIONS
+        reallocation_shrink_ratio = EnvironmentVariable::get_variable("llmalloc_reallocation_shrink_ratio", reallocation_shrink_ratio);
+
+        // LARGE OBJECT CACHE
+        large_object_cache_max_object_size = EnvironmentVariable::get_variable("llmalloc_large_object_cache_max_object_size", large_object_cache_max_object_size);
+        large_object_cache_capacity = EnvironmentVariable::get_variable("llmalloc_large_object_cache_capacity", large_object_cache_capacity);
+        large_object_cache_decay_period = EnvironmentVariable::get_variable("llmalloc_large_object_cache_decay_period", large_object_cache_decay_period);
+
+        // BACKGROUND PURGING
+        int numeric_background_purging = EnvironmentVariable::get_variable("llmalloc_background_purging", 0);
+        background_purging = numeric_background_purging == 1 ? true : false;
+
+        background_purging_decay_period = EnvironmentVariable::get_variable("llmalloc_background_purging_decay_period", background_purging_decay_period);
+        background_purging_max_bytes_per_period = EnvironmentVariable::get_variable("llmalloc_background_purging_max_bytes_per_period", background_purging_max_bytes_per_period);
+        background_purging_max_pending_size = EnvironmentVariable::get_variable("llmalloc_background_purging_max_pending_size", background_purging_max_pending_size);
         
         // OTHERS
         thread_local_cached_heap_count = EnvironmentVariable::get_variable("llmalloc_thread_local_cached_heap_count", thread_local_cached_heap_count);
@@ -88,6 +146,16 @@ struct ScalableMallocOptions
     }
 };
 
+// Reported by get_memory_usage , see mallinfo2 in scalable_malloc_overrides.h for the mapping to mallinfo fields
+struct MemoryUsage
+{
+    std::size_t heap_size = 0;              // Memory heaps received from the arena , including pooled logical pages and pages waiting to be purged
+    std::size_t heap_used_size = 0;         // Chunks handed out by heaps , including chunks waiting in deallocation queues
+    std::size_t retained_size = 0;          // Releasable memory : pooled logical pages , pages waiting to be purged and cached large object mappings
+    std::size_t large_object_count = 0;     // Live large objects , each one has its own mapping
+    std::size_t large_object_size = 0;
+};
+
 LLMALLOC_PACKED
 (
     struct AllocationMetadata
@@ -102,10 +170,16 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
     public:
 
         using ArenaType = Arena;
-        using CentralHeapType = HeapPow2<MPMCBoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
-        using LocalHeapType = HeapPow2<BoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::NO_LOCK>;
+        #ifdef USE_QUARTER_POW2_SIZE_CLASSES
+        using CentralHeapType = HeapQuarterPow2<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using LocalHeapType = HeapQuarterPow2<IntrusiveLIFOQueue<uint64_t>, LockPolicy::NO_LOCK>;
+        #else
+        using CentralHeapType = HeapPow2<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using LocalHeapType = HeapPow2<IntrusiveLIFOQueue<uint64_t>, LockPolicy::NO_LOCK>;
+        #endif
         using ScalableMallocType = ScalableAllocator<CentralHeapType, LocalHeapType>;
         using HashmapType = MPMCDictionary<uint64_t, AllocationMetadata, typename ArenaType::MetadataAllocator>;
+        using Stats = typename ScalableMallocType::Stats;
 
         LLMALLOC_FORCE_INLINE static ScalableMalloc& get_instance()
         {
@@ -113,10 +187,41 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             return instance;
         }
 
-        bool create(ScalableMallocOptions options = ScalableMallocOptions())
+        // Background threads can be started later with start_background_threads , ex: if create is called inside the very first malloc call
+        bool create(ScalableMallocOptions options = ScalableMallocOptions(), bool start_background_threads_now = true)
         {
-            m_max_allocation_size = HeapPow2<>::get_max_allocation_size();
-            m_max_small_object_size = HeapPow2<>::get_max_small_object_size();
+            m_max_allocation_size = LocalHeapType::get_max_allocation_size();
+            m_max_small_object_size = LocalHeapType::get_max_small_object_size();
+            m_reallocation_shrink_ratio = options.reallocation_shrink_ratio;
+
+            LargeObjectCacheOptions large_object_cache_options;
+            large_object_cache_options.max_object_size = options.large_object_cache_max_object_size;
+            large_object_cache_options.capacity = options.large_object_cache_capacity;
+            large_object_cache_options.decay_period = options.large_object_cache_decay_period;
+            large_object_cache_options.background_sweeping = options.background_purging; // The purging thread sweeps the cache
+
+            if (m_large_object_cache.create(large_object_cache_options) == false)
+            {
+                return false;
+            }
+
+            m_background_purging = options.background_purging;
+            m_background_purging_period = options.background_purging_decay_period / 2 > MIN_BACKGROUND_PURGING_PERIOD ? options.background_purging_decay_period / 2 : MIN_BACKGROUND_PURGING_PERIOD;
+
+            if (m_background_purging)
+            {
+                PagePurgerOptions page_purger_options;
+                page_purger_options.decay_period = options.background_purging_decay_period;
+                page_purger_options.max_bytes_per_purge = options.background_purging_max_bytes_per_period;
+                page_purger_options.max_pending_size = options.background_purging_max_pending_size;
+
+                if (m_page_purger.create(page_purger_options) == false)
+                {
+                    return false;
+                }
+
+                m_background_thread_lock.initialise();
+            }
 
             ///////////////////////////////////////////////////////////////
             // CREATE SCALABLE ALLOCATOR INSTANCE
@@ -124,22 +229,30 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             local_heap_params.page_recycling_threshold_per_size_class = options.page_recycling_threshold;
             local_heap_params.segments_can_grow = options.local_heaps_can_grow;
             local_heap_params.segment_grow_coefficient = options.grow_coefficient;
+            local_heap_params.cache_color_count = options.cache_color_count;
+            local_heap_params.logical_page_pool_capacity = options.logical_page_pool_capacity;
             local_heap_params.deallocation_queues_processing_threshold = options.deallocation_queues_processing_threshold;
+            local_heap_params.use_remote_free_lists = options.use_remote_free_lists;
+            local_heap_params.page_purger = m_background_purging ? &m_page_purger : nullptr;
 
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < LocalHeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 local_heap_params.logical_page_counts[i] = options.local_logical_page_counts_per_size_class[i];
                 local_heap_params.recyclable_deallocation_queue_sizes[i] = options.recyclable_deallocation_queue_sizes[i];
-                local_heap_params.non_recyclable_deallocation_queue_sizes[i] = options.non_recyclable_deallocation_queue_sizes[i];
+                local_heap_params.non_recyclable_deallocation_queue_sizes[i] = options.use_remote_free_lists ? 0 : options.non_recyclable_deallocation_queue_sizes[i]; // Not used with remote free lists
             }
 
             typename CentralHeapType::HeapCreationParams central_heap_params;
             central_heap_params.page_recycling_threshold_per_size_class = options.page_recycling_threshold;
             central_heap_params.segments_can_grow = true;
             central_heap_params.segment_grow_coefficient = options.grow_coefficient;
+            central_heap_params.cache_color_count = options.cache_color_count;
+            central_heap_params.logical_page_pool_capacity = options.logical_page_pool_capacity;
             central_heap_params.deallocation_queues_processing_threshold = options.deallocation_queues_processing_threshold;
+            central_heap_params.use_remote_free_lists = options.use_remote_free_lists;
+            central_heap_params.page_purger = m_background_purging ? &m_page_purger : nullptr;
 
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < CentralHeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 central_heap_params.logical_page_counts[i] = options.central_logical_page_counts_per_size_class[i];
                 central_heap_params.recyclable_deallocation_queue_sizes[i] = options.recyclable_deallocation_queue_sizes[i];
@@ -150,6 +263,10 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             arena_options.cache_capacity = options.arena_initial_size;
             arena_options.use_huge_pages = options.use_huge_pages;
             arena_options.numa_node = options.numa_node;
+            arena_options.commit_on_demand = options.arena_commit_on_demand;
+            arena_options.commit_chunk_size = options.arena_commit_chunk_size;
+            arena_options.prefault_commits = options.arena_prefault_commits;
+            arena_options.page_release_policy = options.page_release_policy;
             
             if(options.use_huge_pages == true)
             {
@@ -167,15 +284,61 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             ScalableMallocType::get_instance().set_thread_local_heap_cache_count(options.thread_local_cached_heap_count);
 
             #ifndef USE_ALLOC_HEADERS
-            m_small_object_logical_page_size = local_heap_params.small_object_logical_page_size;
+            m_small_object_logical_page_size_shift = static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(local_heap_params.small_object_logical_page_size)));
+            m_medium_object_logical_page_size_shift = static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(local_heap_params.medium_object_logical_page_size)));
+
+            if( m_large_objects_map.initialise( options.non_small_and_aligned_objects_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
+            {
+                return false;
+            }
 
-            if( m_non_small_and_aligned_objects_map.initialise( options.non_small_and_aligned_objects_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
+            if (m_page_map.initialise() == false)
             {
                 return false;
             }
+
+            local_heap_params.page_map = &m_page_map;
+            central_heap_params.page_map = &m_page_map;
             #endif
 
-            return ScalableMallocType::get_instance().create(central_heap_params, local_heap_params, arena_options);
+            // Heaps with more size classes are bigger , scaling the metadata buffer keeps the max thread local heap count same as the pow2 build
+            std::size_t metadata_buffer_size = ScalableMallocType::DEFAULT_METADATA_BUFFER_SIZE * ((sizeof(LocalHeapType) + sizeof(HeapPow2<>) - 1) / sizeof(HeapPow2<>));
+
+            if (ScalableMallocType::get_instance().create(central_heap_params, local_heap_params, arena_options, metadata_buffer_size) == false)
+            {
+                return false;
+            }
+
+            return start_background_threads_now ? start_background_threads() : true;
+        }
+
+        // Starts the background purging thread if enabled , should be called when malloc calls can be served as creating a thread allocates
+        bool start_background_threads()
+        {
+            if (m_background_purging == false)
+            {
+                return true;
+            }
+
+            bool expected = false;
+
+            if (m_background_threads_started.compare_exchange_strong(expected, true) == false)
+            {
+                return true;
+            }
+
+            // Children inherit the handlers , so they are registered only once
+            if (m_fork_handlers_registered == false)
+            {
+                if (ThreadUtilities::register_fork_handlers(&ScalableMalloc::on_fork_prepare, &ScalableMalloc::on_fork_parent, &ScalableMalloc::on_fork_child) == false)
+                {
+                    return false;
+                }
+
+                m_fork_handlers_registered = true;
+            }
+
+            return ThreadUtilities::create_detached_thread(&ScalableMalloc::background_purging_thread_function, this);
         }
 
         #ifndef USE_ALLOC_HEADERS
@@ -189,85 +352,247 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             void* ptr = ScalableMallocType::get_instance().allocate(size);
 
-            if(llmalloc_unlikely(size > m_max_small_object_size))
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
+            return ptr;
+        }
+
+        // Same as allocate , also reports whether the returned memory is known to be zeroed
+        void* allocate(std::size_t size, bool& is_zeroed)
+        {
+            if (llmalloc_unlikely( size > m_max_allocation_size ))
             {
-                register_unpadded_medium_object(ptr, size);
+                return allocate_large_object(size, &is_zeroed);
             }
 
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
-            return ptr;
+            return ScalableMallocType::get_instance().allocate(size, is_zeroed);
         }
 
         // Slow path removal function
-        void* allocate_large_object(std::size_t size)
+        void* allocate_large_object(std::size_t size, bool* is_zeroed = nullptr)
         {
-            auto ptr = VirtualMemory::allocate(size, false);
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { size, 0 });
+            auto mapping_size = m_large_object_cache.get_mapping_size(size);
+            auto ptr = allocate_large_mapping(mapping_size, is_zeroed);
+
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
+            if (llmalloc_unlikely(m_large_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { mapping_size, 0 }) == false))
+            {
+                deallocate_large_mapping(ptr, mapping_size);
+                return nullptr;
+            }
+
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
             return ptr;
         }
 
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate(void*ptr)
+        {
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            // Small and medium objects live in logical pages which are registered to the page map by segments
+            auto logical_page_size_shift = m_page_map.get(ptr);
+
+            if (llmalloc_unlikely(logical_page_size_shift == 0))
+            {
+                deallocate_large_object(ptr);
+                return;
+            }
+
+            // Chunk start address lookup is needed for aligned objects as they are padded
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            ScalableMallocType::get_instance().deallocate(logical_page->get_chunk_start_address(ptr), logical_page_size_shift == m_small_object_logical_page_size_shift);
+        }
+
         // Slow path removal function
-        void register_unpadded_medium_object(void* ptr, std::size_t size)
+        void deallocate_large_object(void* ptr)
         {
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { size, 0 });
+            AllocationMetadata metadata;
+
+            // Erasing so that the map size tracks only live large objects
+            if (m_large_objects_map.erase(reinterpret_cast<uint64_t>(ptr), metadata))
+            {
+                uint64_t unpadded_pointer = reinterpret_cast<uint64_t>(ptr) - metadata.padding_bytes;
+                deallocate_large_mapping(reinterpret_cast<void*>(unpadded_pointer), metadata.size); // Large object with or without padding bytes
+            }
         }
 
+        // Slow path removal function
+        // Resizes large objects with mremap instead of copying them , returns nullptr if not possible
+        void* reallocate_large_object(void* ptr, std::size_t size)
+        {
+            if (m_page_map.get(ptr) != 0)
+            {
+                return nullptr; // Small or medium object
+            }
+
+            AllocationMetadata metadata;
+
+            // Aligned large objects are excluded as moving their mappings would break their alignments
+            if (m_large_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata) == false || metadata.padding_bytes != 0)
+            {
+                return nullptr;
+            }
+
+            // The entry is detached before mremap , otherwise another thread could map the released address and insert its own entry for it in between.
+            // Its node is reattached to the new address or back to the old one if mremap fails , so the entry can't be lost
+            auto node = m_large_objects_map.detach(reinterpret_cast<uint64_t>(ptr), metadata);
+
+            if (node == nullptr)
+            {
+                return nullptr;
+            }
+
+            // Rounding up to a bucket size keeps the mapping cachable after it is freed
+            auto mapping_size = m_large_object_cache.get_mapping_size(size);
+            void* new_ptr = VirtualMemory::reallocate(ptr, metadata.size, mapping_size);
+
+            if (new_ptr == nullptr)
+            {
+                m_large_objects_map.attach(node, reinterpret_cast<uint64_t>(ptr), metadata);
+                return nullptr;
+            }
+
+            m_large_objects_map.attach(node, reinterpret_cast<uint64_t>(new_ptr), { mapping_size, 0 });
+            on_large_mapping_resized(metadata.size, mapping_size);
+
+            return new_ptr;
+        }
+
+        // For sized deletes and free_sized , the size should be the one passed to the allocation call
+        // Small/medium classification comes from the size so the page map lookup is skipped. Unaligned pointers are always chunk start addresses
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        void deallocate(void*ptr)
+        void deallocate_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
         {
             if (llmalloc_unlikely(ptr == nullptr))
             {
                 return;
             }
 
-            AllocationMetadata metadata;
-            if (llmalloc_unlikely(m_non_small_and_aligned_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata)))
+            if (llmalloc_likely(alignment <= AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT))
+            {
+                if (llmalloc_unlikely(size > m_max_allocation_size))
+                {
+                    deallocate_large_object(ptr);
+                    return;
+                }
+
+                ScalableMallocType::get_instance().deallocate(ptr, size <= m_max_small_object_size);
+                return;
+            }
+
+            std::size_t adjusted_size = size + alignment; // Same as allocate_aligned
+
+            if (llmalloc_unlikely(adjusted_size > m_max_allocation_size))
             {
-                deallocate_non_small_or_aligned_object(metadata, ptr);
+                deallocate_large_object(ptr);
                 return;
             }
 
-            ScalableMallocType::get_instance().deallocate(ptr, true); // Small object without padding bytes
+            bool is_small_object = adjusted_size <= m_max_small_object_size;
+            auto logical_page_size_shift = is_small_object ? m_small_object_logical_page_size_shift : m_medium_object_logical_page_size_shift;
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            ScalableMallocType::get_instance().deallocate(logical_page->get_chunk_start_address(ptr), is_small_object);
         }
 
-        // Slow path removal function
-        void deallocate_non_small_or_aligned_object(const AllocationMetadata& metadata, void* ptr)
+        // Resolves the thread local heap and the bin once , returns the number of allocated objects which can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
         {
-            uint64_t unpadded_pointer = reinterpret_cast<uint64_t>(ptr) - metadata.padding_bytes;
-
-            if (metadata.size <= m_max_small_object_size)
+            if (llmalloc_unlikely( size > m_max_allocation_size ))
             {
-                ScalableMallocType::get_instance().deallocate(reinterpret_cast<void*>(unpadded_pointer), true); // Small object with padding bytes
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    out[i] = allocate_large_object(size);
+
+                    if (out[i] == nullptr)
+                    {
+                        return i;
+                    }
+                }
+
+                return count;
             }
-            else if (metadata.size <= m_max_allocation_size)
+
+            return ScalableMallocType::get_instance().allocate_batch(size, count, out);
+        }
+
+        // Pointers can be of any size and nullptr , runs of small or medium ones are passed to heaps in batches
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            void* chunks[DEALLOCATION_BATCH_CAPACITY];
+            std::size_t chunk_count{ 0 };
+            bool chunks_are_small = true;
+
+            for (std::size_t i = 0; i < count; i++)
             {
-                ScalableMallocType::get_instance().deallocate(reinterpret_cast<void*>(unpadded_pointer), false); // Medium object with or without padding bytes
+                if (llmalloc_unlikely(ptrs[i] == nullptr))
+                {
+                    continue;
+                }
+
+                auto logical_page_size_shift = m_page_map.get(ptrs[i]);
+
+                if (llmalloc_unlikely(logical_page_size_shift == 0))
+                {
+                    deallocate_large_object(ptrs[i]);
+                    continue;
+                }
+
+                bool is_small_object = logical_page_size_shift == m_small_object_logical_page_size_shift;
+
+                if (chunk_count == DEALLOCATION_BATCH_CAPACITY || (chunk_count > 0 && is_small_object != chunks_are_small))
+                {
+                    ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
+                    chunk_count = 0;
+                }
+
+                auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptrs[i], static_cast<std::size_t>(1) << logical_page_size_shift);
+                chunks[chunk_count++] = logical_page->get_chunk_start_address(ptrs[i]);
+                chunks_are_small = is_small_object;
             }
-            else
+
+            if (chunk_count > 0)
             {
-                VirtualMemory::deallocate(reinterpret_cast<void*>(unpadded_pointer), metadata.size); // Large object with or without padding bytes
+                ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
             }
         }
 
         std::size_t get_usable_size(void* ptr)
         {
-            AllocationMetadata metadata;
+            auto logical_page_size_shift = m_page_map.get(ptr);
 
-            if (llmalloc_unlikely(m_non_small_and_aligned_objects_map.get( reinterpret_cast<uint64_t>(ptr), metadata)))
+            if (llmalloc_unlikely(logical_page_size_shift == 0))
             {
-                return metadata.size;
+                AllocationMetadata metadata;
+
+                if (m_large_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata))
+                {
+                    return metadata.size - metadata.padding_bytes;
+                }
+
+                return 0;
             }
 
-            // In case of a small object, we simply access to its page header to find its size quickly
-            auto target_logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, m_small_object_logical_page_size);
-            auto size_class = target_logical_page->get_size_class();
-            return size_class;
+            // In case of a small or medium object, we simply access to its page header to find its size quickly
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            auto chunk_start_address = reinterpret_cast<uint64_t>(logical_page->get_chunk_start_address(ptr));
+            return static_cast<std::size_t>(chunk_start_address + logical_page->get_size_class() - reinterpret_cast<uint64_t>(ptr));
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
         void* allocate_aligned(std::size_t size, std::size_t alignment)
         {
+            if (alignment <= AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT)
+            {
+                return allocate(size);
+            }
+
             std::size_t adjusted_size = size + alignment; // Adding padding bytes
             
             if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
@@ -277,13 +602,17 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             auto ptr = ScalableMallocType::get_instance().allocate(adjusted_size);
 
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
+            // No need to store padding bytes , deallocations find chunk start addresses via logical page headers
             std::size_t remainder = reinterpret_cast<std::uint64_t>(ptr) - ((reinterpret_cast<std::uint64_t>(ptr) / alignment) * alignment);
-            std::size_t offset = alignment - remainder;
+            std::size_t offset = remainder == 0 ? 0 : alignment - remainder;
 
             void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(ptr) + offset);
 
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ret), {adjusted_size , offset});
-
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
             return ret;
         }
@@ -291,12 +620,23 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         // Slow path removal function
         void* allocate_aligned_large_object(std::size_t adjusted_size, std::size_t alignment)
         {
-            auto ptr = VirtualMemory::allocate(adjusted_size, false);
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto ptr = allocate_large_mapping(mapping_size);
+
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
             std::size_t remainder = reinterpret_cast<std::uint64_t>(ptr) - ((reinterpret_cast<std::uint64_t>(ptr) / alignment) * alignment);
             std::size_t offset = alignment - remainder;
             void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(ptr) + offset);
 
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ret), { adjusted_size , offset });
+            if (llmalloc_unlikely(m_large_objects_map.insert(reinterpret_cast<uint64_t>(ret), { mapping_size , offset }) == false))
+            {
+                deallocate_large_mapping(ptr, mapping_size);
+                return nullptr;
+            }
 
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
 
@@ -329,14 +669,39 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             }
         }
 
-        // Slow path removal function
-        void* allocate_large_object(std::size_t adjusted_size)
+        // Same as allocate , also reports whether the returned memory is known to be zeroed. Headers don't overlap with the returned memory
+        void* allocate(std::size_t size, bool& is_zeroed)
         {
-            auto header_address = reinterpret_cast<char*>(VirtualMemory::allocate(adjusted_size, false));
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
+            {
+                return allocate_large_object(adjusted_size, &is_zeroed);
+            }
+
+            char* header_address = reinterpret_cast<char*>(ScalableMallocType::get_instance().allocate(adjusted_size, is_zeroed));
+
             if(llmalloc_likely(header_address))
             {
                 reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
                 reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
+                return  header_address + sizeof(AllocationMetadata);
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        // Slow path removal function
+        void* allocate_large_object(std::size_t adjusted_size, bool* is_zeroed = nullptr)
+        {
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto header_address = reinterpret_cast<char*>(allocate_large_mapping(mapping_size, is_zeroed));
+            if(llmalloc_likely(header_address))
+            {
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = mapping_size; // Large objects store their mapping sizes
+                reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
                 llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(header_address + sizeof(AllocationMetadata), AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
                 return header_address + sizeof(AllocationMetadata);
             }
@@ -368,14 +733,142 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             }
             else
             {
-                VirtualMemory::deallocate(reinterpret_cast<void*>(orig_ptr), size);
+                deallocate_large_mapping(reinterpret_cast<void*>(orig_ptr), size);
+            }
+        }
+
+        // Slow path removal function
+        // Resizes large objects with mremap instead of copying them , returns nullptr if not possible
+        void* reallocate_large_object(void* ptr, std::size_t size)
+        {
+            auto header_address = reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata);
+            auto old_adjusted_size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+
+            // Aligned large objects are excluded as moving their mappings would break their alignments
+            if (old_adjusted_size <= m_max_allocation_size || reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes != 0)
+            {
+                return nullptr;
+            }
+
+            // Rounding up to a bucket size keeps the mapping cachable after it is freed
+            auto mapping_size = m_large_object_cache.get_mapping_size(size + sizeof(AllocationMetadata));
+            auto new_header_address = reinterpret_cast<char*>(VirtualMemory::reallocate(header_address, old_adjusted_size, mapping_size));
+
+            if (new_header_address == nullptr)
+            {
+                return nullptr;
+            }
+
+            on_large_mapping_resized(old_adjusted_size, mapping_size);
+
+            reinterpret_cast<AllocationMetadata*>(new_header_address)->size = mapping_size;
+            return new_header_address + sizeof(AllocationMetadata);
+        }
+
+        // For sized deletes and free_sized , the size should be the one passed to the allocation call
+        // Unaligned small and medium objects are classified from the size without reading their headers
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
+        {
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            // Aligned objects need padding bytes from their headers and large objects need their mapping sizes
+            if (llmalloc_unlikely(ptr == nullptr || alignment > 0 || adjusted_size > m_max_allocation_size))
+            {
+                deallocate(ptr);
+                return;
+            }
+
+            ScalableMallocType::get_instance().deallocate(reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata), adjusted_size <= m_max_small_object_size);
+        }
+
+        // Resolves the thread local heap and the bin once , returns the number of allocated objects which can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
+        {
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    out[i] = allocate_large_object(adjusted_size);
+
+                    if (out[i] == nullptr)
+                    {
+                        return i;
+                    }
+                }
+
+                return count;
+            }
+
+            auto allocated = ScalableMallocType::get_instance().allocate_batch(adjusted_size, count, out);
+
+            for (std::size_t i = 0; i < allocated; i++)
+            {
+                char* header_address = reinterpret_cast<char*>(out[i]);
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
+                reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
+                out[i] = header_address + sizeof(AllocationMetadata);
+            }
+
+            return allocated;
+        }
+
+        // Pointers can be of any size and nullptr , runs of small or medium ones are passed to heaps in batches
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            void* chunks[DEALLOCATION_BATCH_CAPACITY];
+            std::size_t chunk_count{ 0 };
+            bool chunks_are_small = true;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (llmalloc_unlikely(ptrs[i] == nullptr))
+                {
+                    continue;
+                }
+
+                auto header_address = reinterpret_cast<char*>(ptrs[i]) - sizeof(AllocationMetadata);
+                auto size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+                auto orig_ptr = header_address - reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes;
+
+                if (llmalloc_unlikely(size > m_max_allocation_size))
+                {
+                    deallocate_large_mapping(reinterpret_cast<void*>(orig_ptr), size);
+                    continue;
+                }
+
+                bool is_small_object = size <= m_max_small_object_size;
+
+                if (chunk_count == DEALLOCATION_BATCH_CAPACITY || (chunk_count > 0 && is_small_object != chunks_are_small))
+                {
+                    ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
+                    chunk_count = 0;
+                }
+
+                chunks[chunk_count++] = orig_ptr;
+                chunks_are_small = is_small_object;
+            }
+
+            if (chunk_count > 0)
+            {
+                ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
             }
         }
 
         std::size_t get_usable_size(void* ptr)
         {
             auto header_address = reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata);
-            return reinterpret_cast<AllocationMetadata*>(header_address)->size - sizeof(AllocationMetadata);
+            auto size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+
+            if (llmalloc_likely(size <= m_max_allocation_size))
+            {
+                // Capacity of the chunk rather than the requested size , so that reallocations can grow in place
+                size = LocalHeapType::SizeClassesType::get_size_class(LocalHeapType::SizeClassesType::get_bin_index(size));
+            }
+
+            return size - sizeof(AllocationMetadata) - reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes;
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
@@ -414,7 +907,8 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         // Slow path removal function
         void* allocate_aligned_large_object(std::size_t adjusted_size, std::size_t alignment)
         {
-            auto base = VirtualMemory::allocate(adjusted_size, false);
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto base = allocate_large_mapping(mapping_size);
 
             if(llmalloc_likely(base))
             {
@@ -425,7 +919,7 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
                 void* header_address = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(base) + offset);
                 void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(header_address) + sizeof(AllocationMetadata));
 
-                reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = mapping_size; // Large objects store their mapping sizes
                 reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = offset;
 
                 llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
@@ -475,9 +969,11 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         [[nodiscard]] void* allocate_and_zero_memory(std::size_t num, std::size_t size)
         {       
             auto total_size = num * size;
-            void* ret = allocate(total_size);
+            bool is_zeroed = false;
+            void* ret = allocate(total_size, is_zeroed);
 
-            if (ret != nullptr)
+            // Never used chunks and large objects come zeroed from the OS , touching them would also commit their pages
+            if (ret != nullptr && is_zeroed == false)
             {
                 llmalloc_builtin_memset(ret, 0, total_size);
             }
@@ -497,10 +993,22 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
                 deallocate(ptr);
                 return nullptr;
             }
+
+            if (llmalloc_unlikely(size > m_max_allocation_size))
+            {
+                // Large to large reallocations avoid copying and transient doubling of RSS
+                void* remapped_ptr = reallocate_large_object(ptr, size);
+
+                if (remapped_ptr != nullptr)
+                {
+                    return remapped_ptr;
+                }
+            }
             
             std::size_t old_size = get_usable_size(ptr);
             
-            if(size <= old_size)
+            // Growing within the capacity of the chunk happens in place
+            if(size <= old_size && can_be_deallocated_with_size(ptr, size) && should_shrink_to_fit(size, old_size) == false)
             {
                 return ptr;
             }
@@ -509,7 +1017,7 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             if (new_ptr != nullptr)
             {
-                llmalloc_builtin_memcpy(new_ptr, ptr, old_size);
+                llmalloc_builtin_memcpy(new_ptr, ptr, size < old_size ? size : old_size);
                 deallocate(ptr);
             }
 
@@ -556,7 +1064,8 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             std::size_t old_size = get_usable_size(ptr);
 
-            if(size <= old_size)
+            // Same as reallocate , the pointer should remain deallocatable with the new size
+            if(size <= old_size && can_be_deallocated_with_size(ptr, size) && should_shrink_to_fit(size, old_size) == false)
             {
                 return ptr;
             }
@@ -566,19 +1075,213 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             if (new_ptr != nullptr)
             {
 
-                llmalloc_builtin_memcpy(new_ptr, ptr, old_size);
+                llmalloc_builtin_memcpy(new_ptr, ptr, size < old_size ? size : old_size);
                 deallocate(ptr);
             }
 
             return new_ptr;
         }
         ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // TRIMMING AND MEMORY USAGE
+
+        // Returns true if any memory was released. Thread local heaps of other threads which can't be accessed directly trim themselves in their next allocations , see ScalableAllocator
+        bool trim()
+        {
+            auto arena = ScalableMallocType::get_instance().get_arena();
+            auto heap_size_before_trim = arena->get_allocated_size();
+            std::size_t released_size{ 0 };
+
+            ScalableMallocType::get_instance().trim();
+
+            if (m_background_purging)
+            {
+                released_size += m_page_purger.purge(true);
+            }
+
+            released_size += m_large_object_cache.release_all_mappings();
+            released_size += arena->trim();
+
+            return released_size > 0 || arena->get_allocated_size() < heap_size_before_trim;
+        }
+
+        // Used sizes of thread local heaps of other threads which can't be accessed directly are as of their last snapshots , see ScalableAllocator
+        MemoryUsage get_memory_usage()
+        {
+            MemoryUsage usage;
+            std::size_t pooled_size{ 0 };
+
+            ScalableMallocType::get_instance().get_heap_usage(usage.heap_used_size, pooled_size);
+            usage.heap_size = ScalableMallocType::get_instance().get_arena()->get_allocated_size();
+            usage.heap_used_size = usage.heap_used_size < usage.heap_size ? usage.heap_used_size : usage.heap_size; // Snapshots can be older than the arena size
+            usage.retained_size = pooled_size + (m_background_purging ? m_page_purger.get_pending_size() : 0) + m_large_object_cache.get_cached_size();
+            usage.large_object_count = m_large_object_count.load(std::memory_order_relaxed);
+            usage.large_object_size = m_large_object_size.load(std::memory_order_relaxed);
+
+            return usage;
+        }
+
+        // Per size class counters need ENABLE_STATS , page sizes follow the same scheme as used sizes in get_memory_usage
+        Stats get_stats()
+        {
+            Stats stats;
+            ScalableMallocType::get_instance().get_stats(stats);
+            return stats;
+        }
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     private:
+        static constexpr std::size_t DEALLOCATION_BATCH_CAPACITY = 64; // Stack buffer size for chunk start addresses in deallocate_batch
+
         #ifndef USE_ALLOC_HEADERS
-        HashmapType m_non_small_and_aligned_objects_map;
-        std::size_t m_small_object_logical_page_size = 0;
+        HashmapType m_large_objects_map;
+        PageMapType m_page_map;
+        uint8_t m_small_object_logical_page_size_shift = 0;
+        uint8_t m_medium_object_logical_page_size_shift = 0;
+        #endif
+        LargeObjectCache m_large_object_cache;
+        PagePurger m_page_purger;
+        bool m_background_purging = false;
+        uint64_t m_background_purging_period = 0;
+        std::atomic<bool> m_background_threads_started = false;
+        bool m_fork_handlers_registered = false;
+        UserspaceSpinlock<> m_background_thread_lock; // Held during each purging period so that fork doesn't copy a purge in progress
+        static constexpr uint64_t MIN_BACKGROUND_PURGING_PERIOD = 10; // Milliseconds
+
+        // Releases recycled logical pages and expired large object mappings so that application threads don't have to. Exits once ScalableAllocator shutdown starts
+        #ifdef __linux__
+        static void* background_purging_thread_function(void* argument)
+        #elif _WIN32
+        static DWORD WINAPI background_purging_thread_function(LPVOID argument)
         #endif
+        {
+            ScalableMalloc* instance = static_cast<ScalableMalloc*>(argument);
+            ThreadUtilities::set_current_thread_priority_to_low();
+            bool running = true;
+
+            while (running)
+            {
+                TimeUtilities::sleep_in_milliseconds(instance->m_background_purging_period);
+
+                instance->m_background_thread_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                running = ScalableMallocType::get_instance().enter_background_task();
+
+                if (running)
+                {
+                    instance->m_page_purger.purge();
+                    instance->m_large_object_cache.release_expired_mappings();
+                    ScalableMallocType::get_instance().leave_background_task();
+                }
+                ////////////////////////////////////////////////////////////////////
+                instance->m_background_thread_lock.unlock();
+            }
+
+            return 0;
+        }
+
+        static void on_fork_prepare()
+        {
+            get_instance().m_background_thread_lock.lock();
+        }
+
+        static void on_fork_parent()
+        {
+            get_instance().m_background_thread_lock.unlock();
+        }
+
+        // Only the forking thread exists in the child , so the purging thread is started again
+        static void on_fork_child()
+        {
+            ScalableMalloc& instance = get_instance();
+            instance.m_background_thread_lock.unlock();
+            instance.m_background_threads_started.store(false);
+            instance.start_background_threads();
+        }
         std::size_t m_max_allocation_size = 0;
         std::size_t m_max_small_object_size = 0;
-};
\ No newline at end of file
+        double m_reallocation_shrink_ratio = 0.5;
+        std::atomic<std::size_t> m_large_object_count = 0;
+        std::atomic<std::size_t> m_large_object_size = 0;
+
+        void on_large_mapping_resized(std::size_t old_mapping_size, std::size_t new_mapping_size)
+        {
+            m_large_object_size.fetch_add(new_mapping_size, std::memory_order_relaxed);
+            m_large_object_size.fetch_sub(old_mapping_size, std::memory_order_relaxed);
+        }
+
+        // Mapping sizes should come from the large object cache so that freed mappings can be cached
+        void* allocate_large_mapping(std::size_t mapping_size, bool* is_zeroed = nullptr)
+        {
+            void* ret = m_large_object_cache.allocate(mapping_size);
+
+            if (is_zeroed != nullptr)
+            {
+                *is_zeroed = ret == nullptr; // Fresh mappings are zeroed by the OS , cached ones are reused as they are
+            }
+
+            if (ret == nullptr)
+            {
+                ret = VirtualMemory::allocate(mapping_size, false);
+            }
+
+            if (ret != nullptr)
+            {
+                m_large_object_count.fetch_add(1, std::memory_order_relaxed);
+                m_large_object_size.fetch_add(mapping_size, std::memory_order_relaxed);
+            }
+
+            return ret;
+        }
+
+        void deallocate_large_mapping(void* address, std::size_t mapping_size)
+        {
+            m_large_object_count.fetch_sub(1, std::memory_order_relaxed);
+            m_large_object_size.fetch_sub(mapping_size, std::memory_order_relaxed);
+
+            if (m_large_object_cache.deallocate(address, mapping_size) == false)
+            {
+                VirtualMemory::deallocate(address, mapping_size);
+            }
+        }
+
+        // Shrinking reallocations keep their chunks unless the new size wastes most of them
+        bool should_shrink_to_fit(std::size_t size, std::size_t capacity) const
+        {
+            return static_cast<double>(size) < static_cast<double>(capacity) * m_reallocation_shrink_ratio;
+        }
+
+        // Reallocations may be followed by free_sized with the new size , so a pointer can be returned as is only if deallocate_sized can handle it
+        #ifndef USE_ALLOC_HEADERS
+        bool can_be_deallocated_with_size(void* ptr, std::size_t size)
+        {
+            auto logical_page_size_shift = m_page_map.get(ptr);
+
+            if (logical_page_size_shift == 0)
+            {
+                return size > m_max_allocation_size; // Large objects are found via the map
+            }
+
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+
+            return logical_page->get_chunk_start_address(ptr) == ptr && (logical_page_size_shift == m_small_object_logical_page_size_shift) == (size <= m_max_small_object_size);
+        }
+        #else
+        bool can_be_deallocated_with_size(void* ptr, std::size_t size)
+        {
+            auto header = reinterpret_cast<AllocationMetadata*>(reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata));
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (header->size > m_max_allocation_size)
+            {
+                return adjusted_size > m_max_allocation_size; // Large objects are deallocated via their headers
+            }
+
+            return header->padding_bytes == 0 && (header->size <= m_max_small_object_size) == (adjusted_size <= m_max_small_object_size);
+        }
+        #endif
+};
+
+inline ScalableMalloc::Stats get_stats()
+{
+    return ScalableMalloc::get_instance().get_stats();
+}
\ No newline at end of file
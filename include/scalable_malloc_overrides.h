@@ -8,6 +8,7 @@
 #endif // VOLTRON_EXCLUDE
 
 #include <atomic>
+#include <cstdio>
 #include <stdexcept>
 #include "compiler/unused.h"
 #include "compiler/hints_hot_code.h"
@@ -25,7 +26,8 @@ void llmalloc_initialise()
 {
     if(g_scalable_malloc_initialised.load() == false)
     {
-        auto success = llmalloc::ScalableMalloc::get_instance().create();
+        // Creating background threads allocates , so they are started after initialisation
+        auto success = llmalloc::ScalableMalloc::get_instance().create(llmalloc::ScalableMallocOptions(), false);
 
         if(success == false)
         {
@@ -33,6 +35,8 @@ void llmalloc_initialise()
         }
 
         g_scalable_malloc_initialised.store(true);
+
+        llmalloc::ScalableMalloc::get_instance().start_background_threads();
     }
 }
 #endif
@@ -80,6 +84,12 @@ void llmalloc_free(void* ptr)
     return llmalloc::ScalableMalloc::get_instance().deallocate(ptr);
 }
 
+LLMALLOC_ALIGN_CODE(llmalloc::AlignmentConstants::CPU_CACHE_LINE_SIZE)
+void llmalloc_free_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
+{
+    return llmalloc::ScalableMalloc::get_instance().deallocate_sized(ptr, size, alignment);
+}
+
 LLMALLOC_ALIGN_CODE(llmalloc::AlignmentConstants::CPU_CACHE_LINE_SIZE)
 void* llmalloc_calloc(std::size_t num, std::size_t size)
 {
@@ -129,21 +139,88 @@ struct mallinfo
     int keepcost; // top-most, releasable space (in bytes)
 };
 
+// Same as mallinfo with size_t fields , available since glibc 2.33
+struct mallinfo2
+{
+    std::size_t arena;
+    std::size_t ordblks;
+    std::size_t smblks;
+    std::size_t hblks;
+    std::size_t hblkhd;
+    std::size_t usmblks;
+    std::size_t fsmblks;
+    std::size_t uordblks;
+    std::size_t fordblks;
+    std::size_t keepcost;
+};
+
+// Arena is the memory heaps hold and mmapped regions are large objects. Keepcost is the memory malloc_trim can release
+mallinfo2 llmalloc_mallinfo2()
+{
+    #ifndef DISABLE_OVERRIDE_AUTO_INITIALISATIONS
+    llmalloc_initialise();
+    #endif
+    auto usage = llmalloc::ScalableMalloc::get_instance().get_memory_usage();
+
+    struct mallinfo2 info = {0};
+    info.arena = usage.heap_size;
+    info.hblks = usage.large_object_count;
+    info.hblkhd = usage.large_object_size;
+    info.uordblks = usage.heap_used_size;
+    info.fordblks = usage.heap_size - usage.heap_used_size;
+    info.keepcost = usage.retained_size;
+    return info;
+}
+
+// Fields are clamped as they are int
 mallinfo llmalloc_mallinfo()
 {
+    auto info2 = llmalloc_mallinfo2();
+    auto clamp = [](std::size_t value) { return value > static_cast<std::size_t>(INT_MAX) ? INT_MAX : static_cast<int>(value); };
+
     struct mallinfo info = {0};
+    info.arena = clamp(info2.arena);
+    info.hblks = clamp(info2.hblks);
+    info.hblkhd = clamp(info2.hblkhd);
+    info.uordblks = clamp(info2.uordblks);
+    info.fordblks = clamp(info2.fordblks);
+    info.keepcost = clamp(info2.keepcost);
     return info;
 }
 
+void llmalloc_malloc_stats()
+{
+    auto info = llmalloc_mallinfo2();
+    fprintf(stderr, "Total (incl. mmap):\nsystem bytes     = %10zu\nin use bytes     = %10zu\nmmap regions     = %10zu\nmmap bytes       = %10zu\nreleasable bytes = %10zu\n", info.arena + info.hblkhd, info.uordblks + info.hblkhd, info.hblks, info.hblkhd, info.keepcost);
+
+    // Per size class counters are collected only with ENABLE_STATS , and get_stats walks segments of all heaps
+    #ifdef ENABLE_STATS
+    auto stats = llmalloc::ScalableMalloc::get_instance().get_stats();
+    fprintf(stderr, "%10s %12s %12s %12s %10s %8s %8s %14s %14s\n", "size class", "allocs", "frees", "remote frees", "overflows", "grows", "recycles", "resident bytes", "virtual bytes");
+
+    for (std::size_t i = 0; i < stats.bins.size(); i++)
+    {
+        const auto& bin = stats.bins[i];
+        fprintf(stderr, "%10zu %12zu %12zu %12zu %10zu %8zu %8zu %14zu %14zu\n", llmalloc::ScalableMalloc::LocalHeapType::SizeClassesType::get_size_class(i), bin.allocation_count, bin.deallocation_count, bin.cross_thread_deallocation_count, bin.queue_overflow_count, bin.segment_grow_count, bin.recycled_logical_page_count, bin.resident_size, bin.virtual_size);
+    }
+
+    fprintf(stderr, "central heap fallbacks = %zu\narena chunk builds     = %zu\n", stats.central_heap_fallback_count, stats.arena_chunk_build_count);
+    #endif
+}
+
 int llmalloc_mallopt(int param, int value)
 {
     return 0;
 }
 
+// Pad is ignored as there is no single top chunk. Returns 1 if any memory was released
 int llmalloc_malloc_trim(std::size_t pad)
 {
-    // Does not support trimming, it returns 0 to indicate success.
-    return 0;
+    #ifndef DISABLE_OVERRIDE_AUTO_INITIALISATIONS
+    llmalloc_initialise();
+    #endif
+    LLMALLOC_UNUSED(pad);
+    return llmalloc::ScalableMalloc::get_instance().trim() ? 1 : 0;
 }
 
 void *llmalloc_valloc(std::size_t size)
@@ -258,7 +335,9 @@ void* llmalloc_reallocarray(void *ptr, size_t nelem, size_t elsize)
 #define memalign(alignment, size) llmalloc_aligned_malloc(size, alignment)
 #define reallocf(ptr, size) llmalloc_realloc(ptr, size)
 #define reallocarray(ptr, nelem, elsize) llmalloc_reallocarray(ptr, nelem,elsize)
-#define mallinfo llmalloc_mallinfo
+#define mallinfo() llmalloc_mallinfo()
+#define mallinfo2() llmalloc_mallinfo2()
+#define malloc_stats() llmalloc_malloc_stats()
 #define mallopt(param, value) llmalloc_mallopt(param, value)
 #define malloc_trim(pad) llmalloc_malloc_trim(pad)
 #define valloc(size) llmalloc_valloc(size)
@@ -401,42 +480,32 @@ void operator delete[](void* ptr, std::size_t, const std::nothrow_t &) noexcept
 // DELETES WITH SIZES
 void operator delete(void* ptr, std::size_t size) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size);
 }
 
 void operator delete[](void* ptr, std::size_t size) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size);
 }
 
 void operator delete(void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete[](void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete(void* ptr, std::size_t size, std::size_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, align);
 }
 
 void operator delete[](void* ptr, std::size_t size, std::size_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, align);
 }
 
 #endif
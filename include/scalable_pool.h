@@ -11,7 +11,7 @@
 
 #include "utilities/lockable.h"
 #include "utilities/bounded_queue.h"
-#include "utilities/mpmc_queue.h"
+#include "utilities/mpmc_pointer_queue.h"
 
 #include "arena.h"
 #include "logical_page_header.h"
@@ -44,7 +44,7 @@ class ScalablePool
     public:
 
         using ArenaType = Arena;
-        using CentralHeapType = HeapPool<MPMCBoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using CentralHeapType = HeapPool<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
         using LocalHeapType = HeapPool<BoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::NO_LOCK>;
         using ScalableMemoryPool = ScalableAllocator<CentralHeapType, LocalHeapType>;
 
@@ -146,4 +146,16 @@ class ScalablePool
 
             ScalableMemoryPool::get_instance().deallocate(ptr);
         }
+
+        // Returns the number of allocated objects , can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t count, void** out)
+        {
+            return ScalableMemoryPool::get_instance().allocate_batch(sizeof(T), count, out);
+        }
+
+        // Unlike deallocate , passed pointers should not be nullptr
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            ScalableMemoryPool::get_instance().deallocate_batch(ptrs, count);
+        }
 };
\ No newline at end of file
@@ -2,11 +2,24 @@
     - A SEGMENT IS A COLLECTION OF LOGICAL PAGES. IT ALLOWS TO GROW IN SIZE AND TO RETURN UNUSED LOGICAL PAGES BACK TO THE SYSTEM
 
     - IT WILL PLACE A LOGICAL PAGE HEADER TO INITIAL 64 BYTES OF EVERY LOGICAL PAGE.            
+
+    - LOGICAL PAGES WITH FREE CHUNKS ARE KEPT BEFORE FULL ONES IN THE LOGICAL PAGE LIST , SO ALLOCATIONS ALWAYS START FROM THE HEAD WITHOUT SEARCHING.
+      A page is moved to the tail when it runs out of chunks and back to the head when a chunk is returned to it
+
+    - OPTIONALLY CHUNK START OFFSETS OF CONSECUTIVE LOGICAL PAGES ARE STAGGERED BY A CACHE LINE ( CACHE COLORING ).
+      As logical pages are aligned to their sizes , otherwise first chunks of all pages would map to the same cache sets. Headers stay at offset 0 for the mask lookup
+
+    - OPTIONALLY RECYCLED LOGICAL PAGES GO TO A POOL SHARED WITH SEGMENTS OF OTHER SIZE CLASSES , AND GROWS TAKE PAGES FROM IT BEFORE ASKING THE ARENA.
+      Logical pages built on pooled pages are marked as dirty as their memory was used before
+
+    - OTHER THREADS NOTIFY THE SEGMENT WHEN THEY FREE TO ONE OF ITS LOGICAL PAGES THE FIRST TIME AFTER THE LAST RECLAIM , SEE RemoteFreeNotifications.
+      The slow path visits only the notified logical pages instead of all full ones
      
     ! IMPORTANT : THE EXTERNAL BUFFER SHOULD BE ALIGNED TO LOGICAL PAGE SIZE. THAT IS CRITICAL FOR REACHING LOGICAL PAGE HEADERS
 */
 #pragma once
 
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -14,6 +27,7 @@
 
 #include "compiler/hints_branch_predictor.h"
 #include "compiler/hints_hot_code.h"
+#include "compiler/builtin_functions.h"
 #include "compiler/unused.h"
 
 #include "cpu/alignment_constants.h"
@@ -21,11 +35,16 @@
 
 #include "utilities/alignment_and_size_utils.h"
 #include "utilities/lockable.h"
+#include "utilities/page_map.h"
 
 #include "arena.h"
+#include "page_purger.h"
+#include "logical_page_pool.h"
 #include "logical_page_header.h"
 #include "logical_page.h"
 
+using PageMapType = PageMap<typename Arena::MetadataAllocator>;
+
 struct SegmentCreationParameters
 {
     std::size_t m_logical_page_size = 0;
@@ -33,7 +52,104 @@ struct SegmentCreationParameters
     std::size_t m_page_recycling_threshold = 0;
     uint32_t m_size_class = 0;
     double m_grow_coefficient = 2.0; // 0 means that we will be growing by allocating only required amount. Applies to segments that can grow
+    std::size_t m_cache_color_count = 1; // Chunks of consecutive logical pages start up to this many cache lines after the header , 1 disables coloring
     bool m_can_grow = true;
+    PageMapType* m_page_map = nullptr; // Optional , if specified log2 of logical page size will be registered for every logical page
+    PagePurger* m_page_purger = nullptr; // Optional , if specified recycled logical pages are handed to it instead of being released synchronously
+    LogicalPagePool* m_logical_page_pool = nullptr; // Optional , should have the same logical page size. Recycled logical pages are pooled before being released
+};
+
+// Logical pages which got chunks freed by other threads , added by any thread and consumed by the owner of the segment or under its lock
+// If it runs out of capacity , the owner is told to search all of its logical pages once
+class RemoteFreeNotifications
+{
+    public:
+
+        static constexpr std::size_t CAPACITY = 8;
+
+        // Segment ids are 16 bits , so pushing threads find the notifications of the owner segment with a plain array look up
+        static void register_notifications(uint16_t segment_id, RemoteFreeNotifications* notifications)
+        {
+            m_registry[segment_id].store(notifications, std::memory_order_release);
+        }
+
+        static void unregister_notifications(uint16_t segment_id, RemoteFreeNotifications* notifications)
+        {
+            m_registry[segment_id].compare_exchange_strong(notifications, nullptr, std::memory_order_acq_rel);
+        }
+
+        static RemoteFreeNotifications* get_notifications(uint16_t segment_id)
+        {
+            return m_registry[segment_id].load(std::memory_order_acquire);
+        }
+
+        // Can be called from any thread
+        void add(LogicalPage* logical_page)
+        {
+            uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+            do
+            {
+                if (tail - m_head.load(std::memory_order_acquire) >= CAPACITY)
+                {
+                    m_overflowed.store(true, std::memory_order_release);
+                    return;
+                }
+            }
+            while (!m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed, std::memory_order_relaxed));
+
+            m_slots[tail % CAPACITY].store(reinterpret_cast<uint64_t>(logical_page), std::memory_order_release);
+        }
+
+        // Should be called by the owner , passes notified logical pages to the callback
+        // Returns false if some notifications were dropped , in that case all logical pages should be searched
+        template <typename Callback>
+        bool consume(Callback&& callback)
+        {
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            uint64_t tail = m_tail.load(std::memory_order_acquire);
+
+            while (head != tail)
+            {
+                uint64_t value = m_slots[head % CAPACITY].exchange(0, std::memory_order_acquire);
+
+                if (value == 0)
+                {
+                    break; // The slot is claimed but not written yet , it will be consumed next time
+                }
+
+                m_head.store(++head, std::memory_order_release);
+
+                if (value != REMOVED)
+                {
+                    callback(reinterpret_cast<LogicalPage*>(value));
+                }
+            }
+
+            return m_overflowed.exchange(false, std::memory_order_acquire) == false;
+        }
+
+        // Should be called by the owner before recycling a logical page , so that its memory is not accessed after it is released
+        // Notifications about it are already visible here as they are written before the chunks are pushed
+        void remove(LogicalPage* logical_page)
+        {
+            for (auto& slot : m_slots)
+            {
+                uint64_t expected = reinterpret_cast<uint64_t>(logical_page);
+                slot.compare_exchange_strong(expected, REMOVED, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+
+        static constexpr uint64_t REMOVED = 1;
+
+        std::atomic<uint64_t> m_slots[CAPACITY] = {};
+        std::atomic<uint64_t> m_head = 0;
+        std::atomic<uint64_t> m_tail = 0;
+        std::atomic<bool> m_overflowed = false;
+
+        static inline std::atomic<RemoteFreeNotifications*> m_registry[65536] = {}; // Zero initialised , only the entries of created segments are touched
 };
 
 #if defined(ENABLE_PERF_TRACES) // VOLTRON_EXCLUDE
@@ -94,6 +210,9 @@ class Segment : public Lockable<lock_policy>
 
             m_params = params;
             m_arena = arena_ptr;
+            m_carved_chunks_are_zeroed = arena_ptr->are_reused_pages_zeroed();
+
+            RemoteFreeNotifications::register_notifications(m_segment_id, &m_remote_free_notifications);
 
             if (grow(external_buffer, params.m_logical_page_count) == nullptr)
             {
@@ -104,34 +223,52 @@ class Segment : public Lockable<lock_policy>
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
-        void* allocate(std::size_t size = 0)
+        void* allocate(std::size_t size = 0, bool* is_zeroed = nullptr) // is_zeroed is optional , see LogicalPage::allocate
         {
-            void* ret = nullptr;
+            this->enter_concurrent_context(); // Locking only for central heap
 
+            void* ret = allocate_from_available_logical_pages(size, is_zeroed);
+
+            if (llmalloc_unlikely(ret == nullptr))
+            {
+                ret = allocate_from_full_logical_pages(size, is_zeroed);
+            }
+
+            this->leave_concurrent_context();
+
+            return ret;
+        }
+
+        // Takes the lock once and carves as many chunks as possible from each visited logical page
+        // Returns the number of allocated chunks , can be less than count only if the segment can't grow
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
+        {
             this->enter_concurrent_context(); // Locking only for central heap
-            
-            // Next-fit like , we start searching from where we left if possible
-            LogicalPageType* iter = m_last_used ? m_last_used : m_head;
+            ///////////////////////////////////////////////////////////////////
+            std::size_t allocated = allocate_batch_from_available_logical_pages(size, count, out);
 
-            while (iter)
+            if (allocated < count && reclaim_notified_remote_frees())
             {
-                ret = iter->allocate(size);
+                allocated += allocate_batch_from_available_logical_pages(size, count - allocated, out + allocated);
+            }
 
-                if (ret != nullptr)
+            while (allocated < count)
+            {
+                void* ptr = allocate_by_growing(size);
+
+                if (ptr == nullptr)
                 {
-                    m_last_used = iter;
-                    this->leave_concurrent_context();
-                    return ret;
+                    break;
                 }
 
-                iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                out[allocated++] = ptr;
+                // Growing places new logical pages to the head
+                allocated += allocate_batch_from_available_logical_pages(size, count - allocated, out + allocated);
             }
-
-            // If we started the search from a non-head node,  then we need one more iteration
-            ret = allocate_from_start(size);
+            ///////////////////////////////////////////////////////////////////
             this->leave_concurrent_context();
 
-            return ret;
+            return allocated;
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
@@ -146,35 +283,64 @@ class Segment : public Lockable<lock_policy>
 
             affected->deallocate(ptr);
 
-            if (llmalloc_unlikely(affected->get_used_size() == 0))
+            if (llmalloc_unlikely(affected->is_full()))
             {
-                affected->mark_as_non_used();
+                move_to_available_logical_pages(affected);
+            }
 
-                if (m_logical_page_count > m_params.m_page_recycling_threshold)
-                {
-                    recycle_logical_page(affected);
-                }
+            if (llmalloc_unlikely(affected->get_used_size() == 0))
+            {
+                on_logical_page_emptied(affected);
             }
 
             this->leave_concurrent_context();
         }
 
-        bool owns_pointer(void* ptr)
+        // Returns chunks freed by other threads to their logical pages so that emptied ones can be recycled
+        void reclaim_remote_frees()
         {
-            return get_segment_id_from_address(ptr) == m_segment_id;
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            reclaim_notified_remote_frees();
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
         }
 
-        void transfer_logical_pages_from(LogicalPageType* logical_page_head)
+        // Can be called from any thread , the segment which owns the logical page is notified on the first free after its last reclaim
+        static void deallocate_remotely(LogicalPageType* logical_page, void* first, void* last)
         {
-            this->enter_concurrent_context();
+            logical_page->deallocate_remotely(first, last, [logical_page]()
+            {
+                auto notifications = RemoteFreeNotifications::get_notifications(logical_page->get_segment_id());
+
+                if (notifications)
+                {
+                    notifications->add(logical_page);
+                }
+            });
+        }
+
+        // Recycles all empty logical pages regardless of the recycling threshold , chunks freed by other threads are reclaimed first
+        void release_empty_logical_pages()
+        {
+            this->enter_concurrent_context(); // Locking only for central heap
             ///////////////////////////////////////////////////////////////////
-            LogicalPageType* iter = logical_page_head;
+            LogicalPageType* iter = m_head;
 
             while (iter)
             {
                 LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
 
-                add_logical_page(iter); // Will also update iter's next ptr
+                if (iter->reclaim_remote_frees() && iter->is_full())
+                {
+                    move_to_available_logical_pages(iter);
+                }
+
+                if (iter->get_used_size() == 0)
+                {
+                    iter->mark_as_non_used();
+                    recycle_logical_page(iter);
+                }
 
                 iter = iter_next;
             }
@@ -182,6 +348,59 @@ class Segment : public Lockable<lock_policy>
             this->leave_concurrent_context();
         }
 
+        // Sum of chunk sizes handed out from logical pages , chunks freed by other threads are reclaimed first
+        std::size_t get_used_size()
+        {
+            std::size_t used_size{ 0 };
+
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            LogicalPageType* iter = m_head;
+
+            while (iter)
+            {
+                LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+
+                bool reclaimed = iter->reclaim_remote_frees();
+                used_size += iter->get_used_size();
+
+                if (reclaimed)
+                {
+                    on_remote_frees_reclaimed(iter); // Can recycle the logical page
+                }
+
+                iter = iter_next;
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return used_size;
+        }
+
+        // Virtual size is the memory of all logical pages , resident size is the part of it which chunks were carved from so far
+        void get_page_sizes(std::size_t& virtual_size, std::size_t& resident_size)
+        {
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            virtual_size = m_logical_page_count * m_params.m_logical_page_size;
+            resident_size = 0;
+
+            LogicalPageType* iter = m_head;
+
+            while (iter)
+            {
+                resident_size += m_logical_page_object_size + iter->get_carved_size(); // Headers are always touched
+                iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
+        }
+
+        bool owns_pointer(void* ptr)
+        {
+            return get_segment_id_from_address(ptr) == m_segment_id;
+        }
+
         // Constant time logical page look up method for finding logical pages if their start addresses are aligned to logical page size
         static LogicalPageType* get_logical_page_from_address(void* ptr, std::size_t logical_page_size)
         {           
@@ -213,6 +432,12 @@ class Segment : public Lockable<lock_policy>
         std::size_t get_logical_page_count() const { return m_logical_page_count; }
         #endif
 
+        #ifdef ENABLE_STATS
+        // Can be called from any thread
+        std::size_t get_grow_count() const { return m_grow_count.load(std::memory_order_relaxed); }
+        std::size_t get_recycled_logical_page_count() const { return m_recycled_logical_page_count.load(std::memory_order_relaxed); }
+        #endif
+
     private:
         SegmentCreationParameters m_params;
         uint16_t m_segment_id = 0;
@@ -220,24 +445,39 @@ class Segment : public Lockable<lock_policy>
         std::size_t m_logical_page_count = 0;
         LogicalPageType* m_head = nullptr;
         LogicalPageType* m_tail = nullptr;
-        LogicalPageType* m_last_used = nullptr;
+        std::size_t m_next_cache_color = 0;
+        bool m_carved_chunks_are_zeroed = true; // Logical pages may be built on pages which the arena discarded rather than unmapped
         static inline uint16_t m_segment_id_counter = 0; // Not thread safe but segments will always be created from a single thread
 
         ArenaType* m_arena = nullptr;
+        RemoteFreeNotifications m_remote_free_notifications;
+
+        #ifdef ENABLE_STATS
+        // Written only by the owner thread or under the lock , so they are incremented without atomic read-modify-writes
+        std::atomic<std::size_t> m_grow_count = 0;
+        std::atomic<std::size_t> m_recycled_logical_page_count = 0;
 
-        // Returns first logical page ptr of the grow
-        [[nodiscard]] LogicalPageType* grow(char* buffer, std::size_t logical_page_count)
+        static void increment_counter(std::atomic<std::size_t>& counter)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        #endif
+
+        // Returns first logical page ptr of the grow , new logical pages are placed to the head as they are the ones with free chunks
+        // Dirty logical pages are the ones built on reused memory
+        [[nodiscard]] LogicalPageType* grow(char* buffer, std::size_t logical_page_count, bool is_dirty = false)
         {
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(buffer, m_params.m_logical_page_size), "Passed buffer to segment grow should be aligned to the logical page size.");
             LogicalPageType* first_new_logical_page = nullptr;
-            LogicalPageType* previous_page = m_tail;
+            LogicalPageType* previous_page = nullptr;
             LogicalPageType* iter_page = nullptr;
 
             auto create_new_logical_page = [&](char* logical_page_buffer) -> bool
             {
                 iter_page = new(logical_page_buffer) LogicalPageType();
 
-                bool success = iter_page->create(logical_page_buffer + m_logical_page_object_size, m_params.m_logical_page_size - m_logical_page_object_size, m_params.m_size_class);
+                std::size_t color_offset = get_next_cache_color_offset();
+                bool success = iter_page->create(logical_page_buffer + m_logical_page_object_size + color_offset, m_params.m_logical_page_size - m_logical_page_object_size - color_offset, m_params.m_size_class);
 
                 if (success == false)
                 {
@@ -248,6 +488,11 @@ class Segment : public Lockable<lock_policy>
                 iter_page->mark_as_used();
                 iter_page->set_segment_id(m_segment_id);
 
+                if (is_dirty)
+                {
+                    iter_page->mark_as_dirty();
+                }
+
                 m_logical_page_count++;
 
                 return true;
@@ -260,19 +505,6 @@ class Segment : public Lockable<lock_policy>
             }
 
             first_new_logical_page = iter_page;
-
-            if (m_head == nullptr)
-            {
-                // The very first page
-                m_head = iter_page;
-                m_tail = iter_page;
-            }
-            else
-            {
-                previous_page->set_next_logical_page(iter_page);
-                iter_page->set_previous_logical_page(previous_page);
-            }
-
             previous_page = iter_page;
 
             /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -289,86 +521,303 @@ class Segment : public Lockable<lock_policy>
                 previous_page = iter_page;
             }
 
-            m_tail = iter_page;
+            // Chunks of unregistered pages would be classified as large objects when freed , so pages are registered before they are handed out
+            if (m_params.m_page_map && m_params.m_page_map->set(buffer, logical_page_count * m_params.m_logical_page_size, get_logical_page_size_shift()) == false)
+            {
+                m_params.m_page_map->clear(buffer, logical_page_count * m_params.m_logical_page_size);
+                m_arena->release_to_system(buffer, logical_page_count * m_params.m_logical_page_size);
+                m_logical_page_count -= logical_page_count;
+                return nullptr;
+            }
+
+            // Splicing the new logical pages in front of the existing ones
+            if (m_head == nullptr)
+            {
+                m_tail = iter_page;
+            }
+            else
+            {
+                iter_page->set_next_logical_page(m_head);
+                m_head->set_previous_logical_page(iter_page);
+            }
+
+            m_head = first_new_logical_page;
 
             return first_new_logical_page;
         }
 
-        void recycle_logical_page(LogicalPageType* affected)
+        // Cycles through colors , a color which would leave no room for a chunk is skipped
+        std::size_t get_next_cache_color_offset()
         {
-            remove_logical_page(affected);
-            affected->~LogicalPageType();
-            m_arena->release_to_system(affected, m_params.m_logical_page_size);
-            #ifdef ENABLE_PERF_TRACES
-            fprintf(stderr, "\033[0;31m" "segment recycling vm page, size=%zu  sizeclass=%u\n" "\033[0m", m_params.m_logical_page_size, m_params.m_size_class);
-            #endif
+            if (llmalloc_likely(m_params.m_cache_color_count <= 1))
+            {
+                return 0;
+            }
+
+            std::size_t color_offset = (m_next_cache_color++ % m_params.m_cache_color_count) * AlignmentConstants::CPU_CACHE_LINE_SIZE;
+
+            if (m_params.m_logical_page_size - m_logical_page_object_size - color_offset < m_params.m_size_class)
+            {
+                return 0;
+            }
+
+            return color_offset;
         }
 
-        void remove_logical_page(LogicalPageType* affected)
+        LLMALLOC_FORCE_INLINE void* allocate_from_logical_page(LogicalPageType* logical_page, std::size_t size, bool* is_zeroed)
         {
-            auto next = reinterpret_cast<LogicalPageType*>(affected->get_next_logical_page());
-            auto previous = reinterpret_cast<LogicalPageType*>(affected->get_previous_logical_page());
+            void* ret = allocate_chunk(logical_page, size, is_zeroed);
 
-            if (affected == m_last_used)
+            // A full page may have chunks freed by other threads
+            if (llmalloc_unlikely(ret == nullptr) && logical_page->reclaim_remote_frees())
             {
-                if (previous)
+                ret = allocate_chunk(logical_page, size, is_zeroed);
+            }
+
+            return ret;
+        }
+
+        LLMALLOC_FORCE_INLINE void* allocate_chunk(LogicalPageType* logical_page, std::size_t size, bool* is_zeroed)
+        {
+            if (is_zeroed)
+            {
+                void* ret = logical_page->allocate(size, *is_zeroed);
+                *is_zeroed = *is_zeroed && m_carved_chunks_are_zeroed;
+                return ret;
+            }
+
+            return logical_page->allocate(size);
+        }
+
+        // Allocates from the head , every failed attempt moves an exhausted logical page to the tail so the cost is amortised O(1)
+        LLMALLOC_FORCE_INLINE void* allocate_from_available_logical_pages(std::size_t size, bool* is_zeroed)
+        {
+            while (m_head && m_head->is_full() == false)
+            {
+                void* ret = allocate_from_logical_page(m_head, size, is_zeroed);
+
+                if (llmalloc_likely(ret != nullptr))
                 {
-                    m_last_used = previous;
+                    return ret;
                 }
-                else if (next)
+
+                move_to_full_logical_pages(m_head);
+            }
+
+            return nullptr;
+        }
+
+        std::size_t allocate_batch_from_available_logical_pages(std::size_t size, std::size_t count, void** out)
+        {
+            std::size_t allocated{ 0 };
+
+            while (allocated < count && m_head && m_head->is_full() == false)
+            {
+                std::size_t current = m_head->allocate_batch(size, count - allocated, out + allocated);
+
+                // A full page may have chunks freed by other threads
+                if (current < count - allocated && m_head->reclaim_remote_frees())
                 {
-                    m_last_used = next;
+                    current += m_head->allocate_batch(size, count - allocated - current, out + allocated + current);
                 }
-                else
+
+                allocated += current;
+
+                if (allocated < count)
                 {
-                    m_last_used = nullptr;
+                    move_to_full_logical_pages(m_head);
                 }
             }
 
-            if (previous == nullptr)
+            return allocated;
+        }
+
+        // Visits only the logical pages which other threads notified about , all of them if some notifications were dropped
+        // Returns true if any of them got free chunks
+        bool reclaim_notified_remote_frees()
+        {
+            bool reclaimed = false;
+
+            auto reclaim = [&](LogicalPageType* logical_page)
             {
-                m_head = next;
+                if (logical_page->reclaim_remote_frees())
+                {
+                    reclaimed = true;
+                    on_remote_frees_reclaimed(logical_page);
+                }
+            };
+
+            if (llmalloc_unlikely(m_remote_free_notifications.consume(reclaim) == false))
+            {
+                LogicalPageType* iter = m_head;
 
-                if (m_head == nullptr || m_head->get_next_logical_page() == 0)
+                while (iter)
                 {
-                    m_tail = m_head;
+                    LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                    reclaim(iter);
+                    iter = iter_next;
                 }
             }
+
+            return reclaimed;
+        }
+
+        void on_remote_frees_reclaimed(LogicalPageType* affected)
+        {
+            if (affected->is_full())
+            {
+                move_to_available_logical_pages(affected);
+            }
+
+            if (affected->get_used_size() == 0)
+            {
+                on_logical_page_emptied(affected);
+            }
+        }
+
+        void move_to_full_logical_pages(LogicalPageType* logical_page)
+        {
+            logical_page->mark_as_full();
+
+            if (logical_page != m_tail)
+            {
+                unlink_logical_page(logical_page);
+                link_logical_page_to_tail(logical_page);
+            }
+        }
+
+        void move_to_available_logical_pages(LogicalPageType* logical_page)
+        {
+            logical_page->mark_as_non_full();
+
+            if (logical_page != m_head)
+            {
+                unlink_logical_page(logical_page);
+                link_logical_page_to_head(logical_page);
+            }
+        }
+
+        void on_logical_page_emptied(LogicalPageType* affected)
+        {
+            affected->mark_as_non_used();
+
+            if (m_logical_page_count > m_params.m_page_recycling_threshold)
+            {
+                recycle_logical_page(affected);
+            }
+        }
+
+        void recycle_logical_page(LogicalPageType* affected)
+        {
+            m_remote_free_notifications.remove(affected);
+            remove_logical_page(affected);
+            affected->~LogicalPageType();
+            unregister_logical_page(affected);
+
+            if (m_params.m_logical_page_pool && m_params.m_logical_page_pool->add(affected))
+            {
+                // Segments of any size class can grow into it , the pool releases it if it runs out of capacity
+            }
+            else if (m_params.m_page_purger)
+            {
+                m_params.m_page_purger->add(affected, m_params.m_logical_page_size, m_arena);
+            }
             else
             {
-                previous->set_next_logical_page(next);
+                m_arena->release_to_system(affected, m_params.m_logical_page_size);
+            }
+            #ifdef ENABLE_STATS
+            increment_counter(m_recycled_logical_page_count);
+            #endif
+            #ifdef ENABLE_PERF_TRACES
+            fprintf(stderr, "\033[0;31m" "segment recycling vm page, size=%zu  sizeclass=%u\n" "\033[0m", m_params.m_logical_page_size, m_params.m_size_class);
+            #endif
+        }
 
-                if (m_tail == affected)
-                {
-                    m_tail = previous;
-                }
+        uint8_t get_logical_page_size_shift() const
+        {
+            return static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(m_params.m_logical_page_size)));
+        }
+
+        void unregister_logical_page(LogicalPageType* logical_page)
+        {
+            if (m_params.m_page_map)
+            {
+                m_params.m_page_map->clear(logical_page, m_params.m_logical_page_size);
+            }
+        }
+
+        void remove_logical_page(LogicalPageType* affected)
+        {
+            unlink_logical_page(affected);
+            m_logical_page_count--;
+        }
+
+        void unlink_logical_page(LogicalPageType* affected)
+        {
+            auto next = reinterpret_cast<LogicalPageType*>(affected->get_next_logical_page());
+            auto previous = reinterpret_cast<LogicalPageType*>(affected->get_previous_logical_page());
+
+            if (previous == nullptr)
+            {
+                m_head = next;
+            }
+            else
+            {
+                previous->set_next_logical_page(next);
             }
 
-            if (next)
+            if (next == nullptr)
+            {
+                m_tail = previous;
+            }
+            else
+            {
                 next->set_previous_logical_page(previous);
+            }
 
-            m_logical_page_count--;
+            affected->set_next_logical_page(nullptr);
+            affected->set_previous_logical_page(nullptr);
+        }
+
+        void link_logical_page_to_head(LogicalPageType* logical_page)
+        {
+            logical_page->set_previous_logical_page(nullptr);
+            logical_page->set_next_logical_page(m_head);
+
+            if (m_head)
+            {
+                m_head->set_previous_logical_page(logical_page);
+            }
+            else
+            {
+                m_tail = logical_page;
+            }
+
+            m_head = logical_page;
         }
 
-        void add_logical_page(LogicalPageType* logical_page)
+        void link_logical_page_to_tail(LogicalPageType* logical_page)
         {
+            logical_page->set_next_logical_page(nullptr);
+            logical_page->set_previous_logical_page(m_tail);
+
             if (m_tail)
             {
                 m_tail->set_next_logical_page(logical_page);
-                logical_page->set_previous_logical_page(m_tail);
             }
             else
             {
                 m_head = logical_page;
-                m_tail = logical_page;
             }
 
-            logical_page->set_next_logical_page(nullptr);
-            m_logical_page_count++;
+            m_tail = logical_page;
         }
 
         void destroy()
         {
+            RemoteFreeNotifications::unregister_notifications(m_segment_id, &m_remote_free_notifications);
+
             if (m_head == nullptr)
             {
                 return;
@@ -385,6 +834,7 @@ class Segment : public Lockable<lock_policy>
                 {
                     // Invoking dtor of logical page
                     iter->~LogicalPageType();
+                    unregister_logical_page(iter);
                     // Release pages back to system if we are managing the arena
                     m_arena->release_to_system(iter, m_params.m_logical_page_size);
                 }
@@ -397,33 +847,25 @@ class Segment : public Lockable<lock_policy>
         }
 
         // Slow path removal function
-        void* allocate_from_start(std::size_t size)
+        void* allocate_from_full_logical_pages(std::size_t size, bool* is_zeroed)
         {
-            if (m_last_used)
+            // Full logical pages may have chunks freed by other threads
+            if (reclaim_notified_remote_frees())
             {
-                void* ret = nullptr;
-                LogicalPageType* iter = m_head;
+                void* ret = allocate_from_available_logical_pages(size, is_zeroed);
 
-                while (iter != m_last_used)
+                if (ret != nullptr)
                 {
-                    ret = iter->allocate(size);
-
-                    if (ret != nullptr)
-                    {
-                        m_last_used = iter;
-                        return ret;
-                    }
-
-                    iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                    return ret;
                 }
             }
 
             // If we reached here , it means that we need to allocate more memory
-            return allocate_by_growing(size);
+            return allocate_by_growing(size, is_zeroed);
         }
 
         // Slow path removal function
-        void* allocate_by_growing(std::size_t size)
+        void* allocate_by_growing(std::size_t size, bool* is_zeroed = nullptr)
         {
             void* ret = nullptr;
 
@@ -434,7 +876,24 @@ class Segment : public Lockable<lock_policy>
                 calculate_quantities(size, new_logical_page_count, minimum_new_logical_page_count);
 
                 char* new_buffer = nullptr;
-                new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
+                bool is_dirty = false;
+
+                // Pages emptied by segments of other size classes are reused before asking the arena , one at a time as they are not contiguous
+                if (m_params.m_logical_page_pool && minimum_new_logical_page_count == 1)
+                {
+                    new_buffer = static_cast<char*>(m_params.m_logical_page_pool->get());
+
+                    if (new_buffer)
+                    {
+                        new_logical_page_count = 1;
+                        is_dirty = true;
+                    }
+                }
+
+                if (new_buffer == nullptr)
+                {
+                    new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
+                }
 
                 if (new_buffer == nullptr && new_logical_page_count > minimum_new_logical_page_count)  // Meeting grow_coefficient is not possible so lower the new_logical_page_count
                 {
@@ -447,7 +906,11 @@ class Segment : public Lockable<lock_policy>
                     return nullptr;
                 }
 
-                auto first_new_logical_page = grow(new_buffer, new_logical_page_count);
+                auto first_new_logical_page = grow(new_buffer, new_logical_page_count, is_dirty);
+
+                #ifdef ENABLE_STATS
+                increment_counter(m_grow_count);
+                #endif
 
                 #ifdef ENABLE_PERF_TRACES
                 fprintf(stderr, "\033[0;31m" "segment grow size=%zu  sizeclass=%u\n" "\033[0m", size, m_params.m_size_class);
@@ -455,11 +918,10 @@ class Segment : public Lockable<lock_policy>
 
                 if (first_new_logical_page)
                 {
-                    ret = first_new_logical_page->allocate(size);
+                    ret = allocate_chunk(first_new_logical_page, size, is_zeroed);
 
                     if (ret != nullptr)
                     {
-                        m_last_used = first_new_logical_page;
                         return ret;
                     }
                 }
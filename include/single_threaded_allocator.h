@@ -52,7 +52,11 @@ class SingleThreadedAllocator
 {
     public:
 
+        #ifdef USE_QUARTER_POW2_SIZE_CLASSES
+        using HeapType = HeapQuarterPow2<>;
+        #else
         using HeapType = HeapPow2<>;
+        #endif
         using ArenaType = Arena;
         using HashmapType = Dictionary<uint64_t, std::size_t, typename ArenaType::MetadataAllocator>;
 
@@ -67,7 +71,7 @@ class SingleThreadedAllocator
         bool create(SingleThreadedAllocatorOptions options = SingleThreadedAllocatorOptions())
         {
             m_max_allocation_size = HeapType::get_max_allocation_size();
-            m_max_small_object_size = HeapPow2<>::get_max_small_object_size();
+            m_max_small_object_size = HeapType::get_max_small_object_size();
 
             if( m_non_small_objects_hash_map.initialise( options.non_small_objects_hash_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
             {
@@ -83,7 +87,7 @@ class SingleThreadedAllocator
             heap_params.deallocation_queues_processing_threshold = options.deallocation_queue_processing_threshold;
             
             
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < HeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 heap_params.logical_page_counts[i] = options.logical_page_counts_per_size_class[i];
                 heap_params.non_recyclable_deallocation_queue_sizes[i] = 0;
@@ -156,7 +160,8 @@ class SingleThreadedAllocator
         {
             std::size_t medium_or_large_size{0};
 
-            if (llmalloc_unlikely( m_non_small_objects_hash_map.get( reinterpret_cast<uint64_t>(ptr), medium_or_large_size) ))
+            // Erasing as the same address can be handed out again as a small object
+            if (llmalloc_unlikely( m_non_small_objects_hash_map.erase( reinterpret_cast<uint64_t>(ptr), medium_or_large_size) ))
             {
                 deallocate_medium_or_large_object(ptr, medium_or_large_size);
                 return;
@@ -0,0 +1,243 @@
+/*
+    - SIZE CLASS POLICIES FOR HEAPS. THEY MAP REQUESTED SIZES TO BIN INDEXES AND BIN INDEXES TO SIZE CLASSES IN CONSTANT TIME
+
+    - Pow2SizeClasses : 16 32 64 ... 262144 , the fastest mapping but up to 50% internal fragmentation ( ex: 2049 bytes -> 4096 bytes )
+
+    - QuarterPow2SizeClasses : 16 32 48 64 and then 4 classes per pow2 , each a quarter of the pow2 apart ( jemalloc/mimalloc style ) :
+      80 96 112 128 , 160 192 224 256 , ... , 163840 196608 229376 262144. Internal fragmentation drops to 20% in the worst case.
+      Sizes up to 1024 are mapped with a lookup table and the rest with a clz
+
+    - CREATION PARAMETERS OF HEAPS ( PAGE COUNTS , QUEUE SIZES ) ARE PER POW2 SIZE CLASS GROUP SO THAT BOTH POLICIES SHARE THE SAME OPTIONS.
+      A GROUP HOLDS THE BINS WHOSE SIZE CLASSES ROUND UP TO THE SAME POW2 AND THEY SHARE THE GROUP'S PARAMETERS EVENLY.
+      Remainders go to the first bins of a group so that shares sum up to the group's value. Every bin gets at least 1 though ,
+      as segments need a logical page and queues need a slot , so a group value smaller than its bin count is rounded up to the bin count
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "compiler/hints_hot_code.h"
+#include "compiler/builtin_functions.h"
+#include "compiler/unused.h"
+
+class CompileTimePow2Utils
+{
+    public :
+
+        template <std::size_t N>
+        static constexpr std::size_t compile_time_pow2()
+        {
+            static_assert(N>=0); // To ensure that it is called in compile time only
+            return 1 << N;
+        }
+
+        template<unsigned int n>
+        static constexpr unsigned int compile_time_log2()
+        {
+            return (n <= 1) ? 0 : 1 + compile_time_log2<n / 2>();
+        }
+};
+
+class Pow2SizeClasses
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = 15; // Small : 16 32 64 128 256 512 1024 2048 4096 8192 16384 32768 , Medium: 65536 131072 262144
+        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 12;
+        static constexpr std::size_t GROUP_COUNT = BIN_COUNT;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<BIN_COUNT + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<MIN_MEDIUM_OBJECT_BIN_INDEX + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+
+        static constexpr std::size_t MIN_SIZE_CLASS = 16;
+        static constexpr inline std::size_t LOG2_MIN_SIZE_CLASS = CompileTimePow2Utils::compile_time_log2<MIN_SIZE_CLASS>();
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index(std::size_t size)
+        {
+            size = size < MIN_SIZE_CLASS ? MIN_SIZE_CLASS : size;
+            return get_bin_index_from_size_class(get_first_pow2_of(size));
+        }
+
+        // IMPLEMENTATION IS FOR 64 BIT ONLY
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index_from_size_class(std::size_t size_class)
+        {
+            std::size_t index = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size_class))) - LOG2_MIN_SIZE_CLASS;
+            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
+            return index;
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_size_class(std::size_t bin_index)
+        {
+            return MIN_SIZE_CLASS << bin_index;
+        }
+
+        static constexpr std::size_t get_group_index(std::size_t bin_index)
+        {
+            return bin_index;
+        }
+
+        static constexpr std::size_t get_group_bin_count(std::size_t group_index)
+        {
+            LLMALLOC_UNUSED(group_index);
+            return 1;
+        }
+
+        static constexpr std::size_t get_index_in_group(std::size_t bin_index)
+        {
+            LLMALLOC_UNUSED(bin_index);
+            return 0;
+        }
+
+    private:
+
+        // Reference : https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
+        LLMALLOC_FORCE_INLINE static std::size_t get_first_pow2_of(std::size_t input)
+        {
+            /*
+            No need for the if check below , as the caller will pass a miniumum of MIN_SIZE_CLASS which is > 1
+            if (llmalloc_unlikely(input <= 1))
+            {
+                return 1;
+            }
+            */
+
+            input--;
+            input |= input >> 1;
+            input |= input >> 2;
+            input |= input >> 4;
+            input |= input >> 8;
+            input |= input >> 16;
+
+            return input + 1;
+        }
+};
+
+// Compile time table builders for QuarterPow2SizeClasses
+class QuarterPow2SizeClassUtils
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = 52;
+        static constexpr std::size_t LINEAR_BIN_COUNT = 4;                   // 16 32 48 64
+        static constexpr std::size_t LOG2_FIRST_QUARTER_STEPPED_POW2 = 6;    // Quarter steps start after 64
+        static constexpr std::size_t LOOKUP_TABLE_MAX_SIZE = 1024;
+        static constexpr std::size_t LOOKUP_TABLE_SIZE = (LOOKUP_TABLE_MAX_SIZE >> 4) + 1;
+
+        static constexpr std::size_t compute_bin_index(std::size_t size)
+        {
+            if (size <= 64)
+            {
+                return size <= 16 ? 0 : (size + 15) / 16 - 1;
+            }
+
+            std::size_t log2 = 0;
+            while ((static_cast<std::size_t>(1) << (log2 + 1)) < size)
+            {
+                log2++;
+            }
+
+            return LINEAR_BIN_COUNT + ((log2 - LOG2_FIRST_QUARTER_STEPPED_POW2) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+        }
+
+        static constexpr std::array<uint32_t, BIN_COUNT> build_size_classes()
+        {
+            std::array<uint32_t, BIN_COUNT> size_classes{};
+
+            for (std::size_t i = 0; i < LINEAR_BIN_COUNT; i++)
+            {
+                size_classes[i] = static_cast<uint32_t>((i + 1) * 16);
+            }
+
+            for (std::size_t i = LINEAR_BIN_COUNT; i < BIN_COUNT; i++)
+            {
+                std::size_t log2 = LOG2_FIRST_QUARTER_STEPPED_POW2 + (i - LINEAR_BIN_COUNT) / 4;
+                std::size_t step = static_cast<std::size_t>(1) << (log2 - 2);
+                size_classes[i] = static_cast<uint32_t>((static_cast<std::size_t>(1) << log2) + ((i - LINEAR_BIN_COUNT) % 4 + 1) * step);
+            }
+
+            return size_classes;
+        }
+
+        // Index is size/16 rounded up
+        static constexpr std::array<uint8_t, LOOKUP_TABLE_SIZE> build_lookup_table()
+        {
+            std::array<uint8_t, LOOKUP_TABLE_SIZE> table{};
+
+            for (std::size_t i = 0; i < LOOKUP_TABLE_SIZE; i++)
+            {
+                table[i] = static_cast<uint8_t>(compute_bin_index(i << 4));
+            }
+
+            return table;
+        }
+};
+
+class QuarterPow2SizeClasses
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = QuarterPow2SizeClassUtils::BIN_COUNT; // Small : 16 32 48 64 80 96 112 128 160 ... 32768 , Medium: 40960 ... 262144
+        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 40;
+        static constexpr std::size_t GROUP_COUNT = Pow2SizeClasses::GROUP_COUNT;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = Pow2SizeClasses::LARGEST_SIZE_CLASS;
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = Pow2SizeClasses::LARGEST_SMALL_OBJECT_SIZE_CLASS;
+
+        static constexpr std::size_t MIN_SIZE_CLASS = 16;
+
+        static constexpr inline std::array<uint32_t, BIN_COUNT> SIZE_CLASSES = QuarterPow2SizeClassUtils::build_size_classes();
+        static constexpr inline std::array<uint8_t, QuarterPow2SizeClassUtils::LOOKUP_TABLE_SIZE> LOOKUP_TABLE = QuarterPow2SizeClassUtils::build_lookup_table();
+
+        // IMPLEMENTATION IS FOR 64 BIT ONLY
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index(std::size_t size)
+        {
+            if (size <= QuarterPow2SizeClassUtils::LOOKUP_TABLE_MAX_SIZE)
+            {
+                return LOOKUP_TABLE[(size + 15) >> 4];
+            }
+
+            // 2^log2 < size <= 2^(log2+1) , then find which quarter of that range the size is in
+            std::size_t log2 = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size - 1)));
+            std::size_t index = QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT + ((log2 - QuarterPow2SizeClassUtils::LOG2_FIRST_QUARTER_STEPPED_POW2) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
+            return index;
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index_from_size_class(std::size_t size_class)
+        {
+            return get_bin_index(size_class);
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_size_class(std::size_t bin_index)
+        {
+            return SIZE_CLASSES[bin_index];
+        }
+
+        // Group index is log2 of the size class rounded up to pow2 , starting from 16
+        static constexpr std::size_t get_group_index(std::size_t bin_index)
+        {
+            if (bin_index < QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT)
+            {
+                return bin_index < 2 ? bin_index : 2;
+            }
+
+            return 3 + (bin_index - QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT) / 4;
+        }
+
+        static constexpr std::size_t get_group_bin_count(std::size_t group_index)
+        {
+            return group_index < 2 ? 1 : (group_index == 2 ? 2 : 4);
+        }
+
+        static constexpr std::size_t get_index_in_group(std::size_t bin_index)
+        {
+            if (bin_index < QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT)
+            {
+                return bin_index < 2 ? 0 : bin_index - 2;
+            }
+
+            return (bin_index - QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT) % 4;
+        }
+};
\ No newline at end of file
@@ -127,6 +127,18 @@ class BoundedQueue
             
             return true;
         }
+
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            std::size_t popped{ 0 };
+
+            while (popped < count && try_pop(out[popped]))
+            {
+                popped++;
+            }
+
+            return popped;
+        }
     
     private:
         LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) typename SinglyLinkedList<T>::SinglyLinkedListNode* m_head = nullptr;
@@ -7,7 +7,9 @@
    
     - Reallocates memory when the load factor reaches 1
 
-    - Does not support item removal & types with constructors with arguments
+    - Erased nodes are kept in a free list and reused by later inserts
+
+    - Does not support types with constructors with arguments
 */
 #pragma once
 
@@ -63,7 +65,19 @@ class Dictionary
 
             std::size_t index = modulo_table_size(m_hash(key));
 
-            DictionaryNode* new_node = m_node_cache + m_item_count;
+            DictionaryNode* new_node = nullptr;
+
+            if (m_free_nodes != nullptr)
+            {
+                new_node = m_free_nodes;
+                m_free_nodes = new_node->next;
+            }
+            else
+            {
+                new_node = m_node_cache + m_node_cache_index;
+                ++m_node_cache_index;
+            }
+
             new_node->key = key;
             new_node->value = value;
             
@@ -93,6 +107,43 @@ class Dictionary
             return false;
         }
 
+        // Returns the value of the erased item
+        bool erase(const Key& key, Value& value)
+        {
+            assert(m_table_size > 0 && m_node_cache != nullptr);
+
+            std::size_t index = modulo_table_size(m_hash(key));
+            DictionaryNode* previous = nullptr;
+            DictionaryNode* current = m_table[index];
+
+            while (current != nullptr)
+            {
+                if (current->key == key)
+                {
+                    if (previous == nullptr)
+                    {
+                        m_table[index] = current->next;
+                    }
+                    else
+                    {
+                        previous->next = current->next;
+                    }
+
+                    value = current->value;
+
+                    current->next = m_free_nodes;
+                    m_free_nodes = current;
+
+                    --m_item_count;
+                    return true;
+                }
+
+                previous = current;
+                current = current->next;
+            }
+            return false;
+        }
+
     private:
         // Members will always be accessed by a single thread , hence no cpu cache line size alignment
         DictionaryNode** m_table = nullptr;
@@ -100,6 +151,8 @@ class Dictionary
 
         std::size_t m_table_size = 0;
         std::size_t m_item_count = 0;
+        std::size_t m_node_cache_index = 0;
+        DictionaryNode* m_free_nodes = nullptr;
 
         HashFunction m_hash;
 
@@ -174,6 +227,10 @@ class Dictionary
             m_node_cache = new_node_cache;
             m_table_size = size;
 
+            // Copying compacts live nodes to the start of the new node cache
+            m_node_cache_index = copy_count;
+            m_free_nodes = nullptr;
+
             return true;
         }
 
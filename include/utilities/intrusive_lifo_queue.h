@@ -0,0 +1,72 @@
+/*
+    - NON THREAD SAFE UNBOUNDED LIFO QUEUE OF MEMORY ADDRESSES. ITEMS ARE LINKED THROUGH THEIR OWN FIRST 8 BYTES SO THERE ARE NO NODE BUFFERS AND NO CAPACITY LIMIT
+
+    - USE CASE : THREAD LOCAL DEALLOCATION QUEUES OF HEAPS , AS A FREED CHUNK IS NOT USED UNTIL IT IS ALLOCATED AGAIN.
+      Pushed addresses should point to writable memory of at least 8 bytes which stays valid until they are popped
+
+    - SAME INTERFACE AS BoundedQueue SO THAT IT CAN BE PASSED AS DeallocationQueueType. Capacities are ignored and try_push never fails
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../compiler/hints_hot_code.h"
+#include "../compiler/unused.h"
+
+template <typename T = uint64_t>
+class IntrusiveLIFOQueue
+{
+    public:
+
+        static_assert(sizeof(T) == sizeof(void*), "IntrusiveLIFOQueue items should be addresses.");
+
+        bool create(std::size_t capacity)
+        {
+            LLMALLOC_UNUSED(capacity);
+            m_head = nullptr;
+            return true;
+        }
+
+        LLMALLOC_FORCE_INLINE bool try_push(T t)
+        {
+            auto node = reinterpret_cast<IntrusiveNode*>(t);
+            node->m_next = m_head;
+            m_head = node;
+            return true;
+        }
+
+        LLMALLOC_FORCE_INLINE bool try_pop(T& t)
+        {
+            if (m_head == nullptr)
+            {
+                return false;
+            }
+
+            t = reinterpret_cast<T>(m_head);
+            m_head = m_head->m_next;
+            return true;
+        }
+
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            std::size_t popped{ 0 };
+
+            while (popped < count && m_head != nullptr)
+            {
+                out[popped++] = reinterpret_cast<T>(m_head);
+                m_head = m_head->m_next;
+            }
+
+            return popped;
+        }
+
+    private:
+
+        struct IntrusiveNode
+        {
+            IntrusiveNode* m_next = nullptr;
+        };
+
+        IntrusiveNode* m_head = nullptr;
+};
\ No newline at end of file
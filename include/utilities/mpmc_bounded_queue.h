@@ -168,6 +168,18 @@ public:
         }
     }
 
+    std::size_t try_pop_batch(T* out, std::size_t count)
+    {
+        std::size_t popped{ 0 };
+
+        while (popped < count && try_pop(out[popped]))
+        {
+            popped++;
+        }
+
+        return popped;
+    }
+
     std::size_t size() const
     {
         return static_cast<std::size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed));
@@ -2,9 +2,16 @@
     - MPMC THREAD SAFE HOWEVER DESIGNED FOR A CERTAIN SCENARIO THEREFORE DON'T USE IT SOMEWHERE ELSE !
       
       USE CASE : WHEN INSERTS ARE VERY RARE AND SEARCHS ARE VERY FREQUENT, AND WHEN IT IS GUARANTEED THAT 
-      SEARCH FOR A SPECIFIC ITEM WILL ALWAYS GUARANTEEDLY BE CALLED AFTER ITS INSERTION :
+      SEARCH FOR A SPECIFIC ITEM WILL ALWAYS GUARANTEEDLY BE CALLED AFTER ITS INSERTION AND BEFORE ITS ERASURE :
 
-            - INSERTS ARE PROTECTED BY A SPINLOCK SO NO ABA RISK
+            - INSERTS AND ERASES ARE PROTECTED BY A SPINLOCK SO NO ABA RISK
+
+            - ERASED NODES ARE UNLINKED BUT THEIR NEXT POINTERS ARE KEPT INTACT, SO A SEARCH STANDING ON AN ERASED NODE CAN STILL CONTINUE ON ITS CHAIN.
+              ERASED NODES GO TO A FREE LIST AND ARE REUSED BY LATER INSERTS. EVERY REUSE INCREMENTS A GENERATION COUNTER
+              AND A SEARCH THAT MISSES RETRIES IF THE GENERATION CHANGED , AS IT MIGHT HAVE BEEN MOVED TO ANOTHER CHAIN BY A REUSED NODE
+
+            - KEYS AND VALUES ARE STORED IN ATOMIC WORDS AS A REUSED NODE MAY BE REWRITTEN WHILE A SEARCH IS READING IT.
+              A SEARCH THAT HITS ALSO RETRIES IF THE GENERATION CHANGED , SO IT NEVER RETURNS A VALUE MIXED WITH A LATER INSERT ( SEQLOCK READ )
 
             - USES SEPARATE CHAINING WITH ATOMIC LINKED LIST NODES AND ATOMIC HEAD AND CAS TO MAKE SEARCHS LOCKFREE WHILE THERE ARE ONGOING INSERTIONS
 
@@ -13,7 +20,7 @@
 
             - DTOR IS NOT THREAD SAFE HOWEVER IT IS TIED TO THE END OF HOST PROGRAM
 
-    - ITEMS REMOVALS & OBJECTS CTORS WITH ARGUMENTS NOT SUPPORTED
+    - OBJECTS CTORS WITH ARGUMENTS NOT SUPPORTED , KEYS SHOULD BE LOCK FREE ATOMICS AND VALUES SHOULD BE TRIVIALLY COPYABLE
 
     - DEFAULT HASH FUNCTION : MurmurHash3 https://en.wikipedia.org/wiki/MurmurHash
 */
@@ -23,8 +30,10 @@
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
+#include "../compiler/builtin_functions.h"
 #include "../compiler/hints_branch_predictor.h"
 #include "../compiler/hints_hot_code.h"
 #include "../compiler/unused.h"
@@ -39,11 +48,17 @@ class MPMCDictionary
 {
     public:
 
+        static_assert(std::atomic<Key>::is_always_lock_free);
+        static_assert(std::is_trivially_copyable_v<Value>);
+
+        static constexpr std::size_t VALUE_WORD_COUNT = (sizeof(Value) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
         struct DictionaryNode
         {
-            Key key;
-            Value value;
+            std::atomic<Key> key = Key{};
+            std::atomic<uint64_t> value_words[VALUE_WORD_COUNT] = {};
             std::atomic<DictionaryNode*> next = nullptr;
+            DictionaryNode* next_free = nullptr;    // Separate from next as readers may still be traversing over an erased node
 
             DictionaryNode() = default;
         };
@@ -82,7 +97,7 @@ class MPMCDictionary
                 m_table[i].store(nullptr, std::memory_order_relaxed);
             }
 
-            m_insertion_lock.initialise();
+            m_write_lock.initialise();
 
             if (build_node_cache() == false)
             {
@@ -96,33 +111,34 @@ class MPMCDictionary
         {
             assert(m_table && m_table_size > 0);
 
-            m_insertion_lock.lock();
+            m_write_lock.lock();
             ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            if (m_node_cache_index >= m_node_cache_capacity)
+            DictionaryNode* new_node = nullptr;
+
+            if (m_free_nodes != nullptr)
             {
-                if (llmalloc_unlikely(build_node_cache() == false))
+                new_node = m_free_nodes;
+                m_free_nodes = new_node->next_free;
+                prepare_reuse();
+            }
+            else
+            {
+                if (m_node_cache_index >= m_node_cache_capacity)
                 {
-                    m_insertion_lock.unlock();
-                    return false;
+                    if (llmalloc_unlikely(build_node_cache() == false))
+                    {
+                        m_write_lock.unlock();
+                        return false;
+                    }
                 }
-            }
-
-            DictionaryNode* new_node = m_node_cache + m_node_cache_index;
-            new_node->key = key;
-            new_node->value = value;
-
-            std::size_t index = hash(key);
-            DictionaryNode* old_head = m_table[index].load(std::memory_order_relaxed);
 
-            do
-            {
-                new_node->next.store(old_head, std::memory_order_relaxed);
+                new_node = m_node_cache + m_node_cache_index;
+                ++m_node_cache_index;
             }
-            while (!m_table[index].compare_exchange_weak(old_head, new_node, std::memory_order_release, std::memory_order_relaxed));
 
-            ++m_node_cache_index;
+            link_node(new_node, key, value);
             ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            m_insertion_lock.unlock();
+            m_write_lock.unlock();
             return true;
         }
 
@@ -132,20 +148,83 @@ class MPMCDictionary
 
             std::size_t index = hash(key);
 
-            DictionaryNode* current = m_table[index].load(std::memory_order_acquire);
-
-            while (current) 
+            while (true)
             {
-                if (current->key == key) 
+                uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+                DictionaryNode* current = m_table[index].load(std::memory_order_acquire);
+
+                while (current) 
+                {
+                    if (current->key.load(std::memory_order_relaxed) == key) 
+                    {
+                        load_value(current, value);
+
+                        // The node may have been reused while being read
+                        std::atomic_thread_fence(std::memory_order_acquire);
+
+                        if (llmalloc_likely(m_generation.load(std::memory_order_relaxed) == generation))
+                        {
+                            return true;
+                        }
+
+                        break;
+                    }
+
+                    current = current->next.load(std::memory_order_acquire);
+                }
+
+                if (llmalloc_likely(m_generation.load(std::memory_order_acquire) == generation))
                 {
-                    value = current->value;
-                    return true;
+                    return false;
                 }
+            }
+        }
+
+        // Returns the value of the erased item
+        bool erase(const Key& key, Value& value)
+        {
+            assert(m_table && m_table_size > 0);
+
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            DictionaryNode* node = unlink_node(key, value);
 
-                current = current->next.load(std::memory_order_acquire);
+            if (node)
+            {
+                node->next_free = m_free_nodes;
+                m_free_nodes = node;
             }
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
+            return node != nullptr;
+        }
+
+        // Detach and attach move an item to another key without a window in which another insert could take its node , so attach can't fail.
+        // Detach erases the item and hands its node to the caller instead of the free list. Returns nullptr if the key is not found
+        DictionaryNode* detach(const Key& key, Value& value)
+        {
+            assert(m_table && m_table_size > 0);
+
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            DictionaryNode* node = unlink_node(key, value);
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
+            return node;
+        }
+
+        // Inserts with a node returned from detach
+        void attach(DictionaryNode* node, const Key& key, const Value& value)
+        {
+            assert(m_table && m_table_size > 0 && node);
 
-            return false;
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            prepare_reuse();
+            link_node(node, key, value);
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
         }
 
     private:
@@ -153,7 +232,10 @@ class MPMCDictionary
         std::size_t m_table_size = 0;
 
         HashFunction m_hash;
-        UserspaceSpinlock<> m_insertion_lock;
+        UserspaceSpinlock<> m_write_lock;
+
+        DictionaryNode* m_free_nodes = nullptr;
+        std::atomic<uint64_t> m_generation = 0;
 
         DictionaryNode* m_node_cache = nullptr;
         std::size_t m_node_cache_index = 0;
@@ -180,6 +262,90 @@ class MPMCDictionary
             return true;
         }
 
+        // Should be called under the write lock , before an unlinked node is rewritten
+        void prepare_reuse()
+        {
+            // Readers which may be standing on the node will notice that they might have been moved to another chain
+            m_generation.fetch_add(1, std::memory_order_acq_rel);
+            // Pairs with the fence in get , a reader which sees any of the new key and value words also sees the increment
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        // Should be called under the write lock
+        void link_node(DictionaryNode* node, const Key& key, const Value& value)
+        {
+            node->key.store(key, std::memory_order_relaxed);
+            store_value(node, value);
+
+            std::size_t index = hash(key);
+            DictionaryNode* old_head = m_table[index].load(std::memory_order_relaxed);
+
+            do
+            {
+                node->next.store(old_head, std::memory_order_release); // Release as readers on a reused node should also see the generation increment
+            }
+            while (!m_table[index].compare_exchange_weak(old_head, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Should be called under the write lock , returns the unlinked node or nullptr if the key is not found
+        DictionaryNode* unlink_node(const Key& key, Value& value)
+        {
+            std::size_t index = hash(key);
+            DictionaryNode* previous = nullptr;
+            DictionaryNode* current = m_table[index].load(std::memory_order_relaxed);
+
+            while (current)
+            {
+                if (current->key.load(std::memory_order_relaxed) == key)
+                {
+                    DictionaryNode* next = current->next.load(std::memory_order_relaxed);
+
+                    if (previous == nullptr)
+                    {
+                        m_table[index].store(next, std::memory_order_release);
+                    }
+                    else
+                    {
+                        previous->next.store(next, std::memory_order_release);
+                    }
+
+                    load_value(current, value);
+
+                    // Not touching current->next as there may be readers on this node
+                    return current;
+                }
+
+                previous = current;
+                current = current->next.load(std::memory_order_relaxed);
+            }
+
+            return nullptr;
+        }
+
+        // Relaxed word loads and stores compile to plain moves , consistency is provided by the generation checks
+        static void store_value(DictionaryNode* node, const Value& value)
+        {
+            uint64_t words[VALUE_WORD_COUNT] = {};
+            llmalloc_builtin_memcpy(words, &value, sizeof(Value));
+
+            for (std::size_t i = 0; i < VALUE_WORD_COUNT; i++)
+            {
+                node->value_words[i].store(words[i], std::memory_order_relaxed);
+            }
+        }
+
+        static void load_value(const DictionaryNode* node, Value& value)
+        {
+            uint64_t words[VALUE_WORD_COUNT];
+
+            for (std::size_t i = 0; i < VALUE_WORD_COUNT; i++)
+            {
+                words[i] = node->value_words[i].load(std::memory_order_relaxed);
+            }
+
+            llmalloc_builtin_memcpy(&value, words, sizeof(Value));
+        }
+
         LLMALLOC_FORCE_INLINE std::size_t hash(const Key& key) const
         {
             auto hash_value = m_hash(key);
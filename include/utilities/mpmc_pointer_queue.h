@@ -0,0 +1,197 @@
+/*
+    - BOUNDED MPMC QUEUE FOR POINTERS / NON ZERO 8 BYTE VALUES. SLOTS ARE SINGLE ATOMICS AND ZERO MEANS AN EMPTY SLOT , SO THERE ARE NO PER SLOT SEQUENCES
+      A queued pointer costs 8 bytes rather than a cache line as in MPMCBoundedQueue
+
+    - PRODUCERS AND CONSUMERS CLAIM TICKETS WITH CAS ON HEAD AND TAIL COUNTERS ONLY AFTER THEY SEE THEIR SLOT EMPTY OR FULL.
+      Therefore they never wait after claiming. If the other side of the slot is not done yet , they fail as when the queue is full or empty
+      and the caller takes its fallback as with MPMCBoundedQueue
+
+    - CONSECUTIVE TICKETS ARE MAPPED TO DIFFERENT CACHE LINES SO THAT CONCURRENT PUSHES AND POPS DON'T FALSE SHARE SLOTS
+
+    - CONSUMERS CAN POP IN BATCHES WITH A SINGLE CAS. ORDERING IS FIFO ONLY PER SLOT WHICH IS ENOUGH FOR FREE LISTS
+*/
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "../compiler/hints_hot_code.h"
+#include "../cpu/alignment_constants.h"
+
+template <typename T, typename AllocatorType>
+class MPMCPointerQueue
+{
+    public:
+
+        static_assert(std::is_integral<T>::value && sizeof(T) == sizeof(void*), "MPMCPointerQueue items should be addresses.");
+
+        static constexpr std::size_t SLOTS_PER_CACHE_LINE = AlignmentConstants::CPU_CACHE_LINE_SIZE / sizeof(std::atomic<T>);
+
+        MPMCPointerQueue()
+        {
+            static_assert(offsetof(MPMCPointerQueue, m_tail) - offsetof(MPMCPointerQueue, m_head) == static_cast<std::ptrdiff_t>(AlignmentConstants::CPU_CACHE_LINE_SIZE), "head and tail must be a cache line apart to prevent false sharing");
+        }
+
+        ~MPMCPointerQueue()
+        {
+            if (m_slots)
+            {
+                AllocatorType::deallocate(m_slots, m_capacity * sizeof(std::atomic<T>));
+            }
+        }
+
+        MPMCPointerQueue(const MPMCPointerQueue& other) = delete;
+        MPMCPointerQueue& operator= (const MPMCPointerQueue& other) = delete;
+        MPMCPointerQueue(MPMCPointerQueue&& other) = delete;
+        MPMCPointerQueue& operator=(MPMCPointerQueue&& other) = delete;
+
+        // Capacity is rounded up to a multiple of slots per cache line
+        bool create(std::size_t capacity)
+        {
+            if (capacity < 1)
+            {
+                return false;
+            }
+
+            m_capacity = ((capacity + SLOTS_PER_CACHE_LINE - 1) / SLOTS_PER_CACHE_LINE) * SLOTS_PER_CACHE_LINE;
+            m_cache_line_count = m_capacity / SLOTS_PER_CACHE_LINE;
+
+            m_slots = static_cast<std::atomic<T>*>(AllocatorType::allocate(m_capacity * sizeof(std::atomic<T>)));
+
+            if (m_slots == nullptr)
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < m_capacity; i++)
+            {
+                m_slots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        bool try_push(T t)
+        {
+            assert(t != EMPTY_SLOT);
+
+            auto head = m_head.load(std::memory_order_acquire);
+
+            for (;;)
+            {
+                // Signed as the tail can be newer than the head
+                if (static_cast<int64_t>(head - m_tail.load(std::memory_order_acquire)) >= static_cast<int64_t>(m_capacity))
+                {
+                    return false;
+                }
+
+                // Loaded after the tail : the consumer of the previous lap claimed its ticket , an empty slot means it also emptied it
+                if (get_slot(head).load(std::memory_order_acquire) != EMPTY_SLOT)
+                {
+                    auto current_head = m_head.load(std::memory_order_acquire);
+
+                    if (current_head == head)
+                    {
+                        return false; // The consumer of the previous lap is not done yet
+                    }
+
+                    head = current_head;
+                    continue;
+                }
+
+                if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            // Only the owner of the ticket can fill an empty slot
+            get_slot(head).store(t, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& t)
+        {
+            return try_pop_batch(&t, 1) == 1;
+        }
+
+        // Claims up to count leading ready tickets with a single CAS , returns the number of popped items
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            auto tail = m_tail.load(std::memory_order_acquire);
+            std::size_t claimed_count{ 0 };
+
+            for (;;)
+            {
+                auto head = m_head.load(std::memory_order_acquire);
+
+                if (static_cast<int64_t>(head - tail) <= 0)
+                {
+                    return 0;
+                }
+
+                auto claimable_count = head - tail < count ? head - tail : count;
+
+                // Out is written before the claim , the values can't change until the tail moves past them
+                for (claimed_count = 0; claimed_count < claimable_count; claimed_count++)
+                {
+                    out[claimed_count] = get_slot(tail + claimed_count).load(std::memory_order_acquire);
+
+                    if (out[claimed_count] == EMPTY_SLOT)
+                    {
+                        break;
+                    }
+                }
+
+                if (claimed_count == 0)
+                {
+                    auto current_tail = m_tail.load(std::memory_order_acquire);
+
+                    if (current_tail == tail)
+                    {
+                        return 0; // The producer of the first ticket is not done yet
+                    }
+
+                    tail = current_tail;
+                    continue;
+                }
+
+                if (m_tail.compare_exchange_weak(tail, tail + claimed_count, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            for (std::size_t i = 0; i < claimed_count; i++)
+            {
+                get_slot(tail + i).store(EMPTY_SLOT, std::memory_order_release);
+            }
+
+            return claimed_count;
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed));
+        }
+
+    private:
+        static constexpr T EMPTY_SLOT = 0;
+
+        std::atomic<T>* m_slots = nullptr;
+        std::size_t m_capacity = 0;
+        std::size_t m_cache_line_count = 0;
+
+        LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
+        LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
+
+        // Consecutive tickets go to consecutive cache lines , then to the next slot of those lines
+        LLMALLOC_FORCE_INLINE std::atomic<T>& get_slot(std::size_t ticket)
+        {
+            std::size_t index = ticket % m_capacity;
+            return m_slots[(index % m_cache_line_count) * SLOTS_PER_CACHE_LINE + index / m_cache_line_count];
+        }
+};
\ No newline at end of file
@@ -0,0 +1,160 @@
+/*
+    - TWO LEVEL RADIX MAP FROM VIRTUAL MEMORY ADDRESSES TO A 1 BYTE VALUE PER OS PAGE ALLOCATION GRANULARITY ( 4KB ON LINUX , 64KB ON WINDOWS )
+
+    - USE CASE : CLASSIFYING POINTERS WITHOUT HASHING. SEGMENTS STORE LOG2 OF THEIR LOGICAL PAGE SIZES SO THAT A FREED POINTER CAN BE MASKED
+      TO REACH ITS LOGICAL PAGE HEADER. ZERO MEANS THAT THE ADDRESS DOES NOT BELONG TO A LOGICAL PAGE ( EX: LARGE OBJECTS )
+
+    - LOOKUPS ARE LOCK FREE : 2 LOADS. LEAF CREATIONS ARE PROTECTED BY A SPINLOCK AND THEY HAPPEN ONLY ONCE PER 1GB ( 4KB GRANULARITY ) OF ADDRESS SPACE
+
+    - WRITES TO THE SAME ENTRIES ARE EXPECTED TO BE SERIALISED BY CALLERS. A LOOKUP FOR AN ADDRESS IS EXPECTED TO HAPPEN AFTER ITS SET CALL,
+      WHICH IS ALWAYS THE CASE FOR ALLOCATORS AS POINTERS ARE HANDED OUT AFTER THEIR PAGES ARE CREATED
+
+    - LEAVES ARE NEVER RELEASED
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../compiler/hints_hot_code.h"
+#include "../compiler/hints_branch_predictor.h"
+#include "../compiler/builtin_functions.h"
+#include "../os/virtual_memory.h"
+
+#include "userspace_spinlock.h"
+
+template <typename Allocator>
+class PageMap
+{
+    public:
+
+        static constexpr std::size_t ADDRESS_BITS = 47; // User space virtual addresses on x64
+        static constexpr std::size_t GRANULARITY_SHIFT = VirtualMemory::PAGE_ALLOCATION_GRANULARITY == 65536 ? 16 : 12;
+        static constexpr std::size_t LEAF_BITS = 18;
+        static constexpr std::size_t ROOT_BITS = ADDRESS_BITS - GRANULARITY_SHIFT - LEAF_BITS;
+        static constexpr std::size_t LEAF_SIZE = static_cast<std::size_t>(1) << LEAF_BITS;
+        static constexpr std::size_t ROOT_SIZE = static_cast<std::size_t>(1) << ROOT_BITS;
+
+        PageMap() = default;
+        ~PageMap() = default;
+
+        PageMap(const PageMap& other) = delete;
+        PageMap& operator= (const PageMap& other) = delete;
+        PageMap(PageMap&& other) = delete;
+        PageMap& operator=(PageMap&& other) = delete;
+
+        bool initialise()
+        {
+            static_assert(static_cast<std::size_t>(1) << GRANULARITY_SHIFT == VirtualMemory::PAGE_ALLOCATION_GRANULARITY);
+
+            if (m_root != nullptr)
+            {
+                return true;
+            }
+
+            m_root = reinterpret_cast<std::atomic<uint8_t*>*>(Allocator::allocate(ROOT_SIZE * sizeof(std::atomic<uint8_t*>)));
+
+            if (m_root == nullptr)
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < ROOT_SIZE; i++)
+            {
+                m_root[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            m_leaf_creation_lock.initialise();
+
+            return true;
+        }
+
+        // Sets value for all granules of [address, address+size)
+        bool set(void* address, std::size_t size, uint8_t value)
+        {
+            uint64_t start = reinterpret_cast<uint64_t>(address) >> GRANULARITY_SHIFT;
+            uint64_t end = (reinterpret_cast<uint64_t>(address) + size + VirtualMemory::PAGE_ALLOCATION_GRANULARITY - 1) >> GRANULARITY_SHIFT;
+
+            while (start < end)
+            {
+                uint8_t* leaf = get_or_create_leaf(start >> LEAF_BITS);
+
+                if (llmalloc_unlikely(leaf == nullptr))
+                {
+                    return false;
+                }
+
+                uint64_t leaf_index = start & (LEAF_SIZE - 1);
+                uint64_t count = LEAF_SIZE - leaf_index;
+                count = (end - start) < count ? (end - start) : count;
+
+                llmalloc_builtin_memset(leaf + leaf_index, value, count);
+                start += count;
+            }
+
+            return true;
+        }
+
+        void clear(void* address, std::size_t size)
+        {
+            set(address, size, 0);
+        }
+
+        LLMALLOC_FORCE_INLINE uint8_t get(void* address) const
+        {
+            uint64_t index = reinterpret_cast<uint64_t>(address) >> GRANULARITY_SHIFT;
+            uint64_t root_index = index >> LEAF_BITS;
+
+            if (llmalloc_unlikely(root_index >= ROOT_SIZE))
+            {
+                return 0;
+            }
+
+            uint8_t* leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (llmalloc_unlikely(leaf == nullptr))
+            {
+                return 0;
+            }
+
+            return leaf[index & (LEAF_SIZE - 1)];
+        }
+
+    private:
+        std::atomic<uint8_t*>* m_root = nullptr;
+        UserspaceSpinlock<> m_leaf_creation_lock;
+
+        uint8_t* get_or_create_leaf(uint64_t root_index)
+        {
+            if (root_index >= ROOT_SIZE)
+            {
+                return nullptr;
+            }
+
+            uint8_t* leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (llmalloc_likely(leaf != nullptr))
+            {
+                return leaf;
+            }
+
+            m_leaf_creation_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (leaf == nullptr)
+            {
+                leaf = reinterpret_cast<uint8_t*>(Allocator::allocate(LEAF_SIZE)); // Comes zeroed from the OS
+
+                if (leaf != nullptr)
+                {
+                    m_root[root_index].store(leaf, std::memory_order_release);
+                }
+            }
+            ////////////////////////////////////////////////////////////////////
+            m_leaf_creation_lock.unlock();
+
+            return leaf;
+        }
+};
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class QueueUtilities
+{
+    public:
+
+        static constexpr std::size_t POP_BATCH_CAPACITY = 64; // Stack buffer size for batch pops
+
+        // Queues can claim a batch at once , MPMC ones with a single CAS. Pops up to count items as pointers , returns the number of popped items
+        template <typename QueueType>
+        static std::size_t pop_batch(QueueType& queue, std::size_t count, void** out)
+        {
+            uint64_t pointers[POP_BATCH_CAPACITY];
+            std::size_t popped{ 0 };
+
+            while (popped < count)
+            {
+                std::size_t requested = count - popped < POP_BATCH_CAPACITY ? count - popped : POP_BATCH_CAPACITY;
+                std::size_t batch_count = queue.try_pop_batch(pointers, requested);
+
+                for (std::size_t i = 0; i < batch_count; i++)
+                {
+                    out[popped++] = reinterpret_cast<void*>(pointers[i]);
+                }
+
+                if (batch_count < requested)
+                {
+                    break;
+                }
+            }
+
+            return popped;
+        }
+};
\ No newline at end of file
@@ -5,6 +5,12 @@ rm -f llmalloc*so* so_tests
 g++ -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17  -fPIC -o llmalloc.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
 # RELEASE VERSION WITH -DUSE_ALLOC_HEADERS
 g++ -DUSE_ALLOC_HEADERS -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17  -fPIC -o llmalloc_use_alloc_headers.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
+# RELEASE VERSION WITH -DUSE_QUARTER_POW2_SIZE_CLASSES
+g++ -DUSE_QUARTER_POW2_SIZE_CLASSES -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17  -fPIC -o llmalloc_quarter_pow2.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
+# RELEASE WITH STATS
+g++ -DENABLE_STATS -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17  -fPIC -o llmalloc_stats.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
+# RELEASE WITH EXTERNAL HEAP ACCESS
+g++ -DENABLE_EXTERNAL_HEAP_ACCESS -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17  -fPIC -o llmalloc_external_heap_access.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
 # RELEASE WITH PERF TRACES
 g++ -DENABLE_PERF_TRACES -DDISPLAY_ENV_VARS -DNDEBUG -O3 -fno-rtti -shared -I../ -std=c++17 -fPIC -o llmalloc_perf_traces.so.${VERSION} llmalloc.cpp -lstdc++ -pthread -ldl
 # DEBUG VERSION
@@ -8,6 +8,7 @@
 #include <dlfcn.h>
 #include <errno.h>
 
+#define ENABLE_INITIAL_EXEC_TLS // This so is loaded at process startup via LD_PRELOAD , therefore static TLS model is safe
 #include <llmalloc.h>
 using namespace llmalloc;
 using ScalableAllocatorType = ScalableMalloc;
@@ -29,7 +30,8 @@ void initialise_shared_object()
 
     if(shared_object_loaded==true) { initialisatin_lock.unlock(); return; }
 
-    bool success = ScalableAllocatorType::get_instance().create();
+    // Creating background threads allocates , so they are started after releasing the lock
+    bool success = ScalableAllocatorType::get_instance().create(ScalableMallocOptions(), false);
 
     if(success == false)
     {
@@ -41,6 +43,8 @@ void initialise_shared_object()
         shared_object_loaded = true;
     }
     initialisatin_lock.unlock();
+
+    ScalableAllocatorType::get_instance().start_background_threads();
 }
 
 void uninit_shared_object()
@@ -281,14 +285,14 @@ void __libc_free_sized(void* ptr, std::size_t size)
 {
     initialise_shared_object();
 
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size);
 }
 
 void __libc_free_aligned_sized(void* ptr, std::size_t alignment, std::size_t size)
 {
     initialise_shared_object();
 
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size, alignment);
 }
 
 void* __libc_reallocarray(void *ptr, size_t nelem, size_t elsize)
@@ -346,12 +350,13 @@ void *pvalloc(std::size_t size)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // malloc_trim
+// Pad is ignored as there is no single top chunk. Returns 1 if any memory was released
 int malloc_trim(std::size_t pad)
 {
     initialise_shared_object();
 
-    // Since ScalableAllocator does not support trimming, it returns 0 to indicate success.
-    return 0;
+    LLMALLOC_UNUSED(pad);
+    return ScalableAllocatorType::get_instance().trim() ? 1 : 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -372,12 +377,76 @@ struct mallinfo
     int keepcost; // top-most, releasable space (in bytes)
 };
 
-mallinfo mallinfo()
+// Same as mallinfo with size_t fields , available since glibc 2.33
+struct mallinfo2
+{
+    std::size_t arena;
+    std::size_t ordblks;
+    std::size_t smblks;
+    std::size_t hblks;
+    std::size_t hblkhd;
+    std::size_t usmblks;
+    std::size_t fsmblks;
+    std::size_t uordblks;
+    std::size_t fordblks;
+    std::size_t keepcost;
+};
+
+// Arena is the memory heaps hold and mmapped regions are large objects. Keepcost is the memory malloc_trim can release
+struct mallinfo2 mallinfo2()
 {
+    initialise_shared_object();
+
+    auto usage = ScalableAllocatorType::get_instance().get_memory_usage();
+
+    struct mallinfo2 info = {0};
+    info.arena = usage.heap_size;
+    info.hblks = usage.large_object_count;
+    info.hblkhd = usage.large_object_size;
+    info.uordblks = usage.heap_used_size;
+    info.fordblks = usage.heap_size - usage.heap_used_size;
+    info.keepcost = usage.retained_size;
+    return info;
+}
+
+// Fields are clamped as they are int
+struct mallinfo mallinfo()
+{
+    auto info2 = mallinfo2();
+    auto clamp = [](std::size_t value) { return value > static_cast<std::size_t>(INT_MAX) ? INT_MAX : static_cast<int>(value); };
+
     struct mallinfo info = {0};
+    info.arena = clamp(info2.arena);
+    info.hblks = clamp(info2.hblks);
+    info.hblkhd = clamp(info2.hblkhd);
+    info.uordblks = clamp(info2.uordblks);
+    info.fordblks = clamp(info2.fordblks);
+    info.keepcost = clamp(info2.keepcost);
     return info;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// malloc_stats
+void malloc_stats()
+{
+    auto info = mallinfo2();
+    fprintf(stderr, "Total (incl. mmap):\nsystem bytes     = %10zu\nin use bytes     = %10zu\nmmap regions     = %10zu\nmmap bytes       = %10zu\nreleasable bytes = %10zu\n", info.arena + info.hblkhd, info.uordblks + info.hblkhd, info.hblks, info.hblkhd, info.keepcost);
+
+    // Per size class counters are collected only with ENABLE_STATS , and get_stats walks segments of all heaps
+    #ifdef ENABLE_STATS
+    auto stats = ScalableAllocatorType::get_instance().get_stats();
+    fprintf(stderr, "%10s %12s %12s %12s %10s %8s %8s %14s %14s\n", "size class", "allocs", "frees", "remote frees", "overflows", "grows", "recycles", "resident bytes", "virtual bytes");
+
+    for (std::size_t i = 0; i < stats.bins.size(); i++)
+    {
+        const auto& bin = stats.bins[i];
+        fprintf(stderr, "%10zu %12zu %12zu %12zu %10zu %8zu %8zu %14zu %14zu\n", ScalableAllocatorType::LocalHeapType::SizeClassesType::get_size_class(i), bin.allocation_count, bin.deallocation_count, bin.cross_thread_deallocation_count, bin.queue_overflow_count, bin.segment_grow_count, bin.recycled_logical_page_count, bin.resident_size, bin.virtual_size);
+    }
+
+    fprintf(stderr, "central heap fallbacks = %zu\narena chunk builds     = %zu\n", stats.central_heap_fallback_count, stats.arena_chunk_build_count);
+    #endif
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // mallopt
 int mallopt(int param, int value)
@@ -559,45 +628,35 @@ void operator delete[](void* ptr, std::size_t, const std::nothrow_t &) noexcept
 void operator delete(void* ptr, std::size_t size) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size);
 }
 
 void operator delete[](void* ptr, std::size_t size) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size);
 }
 
 void operator delete(void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete[](void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete(void* ptr, std::size_t size, std::size_t align) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size, align);
 }
 
 void operator delete[](void* ptr, std::size_t size, std::size_t align) noexcept
 {
     initialise_shared_object();
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    ScalableAllocatorType::get_instance().deallocate(ptr);
+    ScalableAllocatorType::get_instance().deallocate_sized(ptr, size, align);
 }
\ No newline at end of file
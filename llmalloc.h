@@ -49,6 +49,7 @@ available at https://github.com/rigtorp/MPMCQueue, which is licenced under the M
 #include <memory_resource>
 #endif
 #ifdef ENABLE_OVERRIDE
+#include <cstdio>
 #include <stdexcept>
 #endif
 // CPU INTRINSICS
@@ -62,9 +63,13 @@ available at https://github.com/rigtorp/MPMCQueue, which is licenced under the M
 #ifdef __linux__
 #include <unistd.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <pthread.h>
 #include <sched.h>
 #include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
 #ifdef ENABLE_OVERRIDE
 #include <limits.h>
 #include <dlfcn.h>
@@ -544,7 +549,120 @@ class VirtualMemory
             #endif
             return ret;
         }
-        
+
+        // Returns physical pages of a range while keeping it mapped. With lazy discards the OS reclaims them only under memory pressure
+        // Linux : MADV_DONTNEED pages read back as zeroes , MADV_FREE ( lazy ) pages may keep their old contents
+        // Windows : MEM_RESET in both cases , contents are undefined
+        static bool discard(void* address, std::size_t size, bool lazy)
+        {
+            bool ret{ false };
+            #ifdef __linux__
+            #ifdef MADV_FREE
+            if (lazy && madvise(address, size, MADV_FREE) == 0)
+            {
+                return true;
+            }
+            #else
+            LLMALLOC_UNUSED(lazy);
+            #endif
+            // Kernels older than 4.5 don't support MADV_FREE
+            ret = madvise(address, size, MADV_DONTNEED) == 0 ? true : false;
+            #elif _WIN32
+            LLMALLOC_UNUSED(lazy);
+            ret = VirtualAlloc(address, size, MEM_RESET, PAGE_READWRITE) != nullptr ? true : false;
+            #endif
+            return ret;
+        }
+
+        // Whether pages read back as zeroes after a discard
+        static bool are_discarded_pages_zeroed(bool lazy)
+        {
+            #ifdef __linux__
+            return lazy == false;
+            #elif _WIN32
+            LLMALLOC_UNUSED(lazy);
+            return false;
+            #endif
+        }
+
+        // Resizes a mapping which may move to another address. Returns nullptr on failure and when not supported ( Windows has no mremap equivalent )
+        // Contents are preserved up to the smaller size and the old mapping becomes invalid on success
+        static void* reallocate(void* address, std::size_t old_size, std::size_t new_size)
+        {
+            void* ret{ nullptr };
+            #ifdef __linux__
+            ret = mremap(address, old_size, new_size, MREMAP_MAYMOVE);
+
+            if (ret == MAP_FAILED)
+            {
+                ret = nullptr;
+            }
+            #elif _WIN32
+            LLMALLOC_UNUSED(address);
+            LLMALLOC_UNUSED(old_size);
+            LLMALLOC_UNUSED(new_size);
+            #endif
+            return ret;
+        }
+
+        // Reserves address space without committing memory. Pages can't be accessed before they are committed and they can be released with deallocate
+        static void* reserve(std::size_t size, void* hint_address = nullptr)
+        {
+            void* ret = nullptr;
+            #ifdef __linux__
+            // MAP_NORESERVE so that reservations are not accounted against overcommit limits
+            ret = mmap(hint_address, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+            if (ret == MAP_FAILED)
+            {
+                ret = nullptr;
+            }
+            #elif _WIN32
+            ret = VirtualAlloc(hint_address, size, MEM_RESERVE, PAGE_NOACCESS);
+            #endif
+            return ret;
+        }
+
+        // Commits pages of a reserved range. They come zeroed and get backed by physical memory on first touch unless they are prefaulted
+        static bool commit(void* address, std::size_t size, bool prefault)
+        {
+            bool ret{ false };
+            #ifdef __linux__
+            ret = mprotect(address, size, PROT_READ | PROT_WRITE) == 0 ? true : false;
+            #elif _WIN32
+            ret = VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr ? true : false;
+            #endif
+
+            if (ret && prefault)
+            {
+                VirtualMemory::prefault(address, size);
+            }
+
+            return ret;
+        }
+
+        // Equivalent of MAP_POPULATE for already mapped ranges. Should be called only for committed pages which are not handed out yet
+        static void prefault(void* address, std::size_t size)
+        {
+            #ifdef __linux__
+            constexpr int MADV_POPULATE_WRITE_ADVICE = 23; // MADV_POPULATE_WRITE , Linux 5.14+
+
+            if (madvise(address, size, MADV_POPULATE_WRITE_ADVICE) == 0)
+            {
+                return;
+            }
+            #endif
+
+            // Older kernels and Windows , touching a byte per page
+            auto page_size = get_page_size();
+
+            for (std::size_t offset = 0; offset < size; offset += page_size)
+            {
+                volatile char* page = static_cast<volatile char*>(address) + offset;
+                *page = *page;
+            }
+        }
+
         #ifdef __linux__
         // THP stands for "transparent huge page". A Linux mechanism
         // It affects how we handle allocation of huge pages on Linux
@@ -676,9 +794,20 @@ class VirtualMemory
 };
 /*  
     Standard C++ thread_local keyword does not allow you to specify thread specific destructors
-    and also can't be applied to class members
+    and also can't be applied to non-static class members
+
+    Therefore this class is used only for getting thread exit callbacks. Hot paths should cache their per thread data in
+    LLMALLOC_THREAD_LOCAL variables which won't cost a function call unlike pthread_getspecific/FlsGetValue
 */
 
+// Initial-exec TLS model resolves thread locals with a single fs-relative load instead of __tls_get_addr calls in shared objects.
+// It is safe only for executables and shared objects loaded at startup ( LD_PRELOAD ) as dlopen'ed libraries may fail to load with it
+#if defined(__GNUC__) && defined(ENABLE_INITIAL_EXEC_TLS)
+#define LLMALLOC_THREAD_LOCAL thread_local __attribute__((tls_model("initial-exec")))
+#else
+#define LLMALLOC_THREAD_LOCAL thread_local
+#endif
+
 class ThreadLocalStorage
 {
     public:
@@ -757,6 +886,10 @@ class ThreadLocalStorage
                 static unsigned int get_number_of_physical_cores()
                 static bool is_hyper_threading()
                 static inline void yield()
+                static bool create_detached_thread(ThreadFunction function, void* argument)
+                static void set_current_thread_priority_to_low()
+                static bool register_fork_handlers(ForkHandler prepare, ForkHandler parent, ForkHandler child)
+                static bool issue_process_wide_memory_barrier()
 
 */
 
@@ -770,6 +903,14 @@ class ThreadUtilities
 {
     public:
 
+        #ifdef __linux__
+        using ThreadFunction = void* (*)(void*);
+        #elif _WIN32
+        using ThreadFunction = LPTHREAD_START_ROUTINE;
+        #endif
+
+        using ForkHandler = void (*)();
+
         static unsigned int get_number_of_logical_cores()
         {
             unsigned int num_cores{0};
@@ -842,7 +983,119 @@ class ThreadUtilities
             #endif
         }
 
+        // Avoids std::thread as it allocates
+        static bool create_detached_thread(ThreadFunction function, void* argument)
+        {
+            bool ret = false;
+            #ifdef __linux__
+            pthread_attr_t attributes;
+
+            if (pthread_attr_init(&attributes) != 0)
+            {
+                return false;
+            }
+
+            pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+            pthread_t thread;
+            ret = pthread_create(&thread, &attributes, function, argument) == 0;
+
+            pthread_attr_destroy(&attributes);
+            #elif _WIN32
+            HANDLE thread = CreateThread(nullptr, 0, function, argument, 0, nullptr);
+
+            if (thread != nullptr)
+            {
+                CloseHandle(thread);
+                ret = true;
+            }
+            #endif
+            return ret;
+        }
+
+        // Lowers the priority within the normal scheduling policy , unlike SCHED_IDLE the thread can't be starved by busy threads
+        static void set_current_thread_priority_to_low()
+        {
+            #ifdef __linux__
+            // Nice values are per thread on Linux
+            setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), LOW_PRIORITY_NICE_VALUE);
+            #elif _WIN32
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+            #endif
+        }
+
+        // Handlers run around fork calls , the child one runs in the child process. No-op on Windows as there is no fork
+        static bool register_fork_handlers(ForkHandler prepare, ForkHandler parent, ForkHandler child)
+        {
+            #ifdef __linux__
+            return pthread_atfork(prepare, parent, child) == 0;
+            #elif _WIN32
+            return true;
+            #endif
+        }
+
+        // Executes a full memory barrier on all running threads of the process , so that the other side of a Dekker style handshake can use only compiler barriers
+        static bool issue_process_wide_memory_barrier()
+        {
+            #ifdef __linux__
+            if (syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0)
+            {
+                return true;
+            }
+
+            // Needs Linux 4.14 and a registration once per process
+            if (syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) != 0)
+            {
+                return false;
+            }
+
+            return syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) == 0;
+            #elif _WIN32
+            FlushProcessWriteBuffers();
+            return true;
+            #endif
+        }
+
     private:
+        static constexpr int LOW_PRIORITY_NICE_VALUE = 10;
+};
+/*
+    Provides :
+
+                static uint64_t get_monotonic_time_in_milliseconds()
+                static void sleep_in_milliseconds(uint64_t milliseconds)
+
+*/
+
+class TimeUtilities
+{
+    public:
+
+        // Coarse clocks are enough for decay periods and they don't need a syscall ( vDSO on Linux )
+        static uint64_t get_monotonic_time_in_milliseconds()
+        {
+            uint64_t ret{ 0 };
+            #ifdef __linux__
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            ret = static_cast<uint64_t>(ts.tv_sec) * 1000 + static_cast<uint64_t>(ts.tv_nsec) / 1000000;
+            #elif _WIN32
+            ret = static_cast<uint64_t>(GetTickCount64());
+            #endif
+            return ret;
+        }
+
+        static void sleep_in_milliseconds(uint64_t milliseconds)
+        {
+            #ifdef __linux__
+            struct timespec ts;
+            ts.tv_sec = static_cast<time_t>(milliseconds / 1000);
+            ts.tv_nsec = static_cast<long>((milliseconds % 1000) * 1000000);
+            nanosleep(&ts, nullptr);
+            #elif _WIN32
+            Sleep(static_cast<DWORD>(milliseconds));
+            #endif
+        }
 };
 
 #ifdef DISPLAY_ENV_VARS
@@ -1243,6 +1496,18 @@ class BoundedQueue
             
             return true;
         }
+
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            std::size_t popped{ 0 };
+
+            while (popped < count && try_pop(out[popped]))
+            {
+                popped++;
+            }
+
+            return popped;
+        }
     
     private:
         LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) typename SinglyLinkedList<T>::SinglyLinkedListNode* m_head = nullptr;
@@ -1250,6 +1515,71 @@ class BoundedQueue
         std::size_t m_buffer_length = 0;
         SinglyLinkedList<T> m_freelist; // Underlying memory
 };
+/*
+    - NON THREAD SAFE UNBOUNDED LIFO QUEUE OF MEMORY ADDRESSES. ITEMS ARE LINKED THROUGH THEIR OWN FIRST 8 BYTES SO THERE ARE NO NODE BUFFERS AND NO CAPACITY LIMIT
+
+    - USE CASE : THREAD LOCAL DEALLOCATION QUEUES OF HEAPS , AS A FREED CHUNK IS NOT USED UNTIL IT IS ALLOCATED AGAIN.
+      Pushed addresses should point to writable memory of at least 8 bytes which stays valid until they are popped
+
+    - SAME INTERFACE AS BoundedQueue SO THAT IT CAN BE PASSED AS DeallocationQueueType. Capacities are ignored and try_push never fails
+*/
+
+template <typename T = uint64_t>
+class IntrusiveLIFOQueue
+{
+    public:
+
+        static_assert(sizeof(T) == sizeof(void*), "IntrusiveLIFOQueue items should be addresses.");
+
+        bool create(std::size_t capacity)
+        {
+            LLMALLOC_UNUSED(capacity);
+            m_head = nullptr;
+            return true;
+        }
+
+        LLMALLOC_FORCE_INLINE bool try_push(T t)
+        {
+            auto node = reinterpret_cast<IntrusiveNode*>(t);
+            node->m_next = m_head;
+            m_head = node;
+            return true;
+        }
+
+        LLMALLOC_FORCE_INLINE bool try_pop(T& t)
+        {
+            if (m_head == nullptr)
+            {
+                return false;
+            }
+
+            t = reinterpret_cast<T>(m_head);
+            m_head = m_head->m_next;
+            return true;
+        }
+
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            std::size_t popped{ 0 };
+
+            while (popped < count && m_head != nullptr)
+            {
+                out[popped++] = reinterpret_cast<T>(m_head);
+                m_head = m_head->m_next;
+            }
+
+            return popped;
+        }
+
+    private:
+
+        struct IntrusiveNode
+        {
+            IntrusiveNode* m_next = nullptr;
+        };
+
+        IntrusiveNode* m_head = nullptr;
+};
 /*
     REFERENCE : THIS CODE IS A COSMETICALLY MODIFIED VERSION OF ERIK RIGTORP'S IMPLEMENTATION : https://github.com/rigtorp/MPMCQueue/ ( MIT Licence )
 */
@@ -1411,6 +1741,18 @@ public:
         }
     }
 
+    std::size_t try_pop_batch(T* out, std::size_t count)
+    {
+        std::size_t popped{ 0 };
+
+        while (popped < count && try_pop(out[popped]))
+        {
+            popped++;
+        }
+
+        return popped;
+    }
+
     std::size_t size() const
     {
         return static_cast<std::size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed));
@@ -1431,76 +1773,309 @@ private:
     LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
     LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
 };
-
-template <typename T, typename Enable = void>
-struct MurmurHash3 
-{
-    std::size_t operator()(T h) const noexcept 
-    {
-        h ^= h >> 16;
-        h *= 0x85ebca6b;
-        h ^= h >> 13;
-        h *= 0xc2b2ae35;
-        h ^= h >> 16;
-        return static_cast<std::size_t>(h);
-    }
-};
-
-// 64 bit specialisation
-template <typename T>
-struct MurmurHash3<T, typename std::enable_if<std::is_same<T, uint64_t>::value>::type>
-{
-    std::size_t operator()(uint64_t h) const noexcept 
-    {
-        h ^= h >> 33;
-        h *= 0xff51afd7ed558ccd;
-        h ^= h >> 33;
-        h *= 0xc4ceb9fe1a85ec53;
-        h ^= h >> 33;
-        return static_cast<std::size_t>(h);
-    }
-};
 /*
-    - MPMC THREAD SAFE HOWEVER DESIGNED FOR A CERTAIN SCENARIO THEREFORE DON'T USE IT SOMEWHERE ELSE !
-      
-      USE CASE : WHEN INSERTS ARE VERY RARE AND SEARCHS ARE VERY FREQUENT, AND WHEN IT IS GUARANTEED THAT 
-      SEARCH FOR A SPECIFIC ITEM WILL ALWAYS GUARANTEEDLY BE CALLED AFTER ITS INSERTION :
-
-            - INSERTS ARE PROTECTED BY A SPINLOCK SO NO ABA RISK
-
-            - USES SEPARATE CHAINING WITH ATOMIC LINKED LIST NODES AND ATOMIC HEAD AND CAS TO MAKE SEARCHS LOCKFREE WHILE THERE ARE ONGOING INSERTIONS
+    - BOUNDED MPMC QUEUE FOR POINTERS / NON ZERO 8 BYTE VALUES. SLOTS ARE SINGLE ATOMICS AND ZERO MEANS AN EMPTY SLOT , SO THERE ARE NO PER SLOT SEQUENCES
+      A queued pointer costs 8 bytes rather than a cache line as in MPMCBoundedQueue
 
-            - FIXED SIZE BUCKETS/TABLE WITH NO GROWS SO THERE IS NO RISK OF A GROW AND REHASHING FROM AN INSERTION CALLSTACK DURING A SEARCH,
-              HOWEVER TABLE SIZE SHOULD BE CHOSEN CAREFULLY OTHERWISE COLLISIONS CAN DEGRADE THE PERFORMANCE
-
-            - DTOR IS NOT THREAD SAFE HOWEVER IT IS TIED TO THE END OF HOST PROGRAM
+    - PRODUCERS AND CONSUMERS CLAIM TICKETS WITH CAS ON HEAD AND TAIL COUNTERS ONLY AFTER THEY SEE THEIR SLOT EMPTY OR FULL.
+      Therefore they never wait after claiming. If the other side of the slot is not done yet , they fail as when the queue is full or empty
+      and the caller takes its fallback as with MPMCBoundedQueue
 
-    - ITEMS REMOVALS & OBJECTS CTORS WITH ARGUMENTS NOT SUPPORTED
+    - CONSECUTIVE TICKETS ARE MAPPED TO DIFFERENT CACHE LINES SO THAT CONCURRENT PUSHES AND POPS DON'T FALSE SHARE SLOTS
 
-    - DEFAULT HASH FUNCTION : MurmurHash3 https://en.wikipedia.org/wiki/MurmurHash
+    - CONSUMERS CAN POP IN BATCHES WITH A SINGLE CAS. ORDERING IS FIFO ONLY PER SLOT WHICH IS ENOUGH FOR FREE LISTS
 */
 
-template <typename Key, typename Value, typename Allocator, typename HashFunction = MurmurHash3<Key>>
-class MPMCDictionary 
+template <typename T, typename AllocatorType>
+class MPMCPointerQueue
 {
     public:
 
-        struct DictionaryNode
-        {
-            Key key;
-            Value value;
-            std::atomic<DictionaryNode*> next = nullptr;
+        static_assert(std::is_integral<T>::value && sizeof(T) == sizeof(void*), "MPMCPointerQueue items should be addresses.");
 
-            DictionaryNode() = default;
-        };
+        static constexpr std::size_t SLOTS_PER_CACHE_LINE = AlignmentConstants::CPU_CACHE_LINE_SIZE / sizeof(std::atomic<T>);
 
-        MPMCDictionary() = default;
+        MPMCPointerQueue()
+        {
+            static_assert(offsetof(MPMCPointerQueue, m_tail) - offsetof(MPMCPointerQueue, m_head) == static_cast<std::ptrdiff_t>(AlignmentConstants::CPU_CACHE_LINE_SIZE), "head and tail must be a cache line apart to prevent false sharing");
+        }
 
-        ~MPMCDictionary()
+        ~MPMCPointerQueue()
         {
-            if (m_node_cache)
+            if (m_slots)
             {
-                Allocator::deallocate(m_node_cache, sizeof(DictionaryNode) * m_node_cache_capacity);
+                AllocatorType::deallocate(m_slots, m_capacity * sizeof(std::atomic<T>));
+            }
+        }
+
+        MPMCPointerQueue(const MPMCPointerQueue& other) = delete;
+        MPMCPointerQueue& operator= (const MPMCPointerQueue& other) = delete;
+        MPMCPointerQueue(MPMCPointerQueue&& other) = delete;
+        MPMCPointerQueue& operator=(MPMCPointerQueue&& other) = delete;
+
+        // Capacity is rounded up to a multiple of slots per cache line
+        bool create(std::size_t capacity)
+        {
+            if (capacity < 1)
+            {
+                return false;
+            }
+
+            m_capacity = ((capacity + SLOTS_PER_CACHE_LINE - 1) / SLOTS_PER_CACHE_LINE) * SLOTS_PER_CACHE_LINE;
+            m_cache_line_count = m_capacity / SLOTS_PER_CACHE_LINE;
+
+            m_slots = static_cast<std::atomic<T>*>(AllocatorType::allocate(m_capacity * sizeof(std::atomic<T>)));
+
+            if (m_slots == nullptr)
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < m_capacity; i++)
+            {
+                m_slots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        bool try_push(T t)
+        {
+            assert(t != EMPTY_SLOT);
+
+            auto head = m_head.load(std::memory_order_acquire);
+
+            for (;;)
+            {
+                // Signed as the tail can be newer than the head
+                if (static_cast<int64_t>(head - m_tail.load(std::memory_order_acquire)) >= static_cast<int64_t>(m_capacity))
+                {
+                    return false;
+                }
+
+                // Loaded after the tail : the consumer of the previous lap claimed its ticket , an empty slot means it also emptied it
+                if (get_slot(head).load(std::memory_order_acquire) != EMPTY_SLOT)
+                {
+                    auto current_head = m_head.load(std::memory_order_acquire);
+
+                    if (current_head == head)
+                    {
+                        return false; // The consumer of the previous lap is not done yet
+                    }
+
+                    head = current_head;
+                    continue;
+                }
+
+                if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            // Only the owner of the ticket can fill an empty slot
+            get_slot(head).store(t, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& t)
+        {
+            return try_pop_batch(&t, 1) == 1;
+        }
+
+        // Claims up to count leading ready tickets with a single CAS , returns the number of popped items
+        std::size_t try_pop_batch(T* out, std::size_t count)
+        {
+            auto tail = m_tail.load(std::memory_order_acquire);
+            std::size_t claimed_count{ 0 };
+
+            for (;;)
+            {
+                auto head = m_head.load(std::memory_order_acquire);
+
+                if (static_cast<int64_t>(head - tail) <= 0)
+                {
+                    return 0;
+                }
+
+                auto claimable_count = head - tail < count ? head - tail : count;
+
+                // Out is written before the claim , the values can't change until the tail moves past them
+                for (claimed_count = 0; claimed_count < claimable_count; claimed_count++)
+                {
+                    out[claimed_count] = get_slot(tail + claimed_count).load(std::memory_order_acquire);
+
+                    if (out[claimed_count] == EMPTY_SLOT)
+                    {
+                        break;
+                    }
+                }
+
+                if (claimed_count == 0)
+                {
+                    auto current_tail = m_tail.load(std::memory_order_acquire);
+
+                    if (current_tail == tail)
+                    {
+                        return 0; // The producer of the first ticket is not done yet
+                    }
+
+                    tail = current_tail;
+                    continue;
+                }
+
+                if (m_tail.compare_exchange_weak(tail, tail + claimed_count, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            for (std::size_t i = 0; i < claimed_count; i++)
+            {
+                get_slot(tail + i).store(EMPTY_SLOT, std::memory_order_release);
+            }
+
+            return claimed_count;
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed));
+        }
+
+    private:
+        static constexpr T EMPTY_SLOT = 0;
+
+        std::atomic<T>* m_slots = nullptr;
+        std::size_t m_capacity = 0;
+        std::size_t m_cache_line_count = 0;
+
+        LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_head = 0;
+        LLMALLOC_ALIGN_DATA(AlignmentConstants::CPU_CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail = 0;
+
+        // Consecutive tickets go to consecutive cache lines , then to the next slot of those lines
+        LLMALLOC_FORCE_INLINE std::atomic<T>& get_slot(std::size_t ticket)
+        {
+            std::size_t index = ticket % m_capacity;
+            return m_slots[(index % m_cache_line_count) * SLOTS_PER_CACHE_LINE + index / m_cache_line_count];
+        }
+};
+
+class QueueUtilities
+{
+    public:
+
+        static constexpr std::size_t POP_BATCH_CAPACITY = 64; // Stack buffer size for batch pops
+
+        // Queues can claim a batch at once , MPMC ones with a single CAS. Pops up to count items as pointers , returns the number of popped items
+        template <typename QueueType>
+        static std::size_t pop_batch(QueueType& queue, std::size_t count, void** out)
+        {
+            uint64_t pointers[POP_BATCH_CAPACITY];
+            std::size_t popped{ 0 };
+
+            while (popped < count)
+            {
+                std::size_t requested = count - popped < POP_BATCH_CAPACITY ? count - popped : POP_BATCH_CAPACITY;
+                std::size_t batch_count = queue.try_pop_batch(pointers, requested);
+
+                for (std::size_t i = 0; i < batch_count; i++)
+                {
+                    out[popped++] = reinterpret_cast<void*>(pointers[i]);
+                }
+
+                if (batch_count < requested)
+                {
+                    break;
+                }
+            }
+
+            return popped;
+        }
+};
+
+template <typename T, typename Enable = void>
+struct MurmurHash3 
+{
+    std::size_t operator()(T h) const noexcept 
+    {
+        h ^= h >> 16;
+        h *= 0x85ebca6b;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35;
+        h ^= h >> 16;
+        return static_cast<std::size_t>(h);
+    }
+};
+
+// 64 bit specialisation
+template <typename T>
+struct MurmurHash3<T, typename std::enable_if<std::is_same<T, uint64_t>::value>::type>
+{
+    std::size_t operator()(uint64_t h) const noexcept 
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+};
+/*
+    - MPMC THREAD SAFE HOWEVER DESIGNED FOR A CERTAIN SCENARIO THEREFORE DON'T USE IT SOMEWHERE ELSE !
+      
+      USE CASE : WHEN INSERTS ARE VERY RARE AND SEARCHS ARE VERY FREQUENT, AND WHEN IT IS GUARANTEED THAT 
+      SEARCH FOR A SPECIFIC ITEM WILL ALWAYS GUARANTEEDLY BE CALLED AFTER ITS INSERTION AND BEFORE ITS ERASURE :
+
+            - INSERTS AND ERASES ARE PROTECTED BY A SPINLOCK SO NO ABA RISK
+
+            - ERASED NODES ARE UNLINKED BUT THEIR NEXT POINTERS ARE KEPT INTACT, SO A SEARCH STANDING ON AN ERASED NODE CAN STILL CONTINUE ON ITS CHAIN.
+              ERASED NODES GO TO A FREE LIST AND ARE REUSED BY LATER INSERTS. EVERY REUSE INCREMENTS A GENERATION COUNTER
+              AND A SEARCH THAT MISSES RETRIES IF THE GENERATION CHANGED , AS IT MIGHT HAVE BEEN MOVED TO ANOTHER CHAIN BY A REUSED NODE
+
+            - KEYS AND VALUES ARE STORED IN ATOMIC WORDS AS A REUSED NODE MAY BE REWRITTEN WHILE A SEARCH IS READING IT.
+              A SEARCH THAT HITS ALSO RETRIES IF THE GENERATION CHANGED , SO IT NEVER RETURNS A VALUE MIXED WITH A LATER INSERT ( SEQLOCK READ )
+
+            - USES SEPARATE CHAINING WITH ATOMIC LINKED LIST NODES AND ATOMIC HEAD AND CAS TO MAKE SEARCHS LOCKFREE WHILE THERE ARE ONGOING INSERTIONS
+
+            - FIXED SIZE BUCKETS/TABLE WITH NO GROWS SO THERE IS NO RISK OF A GROW AND REHASHING FROM AN INSERTION CALLSTACK DURING A SEARCH,
+              HOWEVER TABLE SIZE SHOULD BE CHOSEN CAREFULLY OTHERWISE COLLISIONS CAN DEGRADE THE PERFORMANCE
+
+            - DTOR IS NOT THREAD SAFE HOWEVER IT IS TIED TO THE END OF HOST PROGRAM
+
+    - OBJECTS CTORS WITH ARGUMENTS NOT SUPPORTED , KEYS SHOULD BE LOCK FREE ATOMICS AND VALUES SHOULD BE TRIVIALLY COPYABLE
+
+    - DEFAULT HASH FUNCTION : MurmurHash3 https://en.wikipedia.org/wiki/MurmurHash
+*/
+
+template <typename Key, typename Value, typename Allocator, typename HashFunction = MurmurHash3<Key>>
+class MPMCDictionary 
+{
+    public:
+
+        static_assert(std::atomic<Key>::is_always_lock_free);
+        static_assert(std::is_trivially_copyable_v<Value>);
+
+        static constexpr std::size_t VALUE_WORD_COUNT = (sizeof(Value) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        struct DictionaryNode
+        {
+            std::atomic<Key> key = Key{};
+            std::atomic<uint64_t> value_words[VALUE_WORD_COUNT] = {};
+            std::atomic<DictionaryNode*> next = nullptr;
+            DictionaryNode* next_free = nullptr;    // Separate from next as readers may still be traversing over an erased node
+
+            DictionaryNode() = default;
+        };
+
+        MPMCDictionary() = default;
+
+        ~MPMCDictionary()
+        {
+            if (m_node_cache)
+            {
+                Allocator::deallocate(m_node_cache, sizeof(DictionaryNode) * m_node_cache_capacity);
             }
 
             if (m_table)
@@ -1528,7 +2103,7 @@ class MPMCDictionary
                 m_table[i].store(nullptr, std::memory_order_relaxed);
             }
 
-            m_insertion_lock.initialise();
+            m_write_lock.initialise();
 
             if (build_node_cache() == false)
             {
@@ -1542,33 +2117,34 @@ class MPMCDictionary
         {
             assert(m_table && m_table_size > 0);
 
-            m_insertion_lock.lock();
+            m_write_lock.lock();
             ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            if (m_node_cache_index >= m_node_cache_capacity)
+            DictionaryNode* new_node = nullptr;
+
+            if (m_free_nodes != nullptr)
+            {
+                new_node = m_free_nodes;
+                m_free_nodes = new_node->next_free;
+                prepare_reuse();
+            }
+            else
             {
-                if (llmalloc_unlikely(build_node_cache() == false))
+                if (m_node_cache_index >= m_node_cache_capacity)
                 {
-                    m_insertion_lock.unlock();
-                    return false;
+                    if (llmalloc_unlikely(build_node_cache() == false))
+                    {
+                        m_write_lock.unlock();
+                        return false;
+                    }
                 }
-            }
-
-            DictionaryNode* new_node = m_node_cache + m_node_cache_index;
-            new_node->key = key;
-            new_node->value = value;
-
-            std::size_t index = hash(key);
-            DictionaryNode* old_head = m_table[index].load(std::memory_order_relaxed);
 
-            do
-            {
-                new_node->next.store(old_head, std::memory_order_relaxed);
+                new_node = m_node_cache + m_node_cache_index;
+                ++m_node_cache_index;
             }
-            while (!m_table[index].compare_exchange_weak(old_head, new_node, std::memory_order_release, std::memory_order_relaxed));
 
-            ++m_node_cache_index;
+            link_node(new_node, key, value);
             ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            m_insertion_lock.unlock();
+            m_write_lock.unlock();
             return true;
         }
 
@@ -1578,20 +2154,83 @@ class MPMCDictionary
 
             std::size_t index = hash(key);
 
-            DictionaryNode* current = m_table[index].load(std::memory_order_acquire);
-
-            while (current) 
+            while (true)
             {
-                if (current->key == key) 
+                uint64_t generation = m_generation.load(std::memory_order_acquire);
+
+                DictionaryNode* current = m_table[index].load(std::memory_order_acquire);
+
+                while (current) 
                 {
-                    value = current->value;
-                    return true;
+                    if (current->key.load(std::memory_order_relaxed) == key) 
+                    {
+                        load_value(current, value);
+
+                        // The node may have been reused while being read
+                        std::atomic_thread_fence(std::memory_order_acquire);
+
+                        if (llmalloc_likely(m_generation.load(std::memory_order_relaxed) == generation))
+                        {
+                            return true;
+                        }
+
+                        break;
+                    }
+
+                    current = current->next.load(std::memory_order_acquire);
                 }
 
-                current = current->next.load(std::memory_order_acquire);
+                if (llmalloc_likely(m_generation.load(std::memory_order_acquire) == generation))
+                {
+                    return false;
+                }
             }
+        }
 
-            return false;
+        // Returns the value of the erased item
+        bool erase(const Key& key, Value& value)
+        {
+            assert(m_table && m_table_size > 0);
+
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            DictionaryNode* node = unlink_node(key, value);
+
+            if (node)
+            {
+                node->next_free = m_free_nodes;
+                m_free_nodes = node;
+            }
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
+            return node != nullptr;
+        }
+
+        // Detach and attach move an item to another key without a window in which another insert could take its node , so attach can't fail.
+        // Detach erases the item and hands its node to the caller instead of the free list. Returns nullptr if the key is not found
+        DictionaryNode* detach(const Key& key, Value& value)
+        {
+            assert(m_table && m_table_size > 0);
+
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            DictionaryNode* node = unlink_node(key, value);
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
+            return node;
+        }
+
+        // Inserts with a node returned from detach
+        void attach(DictionaryNode* node, const Key& key, const Value& value)
+        {
+            assert(m_table && m_table_size > 0 && node);
+
+            m_write_lock.lock();
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            prepare_reuse();
+            link_node(node, key, value);
+            ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            m_write_lock.unlock();
         }
 
     private:
@@ -1599,7 +2238,10 @@ class MPMCDictionary
         std::size_t m_table_size = 0;
 
         HashFunction m_hash;
-        UserspaceSpinlock<> m_insertion_lock;
+        UserspaceSpinlock<> m_write_lock;
+
+        DictionaryNode* m_free_nodes = nullptr;
+        std::atomic<uint64_t> m_generation = 0;
 
         DictionaryNode* m_node_cache = nullptr;
         std::size_t m_node_cache_index = 0;
@@ -1626,26 +2268,112 @@ class MPMCDictionary
             return true;
         }
 
-        LLMALLOC_FORCE_INLINE std::size_t hash(const Key& key) const
+        // Should be called under the write lock , before an unlinked node is rewritten
+        void prepare_reuse()
         {
-            auto hash_value = m_hash(key);
-            auto result = hash_value - (hash_value / m_table_size) * m_table_size;
-            return result;
+            // Readers which may be standing on the node will notice that they might have been moved to another chain
+            m_generation.fetch_add(1, std::memory_order_acq_rel);
+            // Pairs with the fence in get , a reader which sees any of the new key and value words also sees the increment
+            std::atomic_thread_fence(std::memory_order_release);
         }
-};
-/*
-    - Not thread safe
-    
-    - Memory layout : key value key value key value ...
-    
-    - Uses separate chaining ( linear chaining ) for collisions
-   
-    - Reallocates memory when the load factor reaches 1
 
-    - Does not support item removal & types with constructors with arguments
-*/
+        // Should be called under the write lock
+        void link_node(DictionaryNode* node, const Key& key, const Value& value)
+        {
+            node->key.store(key, std::memory_order_relaxed);
+            store_value(node, value);
 
-template <typename Key, typename Value, typename Allocator, typename HashFunction = MurmurHash3<Key>>
+            std::size_t index = hash(key);
+            DictionaryNode* old_head = m_table[index].load(std::memory_order_relaxed);
+
+            do
+            {
+                node->next.store(old_head, std::memory_order_release); // Release as readers on a reused node should also see the generation increment
+            }
+            while (!m_table[index].compare_exchange_weak(old_head, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Should be called under the write lock , returns the unlinked node or nullptr if the key is not found
+        DictionaryNode* unlink_node(const Key& key, Value& value)
+        {
+            std::size_t index = hash(key);
+            DictionaryNode* previous = nullptr;
+            DictionaryNode* current = m_table[index].load(std::memory_order_relaxed);
+
+            while (current)
+            {
+                if (current->key.load(std::memory_order_relaxed) == key)
+                {
+                    DictionaryNode* next = current->next.load(std::memory_order_relaxed);
+
+                    if (previous == nullptr)
+                    {
+                        m_table[index].store(next, std::memory_order_release);
+                    }
+                    else
+                    {
+                        previous->next.store(next, std::memory_order_release);
+                    }
+
+                    load_value(current, value);
+
+                    // Not touching current->next as there may be readers on this node
+                    return current;
+                }
+
+                previous = current;
+                current = current->next.load(std::memory_order_relaxed);
+            }
+
+            return nullptr;
+        }
+
+        // Relaxed word loads and stores compile to plain moves , consistency is provided by the generation checks
+        static void store_value(DictionaryNode* node, const Value& value)
+        {
+            uint64_t words[VALUE_WORD_COUNT] = {};
+            llmalloc_builtin_memcpy(words, &value, sizeof(Value));
+
+            for (std::size_t i = 0; i < VALUE_WORD_COUNT; i++)
+            {
+                node->value_words[i].store(words[i], std::memory_order_relaxed);
+            }
+        }
+
+        static void load_value(const DictionaryNode* node, Value& value)
+        {
+            uint64_t words[VALUE_WORD_COUNT];
+
+            for (std::size_t i = 0; i < VALUE_WORD_COUNT; i++)
+            {
+                words[i] = node->value_words[i].load(std::memory_order_relaxed);
+            }
+
+            llmalloc_builtin_memcpy(&value, words, sizeof(Value));
+        }
+
+        LLMALLOC_FORCE_INLINE std::size_t hash(const Key& key) const
+        {
+            auto hash_value = m_hash(key);
+            auto result = hash_value - (hash_value / m_table_size) * m_table_size;
+            return result;
+        }
+};
+/*
+    - Not thread safe
+    
+    - Memory layout : key value key value key value ...
+    
+    - Uses separate chaining ( linear chaining ) for collisions
+   
+    - Reallocates memory when the load factor reaches 1
+
+    - Erased nodes are kept in a free list and reused by later inserts
+
+    - Does not support types with constructors with arguments
+*/
+
+template <typename Key, typename Value, typename Allocator, typename HashFunction = MurmurHash3<Key>>
 class Dictionary
 {
     public:
@@ -1686,7 +2414,19 @@ class Dictionary
 
             std::size_t index = modulo_table_size(m_hash(key));
 
-            DictionaryNode* new_node = m_node_cache + m_item_count;
+            DictionaryNode* new_node = nullptr;
+
+            if (m_free_nodes != nullptr)
+            {
+                new_node = m_free_nodes;
+                m_free_nodes = new_node->next;
+            }
+            else
+            {
+                new_node = m_node_cache + m_node_cache_index;
+                ++m_node_cache_index;
+            }
+
             new_node->key = key;
             new_node->value = value;
             
@@ -1716,6 +2456,43 @@ class Dictionary
             return false;
         }
 
+        // Returns the value of the erased item
+        bool erase(const Key& key, Value& value)
+        {
+            assert(m_table_size > 0 && m_node_cache != nullptr);
+
+            std::size_t index = modulo_table_size(m_hash(key));
+            DictionaryNode* previous = nullptr;
+            DictionaryNode* current = m_table[index];
+
+            while (current != nullptr)
+            {
+                if (current->key == key)
+                {
+                    if (previous == nullptr)
+                    {
+                        m_table[index] = current->next;
+                    }
+                    else
+                    {
+                        previous->next = current->next;
+                    }
+
+                    value = current->value;
+
+                    current->next = m_free_nodes;
+                    m_free_nodes = current;
+
+                    --m_item_count;
+                    return true;
+                }
+
+                previous = current;
+                current = current->next;
+            }
+            return false;
+        }
+
     private:
         // Members will always be accessed by a single thread , hence no cpu cache line size alignment
         DictionaryNode** m_table = nullptr;
@@ -1723,6 +2500,8 @@ class Dictionary
 
         std::size_t m_table_size = 0;
         std::size_t m_item_count = 0;
+        std::size_t m_node_cache_index = 0;
+        DictionaryNode* m_free_nodes = nullptr;
 
         HashFunction m_hash;
 
@@ -1797,6 +2576,10 @@ class Dictionary
             m_node_cache = new_node_cache;
             m_table_size = size;
 
+            // Copying compacts live nodes to the start of the new node cache
+            m_node_cache_index = copy_count;
+            m_free_nodes = nullptr;
+
             return true;
         }
 
@@ -1827,6 +2610,154 @@ class Dictionary
             }
         }
 };
+/*
+    - TWO LEVEL RADIX MAP FROM VIRTUAL MEMORY ADDRESSES TO A 1 BYTE VALUE PER OS PAGE ALLOCATION GRANULARITY ( 4KB ON LINUX , 64KB ON WINDOWS )
+
+    - USE CASE : CLASSIFYING POINTERS WITHOUT HASHING. SEGMENTS STORE LOG2 OF THEIR LOGICAL PAGE SIZES SO THAT A FREED POINTER CAN BE MASKED
+      TO REACH ITS LOGICAL PAGE HEADER. ZERO MEANS THAT THE ADDRESS DOES NOT BELONG TO A LOGICAL PAGE ( EX: LARGE OBJECTS )
+
+    - LOOKUPS ARE LOCK FREE : 2 LOADS. LEAF CREATIONS ARE PROTECTED BY A SPINLOCK AND THEY HAPPEN ONLY ONCE PER 1GB ( 4KB GRANULARITY ) OF ADDRESS SPACE
+
+    - WRITES TO THE SAME ENTRIES ARE EXPECTED TO BE SERIALISED BY CALLERS. A LOOKUP FOR AN ADDRESS IS EXPECTED TO HAPPEN AFTER ITS SET CALL,
+      WHICH IS ALWAYS THE CASE FOR ALLOCATORS AS POINTERS ARE HANDED OUT AFTER THEIR PAGES ARE CREATED
+
+    - LEAVES ARE NEVER RELEASED
+*/
+
+template <typename Allocator>
+class PageMap
+{
+    public:
+
+        static constexpr std::size_t ADDRESS_BITS = 47; // User space virtual addresses on x64
+        static constexpr std::size_t GRANULARITY_SHIFT = VirtualMemory::PAGE_ALLOCATION_GRANULARITY == 65536 ? 16 : 12;
+        static constexpr std::size_t LEAF_BITS = 18;
+        static constexpr std::size_t ROOT_BITS = ADDRESS_BITS - GRANULARITY_SHIFT - LEAF_BITS;
+        static constexpr std::size_t LEAF_SIZE = static_cast<std::size_t>(1) << LEAF_BITS;
+        static constexpr std::size_t ROOT_SIZE = static_cast<std::size_t>(1) << ROOT_BITS;
+
+        PageMap() = default;
+        ~PageMap() = default;
+
+        PageMap(const PageMap& other) = delete;
+        PageMap& operator= (const PageMap& other) = delete;
+        PageMap(PageMap&& other) = delete;
+        PageMap& operator=(PageMap&& other) = delete;
+
+        bool initialise()
+        {
+            static_assert(static_cast<std::size_t>(1) << GRANULARITY_SHIFT == VirtualMemory::PAGE_ALLOCATION_GRANULARITY);
+
+            if (m_root != nullptr)
+            {
+                return true;
+            }
+
+            m_root = reinterpret_cast<std::atomic<uint8_t*>*>(Allocator::allocate(ROOT_SIZE * sizeof(std::atomic<uint8_t*>)));
+
+            if (m_root == nullptr)
+            {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < ROOT_SIZE; i++)
+            {
+                m_root[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            m_leaf_creation_lock.initialise();
+
+            return true;
+        }
+
+        // Sets value for all granules of [address, address+size)
+        bool set(void* address, std::size_t size, uint8_t value)
+        {
+            uint64_t start = reinterpret_cast<uint64_t>(address) >> GRANULARITY_SHIFT;
+            uint64_t end = (reinterpret_cast<uint64_t>(address) + size + VirtualMemory::PAGE_ALLOCATION_GRANULARITY - 1) >> GRANULARITY_SHIFT;
+
+            while (start < end)
+            {
+                uint8_t* leaf = get_or_create_leaf(start >> LEAF_BITS);
+
+                if (llmalloc_unlikely(leaf == nullptr))
+                {
+                    return false;
+                }
+
+                uint64_t leaf_index = start & (LEAF_SIZE - 1);
+                uint64_t count = LEAF_SIZE - leaf_index;
+                count = (end - start) < count ? (end - start) : count;
+
+                llmalloc_builtin_memset(leaf + leaf_index, value, count);
+                start += count;
+            }
+
+            return true;
+        }
+
+        void clear(void* address, std::size_t size)
+        {
+            set(address, size, 0);
+        }
+
+        LLMALLOC_FORCE_INLINE uint8_t get(void* address) const
+        {
+            uint64_t index = reinterpret_cast<uint64_t>(address) >> GRANULARITY_SHIFT;
+            uint64_t root_index = index >> LEAF_BITS;
+
+            if (llmalloc_unlikely(root_index >= ROOT_SIZE))
+            {
+                return 0;
+            }
+
+            uint8_t* leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (llmalloc_unlikely(leaf == nullptr))
+            {
+                return 0;
+            }
+
+            return leaf[index & (LEAF_SIZE - 1)];
+        }
+
+    private:
+        std::atomic<uint8_t*>* m_root = nullptr;
+        UserspaceSpinlock<> m_leaf_creation_lock;
+
+        uint8_t* get_or_create_leaf(uint64_t root_index)
+        {
+            if (root_index >= ROOT_SIZE)
+            {
+                return nullptr;
+            }
+
+            uint8_t* leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (llmalloc_likely(leaf != nullptr))
+            {
+                return leaf;
+            }
+
+            m_leaf_creation_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            leaf = m_root[root_index].load(std::memory_order_acquire);
+
+            if (leaf == nullptr)
+            {
+                leaf = reinterpret_cast<uint8_t*>(Allocator::allocate(LEAF_SIZE)); // Comes zeroed from the OS
+
+                if (leaf != nullptr)
+                {
+                    m_root[root_index].store(leaf, std::memory_order_release);
+                }
+            }
+            ////////////////////////////////////////////////////////////////////
+            m_leaf_creation_lock.unlock();
+
+            return leaf;
+        }
+};
 /*
     - IT RELEASES ONLY UNUSED PAGES. RELEASING USED PAGES IS UP TO THE CALLERS.
 
@@ -1834,16 +2765,41 @@ class Dictionary
     
     - CAN BE NUMA AWARE IF SPEFICIED
 
+    - BY DEFAULT CACHES ARE MAPPED WITH MAP_POPULATE. IN COMMIT ON DEMAND MODE , CACHES ARE ONLY RESERVED AND THEY ARE COMMITTED IN CHUNKS AS THEY ARE HANDED OUT.
+      COMMITTED CHUNKS CAN OPTIONALLY BE PREFAULTED FOR LATENCY CRITICAL USES. HUGE PAGE AND NUMA ARENAS ALWAYS USE THE DEFAULT MODE
+
+    - WHEN THE CACHE CAN'T SERVE A REQUEST , A NEW CHUNK IS ADDED. GROWTH CHUNKS START FROM 2MB AND DOUBLE UP TO THE INITIAL CACHE CAPACITY.
+      Tails of older chunks stay usable for smaller requests. A chunk's unused tail is released with a single call when it is evicted
+
+    - ALIGNED ALLOCATIONS ALIGN THE BUMP POINTER OF A CHUNK. THE SKIPPED PAGES ARE KEPT IN AN ADDRESS ORDERED GAP LIST AND SERVED TO LATER REQUESTS
+
+    - BY DEFAULT RELEASED PAGES ARE UNMAPPED. WITH ADVISE_DONTNEED AND ADVISE_FREE RELEASE POLICIES , THEIR PHYSICAL PAGES ARE RETURNED WITH MADVISE AND THE RANGES ARE KEPT AS GAPS.
+      Later segment grows reuse them without new mappings , which avoids VMA churn and mmap_lock contention. ADVISE_FREE pages may keep their old contents
+
+    - trim RETURNS PHYSICAL PAGES OF UNUSED CHUNK TAILS AND GAPS TO THE OS. Where discarded pages read back as zeroes they are discarded and kept for later requests ,
+      otherwise they are unmapped
+
     - LINUX ALLOCATION GRANULARITY IS 4KB (4096) , OTH IT IS 64KB ( 16 * 4096 ) ON WINDOWS .
       REGARDING WINDOWS PAGE ALLOCATION GRANULARITY : https://devblogs.microsoft.com/oldnewthing/20031008-00/?p=42223
 */
 
+enum class PageReleasePolicy : uint8_t
+{
+    UNMAP,              // munmap / VirtualFree
+    ADVISE_DONTNEED,    // MADV_DONTNEED , the range stays in the arena
+    ADVISE_FREE         // MADV_FREE , the range stays in the arena and the OS reclaims its pages only under memory pressure
+};
+
 struct ArenaOptions
 {
     std::size_t cache_capacity = 1024*1024*1024;
     std::size_t page_alignment = 65536;
     bool use_huge_pages = false;
     int numa_node = -1; // -1 means no NUMA
+    bool commit_on_demand = false;          // Reserves the cache and commits it in chunks instead of populating all of it at once
+    std::size_t commit_chunk_size = 2097152;
+    bool prefault_commits = true;           // Applies to commit on demand mode
+    PageReleasePolicy page_release_policy = PageReleasePolicy::UNMAP;
 };
 
 class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED CACHE THEREFORE WE NEED LOCKING
@@ -1876,10 +2832,16 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             m_page_alignment = arena_options.page_alignment;
             m_use_huge_pages = arena_options.use_huge_pages;
             m_numa_node = arena_options.numa_node;
+            m_commit_on_demand = arena_options.commit_on_demand && arena_options.use_huge_pages == false && arena_options.numa_node < 0;
+            m_commit_chunk_size = AlignmentAndSizeUtils::get_next_pow2_multiple_of(arena_options.commit_chunk_size > 0 ? arena_options.commit_chunk_size : 1, m_vm_page_size);
+            m_prefault_commits = arena_options.prefault_commits;
+            m_page_release_policy = arena_options.page_release_policy;
+            m_max_growth_chunk_size = round_up_to_page_alignment(arena_options.cache_capacity > MIN_GROWTH_CHUNK_SIZE ? arena_options.cache_capacity : MIN_GROWTH_CHUNK_SIZE);
+            m_next_growth_chunk_size = round_up_to_page_alignment(MIN_GROWTH_CHUNK_SIZE);
 
             this->enter_concurrent_context();
             //////////////////////////////////////////////////
-            auto ret =  build_cache(arena_options.cache_capacity);
+            auto ret =  build_chunk(round_up_to_page_alignment(arena_options.cache_capacity)) != nullptr;
             //////////////////////////////////////////////////
             this->leave_concurrent_context();
 
@@ -1888,65 +2850,116 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
 
         [[nodiscard]] char* allocate(std::size_t size)
         {
-            this->enter_concurrent_context();
-            //////////////////////////////////////////////////
-            if (size + m_page_alignment > (m_cache_size - m_cache_used_size))
-            {
-                destroy();
-
-                if (!build_cache(size))
-                {
-                    this->leave_concurrent_context();
-                    return nullptr;
-                }
-            }
+            auto ret = allocate_with_alignment(size, m_page_alignment);
 
-            auto ret = m_cache_buffer + m_cache_used_size;
-            m_cache_used_size += size;
-            //////////////////////////////////////////////////
-            this->leave_concurrent_context();
-
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, m_page_alignment), "Arena should not return an address which is not aligned to its page alignment setting.");
+            llmalloc_assert_msg(ret == nullptr || AlignmentAndSizeUtils::is_address_aligned(ret, m_page_alignment), "Arena should not return an address which is not aligned to its page alignment setting.");
 
             return ret;
         }
 
+        // Pages skipped to reach the alignment are kept as gaps and served to later requests
         [[nodiscard]] char* allocate_aligned(std::size_t size, std::size_t alignment)
         {
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(alignment), "Special alignment value requested from Arena should be a multiple of OS page allocation granularity.");
 
-            if(alignment == m_page_alignment)
+            if(m_page_alignment % alignment == 0)
             {
                 return allocate(size);
             }
             else
             {
-                llmalloc_assert_msg(AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(m_page_alignment), "Special alignment value requested from Arena should be a multiple of Arena's page alignment value.");
+                llmalloc_assert_msg(alignment % m_page_alignment == 0, "Special alignment value requested from Arena should be a multiple of Arena's page alignment value.");
 
-                auto ptr = reinterpret_cast<uint64_t>(allocate(size + alignment));
+                auto ret = allocate_with_alignment(size, alignment);
 
-                if(ptr == 0)
-                {
-                    return nullptr;
-                }
+                llmalloc_assert_msg(ret == nullptr || AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Arena failed to meet the requested alignment.");
 
-                std::size_t remainder = ptr - ((ptr / alignment) * alignment);
-                std::size_t offset = alignment - remainder;
-                return reinterpret_cast<char*>(ptr + offset);
+                return ret;
             }
         }
 
         std::size_t page_size()const { return m_vm_page_size; }
         std::size_t page_alignment() const { return m_page_alignment; }
 
+        // Can be called from any thread. Depending on the release policy , the range is either unmapped or kept as a gap after its physical pages are discarded
         void release_to_system(void* address, std::size_t size)
         {
-            #ifdef NDEBUG
-            VirtualMemory::deallocate(address, size);
-            #else
-            auto release_success = VirtualMemory::deallocate(address, size);
-            llmalloc_assert_msg(release_success, "Failure to release pages can lead to system wide issues\n");
-            #endif
+            m_allocated_size.fetch_sub(size, std::memory_order_relaxed);
+
+            if (m_page_release_policy != PageReleasePolicy::UNMAP && VirtualMemory::discard(address, size, m_page_release_policy == PageReleasePolicy::ADVISE_FREE))
+            {
+                this->enter_concurrent_context();
+                //////////////////////////////////////////////////
+                add_gap(static_cast<char*>(address), size);
+                //////////////////////////////////////////////////
+                this->leave_concurrent_context();
+                return;
+            }
+
+            // Discards can fail , ex: for huge pages
+            unmap(address, size);
+        }
+
+        // Returns released bytes. Chunk tails and gaps stay in the arena if discarding them keeps never used pages zeroed , otherwise they are unmapped
+        std::size_t trim()
+        {
+            std::size_t released_size{ 0 };
+            bool can_discard = VirtualMemory::are_discarded_pages_zeroed(false);
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            for (std::size_t i = 0; i < m_chunk_count; i++)
+            {
+                // Only committed parts can have physical pages
+                std::size_t tail_size = m_chunks[i].m_committed_size > m_chunks[i].m_used_size ? m_chunks[i].m_committed_size - m_chunks[i].m_used_size : 0;
+
+                if (can_discard)
+                {
+                    released_size += tail_size > 0 && VirtualMemory::discard(m_chunks[i].m_buffer + m_chunks[i].m_used_size, tail_size, false) ? tail_size : 0;
+                }
+                else
+                {
+                    released_size += m_chunks[i].m_size - m_chunks[i].m_used_size;
+                    release_unused_tail(&m_chunks[i]);
+                }
+            }
+
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                if (can_discard)
+                {
+                    released_size += VirtualMemory::discard(m_gaps[i].m_address, m_gaps[i].m_size, false) ? m_gaps[i].m_size : 0;
+                }
+                else
+                {
+                    released_size += m_gaps[i].m_size;
+                    unmap(m_gaps[i].m_address, m_gaps[i].m_size);
+                }
+            }
+
+            if (can_discard == false)
+            {
+                m_chunk_count = 0;
+                m_gap_count = 0;
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return released_size;
+        }
+
+        // Bytes handed out and not released yet
+        std::size_t get_allocated_size() const { return m_allocated_size.load(std::memory_order_relaxed); }
+
+        #ifdef ENABLE_STATS
+        // Chunks built to grow the arena after its initial one
+        std::size_t get_built_chunk_count() const { return m_built_chunk_count.load(std::memory_order_relaxed); }
+        #endif
+
+        // Never used pages are zeroed , released ones may not be depending on the release policy
+        bool are_reused_pages_zeroed() const
+        {
+            return m_page_release_policy == PageReleasePolicy::UNMAP || VirtualMemory::are_discarded_pages_zeroed(m_page_release_policy == PageReleasePolicy::ADVISE_FREE);
         }
 
         class MetadataAllocator
@@ -1964,20 +2977,59 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
                 }
         };
 
+        #ifdef UNIT_TEST
+        std::size_t get_chunk_count() const { return m_chunk_count; }
+        std::size_t get_gap_count() const { return m_gap_count; }
+        #endif
+
     private:
-        std::size_t m_vm_page_size = 0;
-        std::size_t m_page_alignment = 0;
-        char* m_cache_buffer = nullptr;
-        std::size_t m_cache_size = 0;
-        std::size_t m_cache_used_size = 0;
-        bool m_use_huge_pages = false;
-        int m_numa_node = -1;
 
-        void* allocate_from_system(std::size_t size)
+        struct ArenaChunk
         {
-            void* ret = nullptr;
-            
-            if(m_use_huge_pages)
+            char* m_buffer = nullptr;
+            std::size_t m_size = 0;
+            std::size_t m_used_size = 0;
+            std::size_t m_committed_size = 0;
+        };
+
+        struct ArenaGap
+        {
+            char* m_address = nullptr;
+            std::size_t m_size = 0;
+        };
+
+        static constexpr std::size_t MAX_CHUNK_COUNT = 8;
+        static constexpr std::size_t MAX_GAP_COUNT = 64;
+        static constexpr std::size_t MIN_GROWTH_CHUNK_SIZE = 2097152; // 2MB
+
+        std::size_t m_vm_page_size = 0;
+        std::size_t m_page_alignment = 0;
+        ArenaChunk m_chunks[MAX_CHUNK_COUNT]; // Only chunks with unused space , the most recent one is the last
+        std::size_t m_chunk_count = 0;
+        ArenaGap m_gaps[MAX_GAP_COUNT]; // Address ordered , pages skipped by aligned allocations and pages released with madvise
+        std::size_t m_gap_count = 0;
+        std::size_t m_next_growth_chunk_size = 0;
+        std::size_t m_max_growth_chunk_size = 0;
+        bool m_use_huge_pages = false;
+        int m_numa_node = -1;
+        bool m_commit_on_demand = false;
+        std::size_t m_commit_chunk_size = 0;
+        bool m_prefault_commits = true;
+        PageReleasePolicy m_page_release_policy = PageReleasePolicy::UNMAP;
+        std::atomic<std::size_t> m_allocated_size = 0;
+        #ifdef ENABLE_STATS
+        std::atomic<std::size_t> m_built_chunk_count = 0; // Written under the lock
+        #endif
+
+        void* allocate_from_system(std::size_t size)
+        {
+            void* ret = nullptr;
+            
+            if(m_commit_on_demand)
+            {
+                ret = VirtualMemory::reserve(size);
+            }
+            else if(m_use_huge_pages)
             {
                 ret = static_cast<char*>(VirtualMemory::allocate(size, true, m_numa_node, nullptr));
 
@@ -1995,13 +3047,207 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             return ret;
         }
 
-        [[nodiscard]] bool build_cache(std::size_t size)
+        std::size_t round_up_to_page_alignment(std::size_t size) const
+        {
+            return ((size + m_page_alignment - 1) / m_page_alignment) * m_page_alignment;
+        }
+
+        static char* align_up(char* address, std::size_t alignment)
+        {
+            return reinterpret_cast<char*>(((reinterpret_cast<std::size_t>(address) + alignment - 1) / alignment) * alignment);
+        }
+
+        [[nodiscard]] char* allocate_with_alignment(std::size_t size, std::size_t alignment)
+        {
+            // Keeping all chunk offsets aligned
+            size = round_up_to_page_alignment(size);
+
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            char* ret = allocate_from_gaps(size, alignment);
+
+            if (ret == nullptr)
+            {
+                ArenaChunk* chunk = find_chunk(size, alignment);
+
+                if (llmalloc_unlikely(chunk == nullptr))
+                {
+                    // New chunks are only page aligned
+                    chunk = build_chunk(get_next_growth_chunk_size(size + alignment - m_page_alignment));
+
+                    #ifdef ENABLE_STATS
+                    m_built_chunk_count.store(m_built_chunk_count.load(std::memory_order_relaxed) + (chunk != nullptr ? 1 : 0), std::memory_order_relaxed);
+                    #endif
+                }
+
+                if (chunk != nullptr)
+                {
+                    ret = allocate_from_chunk(chunk, size, alignment);
+                }
+            }
+
+            if (ret != nullptr)
+            {
+                m_allocated_size.fetch_add(size, std::memory_order_relaxed);
+            }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return ret;
+        }
+
+        // First fit , older chunks are tried first so that their tails get used up
+        ArenaChunk* find_chunk(std::size_t size, std::size_t alignment)
+        {
+            for (std::size_t i = 0; i < m_chunk_count; i++)
+            {
+                char* aligned_start = align_up(m_chunks[i].m_buffer + m_chunks[i].m_used_size, alignment);
+                char* end = m_chunks[i].m_buffer + m_chunks[i].m_size;
+
+                if (aligned_start <= end && static_cast<std::size_t>(end - aligned_start) >= size)
+                {
+                    return &m_chunks[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        char* allocate_from_chunk(ArenaChunk* chunk, std::size_t size, std::size_t alignment)
+        {
+            char* start = chunk->m_buffer + chunk->m_used_size;
+            char* ret = align_up(start, alignment);
+            std::size_t new_used_size = static_cast<std::size_t>(ret - chunk->m_buffer) + size;
+
+            // Gaps are committed as well as they will be handed out later
+            if (new_used_size > chunk->m_committed_size && commit_chunk(chunk, new_used_size) == false)
+            {
+                return nullptr;
+            }
+
+            chunk->m_used_size = new_used_size;
+
+            if (chunk->m_used_size == chunk->m_size)
+            {
+                remove_chunk(chunk);
+            }
+
+            add_gap(start, static_cast<std::size_t>(ret - start));
+
+            return ret;
+        }
+
+        char* allocate_from_gaps(std::size_t size, std::size_t alignment)
+        {
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                char* gap_end = m_gaps[i].m_address + m_gaps[i].m_size;
+                char* ret = align_up(m_gaps[i].m_address, alignment);
+
+                if (ret < gap_end && static_cast<std::size_t>(gap_end - ret) >= size)
+                {
+                    if (ret == m_gaps[i].m_address)
+                    {
+                        m_gaps[i].m_address += size;
+                        m_gaps[i].m_size -= size;
+
+                        if (m_gaps[i].m_size == 0)
+                        {
+                            remove_gap(i);
+                        }
+                    }
+                    else
+                    {
+                        // Splitting the gap , the leading part stays in place
+                        m_gaps[i].m_size = static_cast<std::size_t>(ret - m_gaps[i].m_address);
+                        add_gap(ret + size, static_cast<std::size_t>(gap_end - ret - size));
+                    }
+
+                    return ret;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Keeps the gap list address ordered and merges adjacent gaps. If the list is full , the gap is released to the system
+        void add_gap(char* address, std::size_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+
+            std::size_t index = 0;
+
+            while (index < m_gap_count && m_gaps[index].m_address < address)
+            {
+                index++;
+            }
+
+            bool merges_with_previous = index > 0 && m_gaps[index - 1].m_address + m_gaps[index - 1].m_size == address;
+            bool merges_with_next = index < m_gap_count && address + size == m_gaps[index].m_address;
+
+            if (merges_with_previous && merges_with_next)
+            {
+                m_gaps[index - 1].m_size += size + m_gaps[index].m_size;
+                remove_gap(index);
+            }
+            else if (merges_with_previous)
+            {
+                m_gaps[index - 1].m_size += size;
+            }
+            else if (merges_with_next)
+            {
+                m_gaps[index].m_address = address;
+                m_gaps[index].m_size += size;
+            }
+            else if (m_gap_count == MAX_GAP_COUNT)
+            {
+                unmap(address, size);
+            }
+            else
+            {
+                for (std::size_t i = m_gap_count; i > index; i--)
+                {
+                    m_gaps[i] = m_gaps[i - 1];
+                }
+
+                m_gaps[index].m_address = address;
+                m_gaps[index].m_size = size;
+                m_gap_count++;
+            }
+        }
+
+        void remove_gap(std::size_t index)
+        {
+            for (std::size_t i = index + 1; i < m_gap_count; i++)
+            {
+                m_gaps[i - 1] = m_gaps[i];
+            }
+
+            m_gap_count--;
+        }
+
+        std::size_t get_next_growth_chunk_size(std::size_t size)
+        {
+            std::size_t chunk_size = m_next_growth_chunk_size;
+
+            if (m_next_growth_chunk_size < m_max_growth_chunk_size)
+            {
+                m_next_growth_chunk_size = m_next_growth_chunk_size * 2 < m_max_growth_chunk_size ? m_next_growth_chunk_size * 2 : m_max_growth_chunk_size;
+            }
+
+            return chunk_size > size ? chunk_size : size;
+        }
+
+        [[nodiscard]] ArenaChunk* build_chunk(std::size_t size)
         {
             char* buffer = allocate_aligned_from_system(size, m_page_alignment);
 
             if (buffer == nullptr)
             {
-                return false;
+                return nullptr;
             }
 
             #ifdef ENABLE_PERF_TRACES
@@ -2013,13 +3259,74 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             arena_initialised = true;
             #endif
 
-            m_cache_buffer = buffer;
-            m_cache_used_size = 0;
-            m_cache_size = size;
+            if (m_chunk_count == MAX_CHUNK_COUNT)
+            {
+                evict_chunk();
+            }
+
+            ArenaChunk* chunk = &m_chunks[m_chunk_count++];
+            chunk->m_buffer = buffer;
+            chunk->m_used_size = 0;
+            chunk->m_size = size;
+            chunk->m_committed_size = m_commit_on_demand ? 0 : size;
+
+            return chunk;
+        }
+
+        // Commits commit chunks up to the required size , the last commit chunk can be partial
+        [[nodiscard]] bool commit_chunk(ArenaChunk* chunk, std::size_t required_size)
+        {
+            std::size_t target_size = ((required_size + m_commit_chunk_size - 1) / m_commit_chunk_size) * m_commit_chunk_size;
+            target_size = target_size > chunk->m_size ? chunk->m_size : target_size;
+
+            if (VirtualMemory::commit(chunk->m_buffer + chunk->m_committed_size, target_size - chunk->m_committed_size, m_prefault_commits) == false)
+            {
+                return false;
+            }
 
+            chunk->m_committed_size = target_size;
             return true;
         }
 
+        void remove_chunk(ArenaChunk* chunk)
+        {
+            std::size_t index = static_cast<std::size_t>(chunk - m_chunks);
+
+            for (std::size_t i = index + 1; i < m_chunk_count; i++)
+            {
+                m_chunks[i - 1] = m_chunks[i];
+            }
+
+            m_chunk_count--;
+        }
+
+        // Slow path removal function
+        void evict_chunk()
+        {
+            // Evicting the chunk with the least unused space
+            std::size_t eviction_index = 0;
+
+            for (std::size_t i = 1; i < m_chunk_count; i++)
+            {
+                if (m_chunks[i].m_size - m_chunks[i].m_used_size < m_chunks[eviction_index].m_size - m_chunks[eviction_index].m_used_size)
+                {
+                    eviction_index = i;
+                }
+            }
+
+            release_unused_tail(&m_chunks[eviction_index]);
+            remove_chunk(&m_chunks[eviction_index]);
+        }
+
+        // ARENA IS RESPONSIBLE OF CLEARING ONLY NEVER-REQUESTED PAGES.
+        void release_unused_tail(ArenaChunk* chunk)
+        {
+            if (chunk->m_size > chunk->m_used_size)
+            {
+                unmap(chunk->m_buffer + chunk->m_used_size, chunk->m_size - chunk->m_used_size);
+            }
+        }
+
         char* allocate_aligned_from_system(std::size_t size, std::size_t alignment)
         {
             std::size_t actual_size = size + alignment;
@@ -2039,13 +3346,14 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             {
                 // WE NEED PADDING FOR SPECIFIED PAGE ALIGNMENT
                 delta = alignment - remainder;
-                // RELEASING PADDING PAGE
-                release_to_system(buffer, delta);
+                // RELEASING PADDING PAGES BEFORE AND AFTER THE ALIGNED RANGE
+                unmap(buffer, delta);
+                unmap(buffer + delta + size, alignment - delta);
             }
             else
             {
                 // PADDING IS NOT NEEDED, HENCE THE EXTRA ALLOCATED PAGE IS EXCESS
-                release_to_system(buffer + actual_size - alignment, alignment);
+                unmap(buffer + actual_size - alignment, alignment);
             }
             auto ret = buffer + delta;
 
@@ -2054,23 +3362,30 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
             return ret;
         }
         
+        void unmap(void* address, std::size_t size)
+        {
+            #ifdef NDEBUG
+            VirtualMemory::deallocate(address, size);
+            #else
+            auto release_success = VirtualMemory::deallocate(address, size);
+            llmalloc_assert_msg(release_success, "Failure to release pages can lead to system wide issues\n");
+            #endif
+        }
+
         void destroy()
         {
-            if (m_cache_size > m_cache_used_size)
+            for (std::size_t i = 0; i < m_chunk_count; i++)
             {
-                // ARENA IS RESPONSIBLE OF CLEARING ONLY NEVER-REQUESTED PAGES.
-                std::size_t release_start_address = reinterpret_cast<std::size_t>(m_cache_buffer + m_cache_used_size);
-                std::size_t release_end_address = reinterpret_cast<std::size_t>(m_cache_buffer + m_cache_size);
-
-                for (; release_start_address < release_end_address; release_start_address += m_vm_page_size)
-                {
-                    release_to_system(reinterpret_cast<void *>(release_start_address), m_vm_page_size);
-                }
+                release_unused_tail(&m_chunks[i]);
+            }
 
+            for (std::size_t i = 0; i < m_gap_count; i++)
+            {
+                unmap(m_gaps[i].m_address, m_gaps[i].m_size);
             }
-            m_cache_size = 0;
-            m_cache_used_size = 0;
-            m_cache_buffer = nullptr;
+
+            m_chunk_count = 0;
+            m_gap_count = 0;
         }
 };
 /*
@@ -2078,13 +3393,15 @@ class Arena : public Lockable<LockPolicy::USERSPACE_LOCK> // MAINTAINS A SHARED
     LOGICAL PAGE HEADERS WILL BE PLACED TO THE FIRST 64 BYTES OF EVERY LOGICAL PAGE
 
     PAHOLE OUTPUT :
-                            size: 64, cachelines: 1, members: 10
+                            size: 64, cachelines: 1, members: 11
                             last cacheline: 64 bytes
 */
 
 enum class LogicalPageHeaderFlags : uint16_t
 {
-    IS_USED = 0x0001
+    IS_USED = 0x0001,
+    IS_FULL = 0x0002,   // Set by segments when they move the logical page behind the ones which have free chunks
+    IS_DIRTY = 0x0004   // Set by segments when the logical page is built on a reused page , so its never used chunks may not be zeroed
 };
 
 LLMALLOC_PACKED
@@ -2097,18 +3414,20 @@ LLMALLOC_PACKED
         uint64_t m_next_logical_page_ptr;  // To be used by an upper layer abstraction (ex: segment span etc ) to navigate between logical pages
         // 8 BYTES
         uint64_t m_prev_logical_page_ptr;  // Same as above
-        // 2 BYTES
-        uint16_t m_page_flags;             // See enum class LogicalPageHeaderFlags
-        // 4 BYTES
-        uint32_t m_size_class;             // Used to distinguish non-big size class pages, since logical pages won't be holding objects > page size, 2 bytes will be sufficient
         // 8 BYTES
-        uint64_t m_used_size;
+        uint64_t m_remote_free_head;       // Freelist of chunks freed by non-owner threads, accessed atomically therefore it has to stay 8 byte aligned
         // 8 BYTES
         uint64_t m_logical_page_start_address;
         // 8 BYTES
-        uint64_t m_logical_page_size;
-        // 8 BYTES
-        uint64_t m_last_used_node;
+        uint64_t m_last_used_node;         // Bump pointer , lowest chunk address handed out so far. Chunks below it have never been used and are not in the freelist
+        // 4 BYTES
+        uint32_t m_used_size;              // Logical pages are at most 1GB huge pages
+        // 4 BYTES
+        uint32_t m_logical_page_size;
+        // 4 BYTES
+        uint32_t m_size_class;             // Used to distinguish non-big size class pages, since logical pages won't be holding objects > page size, 2 bytes will be sufficient
+        // 2 BYTES
+        uint16_t m_page_flags;             // See enum class LogicalPageHeaderFlags
         // 2 BYTES
         uint16_t m_segment_id;
 
@@ -2120,12 +3439,13 @@ LLMALLOC_PACKED
             m_head = 0;
             m_next_logical_page_ptr = 0;
             m_prev_logical_page_ptr = 0;
-            m_page_flags = 0;
-            m_size_class = 0;
-            m_used_size = 0;
+            m_remote_free_head = 0;
             m_logical_page_start_address = 0;
-            m_logical_page_size = 0;
             m_last_used_node = 0;
+            m_used_size = 0;
+            m_logical_page_size = 0;
+            m_size_class = 0;
+            m_page_flags = 0;
             m_segment_id = 0;
         }
 
@@ -2151,6 +3471,12 @@ LLMALLOC_PACKED
 /*
     - IT IS A FIRST-IN-LAST-OUT FREELIST IMPLEMENTATION. IT CAN HOLD ONLY ONE SIZE CLASS.
 
+    - NEVER USED CHUNKS ARE NOT THREADED TO THE FREELIST AT CREATION. THEY ARE CARVED FROM THE END OF THE BUFFER WITH A BUMP POINTER WHEN THE FREELIST IS EMPTY ,
+      so creating a logical page doesn't touch its memory
+
+    - NOT THREAD SAFE EXCEPT deallocate_remotely WHICH CAN BE CALLED FROM ANY THREAD. REMOTELY FREED CHUNKS ARE PUSHED TO A SEPARATE LOCK FREE STACK
+      AND THEY BECOME AVAILABLE TO THE OWNER AFTER reclaim_remote_frees
+
     - IF THE PASSED BUFFER IS START OF A VIRTUAL PAGE AND THE PASSED SIZE IS A VM PAGE SIZE , THEN IT WILL BE CORRESPONDING TO AN ACTUAL VM PAGE
       IDEAL USE CASE IS ITS CORRESPONDING TO A VM PAGE / BEING VM PAGE ALIGNED. SO THAT A SINGLE PAYLOAD WILL NOT SPREAD TO DIFFERENT VM PAGES.
 */
@@ -2192,18 +3518,17 @@ class LogicalPage
             }
 
             #ifndef UNIT_TEST
-            // Segment should place us to a start of aligned vm page + size of header
-            void* buffer_start_including_header = reinterpret_cast<void*>(reinterpret_cast<std::size_t>(buffer) - sizeof(*this));
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(buffer_start_including_header) == true, "LogicalPage : Segments or heaps should pass buffers which are aligned to OS page allocation granularity.");
-            LLMALLOC_UNUSED(buffer_start_including_header);
+            // Segment should place us to a start of aligned vm page , chunks can start later than the end of the header due to cache coloring
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(this) == true, "LogicalPage : Segments or heaps should place logical pages to addresses which are aligned to OS page allocation granularity.");
+            llmalloc_assert_msg(reinterpret_cast<std::size_t>(buffer) >= reinterpret_cast<std::size_t>(this) + sizeof(*this), "LogicalPage : Chunks can't overlap with the logical page header.");
             #endif
 
             this->m_page_header.initialise();
             this->m_page_header.m_size_class = size_class;
             this->m_page_header.m_logical_page_start_address = reinterpret_cast<uint64_t>(buffer);
-            this->m_page_header.m_logical_page_size = buffer_size;
-
-            grow(buffer, buffer_size);
+            this->m_page_header.m_logical_page_size = static_cast<uint32_t>(buffer_size);
+            // Bump pointer starts from the end of the last whole chunk
+            this->m_page_header.m_last_used_node = reinterpret_cast<uint64_t>(buffer) + (buffer_size / size_class) * size_class;
 
             return true;
         }
@@ -2217,7 +3542,12 @@ class LogicalPage
 
             if (llmalloc_unlikely(free_node == nullptr))
             {
-                return nullptr;
+                free_node = carve();
+
+                if (free_node == nullptr)
+                {
+                    return nullptr;
+                }
             }
 
             this->m_page_header.m_used_size += this->m_page_header.m_size_class;
@@ -2225,53 +3555,214 @@ class LogicalPage
             return  reinterpret_cast<void*>(free_node);
         }
 
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        void deallocate(void* ptr)
+        // Also reports whether the chunk is known to be zeroed. That is the case for never used chunks unless the page is dirty , as segments get their memory fresh from the OS
+        void* allocate(const std::size_t size, bool& is_zeroed)
         {
-            this->m_page_header.m_used_size -= this->m_page_header.m_size_class;
-            push(static_cast<NodeType*>(ptr));
-        }
+            LLMALLOC_UNUSED(size);
 
-        std::size_t get_usable_size(void* ptr) 
-        { 
-            LLMALLOC_UNUSED(ptr);
-            return  static_cast<std::size_t>(this->m_page_header.m_size_class); 
-        }
+            NodeType* free_node = pop();
+            is_zeroed = false;
 
-        bool can_be_recycled() { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_USED>() == false; }
+            if (llmalloc_unlikely(free_node == nullptr))
+            {
+                free_node = carve();
 
-        void mark_as_used() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_USED>();  }
-        void mark_as_non_used() { m_page_header.clear_flag<LogicalPageHeaderFlags::IS_USED>(); }
+                if (free_node == nullptr)
+                {
+                    return nullptr;
+                }
 
-        uint64_t get_used_size() const { return m_page_header.m_used_size; }
-        uint32_t get_size_class() { return m_page_header.m_size_class; }
-        
-        uint16_t get_segment_id() { return m_page_header.m_segment_id; }
-        void set_segment_id(const uint16_t id) { m_page_header.m_segment_id = id; }
+                is_zeroed = is_dirty() == false; // Carved chunks were never written
+            }
 
-        uint64_t get_next_logical_page() const { return m_page_header.m_next_logical_page_ptr; }
-        void set_next_logical_page(void* address) { m_page_header.m_next_logical_page_ptr = reinterpret_cast<uint64_t>(address); }
+            this->m_page_header.m_used_size += this->m_page_header.m_size_class;
 
-        uint64_t get_previous_logical_page() const { return m_page_header.m_prev_logical_page_ptr; }
-        void set_previous_logical_page(void* address) { m_page_header.m_prev_logical_page_ptr = reinterpret_cast<uint64_t>(address); }
+            return  reinterpret_cast<void*>(free_node);
+        }
 
-        #ifdef UNIT_TEST
-        NodeType* get_head_node() { return reinterpret_cast<NodeType*>(m_page_header.m_head); };
-        #endif
+        // Pops up to count chunks in one pass and updates the header once , returns the number of popped chunks
+        std::size_t allocate_batch(const std::size_t size, std::size_t count, void** out)
+        {
+            LLMALLOC_UNUSED(size);
 
-    private:
+            std::size_t allocated{ 0 };
 
-        LogicalPageHeader m_page_header;
+            while (allocated < count)
+            {
+                NodeType* free_node = pop();
 
-        void grow(void* buffer, std::size_t buffer_size)
-        {
-            const std::size_t chunk_count = buffer_size / this->m_page_header.m_size_class;
+                if (llmalloc_unlikely(free_node == nullptr))
+                {
+                    break;
+                }
 
-            for (std::size_t i = 0; i < chunk_count; ++i)
-            {
-                std::size_t address = reinterpret_cast<std::size_t>(buffer) + i * this->m_page_header.m_size_class;
-                push(reinterpret_cast<NodeType*>(address));
+                out[allocated++] = reinterpret_cast<void*>(free_node);
             }
+
+            while (allocated < count)
+            {
+                NodeType* free_node = carve();
+
+                if (free_node == nullptr)
+                {
+                    break;
+                }
+
+                out[allocated++] = reinterpret_cast<void*>(free_node);
+            }
+
+            this->m_page_header.m_used_size += static_cast<uint32_t>(allocated * this->m_page_header.m_size_class);
+
+            return allocated;
+        }
+
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate(void* ptr)
+        {
+            this->m_page_header.m_used_size -= this->m_page_header.m_size_class;
+            push(static_cast<NodeType*>(ptr));
+        }
+
+        // Can be called from any thread
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* ptr)
+        {
+            deallocate_remotely(ptr, ptr);
+        }
+
+        // Can be called from any thread , pushes an already linked chain of chunks ( first->...->last ) with a single CAS
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* first, void* last)
+        {
+            deallocate_remotely(first, last, []() {});
+        }
+
+        // Same as above , on_first_remote_free is called before pushing to an empty stack. The logical page can't be recycled at that point
+        // as the chain is not pushed yet , so the callback can publish the logical page to its owner
+        template <typename Callback>
+        LLMALLOC_FORCE_INLINE void deallocate_remotely(void* first, void* last, Callback&& on_first_remote_free)
+        {
+            auto remote_free_head = get_remote_free_head();
+            NodeType* last_node = static_cast<NodeType*>(last);
+            uint64_t old_head = remote_free_head->load(std::memory_order_relaxed);
+            bool notified = false;
+
+            do
+            {
+                if (llmalloc_unlikely(old_head == 0 && notified == false))
+                {
+                    on_first_remote_free();
+                    notified = true;
+                }
+
+                last_node->m_next = reinterpret_cast<NodeType*>(old_head);
+            }
+            while (!remote_free_head->compare_exchange_weak(old_head, reinterpret_cast<uint64_t>(first), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Should be called by the owner , moves remotely freed chunks to the freelist. Returns false if there was none
+        bool reclaim_remote_frees()
+        {
+            auto remote_free_head = get_remote_free_head();
+
+            if (llmalloc_likely(remote_free_head->load(std::memory_order_relaxed) == 0))
+            {
+                return false;
+            }
+
+            // Taking the whole stack at once so no ABA risk
+            NodeType* iter = reinterpret_cast<NodeType*>(remote_free_head->exchange(0, std::memory_order_acquire));
+
+            while (iter)
+            {
+                NodeType* next = iter->m_next;
+                deallocate(iter);
+                iter = next;
+            }
+
+            return true;
+        }
+
+        std::size_t get_usable_size(void* ptr) 
+        { 
+            LLMALLOC_UNUSED(ptr);
+            return  static_cast<std::size_t>(this->m_page_header.m_size_class); 
+        }
+
+        // Returns start address of the chunk that holds the passed address
+        LLMALLOC_FORCE_INLINE void* get_chunk_start_address(void* ptr) const
+        {
+            uint64_t start = m_page_header.m_logical_page_start_address;
+            uint64_t size_class = static_cast<uint64_t>(m_page_header.m_size_class);
+            uint64_t offset = reinterpret_cast<uint64_t>(ptr) - start;
+
+            if (llmalloc_likely((size_class & (size_class - 1)) == 0))
+            {
+                offset &= ~(size_class - 1);
+            }
+            else
+            {
+                offset = (offset / size_class) * size_class; // Non pow2 size classes , see size_classes.h
+            }
+
+            return reinterpret_cast<void*>(start + offset);
+        }
+
+        bool can_be_recycled() { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_USED>() == false; }
+
+        void mark_as_used() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_USED>();  }
+        void mark_as_non_used() { m_page_header.clear_flag<LogicalPageHeaderFlags::IS_USED>(); }
+
+        bool is_full() const { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+        void mark_as_full() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+        void mark_as_non_full() { m_page_header.clear_flag<LogicalPageHeaderFlags::IS_FULL>(); }
+
+        bool is_dirty() const { return m_page_header.get_flag<LogicalPageHeaderFlags::IS_DIRTY>(); }
+        void mark_as_dirty() { m_page_header.set_flag<LogicalPageHeaderFlags::IS_DIRTY>(); }
+
+        uint64_t get_used_size() const { return m_page_header.m_used_size; }
+        uint32_t get_size_class() { return m_page_header.m_size_class; }
+
+        // Bytes of chunks handed out at least once , never used ones are below the bump pointer
+        uint64_t get_carved_size() const
+        {
+            auto chunks_end = m_page_header.m_logical_page_start_address + (m_page_header.m_logical_page_size / m_page_header.m_size_class) * m_page_header.m_size_class;
+            return chunks_end - m_page_header.m_last_used_node;
+        }
+        
+        uint16_t get_segment_id() { return m_page_header.m_segment_id; }
+        void set_segment_id(const uint16_t id) { m_page_header.m_segment_id = id; }
+
+        uint64_t get_next_logical_page() const { return m_page_header.m_next_logical_page_ptr; }
+        void set_next_logical_page(void* address) { m_page_header.m_next_logical_page_ptr = reinterpret_cast<uint64_t>(address); }
+
+        uint64_t get_previous_logical_page() const { return m_page_header.m_prev_logical_page_ptr; }
+        void set_previous_logical_page(void* address) { m_page_header.m_prev_logical_page_ptr = reinterpret_cast<uint64_t>(address); }
+
+        #ifdef UNIT_TEST
+        NodeType* get_head_node() { return reinterpret_cast<NodeType*>(m_page_header.m_head); };
+        #endif
+
+    private:
+
+        LogicalPageHeader m_page_header;
+
+        // Taking address of a packed member directly would trigger unaligned pointer warnings , the field itself is 8 byte aligned
+        LLMALLOC_FORCE_INLINE std::atomic<uint64_t>* get_remote_free_head()
+        {
+            static_assert(offsetof(LogicalPageHeader, m_remote_free_head) % sizeof(uint64_t) == 0);
+            static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t));
+            return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(&m_page_header) + offsetof(LogicalPageHeader, m_remote_free_head));
+        }
+
+        // Hands out never used chunks in descending address order , returns nullptr if all chunks were handed out at least once
+        LLMALLOC_FORCE_INLINE NodeType* carve()
+        {
+            if (llmalloc_unlikely(this->m_page_header.m_last_used_node - this->m_page_header.m_logical_page_start_address < this->m_page_header.m_size_class))
+            {
+                return nullptr;
+            }
+
+            this->m_page_header.m_last_used_node -= this->m_page_header.m_size_class;
+            return reinterpret_cast<NodeType*>(this->m_page_header.m_last_used_node);
         }
 
         LLMALLOC_FORCE_INLINE void push(NodeType* new_node)
@@ -2293,976 +3784,3179 @@ class LogicalPage
         }
 };
 /*
-    - A SEGMENT IS A COLLECTION OF LOGICAL PAGES. IT ALLOWS TO GROW IN SIZE AND TO RETURN UNUSED LOGICAL PAGES BACK TO THE SYSTEM
+    - COLLECTS EMPTIED LOGICAL PAGES FROM SEGMENTS AND RELEASES THEM TO THE OS AFTER A DECAY PERIOD , SO THAT THREADS CALLING FREE DON'T ENTER THE KERNEL
 
-    - IT WILL PLACE A LOGICAL PAGE HEADER TO INITIAL 64 BYTES OF EVERY LOGICAL PAGE.            
-     
-    ! IMPORTANT : THE EXTERNAL BUFFER SHOULD BE ALIGNED TO LOGICAL PAGE SIZE. THAT IS CRITICAL FOR REACHING LOGICAL PAGE HEADERS
+    - ANY THREAD CAN ADD PAGES WITH A SINGLE CAS. PAGES ARE LINKED THROUGH THEIR OWN FIRST BYTES AS THEY ARE NO LONGER USED BY ANY HEAP
+
+    - purge IS MEANT TO BE CALLED PERIODICALLY BY A LOW PRIORITY BACKGROUND THREAD. IT RELEASES EXPIRED PAGES OLDEST FIRST UP TO A BYTE BUDGET PER CALL
+      so that releases and TLB shootdowns are rate limited
+
+    - IF PENDING PAGES EXCEED A BOUND , THE ADDING THREAD RELEASES THE OLDEST ONES ITSELF REGARDLESS OF THEIR DECAY.
+      So pages don't pile up when the background thread doesn't get CPU time or doesn't exist , ex: in a child process before its thread is restarted
+
+    - PAGES CAN BE ADDED WITH THEIR ARENAS SO THAT THEY ARE RELEASED ACCORDING TO THE ARENA'S PAGE RELEASE POLICY. Otherwise they are unmapped
 */
 
-struct SegmentCreationParameters
+struct PagePurgerOptions
 {
-    std::size_t m_logical_page_size = 0;
-    std::size_t m_logical_page_count = 0;
-    std::size_t m_page_recycling_threshold = 0;
-    uint32_t m_size_class = 0;
-    double m_grow_coefficient = 2.0; // 0 means that we will be growing by allocating only required amount. Applies to segments that can grow
-    bool m_can_grow = true;
+    uint64_t decay_period = 1000;               // In milliseconds , pages are released at least this long after they were added
+    std::size_t max_bytes_per_purge = 67108864; // Release budget per purge call , 0 means no limit
+    std::size_t max_pending_size = 268435456;   // Adding threads release pages synchronously beyond this , 0 means no limit
 };
 
-template <LockPolicy lock_policy>
-class Segment : public Lockable<lock_policy>
+class PagePurger
 {
     public:
-    
-        using LogicalPageType = LogicalPage;
-        using ArenaType = Arena;
 
-        Segment()
-        {
-            m_logical_page_object_size = sizeof(LogicalPageType);
-            llmalloc_assert_msg(m_logical_page_object_size == sizeof(LogicalPageHeader), "Segment: Logical page object size should not exceed logical page header size." );
+        PagePurger() = default;
+        ~PagePurger() = default;
 
-            m_segment_id_counter++;
+        PagePurger(const PagePurger& other) = delete;
+        PagePurger& operator= (const PagePurger& other) = delete;
+        PagePurger(PagePurger&& other) = delete;
+        PagePurger& operator=(PagePurger&& other) = delete;
 
-            // Central heaps and locals heaps use different specialisation for Segments 
-            // Therefore different types lead to 2 diff static m_segment_id_counter variables.
-            // We need segment ids to be unique across all segments to be able to identify whether a deallocated ptr 
-            // belongs to this thread to avoid pushing it into vm pages used on this thread.
-            // Otherwise we wouldn't be able to give unused vm pages back to the system.
-            if constexpr (lock_policy == LockPolicy::NO_LOCK)
-            {
-                // Local heap segment
-                m_segment_id = m_segment_id_counter;
-            }
-            else
-            {
-                // Central heap segment
-                m_segment_id = m_segment_id_counter + 32768;
-            }
+        bool create(const PagePurgerOptions& options)
+        {
+            m_decay_period = options.decay_period;
+            m_max_bytes_per_purge = options.max_bytes_per_purge;
+            m_max_pending_size = options.max_pending_size;
+            m_lock.initialise();
+            return true;
         }
 
-        ~Segment()
+        // Can be called from any thread , the page should not be accessed by anything else afterwards
+        void add(void* address, std::size_t size, Arena* arena = nullptr)
         {
-            destroy();
-        }
+            llmalloc_assert_msg(size >= sizeof(DirtyPage), "PagePurger: Pages should be big enough to hold their links.");
 
-        Segment(const Segment& other) = delete;
-        Segment& operator= (const Segment& other) = delete;
-        Segment(Segment&& other) = delete;
-        Segment& operator=(Segment&& other) = delete;
+            DirtyPage* page = static_cast<DirtyPage*>(address);
+            page->m_size = size;
+            page->m_add_time = TimeUtilities::get_monotonic_time_in_milliseconds();
+            page->m_arena = arena;
 
-        [[nodiscard]] bool create(char* external_buffer, ArenaType* arena_ptr, const SegmentCreationParameters& params)
-        {
-            if (params.m_size_class <= 0 || params.m_logical_page_size <= 0 || AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.m_logical_page_size) == false
-                || params.m_logical_page_count <= 0 || params.m_logical_page_size <= m_logical_page_object_size || !external_buffer || !arena_ptr)
+            DirtyPage* old_head = m_incoming_pages.load(std::memory_order_relaxed);
+
+            do
             {
-                return false;
+                page->m_next = old_head;
             }
+            while (!m_incoming_pages.compare_exchange_weak(old_head, page, std::memory_order_release, std::memory_order_relaxed));
 
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(external_buffer, params.m_logical_page_size) == true, "Segment: Passed buffer is not aligned to specified logical page size. This is a requirement to enable quick access to logical pages from pointers.");
-
-            m_params = params;
-            m_arena = arena_ptr;
+            std::size_t pending_size = m_pending_size.fetch_add(size, std::memory_order_relaxed) + size;
 
-            if (grow(external_buffer, params.m_logical_page_count) == nullptr)
+            if (m_max_pending_size > 0 && pending_size > m_max_pending_size)
             {
-                return false;
+                release_excess_pages();
             }
-
-            return true;
         }
 
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
-        void* allocate(std::size_t size = 0)
+        // Returns released bytes. If ignore_decay is true , all pages are released without any budget
+        std::size_t purge(bool ignore_decay = false)
         {
-            void* ret = nullptr;
+            std::size_t released_size{ 0 };
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
 
-            this->enter_concurrent_context(); // Locking only for central heap
-            
-            // Next-fit like , we start searching from where we left if possible
-            LogicalPageType* iter = m_last_used ? m_last_used : m_head;
+            m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            collect_incoming_pages();
 
-            while (iter)
+            while (m_oldest_page)
             {
-                ret = iter->allocate(size);
-
-                if (ret != nullptr)
+                if (ignore_decay == false)
                 {
-                    m_last_used = iter;
-                    this->leave_concurrent_context();
-                    return ret;
+                    if (m_oldest_page->m_add_time + m_decay_period > now)
+                    {
+                        break; // The rest is newer
+                    }
+
+                    if (m_max_bytes_per_purge > 0 && released_size + m_oldest_page->m_size > m_max_bytes_per_purge && released_size > 0)
+                    {
+                        break;
+                    }
                 }
 
-                iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                released_size += release_oldest_page();
             }
+            ////////////////////////////////////////////////////////////////////
+            m_lock.unlock();
 
-            // If we started the search from a non-head node,  then we need one more iteration
-            ret = allocate_from_start(size);
-            this->leave_concurrent_context();
+            m_pending_size.fetch_sub(released_size, std::memory_order_relaxed);
 
-            return ret;
+            return released_size;
         }
 
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        void deallocate(void* ptr)
+        std::size_t get_pending_size() const { return m_pending_size.load(std::memory_order_relaxed); }
+
+    private:
+
+        struct DirtyPage
         {
-            if( m_head == nullptr ) { return;}
-            auto affected = get_logical_page_from_address(ptr, m_params.m_logical_page_size);
-            llmalloc_assert_msg(affected->get_segment_id() == m_segment_id, "Deleted ptr's segment id should match this segment's id");
-            llmalloc_assert_msg(affected->get_usable_size(ptr) == m_params.m_size_class, "Deleted ptr's size class should match this segment's size class");
+            DirtyPage* m_next;
+            std::size_t m_size;
+            uint64_t m_add_time;
+            Arena* m_arena;
+        };
 
-            this->enter_concurrent_context(); // Locking only for central heap
+        std::atomic<DirtyPage*> m_incoming_pages = nullptr;   // Newest first
+        std::atomic<std::size_t> m_pending_size = 0;
+        DirtyPage* m_oldest_page = nullptr;                   // Oldest first , accessed only under the lock
+        DirtyPage* m_newest_page = nullptr;
+        UserspaceSpinlock<> m_lock;
+        uint64_t m_decay_period = 1000;
+        std::size_t m_max_bytes_per_purge = 0;
+        std::size_t m_max_pending_size = 0;
 
-            affected->deallocate(ptr);
+        // Takes all incoming pages with a single exchange and appends them to the pending list in the order they were added
+        void collect_incoming_pages()
+        {
+            DirtyPage* iter = m_incoming_pages.exchange(nullptr, std::memory_order_acquire);
+            DirtyPage* oldest_incoming = nullptr;
+            DirtyPage* newest_incoming = iter;
 
-            if (llmalloc_unlikely(affected->get_used_size() == 0))
+            while (iter)
             {
-                affected->mark_as_non_used();
+                DirtyPage* next = iter->m_next;
+                iter->m_next = oldest_incoming;
+                oldest_incoming = iter;
+                iter = next;
+            }
 
-                if (m_logical_page_count > m_params.m_page_recycling_threshold)
-                {
-                    recycle_logical_page(affected);
-                }
+            if (oldest_incoming == nullptr)
+            {
+                return;
             }
 
-            this->leave_concurrent_context();
-        }
+            if (m_newest_page)
+            {
+                m_newest_page->m_next = oldest_incoming;
+            }
+            else
+            {
+                m_oldest_page = oldest_incoming;
+            }
 
-        bool owns_pointer(void* ptr)
-        {
-            return get_segment_id_from_address(ptr) == m_segment_id;
+            m_newest_page = newest_incoming;
         }
 
-        void transfer_logical_pages_from(LogicalPageType* logical_page_head)
+        // Should be called under the lock
+        std::size_t release_oldest_page()
         {
-            this->enter_concurrent_context();
-            ///////////////////////////////////////////////////////////////////
-            LogicalPageType* iter = logical_page_head;
+            DirtyPage* page = m_oldest_page;
+            std::size_t page_size = page->m_size;
+            m_oldest_page = page->m_next;
 
-            while (iter)
+            if (m_oldest_page == nullptr)
             {
-                LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
-
-                add_logical_page(iter); // Will also update iter's next ptr
-
-                iter = iter_next;
+                m_newest_page = nullptr;
             }
-            ///////////////////////////////////////////////////////////////////
-            this->leave_concurrent_context();
-        }
 
-        // Constant time logical page look up method for finding logical pages if their start addresses are aligned to logical page size
-        static LogicalPageType* get_logical_page_from_address(void* ptr, std::size_t logical_page_size)
-        {           
-            uint64_t orig_ptr = reinterpret_cast<uint64_t>(ptr);
-            // Masking below is equivalent of -> orig_ptr - modulo(orig_ptr, logical_page_size);
-            uint64_t target_page_address = orig_ptr & ~(logical_page_size - 1);
-            LogicalPageType* target_logical_page = reinterpret_cast<LogicalPageType*>(target_page_address);
-            return target_logical_page;
-        }
+            if (page->m_arena)
+            {
+                page->m_arena->release_to_system(page, page_size);
+            }
+            else
+            {
+                VirtualMemory::deallocate(page, page_size);
+            }
 
-        // Constant time size_class look up method for finding logical pages if their start addresses are aligned to logical page size
-        static uint32_t get_size_class_from_address(void* ptr, std::size_t logical_page_size)
-        {           
-            LogicalPageType* target_logical_page = get_logical_page_from_address(ptr, logical_page_size);
-            return target_logical_page->get_size_class();
+            return page_size;
         }
 
-        uint16_t get_segment_id_from_address(void* ptr)
+        // Releases oldest pages until the pending size is within the bound. Skipped if another thread is already purging
+        void release_excess_pages()
         {
-            LogicalPageType* target_logical_page = get_logical_page_from_address(ptr, m_params.m_logical_page_size);
-            return target_logical_page->get_segment_id();
-        }
+            if (m_lock.try_lock() == false)
+            {
+                return;
+            }
+            ////////////////////////////////////////////////////////////////////
+            collect_incoming_pages();
 
-        LLMALLOC_FORCE_INLINE uint16_t get_id() const { return m_segment_id; }
-        
-        LogicalPageType* get_head_logical_page() { return m_head; }
+            while (m_oldest_page && m_pending_size.load(std::memory_order_relaxed) > m_max_pending_size)
+            {
+                m_pending_size.fetch_sub(release_oldest_page(), std::memory_order_relaxed);
+            }
+            ////////////////////////////////////////////////////////////////////
+            m_lock.unlock();
+        }
+};
 
-        #ifdef UNIT_TEST
-        std::size_t get_logical_page_count() const { return m_logical_page_count; }
-        #endif
+/*
+    - HOLDS EMPTIED LOGICAL PAGES OF A HEAP SO THAT SEGMENTS OF ANY SIZE CLASS CAN GROW INTO THEM BEFORE ASKING THE ARENA FOR NEW MEMORY.
+      Logical pages of all size classes that share a logical page size can be pooled together as segments recreate them with LogicalPage::create
 
-    private:
-        SegmentCreationParameters m_params;
-        uint16_t m_segment_id = 0;
-        std::size_t m_logical_page_object_size = 0;
-        std::size_t m_logical_page_count = 0;
-        LogicalPageType* m_head = nullptr;
-        LogicalPageType* m_tail = nullptr;
-        LogicalPageType* m_last_used = nullptr;
-        static inline uint16_t m_segment_id_counter = 0; // Not thread safe but segments will always be created from a single thread
+    - PAGES ARE LINKED THROUGH THEIR OWN FIRST BYTES AND THE MOST RECENTLY ADDED PAGE IS REUSED FIRST AS ITS MEMORY IS MORE LIKELY TO BE IN CACHES
 
-        ArenaType* m_arena = nullptr;
+    - HYSTERESIS : WHEN AN ADDED PAGE EXCEEDS THE CAPACITY , THE POOL RELEASES ITS OLDER HALF TO THE OS.
+      So that a heap hovering around its page recycling thresholds doesn't map and unmap a page on every swing
 
-        // Returns first logical page ptr of the grow
-        [[nodiscard]] LogicalPageType* grow(char* buffer, std::size_t logical_page_count)
-        {
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(buffer, m_params.m_logical_page_size), "Passed buffer to segment grow should be aligned to the logical page size.");
-            LogicalPageType* first_new_logical_page = nullptr;
-            LogicalPageType* previous_page = m_tail;
-            LogicalPageType* iter_page = nullptr;
+    - POOLED PAGES ARE NOT ZEROED. SEGMENTS MARK LOGICAL PAGES BUILT ON THEM AS DIRTY
 
-            auto create_new_logical_page = [&](char* logical_page_buffer) -> bool
-            {
-                iter_page = new(logical_page_buffer) LogicalPageType();
+    - THREAD SAFE AS SEGMENTS OF A CENTRAL HEAP ARE LOCKED SEPARATELY. IT IS ACCESSED ONLY IN SEGMENT SLOW PATHS
+*/
 
-                bool success = iter_page->create(logical_page_buffer + m_logical_page_object_size, m_params.m_logical_page_size - m_logical_page_object_size, m_params.m_size_class);
+class LogicalPagePool : public Lockable<LockPolicy::USERSPACE_LOCK>
+{
+    public:
 
-                if (success == false)
-                {
-                    m_arena->release_to_system(buffer, m_params.m_logical_page_size);
-                    return false;
-                }
+        LogicalPagePool() = default;
 
-                iter_page->mark_as_used();
-                iter_page->set_segment_id(m_segment_id);
+        ~LogicalPagePool()
+        {
+            destroy();
+        }
 
-                m_logical_page_count++;
+        LogicalPagePool(const LogicalPagePool& other) = delete;
+        LogicalPagePool& operator= (const LogicalPagePool& other) = delete;
+        LogicalPagePool(LogicalPagePool&& other) = delete;
+        LogicalPagePool& operator=(LogicalPagePool&& other) = delete;
 
-                return true;
-            };
-            /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            // FIRST PAGE
-            if (llmalloc_unlikely(create_new_logical_page(buffer) == false))
+        // Capacity is in logical pages , 0 disables pooling. Released pages go to the page purger if specified , otherwise to the arena
+        [[nodiscard]] bool create(std::size_t logical_page_size, std::size_t capacity, Arena* arena, PagePurger* page_purger = nullptr)
+        {
+            if (logical_page_size < sizeof(PooledPage) || arena == nullptr)
             {
-                return nullptr;
+                return false;
             }
 
-            first_new_logical_page = iter_page;
+            m_logical_page_size = logical_page_size;
+            m_capacity = capacity;
+            m_arena = arena;
+            m_page_purger = page_purger;
 
-            if (m_head == nullptr)
-            {
-                // The very first page
-                m_head = iter_page;
-                m_tail = iter_page;
-            }
-            else
+            return true;
+        }
+
+        // Returns false if pooling is disabled , the caller should release the page then
+        bool add(void* address)
+        {
+            if (m_capacity == 0)
             {
-                previous_page->set_next_logical_page(iter_page);
-                iter_page->set_previous_logical_page(previous_page);
+                return false;
             }
 
-            previous_page = iter_page;
+            PooledPage* page = static_cast<PooledPage*>(address);
 
-            /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-            // REST OF THE PAGES
-            for (std::size_t i = 1; i < logical_page_count; i++)
-            {
-                if (create_new_logical_page(buffer + (i * m_params.m_logical_page_size)) == false)
-                {
-                    return nullptr;
-                }
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            page->m_next = m_head;
+            m_head = page;
+            m_page_count++;
 
-                previous_page->set_next_logical_page(iter_page);
-                iter_page->set_previous_logical_page(previous_page);
-                previous_page = iter_page;
+            PooledPage* pages_to_release = nullptr;
+
+            if (m_page_count > m_capacity)
+            {
+                pages_to_release = detach_older_half();
             }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
 
-            m_tail = iter_page;
+            // Releasing outside of the lock as it may enter the kernel
+            release_pages(pages_to_release);
 
-            return first_new_logical_page;
+            return true;
         }
 
-        void recycle_logical_page(LogicalPageType* affected)
+        // Returns nullptr if the pool is empty
+        void* get()
         {
-            remove_logical_page(affected);
-            affected->~LogicalPageType();
-            m_arena->release_to_system(affected, m_params.m_logical_page_size);
-            #ifdef ENABLE_PERF_TRACES
-            fprintf(stderr, "\033[0;31m" "segment recycling vm page, size=%zu  sizeclass=%u\n" "\033[0m", m_params.m_logical_page_size, m_params.m_size_class);
-            #endif
-        }
+            PooledPage* page = nullptr;
 
-        void remove_logical_page(LogicalPageType* affected)
-        {
-            auto next = reinterpret_cast<LogicalPageType*>(affected->get_next_logical_page());
-            auto previous = reinterpret_cast<LogicalPageType*>(affected->get_previous_logical_page());
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            page = m_head;
 
-            if (affected == m_last_used)
+            if (page)
             {
-                if (previous)
-                {
-                    m_last_used = previous;
-                }
-                else if (next)
-                {
-                    m_last_used = next;
-                }
-                else
-                {
-                    m_last_used = nullptr;
-                }
+                m_head = page->m_next;
+                m_page_count--;
             }
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
 
-            if (previous == nullptr)
-            {
-                m_head = next;
+            return page;
+        }
 
-                if (m_head == nullptr || m_head->get_next_logical_page() == 0)
-                {
-                    m_tail = m_head;
-                }
-            }
-            else
-            {
-                previous->set_next_logical_page(next);
+        // Releases all pooled pages directly to the arena , ex: for malloc_trim
+        void release_all()
+        {
+            this->enter_concurrent_context();
+            //////////////////////////////////////////////////
+            PooledPage* pages = m_head;
+            m_head = nullptr;
+            m_page_count = 0;
+            //////////////////////////////////////////////////
+            this->leave_concurrent_context();
 
-                if (m_tail == affected)
-                {
-                    m_tail = previous;
-                }
-            }
+            release_pages(pages, false);
+        }
 
-            if (next)
-                next->set_previous_logical_page(previous);
+        std::size_t get_page_count() const { return m_page_count; }
+        std::size_t get_logical_page_size() const { return m_logical_page_size; }
 
-            m_logical_page_count--;
-        }
+    private:
 
-        void add_logical_page(LogicalPageType* logical_page)
+        struct PooledPage
         {
-            if (m_tail)
+            PooledPage* m_next;
+        };
+
+        PooledPage* m_head = nullptr;   // Most recently added first
+        std::size_t m_page_count = 0;
+        std::size_t m_capacity = 0;
+        std::size_t m_logical_page_size = 0;
+        Arena* m_arena = nullptr;
+        PagePurger* m_page_purger = nullptr;
+
+        // Keeps the most recently added half , returns the rest as a linked list
+        PooledPage* detach_older_half()
+        {
+            std::size_t kept_count = m_capacity / 2;
+
+            if (kept_count == 0)
             {
-                m_tail->set_next_logical_page(logical_page);
-                logical_page->set_previous_logical_page(m_tail);
+                PooledPage* ret = m_head;
+                m_head = nullptr;
+                m_page_count = 0;
+                return ret;
             }
-            else
+
+            PooledPage* last_kept = m_head;
+
+            for (std::size_t i = 1; i < kept_count; i++)
             {
-                m_head = logical_page;
-                m_tail = logical_page;
+                last_kept = last_kept->m_next;
             }
 
-            logical_page->set_next_logical_page(nullptr);
-            m_logical_page_count++;
+            PooledPage* ret = last_kept->m_next;
+            last_kept->m_next = nullptr;
+            m_page_count = kept_count;
+
+            return ret;
         }
 
-        void destroy()
+        void release_pages(PooledPage* page, bool use_page_purger = true)
         {
-            if (m_head == nullptr)
+            while (page)
             {
-                return;
-            }
-
-            LogicalPageType* iter = m_head;
-            LogicalPageType* next = nullptr;
+                PooledPage* next = page->m_next;
 
-            while (iter)
-            {
-                next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
-                
-                if (iter->get_used_size() == 0)
+                if (m_page_purger && use_page_purger)
                 {
-                    // Invoking dtor of logical page
-                    iter->~LogicalPageType();
-                    // Release pages back to system if we are managing the arena
-                    m_arena->release_to_system(iter, m_params.m_logical_page_size);
+                    m_page_purger->add(page, m_logical_page_size, m_arena);
+                }
+                else
+                {
+                    m_arena->release_to_system(page, m_logical_page_size);
                 }
 
-                iter = next;
+                page = next;
             }
+        }
 
+        void destroy()
+        {
+            PooledPage* pages = m_head;
             m_head = nullptr;
-            m_tail = nullptr;
+            m_page_count = 0;
+
+            // Like segments , going directly to the arena on destruction
+            release_pages(pages, false);
         }
+};
 
-        // Slow path removal function
-        void* allocate_from_start(std::size_t size)
-        {
-            if (m_last_used)
-            {
-                void* ret = nullptr;
-                LogicalPageType* iter = m_head;
+/*
+    PER SIZE CLASS STATISTICS OF HEAPS
 
-                while (iter != m_last_used)
-                {
-                    ret = iter->allocate(size);
+    - COUNTERS ARE KEPT ONLY WITH ENABLE_STATS. Heaps increment them without atomic read-modify-writes where they are the only writers
 
-                    if (ret != nullptr)
-                    {
-                        m_last_used = iter;
-                        return ret;
-                    }
+    - PAGE SIZES ARE ALWAYS MEASURED , BY THE OWNERS OF THREAD LOCAL HEAPS. See HeapPow2::add_bin_stats
+*/
 
-                    iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
-                }
-            }
+struct BinStats
+{
+    std::size_t allocation_count = 0;
+    std::size_t deallocation_count = 0;                 // Frees of chunks of the heap's own logical pages
+    std::size_t cross_thread_deallocation_count = 0;    // Frees of chunks of other heaps' logical pages
+    std::size_t queue_overflow_count = 0;               // Frees rejected by full deallocation queues , callers pass them to the central heap
+    std::size_t segment_grow_count = 0;
+    std::size_t recycled_logical_page_count = 0;
+    std::size_t resident_size = 0;                      // Logical page headers and chunks carved at least once
+    std::size_t virtual_size = 0;                       // All logical pages
+};
 
-            // If we reached here , it means that we need to allocate more memory
-            return allocate_by_growing(size);
-        }
+/*
+    - A SEGMENT IS A COLLECTION OF LOGICAL PAGES. IT ALLOWS TO GROW IN SIZE AND TO RETURN UNUSED LOGICAL PAGES BACK TO THE SYSTEM
 
-        // Slow path removal function
-        void* allocate_by_growing(std::size_t size)
-        {
-            void* ret = nullptr;
+    - IT WILL PLACE A LOGICAL PAGE HEADER TO INITIAL 64 BYTES OF EVERY LOGICAL PAGE.            
 
-            if (m_params.m_can_grow == true)
-            {
-                std::size_t new_logical_page_count = 0;
-                std::size_t minimum_new_logical_page_count = 0;
-                calculate_quantities(size, new_logical_page_count, minimum_new_logical_page_count);
+    - LOGICAL PAGES WITH FREE CHUNKS ARE KEPT BEFORE FULL ONES IN THE LOGICAL PAGE LIST , SO ALLOCATIONS ALWAYS START FROM THE HEAD WITHOUT SEARCHING.
+      A page is moved to the tail when it runs out of chunks and back to the head when a chunk is returned to it
 
-                char* new_buffer = nullptr;
-                new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
+    - OPTIONALLY CHUNK START OFFSETS OF CONSECUTIVE LOGICAL PAGES ARE STAGGERED BY A CACHE LINE ( CACHE COLORING ).
+      As logical pages are aligned to their sizes , otherwise first chunks of all pages would map to the same cache sets. Headers stay at offset 0 for the mask lookup
 
-                if (new_buffer == nullptr && new_logical_page_count > minimum_new_logical_page_count)  // Meeting grow_coefficient is not possible so lower the new_logical_page_count
-                {
-                    new_logical_page_count = minimum_new_logical_page_count;
-                    new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
-                }
+    - OPTIONALLY RECYCLED LOGICAL PAGES GO TO A POOL SHARED WITH SEGMENTS OF OTHER SIZE CLASSES , AND GROWS TAKE PAGES FROM IT BEFORE ASKING THE ARENA.
+      Logical pages built on pooled pages are marked as dirty as their memory was used before
 
-                if (!new_buffer)
-                {
-                    return nullptr;
-                }
+    - OTHER THREADS NOTIFY THE SEGMENT WHEN THEY FREE TO ONE OF ITS LOGICAL PAGES THE FIRST TIME AFTER THE LAST RECLAIM , SEE RemoteFreeNotifications.
+      The slow path visits only the notified logical pages instead of all full ones
+     
+    ! IMPORTANT : THE EXTERNAL BUFFER SHOULD BE ALIGNED TO LOGICAL PAGE SIZE. THAT IS CRITICAL FOR REACHING LOGICAL PAGE HEADERS
+*/
 
-                auto first_new_logical_page = grow(new_buffer, new_logical_page_count);
+using PageMapType = PageMap<typename Arena::MetadataAllocator>;
 
-                #ifdef ENABLE_PERF_TRACES
-                fprintf(stderr, "\033[0;31m" "segment grow size=%zu  sizeclass=%u\n" "\033[0m", size, m_params.m_size_class);
-                #endif
+struct SegmentCreationParameters
+{
+    std::size_t m_logical_page_size = 0;
+    std::size_t m_logical_page_count = 0;
+    std::size_t m_page_recycling_threshold = 0;
+    uint32_t m_size_class = 0;
+    double m_grow_coefficient = 2.0; // 0 means that we will be growing by allocating only required amount. Applies to segments that can grow
+    std::size_t m_cache_color_count = 1; // Chunks of consecutive logical pages start up to this many cache lines after the header , 1 disables coloring
+    bool m_can_grow = true;
+    PageMapType* m_page_map = nullptr; // Optional , if specified log2 of logical page size will be registered for every logical page
+    PagePurger* m_page_purger = nullptr; // Optional , if specified recycled logical pages are handed to it instead of being released synchronously
+    LogicalPagePool* m_logical_page_pool = nullptr; // Optional , should have the same logical page size. Recycled logical pages are pooled before being released
+};
 
-                if (first_new_logical_page)
-                {
-                    ret = first_new_logical_page->allocate(size);
+// Logical pages which got chunks freed by other threads , added by any thread and consumed by the owner of the segment or under its lock
+// If it runs out of capacity , the owner is told to search all of its logical pages once
+class RemoteFreeNotifications
+{
+    public:
 
-                    if (ret != nullptr)
-                    {
-                        m_last_used = first_new_logical_page;
-                        return ret;
-                    }
+        static constexpr std::size_t CAPACITY = 8;
+
+        // Segment ids are 16 bits , so pushing threads find the notifications of the owner segment with a plain array look up
+        static void register_notifications(uint16_t segment_id, RemoteFreeNotifications* notifications)
+        {
+            m_registry[segment_id].store(notifications, std::memory_order_release);
+        }
+
+        static void unregister_notifications(uint16_t segment_id, RemoteFreeNotifications* notifications)
+        {
+            m_registry[segment_id].compare_exchange_strong(notifications, nullptr, std::memory_order_acq_rel);
+        }
+
+        static RemoteFreeNotifications* get_notifications(uint16_t segment_id)
+        {
+            return m_registry[segment_id].load(std::memory_order_acquire);
+        }
+
+        // Can be called from any thread
+        void add(LogicalPage* logical_page)
+        {
+            uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+            do
+            {
+                if (tail - m_head.load(std::memory_order_acquire) >= CAPACITY)
+                {
+                    m_overflowed.store(true, std::memory_order_release);
+                    return;
                 }
             }
+            while (!m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed, std::memory_order_relaxed));
 
-            // OUT OF MEMORY !
-            return nullptr;
+            m_slots[tail % CAPACITY].store(reinterpret_cast<uint64_t>(logical_page), std::memory_order_release);
         }
 
-        void calculate_quantities(const std::size_t size, std::size_t& desired_new_logical_page_count, std::size_t& minimum_new_logical_page_count)
+        // Should be called by the owner , passes notified logical pages to the callback
+        // Returns false if some notifications were dropped , in that case all logical pages should be searched
+        template <typename Callback>
+        bool consume(Callback&& callback)
         {
-            minimum_new_logical_page_count = get_required_page_count_for_allocation(m_params.m_logical_page_size, m_logical_page_object_size, m_params.m_size_class, size / m_params.m_size_class);
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            uint64_t tail = m_tail.load(std::memory_order_acquire);
 
-            if ( llmalloc_likely(m_params.m_grow_coefficient > 0))
+            while (head != tail)
             {
-                desired_new_logical_page_count = static_cast<std::size_t>(m_logical_page_count * m_params.m_grow_coefficient);
+                uint64_t value = m_slots[head % CAPACITY].exchange(0, std::memory_order_acquire);
 
-                if (desired_new_logical_page_count < minimum_new_logical_page_count)
+                if (value == 0)
                 {
-                    desired_new_logical_page_count = minimum_new_logical_page_count;
+                    break; // The slot is claimed but not written yet , it will be consumed next time
+                }
+
+                m_head.store(++head, std::memory_order_release);
+
+                if (value != REMOVED)
+                {
+                    callback(reinterpret_cast<LogicalPage*>(value));
                 }
             }
-            else
+
+            return m_overflowed.exchange(false, std::memory_order_acquire) == false;
+        }
+
+        // Should be called by the owner before recycling a logical page , so that its memory is not accessed after it is released
+        // Notifications about it are already visible here as they are written before the chunks are pushed
+        void remove(LogicalPage* logical_page)
+        {
+            for (auto& slot : m_slots)
             {
-                desired_new_logical_page_count = minimum_new_logical_page_count;
+                uint64_t expected = reinterpret_cast<uint64_t>(logical_page);
+                slot.compare_exchange_strong(expected, REMOVED, std::memory_order_relaxed);
             }
         }
 
-        static std::size_t get_required_page_count_for_allocation(std::size_t page_size, std::size_t page_header_size, std::size_t object_size, std::size_t object_count)
+    private:
+
+        static constexpr uint64_t REMOVED = 1;
+
+        std::atomic<uint64_t> m_slots[CAPACITY] = {};
+        std::atomic<uint64_t> m_head = 0;
+        std::atomic<uint64_t> m_tail = 0;
+        std::atomic<bool> m_overflowed = false;
+
+        static inline std::atomic<RemoteFreeNotifications*> m_registry[65536] = {}; // Zero initialised , only the entries of created segments are touched
+};
+
+template <LockPolicy lock_policy>
+class Segment : public Lockable<lock_policy>
+{
+    public:
+    
+        using LogicalPageType = LogicalPage;
+        using ArenaType = Arena;
+
+        Segment()
         {
-            std::size_t object_count_per_page = static_cast<std::size_t>(std::ceil( (page_size - page_header_size) / object_size));
-            std::size_t needed_page_count = static_cast<std::size_t>(std::ceil(static_cast<double>(object_count) / static_cast<double>(object_count_per_page)));
+            m_logical_page_object_size = sizeof(LogicalPageType);
+            llmalloc_assert_msg(m_logical_page_object_size == sizeof(LogicalPageHeader), "Segment: Logical page object size should not exceed logical page header size." );
 
-            if (needed_page_count == 0)
+            m_segment_id_counter++;
+
+            // Central heaps and locals heaps use different specialisation for Segments 
+            // Therefore different types lead to 2 diff static m_segment_id_counter variables.
+            // We need segment ids to be unique across all segments to be able to identify whether a deallocated ptr 
+            // belongs to this thread to avoid pushing it into vm pages used on this thread.
+            // Otherwise we wouldn't be able to give unused vm pages back to the system.
+            if constexpr (lock_policy == LockPolicy::NO_LOCK)
             {
-                needed_page_count = 1;
+                // Local heap segment
+                m_segment_id = m_segment_id_counter;
+            }
+            else
+            {
+                // Central heap segment
+                m_segment_id = m_segment_id_counter + 32768;
             }
+        }
 
-            return needed_page_count;
+        ~Segment()
+        {
+            destroy();
         }
-};
-/*
-    - THE PASSED ALLOCATOR WILL HAVE A CENTRAL HEAP AND ALSO THREAD LOCAL HEAPS.
 
-    - ALLOCATIONS INITIALLY WILL BE FROM LOCAL ( EITHER THREAD LOCAL ) HEAPS. IF LOCAL HEAPS ARE EXHAUSTED , THEN CENTRAL HEAP WILL BE USED.
+        Segment(const Segment& other) = delete;
+        Segment& operator= (const Segment& other) = delete;
+        Segment(Segment&& other) = delete;
+        Segment& operator=(Segment&& other) = delete;
 
-    - USES CONFIGURABLE METADATA ( DEFAULT 256KB ) TO STORE THREAD LOCAL HEAPS. ALSO INITIALLY USES 64KB METADATA TO STORE THE CENTRAL HEAP
-*/
+        [[nodiscard]] bool create(char* external_buffer, ArenaType* arena_ptr, const SegmentCreationParameters& params)
+        {
+            if (params.m_size_class <= 0 || params.m_logical_page_size <= 0 || AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.m_logical_page_size) == false
+                || params.m_logical_page_count <= 0 || params.m_logical_page_size <= m_logical_page_object_size || !external_buffer || !arena_ptr)
+            {
+                return false;
+            }
 
-template <typename CentralHeapType, typename LocalHeapType>
-class ScalableAllocator : public Lockable<LockPolicy::USERSPACE_LOCK>
-{
-public:
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(external_buffer, params.m_logical_page_size) == true, "Segment: Passed buffer is not aligned to specified logical page size. This is a requirement to enable quick access to logical pages from pointers.");
 
-    using ArenaType = Arena;
+            m_params = params;
+            m_arena = arena_ptr;
+            m_carved_chunks_are_zeroed = arena_ptr->are_reused_pages_zeroed();
 
-    // THIS CLASS IS INTENDED TO BE USED DIRECTLY IN MALLOC REPLACEMENTS
-    // SINCE THIS ONE IS A TEMPLATE CLASS , WE HAVE TO ENSURE A SINGLE ONLY STATIC VARIABLE INITIALISATION
-    LLMALLOC_FORCE_INLINE  static ScalableAllocator& get_instance()
-    {
-        static ScalableAllocator instance;
-        return instance;
-    }
+            RemoteFreeNotifications::register_notifications(m_segment_id, &m_remote_free_notifications);
 
-    [[nodiscard]] bool create(const typename CentralHeapType::HeapCreationParams& params_central, const typename LocalHeapType::HeapCreationParams& params_local, const ArenaOptions& arena_options, std::size_t metadata_buffer_size = 262144)
-    {
-        if (arena_options.cache_capacity <= 0 || arena_options.page_alignment <= 0 || metadata_buffer_size <= 0 || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(arena_options.page_alignment) || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(metadata_buffer_size))
+            if (grow(external_buffer, params.m_logical_page_count) == nullptr)
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
+        void* allocate(std::size_t size = 0, bool* is_zeroed = nullptr) // is_zeroed is optional , see LogicalPage::allocate
         {
-            return false;
+            this->enter_concurrent_context(); // Locking only for central heap
+
+            void* ret = allocate_from_available_logical_pages(size, is_zeroed);
+
+            if (llmalloc_unlikely(ret == nullptr))
+            {
+                ret = allocate_from_full_logical_pages(size, is_zeroed);
+            }
+
+            this->leave_concurrent_context();
+
+            return ret;
         }
 
-        if (m_objects_arena.create(arena_options) == false)
+        // Takes the lock once and carves as many chunks as possible from each visited logical page
+        // Returns the number of allocated chunks , can be less than count only if the segment can't grow
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
         {
-            return false;
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            std::size_t allocated = allocate_batch_from_available_logical_pages(size, count, out);
+
+            if (allocated < count && reclaim_notified_remote_frees())
+            {
+                allocated += allocate_batch_from_available_logical_pages(size, count - allocated, out + allocated);
+            }
+
+            while (allocated < count)
+            {
+                void* ptr = allocate_by_growing(size);
+
+                if (ptr == nullptr)
+                {
+                    break;
+                }
+
+                out[allocated++] = ptr;
+                // Growing places new logical pages to the head
+                allocated += allocate_batch_from_available_logical_pages(size, count - allocated, out + allocated);
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return allocated;
         }
 
-        m_metadata_buffer_size = metadata_buffer_size;
-        m_metadata_buffer = reinterpret_cast<char*>(ArenaType::MetadataAllocator::allocate(m_metadata_buffer_size));
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate(void* ptr)
+        {
+            if( m_head == nullptr ) { return;}
+            auto affected = get_logical_page_from_address(ptr, m_params.m_logical_page_size);
+            llmalloc_assert_msg(affected->get_segment_id() == m_segment_id, "Deleted ptr's segment id should match this segment's id");
+            llmalloc_assert_msg(affected->get_usable_size(ptr) == m_params.m_size_class, "Deleted ptr's size class should match this segment's size class");
 
-        if (m_metadata_buffer == nullptr)
+            this->enter_concurrent_context(); // Locking only for central heap
+
+            affected->deallocate(ptr);
+
+            if (llmalloc_unlikely(affected->is_full()))
+            {
+                move_to_available_logical_pages(affected);
+            }
+
+            if (llmalloc_unlikely(affected->get_used_size() == 0))
+            {
+                on_logical_page_emptied(affected);
+            }
+
+            this->leave_concurrent_context();
+        }
+
+        // Returns chunks freed by other threads to their logical pages so that emptied ones can be recycled
+        void reclaim_remote_frees()
         {
-            return false;
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            reclaim_notified_remote_frees();
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
         }
 
-        m_central_heap_buffer = reinterpret_cast<char*>(ArenaType::MetadataAllocator::allocate(65536));
+        // Can be called from any thread , the segment which owns the logical page is notified on the first free after its last reclaim
+        static void deallocate_remotely(LogicalPageType* logical_page, void* first, void* last)
+        {
+            logical_page->deallocate_remotely(first, last, [logical_page]()
+            {
+                auto notifications = RemoteFreeNotifications::get_notifications(logical_page->get_segment_id());
 
-        if(m_central_heap_buffer == nullptr)
+                if (notifications)
+                {
+                    notifications->add(logical_page);
+                }
+            });
+        }
+
+        // Recycles all empty logical pages regardless of the recycling threshold , chunks freed by other threads are reclaimed first
+        void release_empty_logical_pages()
         {
-            return false;
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            LogicalPageType* iter = m_head;
+
+            while (iter)
+            {
+                LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+
+                if (iter->reclaim_remote_frees() && iter->is_full())
+                {
+                    move_to_available_logical_pages(iter);
+                }
+
+                if (iter->get_used_size() == 0)
+                {
+                    iter->mark_as_non_used();
+                    recycle_logical_page(iter);
+                }
+
+                iter = iter_next;
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
         }
 
-        m_central_heap = new(m_central_heap_buffer) CentralHeapType();    // Placement new
+        // Sum of chunk sizes handed out from logical pages , chunks freed by other threads are reclaimed first
+        std::size_t get_used_size()
+        {
+            std::size_t used_size{ 0 };
 
-        if (m_central_heap->create(params_central, &m_objects_arena) == false)
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            LogicalPageType* iter = m_head;
+
+            while (iter)
+            {
+                LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+
+                bool reclaimed = iter->reclaim_remote_frees();
+                used_size += iter->get_used_size();
+
+                if (reclaimed)
+                {
+                    on_remote_frees_reclaimed(iter); // Can recycle the logical page
+                }
+
+                iter = iter_next;
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
+
+            return used_size;
+        }
+
+        // Virtual size is the memory of all logical pages , resident size is the part of it which chunks were carved from so far
+        void get_page_sizes(std::size_t& virtual_size, std::size_t& resident_size)
         {
-            return false;
+            this->enter_concurrent_context(); // Locking only for central heap
+            ///////////////////////////////////////////////////////////////////
+            virtual_size = m_logical_page_count * m_params.m_logical_page_size;
+            resident_size = 0;
+
+            LogicalPageType* iter = m_head;
+
+            while (iter)
+            {
+                resident_size += m_logical_page_object_size + iter->get_carved_size(); // Headers are always touched
+                iter = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+            }
+            ///////////////////////////////////////////////////////////////////
+            this->leave_concurrent_context();
         }
 
-        if (ThreadLocalStorage::get_instance().create(ScalableAllocator::thread_specific_destructor) == false)
+        bool owns_pointer(void* ptr)
         {
-            return false;
+            return get_segment_id_from_address(ptr) == m_segment_id;
         }
 
-        m_local_heap_creation_params = params_local;
+        // Constant time logical page look up method for finding logical pages if their start addresses are aligned to logical page size
+        static LogicalPageType* get_logical_page_from_address(void* ptr, std::size_t logical_page_size)
+        {           
+            uint64_t orig_ptr = reinterpret_cast<uint64_t>(ptr);
+            // Masking below is equivalent of -> orig_ptr - modulo(orig_ptr, logical_page_size);
+            uint64_t target_page_address = orig_ptr & ~(logical_page_size - 1);
+            LogicalPageType* target_logical_page = reinterpret_cast<LogicalPageType*>(target_page_address);
+            return target_logical_page;
+        }
 
-        if (!create_heaps())
+        // Constant time size_class look up method for finding logical pages if their start addresses are aligned to logical page size
+        static uint32_t get_size_class_from_address(void* ptr, std::size_t logical_page_size)
+        {           
+            LogicalPageType* target_logical_page = get_logical_page_from_address(ptr, logical_page_size);
+            return target_logical_page->get_size_class();
+        }
+
+        uint16_t get_segment_id_from_address(void* ptr)
         {
-            return false;
+            LogicalPageType* target_logical_page = get_logical_page_from_address(ptr, m_params.m_logical_page_size);
+            return target_logical_page->get_segment_id();
         }
 
-        m_initialised_successfully.store(true);
+        LLMALLOC_FORCE_INLINE uint16_t get_id() const { return m_segment_id; }
+        
+        LogicalPageType* get_head_logical_page() { return m_head; }
 
-        return true;
-    }
+        #ifdef UNIT_TEST
+        std::size_t get_logical_page_count() const { return m_logical_page_count; }
+        #endif
 
-    void set_thread_local_heap_cache_count(std::size_t count)
-    {
-        m_cached_thread_local_heap_count = count;
-    }
-    
-    void set_enable_fast_shutdown(bool b) { m_fast_shutdown = b; }
-    bool get_enable_fast_shutdown() const { return m_fast_shutdown; }
+        #ifdef ENABLE_STATS
+        // Can be called from any thread
+        std::size_t get_grow_count() const { return m_grow_count.load(std::memory_order_relaxed); }
+        std::size_t get_recycled_logical_page_count() const { return m_recycled_logical_page_count.load(std::memory_order_relaxed); }
+        #endif
+
+    private:
+        SegmentCreationParameters m_params;
+        uint16_t m_segment_id = 0;
+        std::size_t m_logical_page_object_size = 0;
+        std::size_t m_logical_page_count = 0;
+        LogicalPageType* m_head = nullptr;
+        LogicalPageType* m_tail = nullptr;
+        std::size_t m_next_cache_color = 0;
+        bool m_carved_chunks_are_zeroed = true; // Logical pages may be built on pages which the arena discarded rather than unmapped
+        static inline uint16_t m_segment_id_counter = 0; // Not thread safe but segments will always be created from a single thread
+
+        ArenaType* m_arena = nullptr;
+        RemoteFreeNotifications m_remote_free_notifications;
+
+        #ifdef ENABLE_STATS
+        // Written only by the owner thread or under the lock , so they are incremented without atomic read-modify-writes
+        std::atomic<std::size_t> m_grow_count = 0;
+        std::atomic<std::size_t> m_recycled_logical_page_count = 0;
+
+        static void increment_counter(std::atomic<std::size_t>& counter)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        #endif
+
+        // Returns first logical page ptr of the grow , new logical pages are placed to the head as they are the ones with free chunks
+        // Dirty logical pages are the ones built on reused memory
+        [[nodiscard]] LogicalPageType* grow(char* buffer, std::size_t logical_page_count, bool is_dirty = false)
+        {
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(buffer, m_params.m_logical_page_size), "Passed buffer to segment grow should be aligned to the logical page size.");
+            LogicalPageType* first_new_logical_page = nullptr;
+            LogicalPageType* previous_page = nullptr;
+            LogicalPageType* iter_page = nullptr;
+
+            auto create_new_logical_page = [&](char* logical_page_buffer) -> bool
+            {
+                iter_page = new(logical_page_buffer) LogicalPageType();
+
+                std::size_t color_offset = get_next_cache_color_offset();
+                bool success = iter_page->create(logical_page_buffer + m_logical_page_object_size + color_offset, m_params.m_logical_page_size - m_logical_page_object_size - color_offset, m_params.m_size_class);
+
+                if (success == false)
+                {
+                    m_arena->release_to_system(buffer, m_params.m_logical_page_size);
+                    return false;
+                }
+
+                iter_page->mark_as_used();
+                iter_page->set_segment_id(m_segment_id);
+
+                if (is_dirty)
+                {
+                    iter_page->mark_as_dirty();
+                }
+
+                m_logical_page_count++;
+
+                return true;
+            };
+            /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            // FIRST PAGE
+            if (llmalloc_unlikely(create_new_logical_page(buffer) == false))
+            {
+                return nullptr;
+            }
+
+            first_new_logical_page = iter_page;
+            previous_page = iter_page;
+
+            /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+            // REST OF THE PAGES
+            for (std::size_t i = 1; i < logical_page_count; i++)
+            {
+                if (create_new_logical_page(buffer + (i * m_params.m_logical_page_size)) == false)
+                {
+                    return nullptr;
+                }
+
+                previous_page->set_next_logical_page(iter_page);
+                iter_page->set_previous_logical_page(previous_page);
+                previous_page = iter_page;
+            }
+
+            // Chunks of unregistered pages would be classified as large objects when freed , so pages are registered before they are handed out
+            if (m_params.m_page_map && m_params.m_page_map->set(buffer, logical_page_count * m_params.m_logical_page_size, get_logical_page_size_shift()) == false)
+            {
+                m_params.m_page_map->clear(buffer, logical_page_count * m_params.m_logical_page_size);
+                m_arena->release_to_system(buffer, logical_page_count * m_params.m_logical_page_size);
+                m_logical_page_count -= logical_page_count;
+                return nullptr;
+            }
+
+            // Splicing the new logical pages in front of the existing ones
+            if (m_head == nullptr)
+            {
+                m_tail = iter_page;
+            }
+            else
+            {
+                iter_page->set_next_logical_page(m_head);
+                m_head->set_previous_logical_page(iter_page);
+            }
+
+            m_head = first_new_logical_page;
+
+            return first_new_logical_page;
+        }
+
+        // Cycles through colors , a color which would leave no room for a chunk is skipped
+        std::size_t get_next_cache_color_offset()
+        {
+            if (llmalloc_likely(m_params.m_cache_color_count <= 1))
+            {
+                return 0;
+            }
+
+            std::size_t color_offset = (m_next_cache_color++ % m_params.m_cache_color_count) * AlignmentConstants::CPU_CACHE_LINE_SIZE;
+
+            if (m_params.m_logical_page_size - m_logical_page_object_size - color_offset < m_params.m_size_class)
+            {
+                return 0;
+            }
+
+            return color_offset;
+        }
+
+        LLMALLOC_FORCE_INLINE void* allocate_from_logical_page(LogicalPageType* logical_page, std::size_t size, bool* is_zeroed)
+        {
+            void* ret = allocate_chunk(logical_page, size, is_zeroed);
+
+            // A full page may have chunks freed by other threads
+            if (llmalloc_unlikely(ret == nullptr) && logical_page->reclaim_remote_frees())
+            {
+                ret = allocate_chunk(logical_page, size, is_zeroed);
+            }
+
+            return ret;
+        }
+
+        LLMALLOC_FORCE_INLINE void* allocate_chunk(LogicalPageType* logical_page, std::size_t size, bool* is_zeroed)
+        {
+            if (is_zeroed)
+            {
+                void* ret = logical_page->allocate(size, *is_zeroed);
+                *is_zeroed = *is_zeroed && m_carved_chunks_are_zeroed;
+                return ret;
+            }
+
+            return logical_page->allocate(size);
+        }
+
+        // Allocates from the head , every failed attempt moves an exhausted logical page to the tail so the cost is amortised O(1)
+        LLMALLOC_FORCE_INLINE void* allocate_from_available_logical_pages(std::size_t size, bool* is_zeroed)
+        {
+            while (m_head && m_head->is_full() == false)
+            {
+                void* ret = allocate_from_logical_page(m_head, size, is_zeroed);
+
+                if (llmalloc_likely(ret != nullptr))
+                {
+                    return ret;
+                }
+
+                move_to_full_logical_pages(m_head);
+            }
+
+            return nullptr;
+        }
+
+        std::size_t allocate_batch_from_available_logical_pages(std::size_t size, std::size_t count, void** out)
+        {
+            std::size_t allocated{ 0 };
+
+            while (allocated < count && m_head && m_head->is_full() == false)
+            {
+                std::size_t current = m_head->allocate_batch(size, count - allocated, out + allocated);
+
+                // A full page may have chunks freed by other threads
+                if (current < count - allocated && m_head->reclaim_remote_frees())
+                {
+                    current += m_head->allocate_batch(size, count - allocated - current, out + allocated + current);
+                }
+
+                allocated += current;
+
+                if (allocated < count)
+                {
+                    move_to_full_logical_pages(m_head);
+                }
+            }
+
+            return allocated;
+        }
+
+        // Visits only the logical pages which other threads notified about , all of them if some notifications were dropped
+        // Returns true if any of them got free chunks
+        bool reclaim_notified_remote_frees()
+        {
+            bool reclaimed = false;
+
+            auto reclaim = [&](LogicalPageType* logical_page)
+            {
+                if (logical_page->reclaim_remote_frees())
+                {
+                    reclaimed = true;
+                    on_remote_frees_reclaimed(logical_page);
+                }
+            };
+
+            if (llmalloc_unlikely(m_remote_free_notifications.consume(reclaim) == false))
+            {
+                LogicalPageType* iter = m_head;
+
+                while (iter)
+                {
+                    LogicalPageType* iter_next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                    reclaim(iter);
+                    iter = iter_next;
+                }
+            }
+
+            return reclaimed;
+        }
+
+        void on_remote_frees_reclaimed(LogicalPageType* affected)
+        {
+            if (affected->is_full())
+            {
+                move_to_available_logical_pages(affected);
+            }
+
+            if (affected->get_used_size() == 0)
+            {
+                on_logical_page_emptied(affected);
+            }
+        }
+
+        void move_to_full_logical_pages(LogicalPageType* logical_page)
+        {
+            logical_page->mark_as_full();
+
+            if (logical_page != m_tail)
+            {
+                unlink_logical_page(logical_page);
+                link_logical_page_to_tail(logical_page);
+            }
+        }
+
+        void move_to_available_logical_pages(LogicalPageType* logical_page)
+        {
+            logical_page->mark_as_non_full();
+
+            if (logical_page != m_head)
+            {
+                unlink_logical_page(logical_page);
+                link_logical_page_to_head(logical_page);
+            }
+        }
+
+        void on_logical_page_emptied(LogicalPageType* affected)
+        {
+            affected->mark_as_non_used();
+
+            if (m_logical_page_count > m_params.m_page_recycling_threshold)
+            {
+                recycle_logical_page(affected);
+            }
+        }
+
+        void recycle_logical_page(LogicalPageType* affected)
+        {
+            m_remote_free_notifications.remove(affected);
+            remove_logical_page(affected);
+            affected->~LogicalPageType();
+            unregister_logical_page(affected);
+
+            if (m_params.m_logical_page_pool && m_params.m_logical_page_pool->add(affected))
+            {
+                // Segments of any size class can grow into it , the pool releases it if it runs out of capacity
+            }
+            else if (m_params.m_page_purger)
+            {
+                m_params.m_page_purger->add(affected, m_params.m_logical_page_size, m_arena);
+            }
+            else
+            {
+                m_arena->release_to_system(affected, m_params.m_logical_page_size);
+            }
+            #ifdef ENABLE_STATS
+            increment_counter(m_recycled_logical_page_count);
+            #endif
+            #ifdef ENABLE_PERF_TRACES
+            fprintf(stderr, "\033[0;31m" "segment recycling vm page, size=%zu  sizeclass=%u\n" "\033[0m", m_params.m_logical_page_size, m_params.m_size_class);
+            #endif
+        }
+
+        uint8_t get_logical_page_size_shift() const
+        {
+            return static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(m_params.m_logical_page_size)));
+        }
+
+        void unregister_logical_page(LogicalPageType* logical_page)
+        {
+            if (m_params.m_page_map)
+            {
+                m_params.m_page_map->clear(logical_page, m_params.m_logical_page_size);
+            }
+        }
+
+        void remove_logical_page(LogicalPageType* affected)
+        {
+            unlink_logical_page(affected);
+            m_logical_page_count--;
+        }
+
+        void unlink_logical_page(LogicalPageType* affected)
+        {
+            auto next = reinterpret_cast<LogicalPageType*>(affected->get_next_logical_page());
+            auto previous = reinterpret_cast<LogicalPageType*>(affected->get_previous_logical_page());
+
+            if (previous == nullptr)
+            {
+                m_head = next;
+            }
+            else
+            {
+                previous->set_next_logical_page(next);
+            }
+
+            if (next == nullptr)
+            {
+                m_tail = previous;
+            }
+            else
+            {
+                next->set_previous_logical_page(previous);
+            }
+
+            affected->set_next_logical_page(nullptr);
+            affected->set_previous_logical_page(nullptr);
+        }
+
+        void link_logical_page_to_head(LogicalPageType* logical_page)
+        {
+            logical_page->set_previous_logical_page(nullptr);
+            logical_page->set_next_logical_page(m_head);
+
+            if (m_head)
+            {
+                m_head->set_previous_logical_page(logical_page);
+            }
+            else
+            {
+                m_tail = logical_page;
+            }
+
+            m_head = logical_page;
+        }
+
+        void link_logical_page_to_tail(LogicalPageType* logical_page)
+        {
+            logical_page->set_next_logical_page(nullptr);
+            logical_page->set_previous_logical_page(m_tail);
+
+            if (m_tail)
+            {
+                m_tail->set_next_logical_page(logical_page);
+            }
+            else
+            {
+                m_head = logical_page;
+            }
+
+            m_tail = logical_page;
+        }
+
+        void destroy()
+        {
+            RemoteFreeNotifications::unregister_notifications(m_segment_id, &m_remote_free_notifications);
+
+            if (m_head == nullptr)
+            {
+                return;
+            }
+
+            LogicalPageType* iter = m_head;
+            LogicalPageType* next = nullptr;
+
+            while (iter)
+            {
+                next = reinterpret_cast<LogicalPageType*>(iter->get_next_logical_page());
+                
+                if (iter->get_used_size() == 0)
+                {
+                    // Invoking dtor of logical page
+                    iter->~LogicalPageType();
+                    unregister_logical_page(iter);
+                    // Release pages back to system if we are managing the arena
+                    m_arena->release_to_system(iter, m_params.m_logical_page_size);
+                }
+
+                iter = next;
+            }
+
+            m_head = nullptr;
+            m_tail = nullptr;
+        }
+
+        // Slow path removal function
+        void* allocate_from_full_logical_pages(std::size_t size, bool* is_zeroed)
+        {
+            // Full logical pages may have chunks freed by other threads
+            if (reclaim_notified_remote_frees())
+            {
+                void* ret = allocate_from_available_logical_pages(size, is_zeroed);
+
+                if (ret != nullptr)
+                {
+                    return ret;
+                }
+            }
+
+            // If we reached here , it means that we need to allocate more memory
+            return allocate_by_growing(size, is_zeroed);
+        }
+
+        // Slow path removal function
+        void* allocate_by_growing(std::size_t size, bool* is_zeroed = nullptr)
+        {
+            void* ret = nullptr;
+
+            if (m_params.m_can_grow == true)
+            {
+                std::size_t new_logical_page_count = 0;
+                std::size_t minimum_new_logical_page_count = 0;
+                calculate_quantities(size, new_logical_page_count, minimum_new_logical_page_count);
+
+                char* new_buffer = nullptr;
+                bool is_dirty = false;
+
+                // Pages emptied by segments of other size classes are reused before asking the arena , one at a time as they are not contiguous
+                if (m_params.m_logical_page_pool && minimum_new_logical_page_count == 1)
+                {
+                    new_buffer = static_cast<char*>(m_params.m_logical_page_pool->get());
+
+                    if (new_buffer)
+                    {
+                        new_logical_page_count = 1;
+                        is_dirty = true;
+                    }
+                }
+
+                if (new_buffer == nullptr)
+                {
+                    new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
+                }
+
+                if (new_buffer == nullptr && new_logical_page_count > minimum_new_logical_page_count)  // Meeting grow_coefficient is not possible so lower the new_logical_page_count
+                {
+                    new_logical_page_count = minimum_new_logical_page_count;
+                    new_buffer = static_cast<char*>(m_arena->allocate_aligned(m_params.m_logical_page_size * new_logical_page_count, m_params.m_logical_page_size));
+                }
+
+                if (!new_buffer)
+                {
+                    return nullptr;
+                }
+
+                auto first_new_logical_page = grow(new_buffer, new_logical_page_count, is_dirty);
+
+                #ifdef ENABLE_STATS
+                increment_counter(m_grow_count);
+                #endif
+
+                #ifdef ENABLE_PERF_TRACES
+                fprintf(stderr, "\033[0;31m" "segment grow size=%zu  sizeclass=%u\n" "\033[0m", size, m_params.m_size_class);
+                #endif
+
+                if (first_new_logical_page)
+                {
+                    ret = allocate_chunk(first_new_logical_page, size, is_zeroed);
+
+                    if (ret != nullptr)
+                    {
+                        return ret;
+                    }
+                }
+            }
+
+            // OUT OF MEMORY !
+            return nullptr;
+        }
+
+        void calculate_quantities(const std::size_t size, std::size_t& desired_new_logical_page_count, std::size_t& minimum_new_logical_page_count)
+        {
+            minimum_new_logical_page_count = get_required_page_count_for_allocation(m_params.m_logical_page_size, m_logical_page_object_size, m_params.m_size_class, size / m_params.m_size_class);
+
+            if ( llmalloc_likely(m_params.m_grow_coefficient > 0))
+            {
+                desired_new_logical_page_count = static_cast<std::size_t>(m_logical_page_count * m_params.m_grow_coefficient);
+
+                if (desired_new_logical_page_count < minimum_new_logical_page_count)
+                {
+                    desired_new_logical_page_count = minimum_new_logical_page_count;
+                }
+            }
+            else
+            {
+                desired_new_logical_page_count = minimum_new_logical_page_count;
+            }
+        }
+
+        static std::size_t get_required_page_count_for_allocation(std::size_t page_size, std::size_t page_header_size, std::size_t object_size, std::size_t object_count)
+        {
+            std::size_t object_count_per_page = static_cast<std::size_t>(std::ceil( (page_size - page_header_size) / object_size));
+            std::size_t needed_page_count = static_cast<std::size_t>(std::ceil(static_cast<double>(object_count) / static_cast<double>(object_count_per_page)));
+
+            if (needed_page_count == 0)
+            {
+                needed_page_count = 1;
+            }
+
+            return needed_page_count;
+        }
+};
+/*
+    - THE PASSED ALLOCATOR WILL HAVE A CENTRAL HEAP AND ALSO THREAD LOCAL HEAPS.
+
+    - ALLOCATIONS INITIALLY WILL BE FROM LOCAL ( EITHER THREAD LOCAL ) HEAPS. IF LOCAL HEAPS ARE EXHAUSTED , THEN CENTRAL HEAP WILL BE USED.
+
+    - USES CONFIGURABLE METADATA ( DEFAULT 256KB ) TO STORE THREAD LOCAL HEAPS. ALSO INITIALLY USES 64KB METADATA TO STORE THE CENTRAL HEAP
+
+    - TRIMS AND USAGE QUERIES ASK THREAD LOCAL HEAPS OF OTHER THREADS TO TRIM THEMSELVES OR TO PUBLISH THEIR SIZES IN THEIR NEXT ALLOCATIONS ,
+      and their usages are reported as of their last snapshots. Snapshot requests are rate limited
+
+    - WITH ENABLE_EXTERNAL_HEAP_ACCESS , TRIMS AND USAGE QUERIES HANDLE THREAD LOCAL HEAPS OF OTHER THREADS DIRECTLY IF THEIR OWNERS ARE OUTSIDE OF THE ALLOCATOR , ex: blocked threads.
+      Owners mark their calls with plain stores and the querying thread issues a process wide memory barrier , so fast paths don't pay for fences.
+      Owners calling the allocator meanwhile wait until the query or the trim finishes. It is opt-in as every call pays for the marking
+
+    - HEAPS OF EXITED THREADS ARE KEPT AS IDLE HEAPS WITH THEIR LOGICAL PAGES AND HANDED TO NEW THREADS BEFORE CREATING NEW HEAPS.
+      So thread churn neither grows memory nor exhausts the metadata buffer. Idle heaps are trimmed and measured directly as no thread owns them
+
+    - BACKGROUND THREADS OF WRAPPERS , EX: THE PURGING THREAD OF SCALABLE MALLOC , ENCLOSE THEIR WORK WITH enter/leave_background_task.
+      Shutdown sets the shutdown flag so that they stop , and waits for the ones in progress before destroying heaps
+
+    - WITH ENABLE_STATS , HEAPS COUNT THEIR EVENTS PER SIZE CLASS. Counters are only aggregated when get_stats is called , page sizes follow the same snapshot scheme as used sizes
+*/
+
+template <typename CentralHeapType, typename LocalHeapType>
+class ScalableAllocator : public Lockable<LockPolicy::USERSPACE_LOCK>
+{
+public:
+
+    using ArenaType = Arena;
+
+    static constexpr std::size_t DEFAULT_METADATA_BUFFER_SIZE = 262144; // 256KB
+
+    struct Stats
+    {
+        std::array<BinStats, LocalHeapType::BIN_COUNT> bins; // Central and thread local heaps together
+        std::size_t central_heap_fallback_count = 0;        // Allocations served by the central heap as the thread local heap was exhausted or not available
+        std::size_t arena_chunk_build_count = 0;
+    };
+
+    // THIS CLASS IS INTENDED TO BE USED DIRECTLY IN MALLOC REPLACEMENTS
+    // SINCE THIS ONE IS A TEMPLATE CLASS , WE HAVE TO ENSURE A SINGLE ONLY STATIC VARIABLE INITIALISATION
+    LLMALLOC_FORCE_INLINE  static ScalableAllocator& get_instance()
+    {
+        static ScalableAllocator instance;
+        return instance;
+    }
+
+    [[nodiscard]] bool create(const typename CentralHeapType::HeapCreationParams& params_central, const typename LocalHeapType::HeapCreationParams& params_local, const ArenaOptions& arena_options, std::size_t metadata_buffer_size = DEFAULT_METADATA_BUFFER_SIZE)
+    {
+        if (arena_options.cache_capacity <= 0 || arena_options.page_alignment <= 0 || metadata_buffer_size <= 0 || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(arena_options.page_alignment) || !AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(metadata_buffer_size))
+        {
+            return false;
+        }
+
+        if (m_objects_arena.create(arena_options) == false)
+        {
+            return false;
+        }
+
+        m_metadata_buffer_size = metadata_buffer_size;
+        m_metadata_buffer = reinterpret_cast<char*>(ArenaType::MetadataAllocator::allocate(m_metadata_buffer_size));
+
+        if (m_metadata_buffer == nullptr)
+        {
+            return false;
+        }
+
+        m_central_heap_buffer = reinterpret_cast<char*>(ArenaType::MetadataAllocator::allocate(65536));
+
+        if(m_central_heap_buffer == nullptr)
+        {
+            return false;
+        }
+
+        m_central_heap = new(m_central_heap_buffer) CentralHeapType();    // Placement new
+
+        if (m_central_heap->create(params_central, &m_objects_arena) == false)
+        {
+            return false;
+        }
+
+        if (ThreadLocalStorage::get_instance().create(ScalableAllocator::thread_specific_destructor) == false)
+        {
+            return false;
+        }
+
+        m_local_heap_creation_params = params_local;
+
+        if (!create_heaps())
+        {
+            return false;
+        }
+
+        m_initialised_successfully.store(true);
+
+        return true;
+    }
+
+    void set_thread_local_heap_cache_count(std::size_t count)
+    {
+        m_cached_thread_local_heap_count = count;
+    }
+    
+    void set_enable_fast_shutdown(bool b) { m_fast_shutdown = b; }
+    bool get_enable_fast_shutdown() const { return m_fast_shutdown; }
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
     void* allocate(const std::size_t size)
     {
-        void* ret{ nullptr };
-        auto local_heap = get_thread_local_heap();
+        void* ret{ nullptr };
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            ret = local_heap->allocate(size);
+            local_heap->leave_owner_call();
+        }
+
+        if (ret == nullptr)
+        {
+            #ifdef ENABLE_PERF_TRACES
+            m_central_heap_hit_count++;
+            fprintf(stderr, "\033[0;31m" "scalable allocator , central heap hit count=%zu , sizeclass=%zu\n" "\033[0m", m_central_heap_hit_count, size);
+            #endif
+
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, 1);
+            #endif
+
+            //If the local one is exhausted , failover to the central one
+            ret = m_central_heap->allocate(size);
+        }
+
+        return ret;
+    }
+
+    // Same as allocate , also reports whether the returned memory is known to be zeroed so that callers can skip zeroing it
+    [[nodiscard]] void* allocate(const std::size_t size, bool& is_zeroed)
+    {
+        void* ret{ nullptr };
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            ret = local_heap->allocate(size, is_zeroed);
+            local_heap->leave_owner_call();
+        }
+
+        if (ret == nullptr)
+        {
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, 1);
+            #endif
+
+            //If the local one is exhausted , failover to the central one
+            ret = m_central_heap->allocate(size, is_zeroed);
+        }
+
+        return ret;
+    }
+
+    LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+    void deallocate(void* ptr, bool is_small_object = true)
+    {
+        bool returned_to_local_heap = false;
+
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            returned_to_local_heap = local_heap->deallocate(ptr, is_small_object);
+            local_heap->leave_owner_call();
+        }
+
+        if(returned_to_local_heap == false)
+        {
+            m_central_heap->deallocate(ptr, is_small_object);
+        }
+    }
+
+    // Resolves the thread local heap once for all objects , returns the number of allocated objects
+    std::size_t allocate_batch(const std::size_t size, std::size_t count, void** out)
+    {
+        std::size_t allocated{ 0 };
+        auto local_heap = get_thread_local_heap();
+
+        if (local_heap != nullptr)
+        {
+            local_heap->enter_owner_call();
+            allocated = local_heap->allocate_batch(size, count, out);
+            local_heap->leave_owner_call();
+        }
+
+        if (allocated < count)
+        {
+            #ifdef ENABLE_STATS
+            count_central_heap_fallbacks(local_heap, count - allocated);
+            #endif
+
+            //If the local one is exhausted , failover to the central one
+            allocated += m_central_heap->allocate_batch(size, count - allocated, out + allocated);
+        }
+
+        return allocated;
+    }
+
+    void deallocate_batch(void** ptrs, std::size_t count, bool is_small_object = true)
+    {
+        std::size_t deallocated{ 0 };
+        auto local_heap = get_thread_local_heap();
+
+        while (deallocated < count)
+        {
+            if (local_heap != nullptr)
+            {
+                local_heap->enter_owner_call();
+                deallocated += local_heap->deallocate_batch(ptrs + deallocated, count - deallocated, is_small_object);
+                local_heap->leave_owner_call();
+            }
+
+            if (deallocated < count)
+            {
+                // Rejected by the local heap , only that one goes to the central heap and the rest is tried locally again
+                m_central_heap->deallocate(ptrs[deallocated], is_small_object);
+                deallocated++;
+            }
+        }
+    }
+
+    // Returns memory of empty logical pages to the arena , see the notes at the top for thread local heaps of other threads
+    void trim()
+    {
+        auto own_heap = m_thread_local_heap;
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        flush_deallocation_queues(own_heap);
+
+        for_each_local_heap([this, own_heap](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->trim();
+            }
+            else
+            {
+                local_heap->request_trim();
+            }
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
+        m_central_heap->trim();
+    }
+
+    // Used size includes chunks waiting in deallocation queues. Pooled size is the size of emptied logical pages kept by heaps
+    void get_heap_usage(std::size_t& used_size, std::size_t& pooled_size)
+    {
+        auto own_heap = m_thread_local_heap;
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        flush_deallocation_queues(own_heap);
+
+        used_size = m_central_heap->get_used_size();
+        pooled_size = m_central_heap->get_pooled_size();
+        bool can_request_snapshots = can_request_snapshots_now();
+
+        for_each_local_heap([this, own_heap, can_request_snapshots, &used_size, &pooled_size](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                used_size += local_heap->get_used_size();
+            }
+            else
+            {
+                used_size += local_heap->get_published_used_size();
+
+                if (can_request_snapshots)
+                {
+                    local_heap->request_used_size_snapshot();
+                }
+            }
+
+            pooled_size += local_heap->get_pooled_size();
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+    }
+
+    // Counters are zero without ENABLE_STATS , see the notes at the top for page sizes of thread local heaps of other threads
+    void get_stats(Stats& stats)
+    {
+        stats = Stats();
+
+        if (m_initialised_successfully.load() == false)
+        {
+            return;
+        }
+
+        auto own_heap = m_thread_local_heap;
+
+        m_central_heap->publish_page_sizes();
+
+        for (std::size_t i = 0; i < CentralHeapType::BIN_COUNT; i++)
+        {
+            m_central_heap->add_bin_stats(i, stats.bins[i]);
+        }
+
+        stats.central_heap_fallback_count = m_central_heap->get_central_heap_fallback_count();
+
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        acquire_local_heaps(own_heap);
+        bool can_request_snapshots = can_request_snapshots_now();
+
+        for_each_local_heap([this, own_heap, can_request_snapshots, &stats](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->publish_page_sizes();
+            }
+            else if (can_request_snapshots)
+            {
+                local_heap->request_page_sizes_snapshot();
+            }
+
+            for (std::size_t i = 0; i < LocalHeapType::BIN_COUNT; i++)
+            {
+                local_heap->add_bin_stats(i, stats.bins[i]);
+            }
+
+            stats.central_heap_fallback_count += local_heap->get_central_heap_fallback_count();
+        });
+
+        release_local_heaps();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
+        #ifdef ENABLE_STATS
+        stats.arena_chunk_build_count = m_objects_arena.get_built_chunk_count();
+        #endif
+    }
+
+    // Returns false after shutdown started , the task should not run and the thread should exit
+    bool enter_background_task()
+    {
+        m_background_task_count.fetch_add(1);
+
+        if (m_shutdown_started.load() == true)
+        {
+            m_background_task_count.fetch_sub(1);
+            return false;
+        }
+
+        return true;
+    }
+
+    void leave_background_task()
+    {
+        m_background_task_count.fetch_sub(1);
+    }
+
+    CentralHeapType* get_central_heap() { return m_central_heap; }
+    ArenaType* get_arena() { return &m_objects_arena; }
+
+    #ifdef UNIT_TEST
+    std::size_t get_observed_unique_thread_count() const { return m_observed_unique_thread_count; }
+    std::size_t get_max_thread_local_heap_count() const { return m_max_thread_local_heap_count; }
+    std::size_t get_active_local_heap_count() const { return m_active_local_heap_count; }
+    std::size_t get_idle_local_heap_count() const { return m_idle_local_heap_count; }
+    #endif
+
+private:
+    char* m_central_heap_buffer = nullptr;
+    CentralHeapType* m_central_heap = nullptr;
+    ArenaType m_objects_arena;
+    char* m_metadata_buffer = nullptr;
+    std::size_t m_metadata_buffer_size = DEFAULT_METADATA_BUFFER_SIZE;
+    std::size_t m_active_local_heap_count = 0;        // Heaps handed to threads so far , including idle ones
+    std::size_t m_max_thread_local_heap_count = 0;    // Used for only thread local heaps
+    std::size_t m_cached_thread_local_heap_count = 0; // Used for only thread local heaps , its number of available passive heaps
+    LocalHeapType** m_idle_local_heaps = nullptr;     // Heaps of exited threads , used as a LIFO so that the most recently used pages are reused first
+    std::size_t m_idle_local_heap_count = 0;
+    std::size_t m_idle_local_heaps_buffer_size = 0;
+    bool m_fast_shutdown = true;
+    typename LocalHeapType::HeapCreationParams m_local_heap_creation_params;
+
+    static inline std::atomic<bool> m_initialised_successfully = false;
+    static inline std::atomic<bool> m_shutdown_started = false;
+    std::atomic<std::size_t> m_background_task_count = 0;
+    uint64_t m_last_snapshot_request_time = 0; // Accessed only in the concurrent context
+    static constexpr uint64_t SNAPSHOT_REQUEST_INTERVAL = 100; // Milliseconds
+    static inline LLMALLOC_THREAD_LOCAL LocalHeapType* m_thread_local_heap = nullptr;
+
+    #ifdef UNIT_TEST
+    std::size_t m_observed_unique_thread_count = 0;
+    #endif
+
+    #ifdef ENABLE_PERF_TRACES
+    std::size_t m_central_heap_hit_count = 0;
+    #endif
+
+    ScalableAllocator()
+    {
+    }
+
+    ~ScalableAllocator()
+    {
+        // Stops background threads also in fast shutdowns , no need to move logical pages between heaps either
+        m_shutdown_started.store(true);
+
+        if(m_fast_shutdown)
+        {
+            return;
+        }
+
+        if(m_initialised_successfully.load() == true )
+        {
+            // Background tasks which entered before the flag was set may still be touching heap memory
+            while (m_background_task_count.load() > 0)
+            {
+                ThreadUtilities::yield();
+            }
+
+            destroy_heaps();
+
+            ThreadLocalStorage::get_instance().destroy();
+        }
+    }
+
+    ScalableAllocator(const ScalableAllocator& other) = delete;
+    ScalableAllocator& operator= (const ScalableAllocator& other) = delete;
+    ScalableAllocator(ScalableAllocator&& other) = delete;
+    ScalableAllocator& operator=(ScalableAllocator&& other) = delete;
+    
+    static void thread_specific_destructor(void* arg)
+    {
+        // Same as the pthread key/FLS value which is cleared before this callback, further allocations of this thread will get a heap again
+        m_thread_local_heap = nullptr;
+
+        if( m_initialised_successfully.load() == true && m_shutdown_started.load() == false )
+        {
+            // The heap keeps its logical pages and its deallocation queues , the next thread starts with warm pages
+            get_instance().add_idle_local_heap(reinterpret_cast<LocalHeapType*>(arg));
+        }
+    }
+
+    // Should be called in the concurrent context. With ENABLE_EXTERNAL_HEAP_ACCESS , owners of other threads' heaps which are outside of the allocator can't enter
+    // until release_local_heaps , so those heaps become accessible. A single process wide barrier covers all heaps
+    void acquire_local_heaps(LocalHeapType* own_heap)
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        bool has_other_heaps = false;
+
+        for_each_local_heap([this, own_heap, &has_other_heaps](LocalHeapType* local_heap)
+        {
+            if (local_heap != own_heap && is_idle_local_heap(local_heap) == false)
+            {
+                local_heap->begin_external_access();
+                has_other_heaps = true;
+            }
+        });
+
+        if (has_other_heaps == false)
+        {
+            return;
+        }
+
+        bool barrier_issued = ThreadUtilities::issue_process_wide_memory_barrier();
+
+        for_each_local_heap([barrier_issued](LocalHeapType* local_heap)
+        {
+            if (local_heap->is_externally_accessed() && (barrier_issued == false || local_heap->is_owner_in_call()))
+            {
+                local_heap->end_external_access(); // Its owner is inside the allocator , it can only serve requests
+            }
+        });
+        #else
+        LLMALLOC_UNUSED(own_heap);
+        #endif
+    }
+
+    // Should be called in the concurrent context
+    void release_local_heaps()
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        for_each_local_heap([](LocalHeapType* local_heap)
+        {
+            if (local_heap->is_externally_accessed())
+            {
+                local_heap->end_external_access();
+            }
+        });
+        #endif
+    }
+
+    // Should be called in the concurrent context after acquire_local_heaps
+    bool is_accessible_local_heap(LocalHeapType* local_heap, LocalHeapType* own_heap) const
+    {
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        if (local_heap->is_externally_accessed())
+        {
+            return true;
+        }
+        #endif
+
+        return local_heap == own_heap || is_idle_local_heap(local_heap);
+    }
+
+    // Should be called in the concurrent context. Snapshot requests make owners walk all their segments , so they are rate limited
+    bool can_request_snapshots_now()
+    {
+        uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+
+        if (m_last_snapshot_request_time != 0 && now - m_last_snapshot_request_time < SNAPSHOT_REQUEST_INTERVAL)
+        {
+            return false;
+        }
+
+        m_last_snapshot_request_time = now;
+        return true;
+    }
+
+    // Should be called in the concurrent context after acquire_local_heaps.
+    // Flushing can free chunks remotely to logical pages of other heaps , so queues of all accessible heaps are flushed before any of them is measured or trimmed
+    void flush_deallocation_queues(LocalHeapType* own_heap)
+    {
+        m_central_heap->flush_deallocation_queues();
+
+        for_each_local_heap([this, own_heap](LocalHeapType* local_heap)
+        {
+            if (is_accessible_local_heap(local_heap, own_heap))
+            {
+                local_heap->flush_deallocation_queues();
+            }
+        });
+    }
+
+    void add_idle_local_heap(LocalHeapType* local_heap)
+    {
+        this->enter_concurrent_context();
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        m_idle_local_heaps[m_idle_local_heap_count++] = local_heap;
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+    }
+
+    // Should be called in the concurrent context
+    bool is_idle_local_heap(LocalHeapType* local_heap) const
+    {
+        for (std::size_t i = 0; i < m_idle_local_heap_count; i++)
+        {
+            if (m_idle_local_heaps[i] == local_heap)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::size_t get_created_heap_count()
+    {
+        auto heap_count = m_cached_thread_local_heap_count > m_active_local_heap_count ? m_cached_thread_local_heap_count : m_active_local_heap_count;
+        return heap_count;
+    }
+
+    #ifdef ENABLE_STATS
+    // Counted per heap so that thread local heaps are the only writers of their counters , get_stats adds them up
+    void count_central_heap_fallbacks(LocalHeapType* local_heap, std::size_t count)
+    {
+        if (local_heap != nullptr)
+        {
+            local_heap->count_central_heap_fallbacks(count);
+        }
+        else
+        {
+            m_central_heap->count_central_heap_fallbacks(count);
+        }
+    }
+    #endif
+
+    // Should be called in the concurrent context
+    template <typename Function>
+    void for_each_local_heap(Function function)
+    {
+        auto heap_count = get_created_heap_count();
+
+        for (std::size_t i = 0; i < heap_count; i++)
+        {
+            function(reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (i * sizeof(LocalHeapType))));
+        }
+    }
+
+    void destroy_heaps()
+    {
+        if (m_metadata_buffer)
+        {
+            auto heap_count = get_created_heap_count();
+
+            for (std::size_t i = 0; i < heap_count; i++)
+            {
+                LocalHeapType* local_heap = reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (i * sizeof(LocalHeapType)));
+                local_heap->~LocalHeapType();
+            }
+
+            ArenaType::MetadataAllocator::deallocate(m_metadata_buffer, m_metadata_buffer_size);
+        }
+
+        if(m_central_heap_buffer)
+        {
+            ArenaType::MetadataAllocator::deallocate(m_central_heap_buffer, 65536);
+        }
+
+        if (m_idle_local_heaps)
+        {
+            ArenaType::MetadataAllocator::deallocate(m_idle_local_heaps, m_idle_local_heaps_buffer_size);
+        }
+    }
+
+    LocalHeapType* get_thread_local_heap()
+    {
+        return get_thread_local_heap_internal();
+    }
+
+    LLMALLOC_FORCE_INLINE LocalHeapType* get_thread_local_heap_internal()
+    {
+        // Fast path : a single TLS load , ThreadLocalStorage is used only to get thread exit callbacks
+        auto thread_local_heap = m_thread_local_heap;
+
+        if (llmalloc_likely(thread_local_heap != nullptr))
+        {
+            return thread_local_heap;
+        }
+
+        return get_thread_local_heap_by_assigning();
+    }
+
+    // Slow path removal function
+    LocalHeapType* get_thread_local_heap_by_assigning()
+    {
+        LocalHeapType* thread_local_heap = nullptr;
+
+        // LOCKING HERE WILL HAPPEN ONLY ONCE FOR EACH THREAD , AT THEIR START
+        // AS THERE ARE SHARED VARIABLES FOR THREAD-LOCAL HEAP CREATION
+        this->enter_concurrent_context();
+
+        #ifdef UNIT_TEST
+        m_observed_unique_thread_count++;
+        #endif
+
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        if (m_idle_local_heap_count > 0)
+        {
+            thread_local_heap = m_idle_local_heaps[--m_idle_local_heap_count];
+        }
+        else
+        {
+            if (m_active_local_heap_count + 1 >= m_max_thread_local_heap_count)
+            {
+                // If we are here , it means that metadata buffer size is not sufficient to handle all running threads of the application
+                this->leave_concurrent_context();
+                return nullptr;
+            }
+
+            if (m_active_local_heap_count >= m_cached_thread_local_heap_count)
+            {
+                thread_local_heap = create_local_heap(m_active_local_heap_count);
+            }
+            else
+            {
+                thread_local_heap = reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (m_active_local_heap_count * sizeof(LocalHeapType)));
+            }
+
+            m_active_local_heap_count++;
+        }
+
+        ThreadLocalStorage::get_instance().set(thread_local_heap); // Needed for the thread exit callback
+        m_thread_local_heap = thread_local_heap;
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        this->leave_concurrent_context();
+
+        return thread_local_heap;
+    }
+
+    bool create_heaps()
+    {
+        m_max_thread_local_heap_count = m_metadata_buffer_size / sizeof(LocalHeapType);
+
+        if (m_max_thread_local_heap_count == 0)
+        {
+            return false;
+        }
+
+        if (m_max_thread_local_heap_count < m_cached_thread_local_heap_count)
+        {
+            m_cached_thread_local_heap_count = m_max_thread_local_heap_count;
+        }
+
+        m_idle_local_heaps_buffer_size = AlignmentAndSizeUtils::get_next_pow2_multiple_of(m_max_thread_local_heap_count * sizeof(LocalHeapType*), VirtualMemory::PAGE_ALLOCATION_GRANULARITY);
+        m_idle_local_heaps = reinterpret_cast<LocalHeapType**>(ArenaType::MetadataAllocator::allocate(m_idle_local_heaps_buffer_size));
+
+        if (m_idle_local_heaps == nullptr)
+        {
+            return false;
+        }
+
+        for (std::size_t i{ 0 }; i < m_cached_thread_local_heap_count; i++)
+        {
+            auto local_heap = create_local_heap(i);
+            if (!local_heap) return false;
+        }
+
+        return true;
+    }
+
+    LocalHeapType* create_local_heap(std::size_t metadata_buffer_index)
+    {
+        LocalHeapType* local_heap = new(m_metadata_buffer + (metadata_buffer_index * sizeof(LocalHeapType))) LocalHeapType();    // Placement new
+
+        if (local_heap->create(m_local_heap_creation_params, &m_objects_arena) == false)
+        {       
+            #ifdef ENABLE_PERF_TRACES
+            fprintf(stderr, "\033[0;31m" "scalable allocator , failed to create thread local heap\n" "\033[0m");
+            #endif
+            
+            return nullptr;
+        }
+
+        return local_heap;
+    }
+};
+/*
+    - SIZE CLASS POLICIES FOR HEAPS. THEY MAP REQUESTED SIZES TO BIN INDEXES AND BIN INDEXES TO SIZE CLASSES IN CONSTANT TIME
+
+    - Pow2SizeClasses : 16 32 64 ... 262144 , the fastest mapping but up to 50% internal fragmentation ( ex: 2049 bytes -> 4096 bytes )
+
+    - QuarterPow2SizeClasses : 16 32 48 64 and then 4 classes per pow2 , each a quarter of the pow2 apart ( jemalloc/mimalloc style ) :
+      80 96 112 128 , 160 192 224 256 , ... , 163840 196608 229376 262144. Internal fragmentation drops to 20% in the worst case.
+      Sizes up to 1024 are mapped with a lookup table and the rest with a clz
+
+    - CREATION PARAMETERS OF HEAPS ( PAGE COUNTS , QUEUE SIZES ) ARE PER POW2 SIZE CLASS GROUP SO THAT BOTH POLICIES SHARE THE SAME OPTIONS.
+      A GROUP HOLDS THE BINS WHOSE SIZE CLASSES ROUND UP TO THE SAME POW2 AND THEY SHARE THE GROUP'S PARAMETERS EVENLY.
+      Remainders go to the first bins of a group so that shares sum up to the group's value. Every bin gets at least 1 though ,
+      as segments need a logical page and queues need a slot , so a group value smaller than its bin count is rounded up to the bin count
+*/
+
+class CompileTimePow2Utils
+{
+    public :
+
+        template <std::size_t N>
+        static constexpr std::size_t compile_time_pow2()
+        {
+            static_assert(N>=0); // To ensure that it is called in compile time only
+            return 1 << N;
+        }
+
+        template<unsigned int n>
+        static constexpr unsigned int compile_time_log2()
+        {
+            return (n <= 1) ? 0 : 1 + compile_time_log2<n / 2>();
+        }
+};
+
+class Pow2SizeClasses
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = 15; // Small : 16 32 64 128 256 512 1024 2048 4096 8192 16384 32768 , Medium: 65536 131072 262144
+        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 12;
+        static constexpr std::size_t GROUP_COUNT = BIN_COUNT;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<BIN_COUNT + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<MIN_MEDIUM_OBJECT_BIN_INDEX + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+
+        static constexpr std::size_t MIN_SIZE_CLASS = 16;
+        static constexpr inline std::size_t LOG2_MIN_SIZE_CLASS = CompileTimePow2Utils::compile_time_log2<MIN_SIZE_CLASS>();
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index(std::size_t size)
+        {
+            size = size < MIN_SIZE_CLASS ? MIN_SIZE_CLASS : size;
+            return get_bin_index_from_size_class(get_first_pow2_of(size));
+        }
+
+        // IMPLEMENTATION IS FOR 64 BIT ONLY
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index_from_size_class(std::size_t size_class)
+        {
+            std::size_t index = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size_class))) - LOG2_MIN_SIZE_CLASS;
+            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
+            return index;
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_size_class(std::size_t bin_index)
+        {
+            return MIN_SIZE_CLASS << bin_index;
+        }
+
+        static constexpr std::size_t get_group_index(std::size_t bin_index)
+        {
+            return bin_index;
+        }
+
+        static constexpr std::size_t get_group_bin_count(std::size_t group_index)
+        {
+            LLMALLOC_UNUSED(group_index);
+            return 1;
+        }
+
+        static constexpr std::size_t get_index_in_group(std::size_t bin_index)
+        {
+            LLMALLOC_UNUSED(bin_index);
+            return 0;
+        }
+
+    private:
+
+        // Reference : https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
+        LLMALLOC_FORCE_INLINE static std::size_t get_first_pow2_of(std::size_t input)
+        {
+            /*
+            No need for the if check below , as the caller will pass a miniumum of MIN_SIZE_CLASS which is > 1
+            if (llmalloc_unlikely(input <= 1))
+            {
+                return 1;
+            }
+            */
+
+            input--;
+            input |= input >> 1;
+            input |= input >> 2;
+            input |= input >> 4;
+            input |= input >> 8;
+            input |= input >> 16;
+
+            return input + 1;
+        }
+};
+
+// Compile time table builders for QuarterPow2SizeClasses
+class QuarterPow2SizeClassUtils
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = 52;
+        static constexpr std::size_t LINEAR_BIN_COUNT = 4;                   // 16 32 48 64
+        static constexpr std::size_t LOG2_FIRST_QUARTER_STEPPED_POW2 = 6;    // Quarter steps start after 64
+        static constexpr std::size_t LOOKUP_TABLE_MAX_SIZE = 1024;
+        static constexpr std::size_t LOOKUP_TABLE_SIZE = (LOOKUP_TABLE_MAX_SIZE >> 4) + 1;
+
+        static constexpr std::size_t compute_bin_index(std::size_t size)
+        {
+            if (size <= 64)
+            {
+                return size <= 16 ? 0 : (size + 15) / 16 - 1;
+            }
+
+            std::size_t log2 = 0;
+            while ((static_cast<std::size_t>(1) << (log2 + 1)) < size)
+            {
+                log2++;
+            }
+
+            return LINEAR_BIN_COUNT + ((log2 - LOG2_FIRST_QUARTER_STEPPED_POW2) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+        }
+
+        static constexpr std::array<uint32_t, BIN_COUNT> build_size_classes()
+        {
+            std::array<uint32_t, BIN_COUNT> size_classes{};
+
+            for (std::size_t i = 0; i < LINEAR_BIN_COUNT; i++)
+            {
+                size_classes[i] = static_cast<uint32_t>((i + 1) * 16);
+            }
+
+            for (std::size_t i = LINEAR_BIN_COUNT; i < BIN_COUNT; i++)
+            {
+                std::size_t log2 = LOG2_FIRST_QUARTER_STEPPED_POW2 + (i - LINEAR_BIN_COUNT) / 4;
+                std::size_t step = static_cast<std::size_t>(1) << (log2 - 2);
+                size_classes[i] = static_cast<uint32_t>((static_cast<std::size_t>(1) << log2) + ((i - LINEAR_BIN_COUNT) % 4 + 1) * step);
+            }
+
+            return size_classes;
+        }
+
+        // Index is size/16 rounded up
+        static constexpr std::array<uint8_t, LOOKUP_TABLE_SIZE> build_lookup_table()
+        {
+            std::array<uint8_t, LOOKUP_TABLE_SIZE> table{};
+
+            for (std::size_t i = 0; i < LOOKUP_TABLE_SIZE; i++)
+            {
+                table[i] = static_cast<uint8_t>(compute_bin_index(i << 4));
+            }
+
+            return table;
+        }
+};
+
+class QuarterPow2SizeClasses
+{
+    public:
+
+        static constexpr std::size_t BIN_COUNT = QuarterPow2SizeClassUtils::BIN_COUNT; // Small : 16 32 48 64 80 96 112 128 160 ... 32768 , Medium: 40960 ... 262144
+        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 40;
+        static constexpr std::size_t GROUP_COUNT = Pow2SizeClasses::GROUP_COUNT;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = Pow2SizeClasses::LARGEST_SIZE_CLASS;
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = Pow2SizeClasses::LARGEST_SMALL_OBJECT_SIZE_CLASS;
+
+        static constexpr std::size_t MIN_SIZE_CLASS = 16;
+
+        static constexpr inline std::array<uint32_t, BIN_COUNT> SIZE_CLASSES = QuarterPow2SizeClassUtils::build_size_classes();
+        static constexpr inline std::array<uint8_t, QuarterPow2SizeClassUtils::LOOKUP_TABLE_SIZE> LOOKUP_TABLE = QuarterPow2SizeClassUtils::build_lookup_table();
 
-        if (local_heap != nullptr)
+        // IMPLEMENTATION IS FOR 64 BIT ONLY
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index(std::size_t size)
         {
-            ret = local_heap->allocate(size);
+            if (size <= QuarterPow2SizeClassUtils::LOOKUP_TABLE_MAX_SIZE)
+            {
+                return LOOKUP_TABLE[(size + 15) >> 4];
+            }
+
+            // 2^log2 < size <= 2^(log2+1) , then find which quarter of that range the size is in
+            std::size_t log2 = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size - 1)));
+            std::size_t index = QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT + ((log2 - QuarterPow2SizeClassUtils::LOG2_FIRST_QUARTER_STEPPED_POW2) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
+            return index;
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_bin_index_from_size_class(std::size_t size_class)
+        {
+            return get_bin_index(size_class);
+        }
+
+        LLMALLOC_FORCE_INLINE static std::size_t get_size_class(std::size_t bin_index)
+        {
+            return SIZE_CLASSES[bin_index];
+        }
+
+        // Group index is log2 of the size class rounded up to pow2 , starting from 16
+        static constexpr std::size_t get_group_index(std::size_t bin_index)
+        {
+            if (bin_index < QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT)
+            {
+                return bin_index < 2 ? bin_index : 2;
+            }
+
+            return 3 + (bin_index - QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT) / 4;
+        }
+
+        static constexpr std::size_t get_group_bin_count(std::size_t group_index)
+        {
+            return group_index < 2 ? 1 : (group_index == 2 ? 2 : 4);
+        }
+
+        static constexpr std::size_t get_index_in_group(std::size_t bin_index)
+        {
+            if (bin_index < QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT)
+            {
+                return bin_index < 2 ? 0 : bin_index - 2;
+            }
+
+            return (bin_index - QuarterPow2SizeClassUtils::LINEAR_BIN_COUNT) % 4;
+        }
+};
+
+// Template defaults are for thread local or single threaded cases
+// Size classes are pow2 by default , see size_classes.h and HeapQuarterPow2 below for finer grained size classes
+template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK, typename SizeClasses = Pow2SizeClasses> 
+class HeapPow2
+{
+    public:
+
+        HeapPow2() {}
+        ~HeapPow2() {}
+        HeapPow2(const HeapPow2& other) = delete;
+        HeapPow2& operator= (const HeapPow2& other) = delete;
+        HeapPow2(HeapPow2&& other) = delete;
+        HeapPow2& operator=(HeapPow2&& other) = delete;
+
+        using SizeClassesType = SizeClasses;
+
+        static constexpr std::size_t BIN_COUNT = SizeClasses::BIN_COUNT;
+        static constexpr std::size_t SIZE_CLASS_GROUP_COUNT = SizeClasses::GROUP_COUNT; // Creation params are per pow2 size class group
+        static constexpr std::size_t MAX_BIN_INDEX = SizeClasses::MAX_BIN_INDEX;
+        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = SizeClasses::MIN_MEDIUM_OBJECT_BIN_INDEX;
+        static constexpr inline std::size_t LARGEST_SIZE_CLASS = SizeClasses::LARGEST_SIZE_CLASS;
+        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = SizeClasses::LARGEST_SMALL_OBJECT_SIZE_CLASS;
+
+        static constexpr std::size_t MIN_SIZE_CLASS = SizeClasses::MIN_SIZE_CLASS;
+
+        using ArenaType = Arena;
+        using SegmentType = Segment<segment_lock_policy>;
+
+        struct HeapCreationParams
+        {
+            // SIZES AND CAPACITIES
+            std::size_t small_object_logical_page_size = 65536; // 64 KB
+            std::size_t medium_object_logical_page_size = 524288; // 512 KB
+            std::size_t logical_page_counts[SIZE_CLASS_GROUP_COUNT] = { 1,1,1,1,1, 1,1,2,4,8, 16,32,8,16,32 };
+            // RECYCLING AND GROWING
+            std::size_t page_recycling_threshold_per_size_class = 1024;
+            bool segments_can_grow = true;
+            double segment_grow_coefficient = 2.0;
+            std::size_t cache_color_count = 1; // See Segment , 1 disables cache coloring
+            std::size_t logical_page_pool_capacity = 16; // Emptied small object logical pages are kept for bins of any size class up to this count , 0 disables pooling
+            // DEALLOCATION QUEUES
+            std::size_t deallocation_queues_processing_threshold = 1024;
+            std::size_t recyclable_deallocation_queue_sizes[SIZE_CLASS_GROUP_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
+            std::size_t non_recyclable_deallocation_queue_sizes[SIZE_CLASS_GROUP_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
+            bool use_remote_free_lists = false; // If true, pointers of other heaps go back to their logical pages instead of non recyclable deallocation queues
+            // OTHERS
+            PageMapType* page_map = nullptr; // Optional, segments will register their logical pages to it
+            PagePurger* page_purger = nullptr; // Optional, segments will hand recycled logical pages to it
+        };
+
+        [[nodiscard]] bool create(const HeapCreationParams& params, ArenaType* arena)
+        {
+            //////////////////////////////////////////////////////////////////////////////////////////////
+            // 1. CHECKS
+            llmalloc_assert_msg(arena, "Heap must receive a valid arena instance.");
+
+            // Logical page sizes should be multiples of page allocation granularity ( 4KB on Linux ,64 KB on Windows )
+            if (!AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.small_object_logical_page_size))
+            {
+                return false;
+            }
+            
+            if (!AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.medium_object_logical_page_size))
+            {
+                return false;
+            }
+
+            m_small_object_logical_page_size = params.small_object_logical_page_size;
+            m_medium_object_logical_page_size = params.medium_object_logical_page_size;
+
+            if (m_small_object_logical_page_pool.create(m_small_object_logical_page_size, params.logical_page_pool_capacity, arena, params.page_purger) == false)
+            {
+                return false;
+            }
+
+            //////////////////////////////////////////////////////////////////////////////////////////////
+            // 2. CALCULATE REQUIRED BUFFER SIZE
+            std::size_t small_objects_required_buffer_size{ 0 };
+            std::size_t medium_objects_required_buffer_size{ 0 };
+
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                if(i<MIN_MEDIUM_OBJECT_BIN_INDEX)
+                {
+                    small_objects_required_buffer_size += (get_bin_share(params.logical_page_counts, i) * m_small_object_logical_page_size);
+                }
+                else
+                {
+                    medium_objects_required_buffer_size += (get_bin_share(params.logical_page_counts, i) * m_medium_object_logical_page_size);
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////////////////////////
+            // 3. ALLOCATE BUFFERS
+            auto small_objects_buffer_address = reinterpret_cast<uint64_t>(arena->allocate(small_objects_required_buffer_size));
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(small_objects_buffer_address)), "HeapPow2: Arena failed to pass an address which is aligned to OS page allocation granularity.");
+
+            char* medium_objects_buffer_address = reinterpret_cast<char*>(arena->allocate_aligned(medium_objects_required_buffer_size, m_medium_object_logical_page_size));
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(medium_objects_buffer_address)), "HeapPow2: Arena failed to pass an address which is aligned to OS page allocation granularity.");
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(reinterpret_cast<void*>(medium_objects_buffer_address), m_medium_object_logical_page_size), "HeapPow2: Failed to get an address which is aligned to medium objects page size.");
+
+            //////////////////////////////////////////////////////////////////////////////////////////////
+            // 4. DISTRIBUTE BUFFER TO BINS ,  NEED TO PLACE LOGICAL PAGE HEADERS TO START OF PAGES !
+
+            std::size_t buffer_index{ 0 };
+
+            SegmentCreationParameters segment_params;
+            segment_params.m_page_recycling_threshold = params.page_recycling_threshold_per_size_class;
+            segment_params.m_can_grow = params.segments_can_grow;
+            segment_params.m_grow_coefficient = params.segment_grow_coefficient;
+            segment_params.m_cache_color_count = params.cache_color_count;
+            segment_params.m_page_map = params.page_map;
+            segment_params.m_page_purger = params.page_purger;
+
+            for (std::size_t i = 0; i < MIN_MEDIUM_OBJECT_BIN_INDEX; i++)
+            {
+                auto required_logical_page_count = get_bin_share(params.logical_page_counts, i);
+                segment_params.m_size_class = static_cast<uint32_t>(SizeClasses::get_size_class(i));
+                segment_params.m_logical_page_count = required_logical_page_count;
+
+                segment_params.m_logical_page_size = m_small_object_logical_page_size;
+                segment_params.m_logical_page_pool = &m_small_object_logical_page_pool;
+                auto bin_buffer_size = required_logical_page_count * m_small_object_logical_page_size;
+
+                bool success = m_segments[i].create(reinterpret_cast<char*>(small_objects_buffer_address) + buffer_index, arena, segment_params);
+
+                if (!success)
+                {
+                    return false;
+                }
+
+                buffer_index += bin_buffer_size;
+            }
+
+            buffer_index = 0;
+
+            for (std::size_t i = MIN_MEDIUM_OBJECT_BIN_INDEX; i < BIN_COUNT; i++)
+            {
+                auto required_logical_page_count = get_bin_share(params.logical_page_counts, i);
+                segment_params.m_size_class = static_cast<uint32_t>(SizeClasses::get_size_class(i));
+                segment_params.m_logical_page_count = required_logical_page_count;
+
+                segment_params.m_logical_page_size = m_medium_object_logical_page_size;
+                segment_params.m_logical_page_pool = nullptr; // Medium object bins have few pages , their recycling threshold applies as it is
+                auto bin_buffer_size = required_logical_page_count * m_medium_object_logical_page_size;
+
+                bool success = m_segments[i].create(medium_objects_buffer_address + buffer_index, arena, segment_params);
+
+                if (!success)
+                {
+                    return false;
+                }
+
+                buffer_index += bin_buffer_size;
+            }
+            //////////////////////////////////////////////////////////////////////////////////////////////
+            // 5. DEALLOCATION QUEUES
+            m_configured_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            m_deallocation_queue_processing_threshold.store(m_configured_deallocation_queue_processing_threshold, std::memory_order_relaxed);
+            m_use_remote_free_lists = params.use_remote_free_lists;
+
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                if( params.non_recyclable_deallocation_queue_sizes[SizeClasses::get_group_index(i)] > 0 )
+                {
+                    if (m_non_recyclable_deallocation_queues[i].create(get_bin_share(params.non_recyclable_deallocation_queue_sizes, i)) == false)
+                    {
+                        return false;
+                    }
+                }
+
+                if (m_recyclable_deallocation_queues[i].create(get_bin_share(params.recyclable_deallocation_queue_sizes, i)) == false)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Creation params are per pow2 size class group , see size_classes.h for how bins of a group share them
+        static std::size_t get_bin_share(const std::size_t* group_values, std::size_t bin_index)
+        {
+            auto group_value = group_values[SizeClasses::get_group_index(bin_index)];
+            auto group_bin_count = SizeClasses::get_group_bin_count(SizeClasses::get_group_index(bin_index));
+            auto share = group_value / group_bin_count + (SizeClasses::get_index_in_group(bin_index) < group_value % group_bin_count ? 1 : 0);
+            return share > 0 ? share : 1;
+        }
+
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
+        void* allocate(std::size_t size = 0)
+        {
+            auto bin_index = SizeClasses::get_bin_index(size);
+            void* ret = allocate_from_bin(bin_index, SizeClasses::get_size_class(bin_index), nullptr);
+
+            #ifdef ENABLE_STATS
+            // Failed ones are counted by the heap which serves them
+            if (ret != nullptr)
+            {
+                increment_counter(m_bin_counters[bin_index].allocation_count);
+            }
+            #endif
+
+            return ret;
+        }
+
+        // Same as allocate , also reports whether the returned chunk is known to be zeroed. Only never used chunks of logical pages are
+        [[nodiscard]] void* allocate(std::size_t size, bool& is_zeroed)
+        {
+            is_zeroed = false;
+
+            auto bin_index = SizeClasses::get_bin_index(size);
+            void* ret = allocate_from_bin(bin_index, SizeClasses::get_size_class(bin_index), &is_zeroed);
+
+            #ifdef ENABLE_STATS
+            if (ret != nullptr)
+            {
+                increment_counter(m_bin_counters[bin_index].allocation_count);
+            }
+            #endif
+
+            return ret;
+        }
+
+        // Slow path removal function
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void* allocate_by_processing_deallocation_queues(std::size_t bin_index, std::size_t size)
+        {
+            #ifdef ENABLE_PERF_TRACES
+            fprintf(stderr, "\033[0;31m" "Heap processing deallocation queue in allocation callstack\n" "\033[0m");
+            #endif
+
+            m_potential_pending_max_deallocation_count = 0;
+
+            if (llmalloc_unlikely(m_pending_requests.load(std::memory_order_relaxed) != 0))
+            {
+                serve_pending_requests();
+            }
+
+            if (m_use_remote_free_lists)
+            {
+                m_segments[bin_index].reclaim_remote_frees();
+            }
+
+            auto ret = process_recyclable_deallocation_queue(bin_index);
+
+            if(ret != nullptr)
+            {
+                return ret;
+            }
+
+            uint64_t pointer{ 0 };
+
+            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                return reinterpret_cast<void*>(pointer);
+            }
+
+            return m_segments[bin_index].allocate(size);
+        }
+
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        bool deallocate(void* ptr, bool is_small_object)
+        {
+            auto logical_page_size = is_small_object ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
+            auto target_logical_page = SegmentType::get_logical_page_from_address(ptr, logical_page_size);
+
+            auto size_class = target_logical_page->get_size_class();
+
+            llmalloc_assert_msg(size_class >= MIN_SIZE_CLASS, "HeapPow2 deallocate : Found size class is invalid. The pointer may not have been allocated by this allocator.");
+            
+            auto bin_index = SizeClasses::get_bin_index_from_size_class(size_class);
+
+            if (m_segments[bin_index].get_id() == target_logical_page->get_segment_id())
+            {
+                #ifdef ENABLE_STATS
+                return on_deallocation(bin_index, m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr)), m_bin_counters[bin_index].deallocation_count);
+                #else
+                return m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                #endif
+            }
+            else if (m_use_remote_free_lists)
+            {
+                // Owner heap will reclaim it in its allocation slow path , so that the logical page can be recycled
+                SegmentType::deallocate_remotely(target_logical_page, ptr, ptr);
+
+                #ifdef ENABLE_STATS
+                increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                #endif
+
+                return true;
+            }
+            else
+            {
+                #ifdef ENABLE_STATS
+                return on_deallocation(bin_index, m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr)), m_bin_counters[bin_index].cross_thread_deallocation_count);
+                #else
+                return m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                #endif
+            }
         }
 
-        if (ret == nullptr)
+        // Resolves the bin once , then drains the deallocation queues and carves the rest from the segment
+        // Returns the number of allocated objects , can be less than count only if the heap is exhausted
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
         {
-            #ifdef ENABLE_PERF_TRACES
-            m_central_heap_hit_count++;
-            fprintf(stderr, "\033[0;31m" "scalable allocator , central heap hit count=%zu , sizeclass=%zu\n" "\033[0m", m_central_heap_hit_count, size);
-            #endif
+            auto bin_index = SizeClasses::get_bin_index(size);
+            size = SizeClasses::get_size_class(bin_index);
 
-            //If the local one is exhausted , failover to the central one
-            ret = m_central_heap->allocate(size);
-        }
+            std::size_t allocated{ 0 };
 
-        return ret;
-    }
+            m_potential_pending_max_deallocation_count += count;
 
-    LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-    void deallocate(void* ptr, bool is_small_object = true)
-    {
-        bool returned_to_local_heap = false;
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold.load(std::memory_order_relaxed)))
+            {
+                void* ptr = allocate_by_processing_deallocation_queues(bin_index, size);
 
-        auto local_heap = get_thread_local_heap();
+                if (ptr == nullptr)
+                {
+                    return 0;
+                }
 
-        if (local_heap != nullptr)
-        {
-            returned_to_local_heap = local_heap->deallocate(ptr, is_small_object);
+                out[allocated++] = ptr;
+            }
+
+            allocated += QueueUtilities::pop_batch(m_non_recyclable_deallocation_queues[bin_index], count - allocated, out + allocated);
+            allocated += QueueUtilities::pop_batch(m_recyclable_deallocation_queues[bin_index], count - allocated, out + allocated);
+
+            if (allocated < count)
+            {
+                allocated += m_segments[bin_index].allocate_batch(size, count - allocated, out + allocated);
+            }
+
+            #ifdef ENABLE_STATS
+            increment_counter(m_bin_counters[bin_index].allocation_count, allocated);
+            #endif
+
+            return allocated;
         }
 
-        if(returned_to_local_heap == false)
+        // Consecutive pointers of the same logical page are handled after a single page header access
+        // Returns the number of leading pointers this heap accepted , the caller should pass the first rejected one elsewhere
+        std::size_t deallocate_batch(void** ptrs, std::size_t count, bool is_small_object)
         {
-            m_central_heap->deallocate(ptr, is_small_object);
-        }
-    }
+            auto logical_page_size = is_small_object ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
 
-    CentralHeapType* get_central_heap() { return m_central_heap; }
+            LogicalPage* current_logical_page = nullptr;
+            std::size_t bin_index{ 0 };
+            bool is_owned = false;
+            void* remote_chain_head = nullptr; // Remote frees of the current page are linked and pushed with a single CAS
+            void* remote_chain_tail = nullptr;
 
-    #ifdef UNIT_TEST
-    std::size_t get_observed_unique_thread_count() const { return m_observed_unique_thread_count; }
-    std::size_t get_max_thread_local_heap_count() const { return m_max_thread_local_heap_count; }
-    #endif
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto target_logical_page = SegmentType::get_logical_page_from_address(ptrs[i], logical_page_size);
 
-private:
-    char* m_central_heap_buffer = nullptr;
-    CentralHeapType* m_central_heap = nullptr;
-    ArenaType m_objects_arena;
-    char* m_metadata_buffer = nullptr;
-    std::size_t m_metadata_buffer_size = 262144;       // Default 256KB
-    std::size_t m_active_local_heap_count = 0;
-    std::size_t m_max_thread_local_heap_count = 0;    // Used for only thread local heaps
-    std::size_t m_cached_thread_local_heap_count = 0; // Used for only thread local heaps , its number of available passive heaps
-    bool m_fast_shutdown = true;
-    typename LocalHeapType::HeapCreationParams m_local_heap_creation_params;
+                if (target_logical_page != current_logical_page)
+                {
+                    if (remote_chain_head)
+                    {
+                        SegmentType::deallocate_remotely(current_logical_page, remote_chain_head, remote_chain_tail);
+                        remote_chain_head = nullptr;
+                    }
 
-    static inline std::atomic<bool> m_initialised_successfully = false;
-    static inline std::atomic<bool> m_shutdown_started = false;
+                    current_logical_page = target_logical_page;
+                    auto size_class = target_logical_page->get_size_class();
 
-    #ifdef UNIT_TEST
-    std::size_t m_observed_unique_thread_count = 0;
-    #endif
+                    llmalloc_assert_msg(size_class >= MIN_SIZE_CLASS, "HeapPow2 deallocate_batch : Found size class is invalid. The pointer may not have been allocated by this allocator.");
 
-    #ifdef ENABLE_PERF_TRACES
-    std::size_t m_central_heap_hit_count = 0;
-    #endif
+                    bin_index = SizeClasses::get_bin_index_from_size_class(size_class);
+                    is_owned = m_segments[bin_index].get_id() == target_logical_page->get_segment_id();
+                }
 
-    ScalableAllocator()
-    {
-    }
+                if (is_owned)
+                {
+                    if (llmalloc_unlikely(m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                    {
+                        #ifdef ENABLE_STATS
+                        increment_counter(m_bin_counters[bin_index].queue_overflow_count);
+                        #endif
+                        return i;
+                    }
 
-    ~ScalableAllocator()
-    {
-        if(m_fast_shutdown)
-        {
-            return;
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].deallocation_count);
+                    #endif
+                }
+                else if (m_use_remote_free_lists)
+                {
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                    #endif
+
+                    if (remote_chain_head == nullptr)
+                    {
+                        remote_chain_head = ptrs[i];
+                    }
+                    else
+                    {
+                        reinterpret_cast<LogicalPage::NodeType*>(remote_chain_tail)->m_next = reinterpret_cast<LogicalPage::NodeType*>(ptrs[i]);
+                    }
+
+                    remote_chain_tail = ptrs[i];
+                }
+                else
+                {
+                    if (llmalloc_unlikely(m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                    {
+                        #ifdef ENABLE_STATS
+                        increment_counter(m_bin_counters[bin_index].queue_overflow_count);
+                        #endif
+                        return i;
+                    }
+
+                    #ifdef ENABLE_STATS
+                    increment_counter(m_bin_counters[bin_index].cross_thread_deallocation_count);
+                    #endif
+                }
+            }
+
+            if (remote_chain_head)
+            {
+                SegmentType::deallocate_remotely(current_logical_page, remote_chain_head, remote_chain_tail);
+            }
+
+            return count;
         }
 
-        if(m_initialised_successfully.load() == true )
+        // Returns memory of empty logical pages to the arena
+        // Thread local heaps should be trimmed by their owners or by other threads during external access , otherwise other threads can use request_trim
+        void trim()
         {
-            // We call it here it in case not called earlier and there are still running threads which are not destructed , no need to move logical pages between heaps
-            m_shutdown_started.store(true);
-
-            destroy_heaps();
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                flush_deallocation_queues(i);
+                m_segments[i].release_empty_logical_pages();
+            }
 
-            ThreadLocalStorage::get_instance().destroy();
+            m_small_object_logical_page_pool.release_all();
         }
-    }
 
-    ScalableAllocator(const ScalableAllocator& other) = delete;
-    ScalableAllocator& operator= (const ScalableAllocator& other) = delete;
-    ScalableAllocator(ScalableAllocator&& other) = delete;
-    ScalableAllocator& operator=(ScalableAllocator&& other) = delete;
-    
-    static void thread_specific_destructor(void* arg)
-    {
-        if(get_instance().get_enable_fast_shutdown() == false)
+        // Chunks in deallocation queues are flushed first so that they are not counted as used
+        // Thread local heaps should be measured by their owners or by other threads during external access , otherwise other threads can use request_used_size_snapshot
+        std::size_t get_used_size()
         {
-            if( m_initialised_successfully.load() == true && m_shutdown_started.load() == false )
+            std::size_t used_size{ 0 };
+
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
             {
-                auto central_heap = get_instance().get_central_heap();
-                auto segment_count = CentralHeapType::get_segment_count();
+                flush_deallocation_queues(i);
+                used_size += m_segments[i].get_used_size();
+            }
 
-                auto thread_local_heap = reinterpret_cast<LocalHeapType*>(arg);
+            return used_size;
+        }
 
-                for(std::size_t i =0; i<segment_count; i++)
-                {
-                    central_heap->get_segment(i)->transfer_logical_pages_from( thread_local_heap->get_segment(i)->get_head_logical_page() );
-                }
+        // Thread local heaps should be flushed by their owners or by other threads during external access
+        void flush_deallocation_queues()
+        {
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                flush_deallocation_queues(i);
             }
         }
-    }
 
-    std::size_t get_created_heap_count()
-    {
-        auto heap_count = m_cached_thread_local_heap_count > m_active_local_heap_count ? m_cached_thread_local_heap_count : m_active_local_heap_count;
-        return heap_count;
-    }
+        // Can be called from any thread
+        std::size_t get_pooled_size() const
+        {
+            return m_small_object_logical_page_pool.get_page_count() * m_small_object_logical_page_size;
+        }
 
-    void destroy_heaps()
-    {
-        if (m_metadata_buffer)
+        // Owners of thread local heaps enclose their calls with these. With ENABLE_EXTERNAL_HEAP_ACCESS , other threads can access the heap while the owner is outside of it.
+        // Plain stores and only a compiler barrier here , other threads pay for the process wide barrier instead. Without it they are no-ops
+        LLMALLOC_FORCE_INLINE void enter_owner_call()
         {
-            auto heap_count = get_created_heap_count();
+            #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+            m_owner_in_call.store(true, std::memory_order_relaxed);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
 
-            for (std::size_t i = 0; i < heap_count; i++)
+            if (llmalloc_unlikely(m_external_access.load(std::memory_order_acquire)))
             {
-                LocalHeapType* local_heap = reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (i * sizeof(LocalHeapType)));
-                local_heap->~LocalHeapType();
+                wait_for_external_access();
             }
-
-            ArenaType::MetadataAllocator::deallocate(m_metadata_buffer, m_metadata_buffer_size);
+            #endif
         }
 
-        if(m_central_heap_buffer)
+        LLMALLOC_FORCE_INLINE void leave_owner_call()
         {
-            ArenaType::MetadataAllocator::deallocate(m_central_heap_buffer, 65536);
+            #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+            m_owner_in_call.store(false, std::memory_order_release);
+            #endif
         }
-    }
 
-    LocalHeapType* get_thread_local_heap()
-    {
-        return get_thread_local_heap_internal();
-    }
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        // Should be followed by ThreadUtilities::issue_process_wide_memory_barrier. Then if is_owner_in_call returns false ,
+        // the heap can be accessed as the owner can't enter until end_external_access. Otherwise external access should be ended right away
+        void begin_external_access() { m_external_access.store(true); }
+        bool is_owner_in_call() const { return m_owner_in_call.load(std::memory_order_acquire); }
+        bool is_externally_accessed() const { return m_external_access.load(std::memory_order_relaxed); }
+        void end_external_access() { m_external_access.store(false, std::memory_order_release); }
+        #endif
 
-    LLMALLOC_FORCE_INLINE LocalHeapType* get_thread_local_heap_internal()
-    {
-        auto thread_local_heap = reinterpret_cast<LocalHeapType*>(ThreadLocalStorage::get_instance().get());
+        // Can be called from any thread. Requests are served by the owner in its next allocation , which they route to the slow path
+        void request_trim() { add_request(REQUEST_TRIM); }
+        void request_used_size_snapshot() { add_request(REQUEST_USED_SIZE_SNAPSHOT); }
 
-        if (thread_local_heap == nullptr)
+        // Used size published by the owner when it served the last snapshot request
+        std::size_t get_published_used_size() const { return m_published_used_size.load(std::memory_order_relaxed); }
+
+        // Thread local heaps should publish their page sizes by themselves , other threads can use request_page_sizes_snapshot
+        void publish_page_sizes()
         {
-            // LOCKING HERE WILL HAPPEN ONLY ONCE FOR EACH THREAD , AT THEIR START
-            // AS THERE ARE SHARED VARIABLES FOR THREAD-LOCAL HEAP CREATION
-            this->enter_concurrent_context();
+            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            {
+                std::size_t virtual_size{ 0 };
+                std::size_t resident_size{ 0 };
 
-            #ifdef UNIT_TEST
-            m_observed_unique_thread_count++;
-            #endif
+                m_segments[i].get_page_sizes(virtual_size, resident_size);
 
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-            if (m_active_local_heap_count + 1 >= m_max_thread_local_heap_count)
-            {
-                // If we are here , it means that metadata buffer size is not sufficient to handle all threads of the application
-                this->leave_concurrent_context();
-                return nullptr;
+                m_published_page_sizes[i].virtual_size.store(virtual_size, std::memory_order_relaxed);
+                m_published_page_sizes[i].resident_size.store(resident_size, std::memory_order_relaxed);
             }
+        }
 
-            if (m_active_local_heap_count >= m_cached_thread_local_heap_count)
-            {
-                thread_local_heap = create_local_heap(m_active_local_heap_count);
-            }
-            else
-            {
-                thread_local_heap = reinterpret_cast<LocalHeapType*>(m_metadata_buffer + (m_active_local_heap_count * sizeof(LocalHeapType)));
-            }
+        void request_page_sizes_snapshot() { add_request(REQUEST_PAGE_SIZES_SNAPSHOT); }
 
-            m_active_local_heap_count++;
-            ThreadLocalStorage::get_instance().set(thread_local_heap);
-            ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-            this->leave_concurrent_context();
+        // Can be called from any thread , adds counters and last published page sizes of the bin to the passed stats
+        void add_bin_stats(std::size_t bin_index, BinStats& stats) const
+        {
+            #ifdef ENABLE_STATS
+            stats.allocation_count += m_bin_counters[bin_index].allocation_count.load(std::memory_order_relaxed);
+            stats.deallocation_count += m_bin_counters[bin_index].deallocation_count.load(std::memory_order_relaxed);
+            stats.cross_thread_deallocation_count += m_bin_counters[bin_index].cross_thread_deallocation_count.load(std::memory_order_relaxed);
+            stats.queue_overflow_count += m_bin_counters[bin_index].queue_overflow_count.load(std::memory_order_relaxed);
+            stats.segment_grow_count += m_segments[bin_index].get_grow_count();
+            stats.recycled_logical_page_count += m_segments[bin_index].get_recycled_logical_page_count();
+            #endif
+            stats.resident_size += m_published_page_sizes[bin_index].resident_size.load(std::memory_order_relaxed);
+            stats.virtual_size += m_published_page_sizes[bin_index].virtual_size.load(std::memory_order_relaxed);
         }
 
-        return thread_local_heap;
-    }
+        // ScalableAllocator counts allocations it passes to the central heap on the thread local heap , or on the central heap for threads without one
+        void count_central_heap_fallbacks(std::size_t count)
+        {
+            #ifdef ENABLE_STATS
+            increment_counter(m_central_heap_fallback_count, count);
+            #else
+            LLMALLOC_UNUSED(count);
+            #endif
+        }
 
-    bool create_heaps()
-    {
-        m_max_thread_local_heap_count = m_metadata_buffer_size / sizeof(LocalHeapType);
+        // Can be called from any thread , zero without ENABLE_STATS
+        std::size_t get_central_heap_fallback_count() const
+        {
+            #ifdef ENABLE_STATS
+            return m_central_heap_fallback_count.load(std::memory_order_relaxed);
+            #else
+            return 0;
+            #endif
+        }
 
-        if (m_max_thread_local_heap_count == 0)
+        SegmentType* get_segment(std::size_t bin_index)
         {
-            return false;
+            return &(m_segments[bin_index]);
         }
 
-        if (m_max_thread_local_heap_count < m_cached_thread_local_heap_count)
+        static std::size_t get_segment_count()
         {
-            m_cached_thread_local_heap_count = m_max_thread_local_heap_count;
+            return BIN_COUNT;
         }
 
-        for (std::size_t i{ 0 }; i < m_cached_thread_local_heap_count; i++)
+        static std::size_t get_max_allocation_size()
         {
-            auto local_heap = create_local_heap(i);
-            if (!local_heap) return false;
+            return LARGEST_SIZE_CLASS;
         }
 
-        return true;
-    }
+        static std::size_t get_max_small_object_size()
+        {
+            return LARGEST_SMALL_OBJECT_SIZE_CLASS;
+        }
 
-    LocalHeapType* create_local_heap(std::size_t metadata_buffer_index)
-    {
-        LocalHeapType* local_heap = new(m_metadata_buffer + (metadata_buffer_index * sizeof(LocalHeapType))) LocalHeapType();    // Placement new
+        #ifdef UNIT_TEST
+        std::size_t get_bin_logical_page_count(std::size_t bin_index)
+        {
+            return m_segments[bin_index].get_logical_page_count();
+        }
 
-        if (local_heap->create(m_local_heap_creation_params, &m_objects_arena) == false)
-        {       
-            #ifdef ENABLE_PERF_TRACES
-            fprintf(stderr, "\033[0;31m" "scalable allocator , failed to create thread local heap\n" "\033[0m");
-            #endif
-            
-            return nullptr;
+        std::size_t get_pooled_logical_page_count() const
+        {
+            return m_small_object_logical_page_pool.get_page_count();
         }
+        #endif
 
-        return local_heap;
-    }
-};
+    private:
+
+        std::size_t m_small_object_logical_page_size = 0;
+        std::size_t m_medium_object_logical_page_size = 0;
+        LogicalPagePool m_small_object_logical_page_pool;
+        std::array<SegmentType, BIN_COUNT> m_segments;
+
+        std::size_t m_potential_pending_max_deallocation_count = 0; // Not thread safe but doesn't need to be
+        std::atomic<std::size_t> m_deallocation_queue_processing_threshold = 0; // Other threads lower it to 0 to route the owner to the slow path , relaxed loads are plain loads
+        std::size_t m_configured_deallocation_queue_processing_threshold = 0;
+        std::atomic<uint32_t> m_pending_requests = 0;
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        std::atomic<bool> m_owner_in_call = false;
+        std::atomic<bool> m_external_access = false;
+        #endif
+        std::atomic<std::size_t> m_published_used_size = 0;
+        bool m_use_remote_free_lists = false;
+        std::array<DeallocationQueueType, BIN_COUNT> m_recyclable_deallocation_queues;
+        std::array<DeallocationQueueType, BIN_COUNT> m_non_recyclable_deallocation_queues;
+
+        struct PublishedPageSizes
+        {
+            std::atomic<std::size_t> resident_size = 0;
+            std::atomic<std::size_t> virtual_size = 0;
+        };
+
+        std::array<PublishedPageSizes, BIN_COUNT> m_published_page_sizes;
+
+        #ifdef ENABLE_STATS
+        struct BinCounters
+        {
+            std::atomic<std::size_t> allocation_count = 0;
+            std::atomic<std::size_t> deallocation_count = 0;
+            std::atomic<std::size_t> cross_thread_deallocation_count = 0;
+            std::atomic<std::size_t> queue_overflow_count = 0;
+        };
+
+        std::array<BinCounters, BIN_COUNT> m_bin_counters;
+        std::atomic<std::size_t> m_central_heap_fallback_count = 0;
+
+        // Thread local heaps are the only writers of their counters , so they are incremented with plain loads and stores. Central heap ones have concurrent writers
+        static void increment_counter(std::atomic<std::size_t>& counter, std::size_t value = 1)
+        {
+            if constexpr (segment_lock_policy == LockPolicy::NO_LOCK)
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+            else
+            {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }
+        }
+
+        bool on_deallocation(std::size_t bin_index, bool pushed, std::atomic<std::size_t>& counter)
+        {
+            increment_counter(pushed ? counter : m_bin_counters[bin_index].queue_overflow_count);
+            return pushed;
+        }
+        #endif
 
-class CompileTimePow2Utils
-{
-    public :
+        static constexpr uint32_t REQUEST_TRIM = 0x0001;
+        static constexpr uint32_t REQUEST_USED_SIZE_SNAPSHOT = 0x0002;
+        static constexpr uint32_t REQUEST_PAGE_SIZES_SNAPSHOT = 0x0004;
 
-        template <std::size_t N>
-        static constexpr std::size_t compile_time_pow2()
+        void add_request(uint32_t request)
         {
-            static_assert(N>=0); // To ensure that it is called in compile time only
-            return 1 << N;
+            m_pending_requests.fetch_or(request);
+            m_deallocation_queue_processing_threshold.store(0);
         }
 
-        template<unsigned int n>
-        static constexpr unsigned int compile_time_log2()
+        // Chunks in the recyclable queue go back to their logical pages and chunks of other heaps in the non recyclable one
+        // are freed remotely to their logical pages , so that their owners can recycle them
+        void flush_deallocation_queues(std::size_t bin_index)
         {
-            return (n <= 1) ? 0 : 1 + compile_time_log2<n / 2>();
+            auto logical_page_size = bin_index < MIN_MEDIUM_OBJECT_BIN_INDEX ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
+            uint64_t pointer{ 0 };
+
+            while (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                m_segments[bin_index].deallocate(reinterpret_cast<void*>(pointer));
+            }
+
+            while (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                SegmentType::deallocate_remotely(SegmentType::get_logical_page_from_address(reinterpret_cast<void*>(pointer), logical_page_size), reinterpret_cast<void*>(pointer), reinterpret_cast<void*>(pointer));
+            }
         }
-};
 
-// Template defaults are for thread local or single threaded cases
-template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK> 
-class HeapPow2
-{
-    public:
+        LLMALLOC_FORCE_INLINE void* allocate_from_bin(std::size_t bin_index, std::size_t size, bool* is_zeroed)
+        {
+            m_potential_pending_max_deallocation_count++;
 
-        HeapPow2() {}
-        ~HeapPow2() {}
-        HeapPow2(const HeapPow2& other) = delete;
-        HeapPow2& operator= (const HeapPow2& other) = delete;
-        HeapPow2(HeapPow2&& other) = delete;
-        HeapPow2& operator=(HeapPow2&& other) = delete;
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold.load(std::memory_order_relaxed)))
+            {
+                return allocate_by_processing_deallocation_queues(bin_index, size);
+            }
 
-        static constexpr std::size_t BIN_COUNT = 15; // Small : 16 32 64 128 256 512 1024 2048 4096 8192 16384 32768 , Medium: 65536 131072 262144
-        static constexpr std::size_t MAX_BIN_INDEX = BIN_COUNT - 1;
-        static constexpr std::size_t MIN_MEDIUM_OBJECT_BIN_INDEX = 12;
-        static constexpr inline std::size_t LARGEST_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<BIN_COUNT + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
-        static constexpr inline std::size_t LARGEST_SMALL_OBJECT_SIZE_CLASS = CompileTimePow2Utils::compile_time_pow2<MIN_MEDIUM_OBJECT_BIN_INDEX + 3>(); // +3 since we skip bin2 bin4 and bin8 as the size classes start from 16
+            uint64_t pointer{ 0 };
 
-        static constexpr std::size_t MIN_SIZE_CLASS = 16;
-        static constexpr inline std::size_t LOG2_MIN_SIZE_CLASS = CompileTimePow2Utils::compile_time_log2<MIN_SIZE_CLASS>();
+            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                return reinterpret_cast<void*>(pointer);
+            }
 
-        using ArenaType = Arena;
-        using SegmentType = Segment<segment_lock_policy>;
+            if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            {
+                return reinterpret_cast<void*>(pointer);
+            }
 
-        struct HeapCreationParams
+            return m_segments[bin_index].allocate(size, is_zeroed);
+        }
+
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        // Slow path removal function
+        void wait_for_external_access()
         {
-            // SIZES AND CAPACITIES
-            std::size_t small_object_logical_page_size = 65536; // 64 KB
-            std::size_t medium_object_logical_page_size = 524288; // 512 KB
-            std::size_t logical_page_counts[BIN_COUNT] = { 1,1,1,1,1, 1,1,2,4,8, 16,32,8,16,32 };
-            // RECYCLING AND GROWING
-            std::size_t page_recycling_threshold_per_size_class = 1024;
-            bool segments_can_grow = true;
-            double segment_grow_coefficient = 2.0;
-            // DEALLOCATION QUEUES
-            std::size_t deallocation_queues_processing_threshold = 1024;
-            std::size_t recyclable_deallocation_queue_sizes[BIN_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
-            std::size_t non_recyclable_deallocation_queue_sizes[BIN_COUNT] = { 65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536 };
-        };
+            do
+            {
+                m_owner_in_call.store(false, std::memory_order_release);
 
-        [[nodiscard]] bool create(const HeapCreationParams& params, ArenaType* arena)
+                while (m_external_access.load(std::memory_order_acquire))
+                {
+                    ThreadUtilities::yield();
+                }
+
+                m_owner_in_call.store(true, std::memory_order_relaxed);
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            }
+            while (m_external_access.load(std::memory_order_acquire));
+        }
+        #endif
+
+        // Slow path removal function
+        void serve_pending_requests()
         {
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            // 1. CHECKS
-            llmalloc_assert_msg(arena, "Heap must receive a valid arena instance.");
+            // Restoring the threshold before taking the requests , so that a request added in between lowers it again
+            m_deallocation_queue_processing_threshold.store(m_configured_deallocation_queue_processing_threshold);
+            auto requests = m_pending_requests.exchange(0);
 
-            // Logical page sizes should be multiples of page allocation granularity ( 4KB on Linux ,64 KB on Windows )
-            if (!AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.small_object_logical_page_size))
+            if (requests & REQUEST_TRIM)
             {
-                return false;
+                trim();
             }
-            
-            if (!AlignmentAndSizeUtils::is_size_a_multiple_of_page_allocation_granularity(params.medium_object_logical_page_size))
+
+            if (requests & REQUEST_USED_SIZE_SNAPSHOT)
             {
-                return false;
+                m_published_used_size.store(get_used_size(), std::memory_order_relaxed);
             }
 
-            m_small_object_logical_page_size = params.small_object_logical_page_size;
-            m_medium_object_logical_page_size = params.medium_object_logical_page_size;
+            if (requests & REQUEST_PAGE_SIZES_SNAPSHOT)
+            {
+                publish_page_sizes();
+            }
+        }
 
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            // 2. CALCULATE REQUIRED BUFFER SIZE
-            std::size_t small_objects_required_buffer_size{ 0 };
-            std::size_t medium_objects_required_buffer_size{ 0 };
-            std::size_t size_class = MIN_SIZE_CLASS;
+        void* process_recyclable_deallocation_queue(std::size_t bin_index)
+        {
+            void* ret = nullptr;
 
-            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            while (true)
             {
-                if(i<MIN_MEDIUM_OBJECT_BIN_INDEX)
+                uint64_t pointer{ 0 };
+
+                if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
                 {
-                    small_objects_required_buffer_size += (params.logical_page_counts[i] * m_small_object_logical_page_size);
+                    if (llmalloc_likely(ret != nullptr))
+                    {
+                        m_segments[bin_index].deallocate(reinterpret_cast<void*>(pointer));
+                    }
+                    else
+                    {
+                        ret = reinterpret_cast<void*>(pointer);
+                    }
                 }
                 else
                 {
-                    medium_objects_required_buffer_size += (params.logical_page_counts[i] * m_medium_object_logical_page_size);
+                    break;
                 }
-
-                size_class = size_class << 1;
             }
 
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            // 3. ALLOCATE BUFFERS
-            auto small_objects_buffer_address = reinterpret_cast<uint64_t>(arena->allocate(small_objects_required_buffer_size));
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(small_objects_buffer_address)), "HeapPow2: Arena failed to pass an address which is aligned to OS page allocation granularity.");
-
-            char* medium_objects_buffer_address = reinterpret_cast<char*>(arena->allocate_aligned(medium_objects_required_buffer_size, m_medium_object_logical_page_size));
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(medium_objects_buffer_address)), "HeapPow2: Arena failed to pass an address which is aligned to OS page allocation granularity.");
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(reinterpret_cast<void*>(medium_objects_buffer_address), m_medium_object_logical_page_size), "HeapPow2: Failed to get an address which is aligned to medium objects page size.");
-
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            // 4. DISTRIBUTE BUFFER TO BINS ,  NEED TO PLACE LOGICAL PAGE HEADERS TO START OF PAGES !
+            return ret;
+        }
 
-            std::size_t buffer_index{ 0 };
-            size_class = MIN_SIZE_CLASS;
+};
 
-            SegmentCreationParameters segment_params;
-            segment_params.m_page_recycling_threshold = params.page_recycling_threshold_per_size_class;
-            segment_params.m_can_grow = params.segments_can_grow;
-            segment_params.m_grow_coefficient = params.segment_grow_coefficient;
+// 4 size classes per pow2 to reduce internal fragmentation , at the cost of a few more instructions per allocation
+template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK>
+using HeapQuarterPow2 = HeapPow2<DeallocationQueueType, segment_lock_policy, QuarterPow2SizeClasses>;
 
-            for (std::size_t i = 0; i < MIN_MEDIUM_OBJECT_BIN_INDEX; i++)
-            {
-                auto required_logical_page_count = params.logical_page_counts[i];
-                segment_params.m_size_class = static_cast<uint32_t>(size_class);
-                segment_params.m_logical_page_count = required_logical_page_count;
+// Template defaults are for thread local or single threaded cases
+template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK>
+class HeapPool
+{
+    public:
+    
+        using ArenaType = Arena;
 
-                segment_params.m_logical_page_size = m_small_object_logical_page_size;
-                auto bin_buffer_size = required_logical_page_count * m_small_object_logical_page_size;
+        HeapPool() {}
+        ~HeapPool() {}
+        HeapPool(const HeapPool& other) = delete;
+        HeapPool& operator= (const HeapPool& other) = delete;
+        HeapPool(HeapPool&& other) = delete;
+        HeapPool& operator=(HeapPool&& other) = delete;
 
-                bool success = m_segments[i].create(reinterpret_cast<char*>(small_objects_buffer_address) + buffer_index, arena, segment_params);
+        using SegmentType = Segment<segment_lock_policy>;
 
-                if (!success)
-                {
-                    return false;
-                }
+        struct HeapCreationParams
+        {
+            // SIZES AND CAPACITIES
+            uint32_t size_class = 0;
+            std::size_t initial_size = 0;
+            std::size_t logical_page_size = 65536; // 64 KB
+            // RECYCLING AND GROWING
+            bool segments_can_grow = true;
+            std::size_t page_recycling_threshold = 1;
+            double grow_coefficient = 2.0;
+            // DEALLOCATION QUEUES
+            std::size_t recyclable_deallocation_queue_size = 65536;
+            std::size_t non_recyclable_deallocation_queue_size = 65536;
+            std::size_t deallocation_queues_processing_threshold = 1024;
+        };
 
-                buffer_index += bin_buffer_size;
-                size_class = size_class << 1;
-            }
+        [[nodiscard]] bool create(const HeapCreationParams& params, ArenaType* arena_ptr)
+        {
+            llmalloc_assert_msg(params.size_class > 0, "Pool size class should be greater than zero.");
+            llmalloc_assert_msg(params.initial_size > 0, "Pool initial size should be greater than zero.");
+            llmalloc_assert_msg(params.initial_size % params.logical_page_size == 0, "Initial pool size should be a multiple of its logical page size.");
 
-            buffer_index = 0;
+            m_arena = arena_ptr;
 
-            for (std::size_t i = MIN_MEDIUM_OBJECT_BIN_INDEX; i < BIN_COUNT; i++)
-            {
-                auto required_logical_page_count = params.logical_page_counts[i];
-                segment_params.m_size_class = static_cast<uint32_t>(size_class);
-                segment_params.m_logical_page_count = required_logical_page_count;
+            auto buffer_length = params.initial_size;
+            auto buffer_address = reinterpret_cast<uint64_t>(m_arena->allocate(buffer_length));
 
-                segment_params.m_logical_page_size = m_medium_object_logical_page_size;
-                auto bin_buffer_size = required_logical_page_count * m_medium_object_logical_page_size;
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(buffer_address)), "Arena failed to return page alloc granularity aligned address for memory pool.");
+            
+            std::size_t segment_size = static_cast<std::size_t>(buffer_length);
+            std::size_t logical_page_count_per_segment = static_cast<std::size_t>(segment_size / params.logical_page_size);
 
-                bool success = m_segments[i].create(medium_objects_buffer_address + buffer_index, arena, segment_params);
+            SegmentCreationParameters segment_params;
+            segment_params.m_size_class = params.size_class;
+            segment_params.m_logical_page_size = params.logical_page_size;
+            segment_params.m_page_recycling_threshold = params.page_recycling_threshold;
+            segment_params.m_can_grow = params.segments_can_grow;
+            segment_params.m_grow_coefficient = params.grow_coefficient;
 
-                if (!success)
-                {
-                    return false;
-                }
+            segment_params.m_logical_page_count = logical_page_count_per_segment;
 
-                buffer_index += bin_buffer_size;
-                size_class = size_class << 1;
+            if (m_segment.create(reinterpret_cast<char*>(buffer_address), m_arena, segment_params) == false)
+            {
+                return false;
             }
-            //////////////////////////////////////////////////////////////////////////////////////////////
-            // 5. DEALLOCATION QUEUES
-            m_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
-
-            for (std::size_t i = 0; i < BIN_COUNT; i++)
+            
+            if (m_recyclable_deallocation_queue.create(params.recyclable_deallocation_queue_size/sizeof(uint64_t)) == false)
             {
-                if( params.non_recyclable_deallocation_queue_sizes[i] > 0 )
-                {
-                    if (m_non_recyclable_deallocation_queues[i].create(params.non_recyclable_deallocation_queue_sizes[i]) == false)
-                    {
-                        return false;
-                    }
-                }
-
-                if (m_recyclable_deallocation_queues[i].create(params.recyclable_deallocation_queue_sizes[i]) == false)
-                {
-                    return false;
-                }
+                return false;
+            }
+            
+            if (m_non_recyclable_deallocation_queue.create(params.non_recyclable_deallocation_queue_size/sizeof(uint64_t)) == false)
+            {
+                return false;
             }
+            
+            m_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            m_logical_page_size = params.logical_page_size;
 
             return true;
         }
@@ -3270,119 +6964,167 @@ class HeapPow2
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
         void* allocate(std::size_t size = 0)
         {
-            size = size < MIN_SIZE_CLASS ? MIN_SIZE_CLASS : size;
-            size = get_first_pow2_of(size);
-            auto bin_index = get_pow2_bin_index_from_size(size);
+            LLMALLOC_UNUSED(size);
 
             m_potential_pending_max_deallocation_count++;
 
-            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count >= m_deallocation_queue_processing_threshold))
+            if(llmalloc_unlikely(m_potential_pending_max_deallocation_count.load() >= m_deallocation_queue_processing_threshold ))
             {
-                return allocate_by_processing_deallocation_queues(bin_index, size);
+                return allocate_by_processing_deallocation_queue(size);
             }
 
             uint64_t pointer{ 0 };
 
-            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            if (m_non_recyclable_deallocation_queue.try_pop(pointer))
             {
                 return reinterpret_cast<void*>(pointer);
             }
 
-            if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            if (m_recyclable_deallocation_queue.try_pop(pointer))
             {
                 return reinterpret_cast<void*>(pointer);
             }
 
-            return m_segments[bin_index].allocate(size);
+            return m_segment.allocate(size);
         }
 
         // Slow path removal function
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        void* allocate_by_processing_deallocation_queues(std::size_t bin_index, std::size_t size)
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
+        void* allocate_by_processing_deallocation_queue(std::size_t size)
         {
             #ifdef ENABLE_PERF_TRACES
-            fprintf(stderr, "\033[0;31m" "Heap processing deallocation queue in allocation callstack\n" "\033[0m");
+            fprintf(stderr, "\033[0;31m" "HeapPoolCentral processing deallocation queue in allocation callstack\n" "\033[0m");
             #endif
 
-            m_potential_pending_max_deallocation_count = 0;
-
-            auto ret = process_recyclable_deallocation_queue(bin_index);
-
+            m_potential_pending_max_deallocation_count = 0;
+            
+            auto ret = process_recyclable_deallocation_queue();
+            
             if(ret != nullptr)
             {
                 return ret;
             }
-
+            
             uint64_t pointer{ 0 };
 
-            if (m_non_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+            if (m_non_recyclable_deallocation_queue.try_pop(pointer))
             {
                 return reinterpret_cast<void*>(pointer);
             }
 
-            return m_segments[bin_index].allocate(size);
+            return m_segment.allocate(size);
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        bool deallocate(void* ptr, bool is_small_object)
+        bool deallocate(void* ptr, bool is_small_object = false)
         {
-            auto logical_page_size = is_small_object ? m_small_object_logical_page_size : m_medium_object_logical_page_size;
-            auto target_logical_page = SegmentType::get_logical_page_from_address(ptr, logical_page_size);
-
-            auto size_class = target_logical_page->get_size_class();
-
-            llmalloc_assert_msg(size_class >= MIN_SIZE_CLASS, "HeapPow2 deallocate : Found size class is invalid. The pointer may not have been allocated by this allocator.");
-            
-            auto bin_index = get_pow2_bin_index_from_size(size_class);
+            LLMALLOC_UNUSED(is_small_object);
 
-            if (m_segments[bin_index].get_id() == target_logical_page->get_segment_id())
+            if(m_segment.owns_pointer(ptr))
             {
-                return m_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                return m_recyclable_deallocation_queue.try_push(reinterpret_cast<uint64_t>(ptr));
             }
             else
             {
-                return m_non_recyclable_deallocation_queues[bin_index].try_push(reinterpret_cast<uint64_t>(ptr));
+                // We don't want to return this pointer back to segment where virtual memory page recycling happens
+                return m_non_recyclable_deallocation_queue.try_push(reinterpret_cast<uint64_t>(ptr));
             }
         }
 
-        SegmentType* get_segment(std::size_t bin_index)
+        // Returns the number of allocated objects , can be less than count only if the pool is exhausted
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
         {
-            return &(m_segments[bin_index]);
+            std::size_t allocated{ 0 };
+
+            m_potential_pending_max_deallocation_count += count;
+
+            if (llmalloc_unlikely(m_potential_pending_max_deallocation_count.load() >= m_deallocation_queue_processing_threshold))
+            {
+                void* ptr = allocate_by_processing_deallocation_queue(size);
+
+                if (ptr == nullptr)
+                {
+                    return 0;
+                }
+
+                out[allocated++] = ptr;
+            }
+
+            allocated += QueueUtilities::pop_batch(m_non_recyclable_deallocation_queue, count - allocated, out + allocated);
+            allocated += QueueUtilities::pop_batch(m_recyclable_deallocation_queue, count - allocated, out + allocated);
+
+            if (allocated < count)
+            {
+                allocated += m_segment.allocate_batch(size, count - allocated, out + allocated);
+            }
+
+            return allocated;
         }
 
-        static std::size_t get_segment_count()
+        // Consecutive pointers of the same logical page are classified after a single page header access
+        // Returns the number of leading pointers this pool accepted , the caller should pass the first rejected one elsewhere
+        std::size_t deallocate_batch(void** ptrs, std::size_t count, bool is_small_object = false)
         {
-            return BIN_COUNT;
+            LLMALLOC_UNUSED(is_small_object);
+
+            LogicalPage* current_logical_page = nullptr;
+            bool is_owned = false;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto target_logical_page = SegmentType::get_logical_page_from_address(ptrs[i], m_logical_page_size);
+
+                if (target_logical_page != current_logical_page)
+                {
+                    current_logical_page = target_logical_page;
+                    is_owned = target_logical_page->get_segment_id() == m_segment.get_id();
+                }
+
+                auto& target_queue = is_owned ? m_recyclable_deallocation_queue : m_non_recyclable_deallocation_queue;
+
+                if (llmalloc_unlikely(target_queue.try_push(reinterpret_cast<uint64_t>(ptrs[i])) == false))
+                {
+                    return i;
+                }
+            }
+
+            return count;
         }
 
-        static std::size_t get_max_allocation_size()
+        // ScalableAllocator encloses owner calls with these , pools are never accessed by other threads so they are no-ops
+        LLMALLOC_FORCE_INLINE void enter_owner_call() {}
+        LLMALLOC_FORCE_INLINE void leave_owner_call() {}
+
+        // Pools don't keep statistics
+        void count_central_heap_fallbacks(std::size_t count) { LLMALLOC_UNUSED(count); }
+        std::size_t get_central_heap_fallback_count() const { return 0; }
+
+        static std::size_t get_segment_count()
         {
-            return LARGEST_SIZE_CLASS;
+            return 1;
         }
 
-        static std::size_t get_max_small_object_size()
+        SegmentType* get_segment(std::size_t bin_index)
         {
-            return LARGEST_SMALL_OBJECT_SIZE_CLASS;
+            llmalloc_assert_msg(bin_index>0, "HeapPool holds only a single segment.");
+            return &m_segment;
         }
 
         #ifdef UNIT_TEST
-        std::size_t get_bin_logical_page_count(std::size_t bin_index)
-        {
-            return m_segments[bin_index].get_logical_page_count();
-        }
+        std::size_t get_logical_page_count() { return m_segment.get_logical_page_count(); }
         #endif
 
     private:
-        std::size_t m_small_object_logical_page_size = 0;
-        std::size_t m_medium_object_logical_page_size = 0;
-        std::array<SegmentType, BIN_COUNT> m_segments;
 
-        std::size_t m_potential_pending_max_deallocation_count = 0; // Not thread safe but doesn't need to be
-        std::size_t m_deallocation_queue_processing_threshold = 0;
-        std::array<DeallocationQueueType, BIN_COUNT> m_recyclable_deallocation_queues;
-        std::array<DeallocationQueueType, BIN_COUNT> m_non_recyclable_deallocation_queues;
+        SegmentType m_segment;
+        ArenaType* m_arena = nullptr;
+        std::atomic<std::size_t> m_potential_pending_max_deallocation_count = 0;
+        std::size_t m_deallocation_queue_processing_threshold = 65536;
+        std::size_t m_logical_page_size = 0;
+        DeallocationQueueType m_recyclable_deallocation_queue;
+        DeallocationQueueType m_non_recyclable_deallocation_queue;
 
-        void* process_recyclable_deallocation_queue(std::size_t bin_index)
+        void* process_recyclable_deallocation_queue()
         {
             void* ret = nullptr;
 
@@ -3390,11 +7132,11 @@ class HeapPow2
             {
                 uint64_t pointer{ 0 };
 
-                if (m_recyclable_deallocation_queues[bin_index].try_pop(pointer))
+                if (m_recyclable_deallocation_queue.try_pop(pointer))
                 {
                     if (llmalloc_likely(ret != nullptr))
                     {
-                        m_segments[bin_index].deallocate(reinterpret_cast<void*>(pointer));
+                        m_segment.deallocate(reinterpret_cast<void*>(pointer));
                     }
                     else
                     {
@@ -3409,236 +7151,342 @@ class HeapPow2
 
             return ret;
         }
+};
+/*
+    - CACHES FREED LARGE OBJECT MAPPINGS SO THAT SUBSEQUENT LARGE ALLOCATIONS OF SIMILAR SIZES DON'T PAY FOR MMAP/MUNMAP SYSCALLS AND PAGE FAULTS
 
-        // Reference : https://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
-        LLMALLOC_FORCE_INLINE std::size_t get_first_pow2_of(std::size_t input)
-        {
-            assert(input>= MIN_SIZE_CLASS);
+    - MAPPING SIZES ARE ROUNDED UP TO GEOMETRIC BUCKETS , 4 PER POW2 : 320KB 384KB 448KB 512KB , 640KB 768KB 896KB 1MB , ... , 1GB
+      Any cached mapping of a bucket can serve any request of the same bucket. Rounding up costs up to 25% of virtual memory per object
 
-            /* 
-            No need for the if check below , as the caller will pass a miniumum of MIN_SIZE_CLASS which is > 1
-            if (llmalloc_unlikely(input <= 1))
-            {
-                return 1;
-            }
-            */
+    - THE CACHE HAS A SINGLE BYTE BUDGET FOR ALL BUCKETS AS CACHED MAPPINGS ARE POPULATED. WHEN A NEW MAPPING DOESN'T FIT INTO IT ,
+      THE OLDEST MAPPINGS OF ITS BUCKET ARE RELEASED TO THE OS. If that is not enough , the new mapping is not cached
 
-            input--;
-            input |= input >> 1;
-            input |= input >> 2;
-            input |= input >> 4;
-            input |= input >> 8;
-            input |= input >> 16;
+    - DECAY : MAPPINGS WHICH STAY IN THE CACHE LONGER THAN THE DECAY PERIOD ARE RELEASED TO THE OS. With background sweeping , only release_expired_mappings
+      calls of a background thread release them so that frees don't pay for munmaps. Otherwise expired mappings of a bucket are released during its
+      deallocations and all buckets are swept at most once per decay period during cache operations , so cached memory stays until the next large object operation
 
-            return input + 1;
-        }
+    - BUCKETS ARE LIFO STACKS PROTECTED BY SPINLOCKS. MOST RECENTLY CACHED MAPPINGS ARE REUSED FIRST AS THEY ARE MORE LIKELY TO BE IN CPU CACHES AND TLBS.
+      Stacks are also ordered by cache times , so the oldest mappings are at the bottom. Mappings are released to the OS after locks are released
 
-        // IMPLEMENTATION IS FOR 64 BIT ONLY
-        LLMALLOC_FORCE_INLINE std::size_t get_pow2_bin_index_from_size(std::size_t size)
-        {
-            std::size_t index = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size))) - LOG2_MIN_SIZE_CLASS;
-            index = index > MAX_BIN_INDEX ? MAX_BIN_INDEX : index;
-            return index;
-        }
+    - CACHED MAPPINGS ARE NOT ZEROED
+*/
+
+struct LargeObjectCacheOptions
+{
+    std::size_t max_object_size = 33554432;     // Mappings of bigger objects are not cached , 0 disables the cache
+    std::size_t capacity = 67108864;            // Byte budget of all buckets , 0 disables the cache
+    uint64_t decay_period = 1000;               // In milliseconds , 0 disables the decay so that mappings are released only by the budget
+    bool background_sweeping = false;           // Expired mappings are released only by release_expired_mappings calls
 };
 
-// Template defaults are for thread local or single threaded cases
-template<typename DeallocationQueueType = BoundedQueue<uint64_t, typename Arena::MetadataAllocator>, LockPolicy segment_lock_policy = LockPolicy::NO_LOCK>
-class HeapPool
+class LargeObjectCache
 {
     public:
-    
-        using ArenaType = Arena;
 
-        HeapPool() {}
-        ~HeapPool() {}
-        HeapPool(const HeapPool& other) = delete;
-        HeapPool& operator= (const HeapPool& other) = delete;
-        HeapPool(HeapPool&& other) = delete;
-        HeapPool& operator=(HeapPool&& other) = delete;
+        static constexpr std::size_t LOG2_MIN_OBJECT_SIZE = 18;        // Objects up to 256KB are served by heaps
+        static constexpr std::size_t LOG2_MAX_OBJECT_SIZE = 30;
+        static constexpr std::size_t BUCKET_COUNT = (LOG2_MAX_OBJECT_SIZE - LOG2_MIN_OBJECT_SIZE) * 4;
+        static constexpr std::size_t MAX_MAPPING_COUNT_PER_BUCKET = 32;
 
-        using SegmentType = Segment<segment_lock_policy>;
+        LargeObjectCache() = default;
+        ~LargeObjectCache() = default;
 
-        struct HeapCreationParams
+        LargeObjectCache(const LargeObjectCache& other) = delete;
+        LargeObjectCache& operator= (const LargeObjectCache& other) = delete;
+        LargeObjectCache(LargeObjectCache&& other) = delete;
+        LargeObjectCache& operator=(LargeObjectCache&& other) = delete;
+
+        bool create(const LargeObjectCacheOptions& options)
         {
-            // SIZES AND CAPACITIES
-            uint32_t size_class = 0;
-            std::size_t initial_size = 0;
-            std::size_t logical_page_size = 65536; // 64 KB
-            // RECYCLING AND GROWING
-            bool segments_can_grow = true;
-            std::size_t page_recycling_threshold = 1;
-            double grow_coefficient = 2.0;
-            // DEALLOCATION QUEUES
-            std::size_t recyclable_deallocation_queue_size = 65536;
-            std::size_t non_recyclable_deallocation_queue_size = 65536;
-            std::size_t deallocation_queues_processing_threshold = 1024;
-        };
+            constexpr std::size_t max_object_size_limit = static_cast<std::size_t>(1) << LOG2_MAX_OBJECT_SIZE;
 
-        [[nodiscard]] bool create(const HeapCreationParams& params, ArenaType* arena_ptr)
+            m_max_object_size = options.max_object_size > options.capacity ? options.capacity : options.max_object_size;
+            m_max_object_size = m_max_object_size > max_object_size_limit ? max_object_size_limit : m_max_object_size;
+            m_capacity = options.capacity;
+            m_decay_period = options.decay_period;
+            m_background_sweeping = options.background_sweeping;
+            m_cached_size.store(0, std::memory_order_relaxed);
+
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                m_buckets[i].m_lock.initialise();
+                m_buckets[i].m_mapping_count = 0;
+            }
+
+            m_next_sweep_time.store(TimeUtilities::get_monotonic_time_in_milliseconds() + m_decay_period, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        // Cachable sizes are rounded up to their bucket sizes , so that their mappings can be reused by any request of the same bucket
+        std::size_t get_mapping_size(std::size_t size) const
         {
-            llmalloc_assert_msg(params.size_class > 0, "Pool size class should be greater than zero.");
-            llmalloc_assert_msg(params.initial_size > 0, "Pool initial size should be greater than zero.");
-            llmalloc_assert_msg(params.initial_size % params.logical_page_size == 0, "Initial pool size should be a multiple of its logical page size.");
+            if (size <= MIN_OBJECT_SIZE || size > m_max_object_size)
+            {
+                return size;
+            }
 
-            m_arena = arena_ptr;
+            return get_bucket_size(get_bucket_index(size));
+        }
 
-            auto buffer_length = params.initial_size;
-            auto buffer_address = reinterpret_cast<uint64_t>(m_arena->allocate(buffer_length));
+        // Returns nullptr if there is no cached mapping , mapping_size should be the one returned from get_mapping_size
+        void* allocate(std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
+            {
+                return nullptr;
+            }
 
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_page_allocation_granularity_aligned(reinterpret_cast<void*>(buffer_address)), "Arena failed to return page alloc granularity aligned address for memory pool.");
-            
-            std::size_t segment_size = static_cast<std::size_t>(buffer_length);
-            std::size_t logical_page_count_per_segment = static_cast<std::size_t>(segment_size / params.logical_page_size);
+            void* ret = nullptr;
+            Bucket& bucket = m_buckets[get_bucket_index(mapping_size)];
 
-            SegmentCreationParameters segment_params;
-            segment_params.m_size_class = params.size_class;
-            segment_params.m_logical_page_size = params.logical_page_size;
-            segment_params.m_page_recycling_threshold = params.page_recycling_threshold;
-            segment_params.m_can_grow = params.segments_can_grow;
-            segment_params.m_grow_coefficient = params.grow_coefficient;
+            bucket.m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            if (bucket.m_mapping_count > 0)
+            {
+                ret = bucket.m_mappings[--bucket.m_mapping_count].m_address;
+                m_cached_size.fetch_sub(mapping_size, std::memory_order_relaxed);
+            }
+            ////////////////////////////////////////////////////////////////////
+            bucket.m_lock.unlock();
 
-            segment_params.m_logical_page_count = logical_page_count_per_segment;
+            if (m_background_sweeping == false)
+            {
+                sweep_if_needed(TimeUtilities::get_monotonic_time_in_milliseconds());
+            }
 
-            if (m_segment.create(reinterpret_cast<char*>(buffer_address), m_arena, segment_params) == false)
+            return ret;
+        }
+
+        // Returns false if the mapping can't be cached , then the caller should release it to the OS
+        bool deallocate(void* address, std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
             {
                 return false;
             }
-            
-            if (m_recyclable_deallocation_queue.create(params.recyclable_deallocation_queue_size/sizeof(uint64_t)) == false)
+
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+            Bucket& bucket = m_buckets[get_bucket_index(mapping_size)];
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+
+            bucket.m_lock.lock();
+            ////////////////////////////////////////////////////////////////////
+            // Passing 0 as the current time skips the decay
+            std::size_t released_mapping_count = remove_expired_mappings(bucket, m_background_sweeping ? 0 : now, MAX_MAPPING_COUNT_PER_BUCKET - 1, released_mappings, mapping_size);
+            bool reserved = try_reserve(mapping_size);
+
+            while (reserved == false && bucket.m_mapping_count > 0)
             {
-                return false;
+                released_mapping_count += remove_expired_mappings(bucket, 0, bucket.m_mapping_count - 1, released_mappings + released_mapping_count, mapping_size);
+                reserved = try_reserve(mapping_size);
             }
-            
-            if (m_non_recyclable_deallocation_queue.create(params.non_recyclable_deallocation_queue_size/sizeof(uint64_t)) == false)
+
+            if (reserved)
             {
-                return false;
+                bucket.m_mappings[bucket.m_mapping_count].m_address = address;
+                bucket.m_mappings[bucket.m_mapping_count].m_cache_time = now;
+                bucket.m_mapping_count++;
             }
-            
-            m_deallocation_queue_processing_threshold = params.deallocation_queues_processing_threshold;
+            ////////////////////////////////////////////////////////////////////
+            bucket.m_lock.unlock();
 
-            return true;
+            release_mappings(released_mappings, released_mapping_count, mapping_size);
+
+            if (m_background_sweeping == false)
+            {
+                sweep_if_needed(now);
+            }
+
+            return reserved;
         }
 
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
-        void* allocate(std::size_t size = 0)
+        // Releases expired mappings of all buckets to the OS
+        void release_expired_mappings()
         {
-            LLMALLOC_UNUSED(size);
+            uint64_t now = TimeUtilities::get_monotonic_time_in_milliseconds();
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
 
-            m_potential_pending_max_deallocation_count++;
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                Bucket& bucket = m_buckets[i];
 
-            if(llmalloc_unlikely(m_potential_pending_max_deallocation_count.load() >= m_deallocation_queue_processing_threshold ))
+                bucket.m_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                std::size_t released_mapping_count = remove_expired_mappings(bucket, now, MAX_MAPPING_COUNT_PER_BUCKET, released_mappings, get_bucket_size(i));
+                ////////////////////////////////////////////////////////////////////
+                bucket.m_lock.unlock();
+
+                release_mappings(released_mappings, released_mapping_count, get_bucket_size(i));
+            }
+        }
+
+        // Releases all cached mappings to the OS regardless of their cache times , returns released bytes
+        std::size_t release_all_mappings()
+        {
+            std::size_t released_size{ 0 };
+            CachedMapping released_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
             {
-                return allocate_by_processing_deallocation_queue(size);
+                Bucket& bucket = m_buckets[i];
+
+                bucket.m_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                std::size_t released_mapping_count = remove_expired_mappings(bucket, 0, 0, released_mappings, get_bucket_size(i));
+                ////////////////////////////////////////////////////////////////////
+                bucket.m_lock.unlock();
+
+                release_mappings(released_mappings, released_mapping_count, get_bucket_size(i));
+                released_size += released_mapping_count * get_bucket_size(i);
             }
 
-            uint64_t pointer{ 0 };
+            return released_size;
+        }
 
-            if (m_non_recyclable_deallocation_queue.try_pop(pointer))
+        // Total size of cached mappings
+        std::size_t get_cached_size() const
+        {
+            return m_cached_size.load(std::memory_order_relaxed);
+        }
+
+        std::size_t get_cached_mapping_count(std::size_t mapping_size)
+        {
+            if (is_cachable(mapping_size) == false)
             {
-                return reinterpret_cast<void*>(pointer);
+                return 0;
             }
 
-            if (m_recyclable_deallocation_queue.try_pop(pointer))
+            return m_buckets[get_bucket_index(mapping_size)].m_mapping_count;
+        }
+
+    private:
+
+        static constexpr std::size_t MIN_OBJECT_SIZE = static_cast<std::size_t>(1) << LOG2_MIN_OBJECT_SIZE;
+
+        struct CachedMapping
+        {
+            void* m_address = nullptr;
+            uint64_t m_cache_time = 0;
+        };
+
+        struct Bucket
+        {
+            UserspaceSpinlock<AlignmentConstants::CPU_CACHE_LINE_SIZE> m_lock;
+            std::size_t m_mapping_count = 0;
+            CachedMapping m_mappings[MAX_MAPPING_COUNT_PER_BUCKET];
+        };
+
+        Bucket m_buckets[BUCKET_COUNT];
+        std::size_t m_max_object_size = 0;
+        std::size_t m_capacity = 0;
+        uint64_t m_decay_period = 0;
+        bool m_background_sweeping = false;
+        std::atomic<std::size_t> m_cached_size{ 0 };
+        std::atomic<uint64_t> m_next_sweep_time{ 0 };
+
+        // Buckets have separate locks , so the budget is shared with a CAS loop
+        bool try_reserve(std::size_t mapping_size)
+        {
+            std::size_t cached_size = m_cached_size.load(std::memory_order_relaxed);
+
+            do
             {
-                return reinterpret_cast<void*>(pointer);
+                if (cached_size + mapping_size > m_capacity)
+                {
+                    return false;
+                }
+            }
+            while (m_cached_size.compare_exchange_weak(cached_size, cached_size + mapping_size, std::memory_order_relaxed, std::memory_order_relaxed) == false);
+
+            return true;
+        }
+
+        // Mapping sizes which are not bucket sizes ( ex: remapped objects ) are not cached
+        bool is_cachable(std::size_t mapping_size) const
+        {
+            if (mapping_size <= MIN_OBJECT_SIZE || mapping_size > m_max_object_size)
+            {
+                return false;
             }
 
-            return m_segment.allocate(size);
+            return get_bucket_size(get_bucket_index(mapping_size)) == mapping_size;
         }
 
-        // Slow path removal function
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE) [[nodiscard]]
-        void* allocate_by_processing_deallocation_queue(std::size_t size)
+        // 2^log2 < size <= 2^(log2+1) , then find which quarter of that range the size is in
+        static std::size_t get_bucket_index(std::size_t size)
         {
-            #ifdef ENABLE_PERF_TRACES
-            fprintf(stderr, "\033[0;31m" "HeapPoolCentral processing deallocation queue in allocation callstack\n" "\033[0m");
-            #endif
+            std::size_t log2 = static_cast<std::size_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(size - 1)));
+            return ((log2 - LOG2_MIN_OBJECT_SIZE) << 2) + ((size - 1 - (static_cast<std::size_t>(1) << log2)) >> (log2 - 2));
+        }
 
-            m_potential_pending_max_deallocation_count = 0;
-            
-            auto ret = process_recyclable_deallocation_queue();
-            
-            if(ret != nullptr)
+        static std::size_t get_bucket_size(std::size_t bucket_index)
+        {
+            std::size_t log2 = LOG2_MIN_OBJECT_SIZE + (bucket_index >> 2);
+            return (static_cast<std::size_t>(1) << log2) + ((bucket_index & 3) + 1) * (static_cast<std::size_t>(1) << (log2 - 2));
+        }
+
+        // Should be called while holding the lock of the bucket. Removes expired mappings and the oldest ones that exceed the count from the bottom of the stack
+        std::size_t remove_expired_mappings(Bucket& bucket, uint64_t now, std::size_t capacity, CachedMapping* released_mappings, std::size_t mapping_size)
+        {
+            std::size_t released_mapping_count = bucket.m_mapping_count > capacity ? bucket.m_mapping_count - capacity : 0;
+
+            if (m_decay_period > 0)
             {
-                return ret;
+                while (released_mapping_count < bucket.m_mapping_count && bucket.m_mappings[released_mapping_count].m_cache_time + m_decay_period <= now)
+                {
+                    released_mapping_count++;
+                }
             }
-            
-            uint64_t pointer{ 0 };
 
-            if (m_non_recyclable_deallocation_queue.try_pop(pointer))
+            if (released_mapping_count == 0)
             {
-                return reinterpret_cast<void*>(pointer);
+                return 0;
             }
 
-            return m_segment.allocate(size);
-        }
-
-        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        bool deallocate(void* ptr, bool is_small_object = false)
-        {
-            LLMALLOC_UNUSED(is_small_object);
-
-            if(m_segment.owns_pointer(ptr))
+            for (std::size_t i = 0; i < released_mapping_count; i++)
             {
-                return m_recyclable_deallocation_queue.try_push(reinterpret_cast<uint64_t>(ptr));
+                released_mappings[i] = bucket.m_mappings[i];
             }
-            else
+
+            for (std::size_t i = released_mapping_count; i < bucket.m_mapping_count; i++)
             {
-                // We don't want to return this pointer back to segment where virtual memory page recycling happens
-                return m_non_recyclable_deallocation_queue.try_push(reinterpret_cast<uint64_t>(ptr));
+                bucket.m_mappings[i - released_mapping_count] = bucket.m_mappings[i];
             }
-        }
 
-        static std::size_t get_segment_count()
-        {
-            return 1;
+            bucket.m_mapping_count -= released_mapping_count;
+            m_cached_size.fetch_sub(released_mapping_count * mapping_size, std::memory_order_relaxed);
+
+            return released_mapping_count;
         }
 
-        SegmentType* get_segment(std::size_t bin_index)
+        void release_mappings(CachedMapping* mappings, std::size_t count, std::size_t mapping_size)
         {
-            llmalloc_assert_msg(bin_index>0, "HeapPool holds only a single segment.");
-            return &m_segment;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                VirtualMemory::deallocate(mappings[i].m_address, mapping_size);
+            }
         }
 
-        #ifdef UNIT_TEST
-        std::size_t get_logical_page_count() { return m_segment.get_logical_page_count(); }
-        #endif
-
-    private:
-        SegmentType m_segment;
-        ArenaType* m_arena = nullptr;
-        std::atomic<std::size_t> m_potential_pending_max_deallocation_count = 0;
-        std::size_t m_deallocation_queue_processing_threshold = 65536;
-        DeallocationQueueType m_recyclable_deallocation_queue;
-        DeallocationQueueType m_non_recyclable_deallocation_queue;
-
-        void* process_recyclable_deallocation_queue()
+        // Only one thread sweeps per decay period
+        void sweep_if_needed(uint64_t now)
         {
-            void* ret = nullptr;
-
-            while (true)
+            if (m_decay_period == 0)
             {
-                uint64_t pointer{ 0 };
+                return;
+            }
 
-                if (m_recyclable_deallocation_queue.try_pop(pointer))
-                {
-                    if (llmalloc_likely(ret != nullptr))
-                    {
-                        m_segment.deallocate(reinterpret_cast<void*>(pointer));
-                    }
-                    else
-                    {
-                        ret = reinterpret_cast<void*>(pointer);
-                    }
-                }
-                else
-                {
-                    break;
-                }
+            uint64_t next_sweep_time = m_next_sweep_time.load(std::memory_order_relaxed);
+
+            if (llmalloc_likely(now < next_sweep_time))
+            {
+                return;
             }
 
-            return ret;
+            if (m_next_sweep_time.compare_exchange_strong(next_sweep_time, now + m_decay_period, std::memory_order_relaxed))
+            {
+                release_expired_mappings();
+            }
         }
 };
 // INTERFACE WRAPPER FOR THREAD CACHING MEMORY POOL
@@ -3669,7 +7517,7 @@ class ScalablePool
     public:
 
         using ArenaType = Arena;
-        using CentralHeapType = HeapPool<MPMCBoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using CentralHeapType = HeapPool<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
         using LocalHeapType = HeapPool<BoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::NO_LOCK>;
         using ScalableMemoryPool = ScalableAllocator<CentralHeapType, LocalHeapType>;
 
@@ -3771,6 +7619,18 @@ class ScalablePool
 
             ScalableMemoryPool::get_instance().deallocate(ptr);
         }
+
+        // Returns the number of allocated objects , can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t count, void** out)
+        {
+            return ScalableMemoryPool::get_instance().allocate_batch(sizeof(T), count, out);
+        }
+
+        // Unlike deallocate , passed pointers should not be nullptr
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            ScalableMemoryPool::get_instance().deallocate_batch(ptrs, count);
+        }
 };
 /*
     - std::allocator::allocate interface has to return contigious buffer for multiple objects which is not supported by HeapPool.
@@ -3803,7 +7663,11 @@ class SingleThreadedAllocator
 {
     public:
 
+        #ifdef USE_QUARTER_POW2_SIZE_CLASSES
+        using HeapType = HeapQuarterPow2<>;
+        #else
         using HeapType = HeapPow2<>;
+        #endif
         using ArenaType = Arena;
         using HashmapType = Dictionary<uint64_t, std::size_t, typename ArenaType::MetadataAllocator>;
 
@@ -3818,7 +7682,7 @@ class SingleThreadedAllocator
         bool create(SingleThreadedAllocatorOptions options = SingleThreadedAllocatorOptions())
         {
             m_max_allocation_size = HeapType::get_max_allocation_size();
-            m_max_small_object_size = HeapPow2<>::get_max_small_object_size();
+            m_max_small_object_size = HeapType::get_max_small_object_size();
 
             if( m_non_small_objects_hash_map.initialise( options.non_small_objects_hash_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
             {
@@ -3834,7 +7698,7 @@ class SingleThreadedAllocator
             heap_params.deallocation_queues_processing_threshold = options.deallocation_queue_processing_threshold;
             
             
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < HeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 heap_params.logical_page_counts[i] = options.logical_page_counts_per_size_class[i];
                 heap_params.non_recyclable_deallocation_queue_sizes[i] = 0;
@@ -3907,7 +7771,8 @@ class SingleThreadedAllocator
         {
             std::size_t medium_or_large_size{0};
 
-            if (llmalloc_unlikely( m_non_small_objects_hash_map.get( reinterpret_cast<uint64_t>(ptr), medium_or_large_size) ))
+            // Erasing as the same address can be handed out again as a small object
+            if (llmalloc_unlikely( m_non_small_objects_hash_map.erase( reinterpret_cast<uint64_t>(ptr), medium_or_large_size) ))
             {
                 deallocate_medium_or_large_object(ptr, medium_or_large_size);
                 return;
@@ -4029,34 +7894,68 @@ struct ScalableMallocOptions
 {
     // SIZE AND CAPACITIES
     std::size_t arena_initial_size = 2147483648;
+    bool arena_commit_on_demand = false; // Opt-in , arena is reserved and committed in chunks as it is used rather than populating all of it at startup
+    std::size_t arena_commit_chunk_size = 2097152;
+    bool arena_prefault_commits = true; // Committed chunks are prefaulted , latency critical uses avoid page faults while memory footprint grows only by chunks
     std::size_t central_logical_page_counts_per_size_class[HeapPow2<>::BIN_COUNT] = {1,1,1,1,1,1,1,2,4,8,16,32,8,16,32};
     std::size_t local_logical_page_counts_per_size_class[HeapPow2<>::BIN_COUNT] = {1,1,1,1,1,1,1,2,4,8,16,32,8,16,32};
     // RECYCLING & GROWING
     std::size_t page_recycling_threshold = 10;
+    PageReleasePolicy page_release_policy = PageReleasePolicy::UNMAP; // Recycled logical pages can be discarded with madvise and kept in the arena for later grows
+    std::size_t logical_page_pool_capacity = 16; // Per heap , recycled small object logical pages are kept for bins of any size class before being released , 0 disables
     bool local_heaps_can_grow = true;
     double grow_coefficient = 2.0;
+    std::size_t cache_color_count = 1; // Chunks of consecutive logical pages start at different cache line offsets , 1 disables coloring
     // DEALLOCATION QUEUES
     std::size_t deallocation_queues_processing_threshold = 409600;
+    // Queue sizes apply only to the central heap , thread local heaps link freed chunks through themselves without any capacity limit
     std::size_t recyclable_deallocation_queue_sizes[HeapPow2<>::BIN_COUNT] = {65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536};
     std::size_t non_recyclable_deallocation_queue_sizes[HeapPow2<>::BIN_COUNT] = {65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536};
+    bool use_remote_free_lists = false; // Cross thread frees go back to the logical pages of their owner heaps , costs a CAS per cross thread free
+    // REALLOCATIONS
+    double reallocation_shrink_ratio = 0.5; // Reallocations move objects to new chunks if the new size is below this fraction of the current capacity , 0 disables
+    // LARGE OBJECT CACHE
+    std::size_t large_object_cache_max_object_size = 33554432; // Freed mappings of large objects up to this size are cached for reuse , 0 disables the cache
+    std::size_t large_object_cache_capacity = 67108864; // Byte budget of all cached mappings
+    std::size_t large_object_cache_decay_period = 1000; // Cached mappings are released to the OS after this many milliseconds , 0 disables the decay
+    // BACKGROUND PURGING
+    bool background_purging = false; // Recycled logical pages are released by a low priority thread after a decay period instead of inside free calls
+    std::size_t background_purging_decay_period = 1000; // In milliseconds
+    std::size_t background_purging_max_bytes_per_period = 67108864; // Rate limit of releases , 0 means no limit
+    std::size_t background_purging_max_pending_size = 268435456; // Freeing threads release pages themselves beyond this , 0 means no limit
     // OTHERS
     bool use_huge_pages = false;
     int numa_node=-1;
     std::size_t thread_local_cached_heap_count = 0;
     #ifndef USE_ALLOC_HEADERS
-    std::size_t non_small_and_aligned_objects_map_size = 655360; // Applies to no alloc headers
+    std::size_t non_small_and_aligned_objects_map_size = 655360; // Applies to no alloc headers, holds only large objects as others are found via the page map
     #endif
 
     ScalableMallocOptions()
     {
         // SIZE AND CAPACITIES
         arena_initial_size = EnvironmentVariable::get_variable("llmalloc_arena_initial_size", arena_initial_size); // Default 2 GB      
+
+        int numeric_arena_commit_on_demand = EnvironmentVariable::get_variable("llmalloc_arena_commit_on_demand", 0);
+        arena_commit_on_demand = numeric_arena_commit_on_demand == 1 ? true : false;
+
+        arena_commit_chunk_size = EnvironmentVariable::get_variable("llmalloc_arena_commit_chunk_size", arena_commit_chunk_size);
+
+        int numeric_arena_prefault_commits = EnvironmentVariable::get_variable("llmalloc_arena_prefault_commits", 1);
+        arena_prefault_commits = numeric_arena_prefault_commits == 1 ? true : false;
+
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(local_logical_page_counts_per_size_class, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_local_logical_page_counts_per_size_class", "1,1,1,1,1,1,1,2,4,8,16,32,8,16,32"));
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(central_logical_page_counts_per_size_class, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_central_logical_page_counts_per_size_class", "1,1,1,1,1,1,1,2,4,8,16,32,8,16,32"));
 
         // RECYCLING & GROWING
         page_recycling_threshold = EnvironmentVariable::get_variable("llmalloc_page_recycling_threshold", page_recycling_threshold);
+
+        int numeric_page_release_policy = EnvironmentVariable::get_variable("llmalloc_page_release_policy", 0);
+        page_release_policy = numeric_page_release_policy == 2 ? PageReleasePolicy::ADVISE_FREE : (numeric_page_release_policy == 1 ? PageReleasePolicy::ADVISE_DONTNEED : PageReleasePolicy::UNMAP);
+
+        logical_page_pool_capacity = EnvironmentVariable::get_variable("llmalloc_logical_page_pool_capacity", logical_page_pool_capacity);
         grow_coefficient = EnvironmentVariable::get_variable("llmalloc_grow_coefficient", grow_coefficient);
+        cache_color_count = EnvironmentVariable::get_variable("llmalloc_cache_color_count", cache_color_count);
 
         int numeric_local_heaps_can_grow = EnvironmentVariable::get_variable("llmalloc_local_heaps_can_grow", 1);
         local_heaps_can_grow = numeric_local_heaps_can_grow == 1 ? true : false;
@@ -4066,6 +7965,25 @@ struct ScalableMallocOptions
         
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(recyclable_deallocation_queue_sizes, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_recyclable_deallocation_queue_sizes", "65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536"));
         EnvironmentVariable::set_numeric_array_from_comma_separated_value_string(non_recyclable_deallocation_queue_sizes, HeapPow2<>::BIN_COUNT, EnvironmentVariable::get_variable("llmalloc_non_recyclable_deallocation_queue_sizes", "65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536,65536"));
+
+        int numeric_use_remote_free_lists = EnvironmentVariable::get_variable("llmalloc_use_remote_free_lists", 0);
+        use_remote_free_lists = numeric_use_remote_free_lists == 1 ? true : false;
+
+        // REALLOCATIONS
+        reallocation_shrink_ratio = EnvironmentVariable::get_variable("llmalloc_reallocation_shrink_ratio", reallocation_shrink_ratio);
+
+        // LARGE OBJECT CACHE
+        large_object_cache_max_object_size = EnvironmentVariable::get_variable("llmalloc_large_object_cache_max_object_size", large_object_cache_max_object_size);
+        large_object_cache_capacity = EnvironmentVariable::get_variable("llmalloc_large_object_cache_capacity", large_object_cache_capacity);
+        large_object_cache_decay_period = EnvironmentVariable::get_variable("llmalloc_large_object_cache_decay_period", large_object_cache_decay_period);
+
+        // BACKGROUND PURGING
+        int numeric_background_purging = EnvironmentVariable::get_variable("llmalloc_background_purging", 0);
+        background_purging = numeric_background_purging == 1 ? true : false;
+
+        background_purging_decay_period = EnvironmentVariable::get_variable("llmalloc_background_purging_decay_period", background_purging_decay_period);
+        background_purging_max_bytes_per_period = EnvironmentVariable::get_variable("llmalloc_background_purging_max_bytes_per_period", background_purging_max_bytes_per_period);
+        background_purging_max_pending_size = EnvironmentVariable::get_variable("llmalloc_background_purging_max_pending_size", background_purging_max_pending_size);
         
         // OTHERS
         thread_local_cached_heap_count = EnvironmentVariable::get_variable("llmalloc_thread_local_cached_heap_count", thread_local_cached_heap_count);
@@ -4086,6 +8004,16 @@ struct ScalableMallocOptions
     }
 };
 
+// Reported by get_memory_usage , see mallinfo2 in scalable_malloc_overrides.h for the mapping to mallinfo fields
+struct MemoryUsage
+{
+    std::size_t heap_size = 0;              // Memory heaps received from the arena , including pooled logical pages and pages waiting to be purged
+    std::size_t heap_used_size = 0;         // Chunks handed out by heaps , including chunks waiting in deallocation queues
+    std::size_t retained_size = 0;          // Releasable memory : pooled logical pages , pages waiting to be purged and cached large object mappings
+    std::size_t large_object_count = 0;     // Live large objects , each one has its own mapping
+    std::size_t large_object_size = 0;
+};
+
 LLMALLOC_PACKED
 (
     struct AllocationMetadata
@@ -4100,10 +8028,16 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
     public:
 
         using ArenaType = Arena;
-        using CentralHeapType = HeapPow2<MPMCBoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
-        using LocalHeapType = HeapPow2<BoundedQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::NO_LOCK>;
+        #ifdef USE_QUARTER_POW2_SIZE_CLASSES
+        using CentralHeapType = HeapQuarterPow2<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using LocalHeapType = HeapQuarterPow2<IntrusiveLIFOQueue<uint64_t>, LockPolicy::NO_LOCK>;
+        #else
+        using CentralHeapType = HeapPow2<MPMCPointerQueue<uint64_t, typename ArenaType::MetadataAllocator>, LockPolicy::USERSPACE_LOCK>;
+        using LocalHeapType = HeapPow2<IntrusiveLIFOQueue<uint64_t>, LockPolicy::NO_LOCK>;
+        #endif
         using ScalableMallocType = ScalableAllocator<CentralHeapType, LocalHeapType>;
         using HashmapType = MPMCDictionary<uint64_t, AllocationMetadata, typename ArenaType::MetadataAllocator>;
+        using Stats = typename ScalableMallocType::Stats;
 
         LLMALLOC_FORCE_INLINE static ScalableMalloc& get_instance()
         {
@@ -4111,10 +8045,41 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             return instance;
         }
 
-        bool create(ScalableMallocOptions options = ScalableMallocOptions())
+        // Background threads can be started later with start_background_threads , ex: if create is called inside the very first malloc call
+        bool create(ScalableMallocOptions options = ScalableMallocOptions(), bool start_background_threads_now = true)
         {
-            m_max_allocation_size = HeapPow2<>::get_max_allocation_size();
-            m_max_small_object_size = HeapPow2<>::get_max_small_object_size();
+            m_max_allocation_size = LocalHeapType::get_max_allocation_size();
+            m_max_small_object_size = LocalHeapType::get_max_small_object_size();
+            m_reallocation_shrink_ratio = options.reallocation_shrink_ratio;
+
+            LargeObjectCacheOptions large_object_cache_options;
+            large_object_cache_options.max_object_size = options.large_object_cache_max_object_size;
+            large_object_cache_options.capacity = options.large_object_cache_capacity;
+            large_object_cache_options.decay_period = options.large_object_cache_decay_period;
+            large_object_cache_options.background_sweeping = options.background_purging; // The purging thread sweeps the cache
+
+            if (m_large_object_cache.create(large_object_cache_options) == false)
+            {
+                return false;
+            }
+
+            m_background_purging = options.background_purging;
+            m_background_purging_period = options.background_purging_decay_period / 2 > MIN_BACKGROUND_PURGING_PERIOD ? options.background_purging_decay_period / 2 : MIN_BACKGROUND_PURGING_PERIOD;
+
+            if (m_background_purging)
+            {
+                PagePurgerOptions page_purger_options;
+                page_purger_options.decay_period = options.background_purging_decay_period;
+                page_purger_options.max_bytes_per_purge = options.background_purging_max_bytes_per_period;
+                page_purger_options.max_pending_size = options.background_purging_max_pending_size;
+
+                if (m_page_purger.create(page_purger_options) == false)
+                {
+                    return false;
+                }
+
+                m_background_thread_lock.initialise();
+            }
 
             ///////////////////////////////////////////////////////////////
             // CREATE SCALABLE ALLOCATOR INSTANCE
@@ -4122,22 +8087,30 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             local_heap_params.page_recycling_threshold_per_size_class = options.page_recycling_threshold;
             local_heap_params.segments_can_grow = options.local_heaps_can_grow;
             local_heap_params.segment_grow_coefficient = options.grow_coefficient;
+            local_heap_params.cache_color_count = options.cache_color_count;
+            local_heap_params.logical_page_pool_capacity = options.logical_page_pool_capacity;
             local_heap_params.deallocation_queues_processing_threshold = options.deallocation_queues_processing_threshold;
+            local_heap_params.use_remote_free_lists = options.use_remote_free_lists;
+            local_heap_params.page_purger = m_background_purging ? &m_page_purger : nullptr;
 
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < LocalHeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 local_heap_params.logical_page_counts[i] = options.local_logical_page_counts_per_size_class[i];
                 local_heap_params.recyclable_deallocation_queue_sizes[i] = options.recyclable_deallocation_queue_sizes[i];
-                local_heap_params.non_recyclable_deallocation_queue_sizes[i] = options.non_recyclable_deallocation_queue_sizes[i];
+                local_heap_params.non_recyclable_deallocation_queue_sizes[i] = options.use_remote_free_lists ? 0 : options.non_recyclable_deallocation_queue_sizes[i]; // Not used with remote free lists
             }
 
             typename CentralHeapType::HeapCreationParams central_heap_params;
             central_heap_params.page_recycling_threshold_per_size_class = options.page_recycling_threshold;
             central_heap_params.segments_can_grow = true;
             central_heap_params.segment_grow_coefficient = options.grow_coefficient;
+            central_heap_params.cache_color_count = options.cache_color_count;
+            central_heap_params.logical_page_pool_capacity = options.logical_page_pool_capacity;
             central_heap_params.deallocation_queues_processing_threshold = options.deallocation_queues_processing_threshold;
+            central_heap_params.use_remote_free_lists = options.use_remote_free_lists;
+            central_heap_params.page_purger = m_background_purging ? &m_page_purger : nullptr;
 
-            for (std::size_t i = 0; i < HeapPow2<>::BIN_COUNT; i++)
+            for (std::size_t i = 0; i < CentralHeapType::SIZE_CLASS_GROUP_COUNT; i++)
             {
                 central_heap_params.logical_page_counts[i] = options.central_logical_page_counts_per_size_class[i];
                 central_heap_params.recyclable_deallocation_queue_sizes[i] = options.recyclable_deallocation_queue_sizes[i];
@@ -4148,6 +8121,10 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             arena_options.cache_capacity = options.arena_initial_size;
             arena_options.use_huge_pages = options.use_huge_pages;
             arena_options.numa_node = options.numa_node;
+            arena_options.commit_on_demand = options.arena_commit_on_demand;
+            arena_options.commit_chunk_size = options.arena_commit_chunk_size;
+            arena_options.prefault_commits = options.arena_prefault_commits;
+            arena_options.page_release_policy = options.page_release_policy;
             
             if(options.use_huge_pages == true)
             {
@@ -4165,15 +8142,61 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             ScalableMallocType::get_instance().set_thread_local_heap_cache_count(options.thread_local_cached_heap_count);
 
             #ifndef USE_ALLOC_HEADERS
-            m_small_object_logical_page_size = local_heap_params.small_object_logical_page_size;
+            m_small_object_logical_page_size_shift = static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(local_heap_params.small_object_logical_page_size)));
+            m_medium_object_logical_page_size_shift = static_cast<uint8_t>(63 - llmalloc_builtin_clzl(static_cast<unsigned long>(local_heap_params.medium_object_logical_page_size)));
+
+            if( m_large_objects_map.initialise( options.non_small_and_aligned_objects_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
+            {
+                return false;
+            }
 
-            if( m_non_small_and_aligned_objects_map.initialise( options.non_small_and_aligned_objects_map_size / sizeof(typename HashmapType::DictionaryNode) ) == false)
+            if (m_page_map.initialise() == false)
             {
                 return false;
             }
+
+            local_heap_params.page_map = &m_page_map;
+            central_heap_params.page_map = &m_page_map;
             #endif
 
-            return ScalableMallocType::get_instance().create(central_heap_params, local_heap_params, arena_options);
+            // Heaps with more size classes are bigger , scaling the metadata buffer keeps the max thread local heap count same as the pow2 build
+            std::size_t metadata_buffer_size = ScalableMallocType::DEFAULT_METADATA_BUFFER_SIZE * ((sizeof(LocalHeapType) + sizeof(HeapPow2<>) - 1) / sizeof(HeapPow2<>));
+
+            if (ScalableMallocType::get_instance().create(central_heap_params, local_heap_params, arena_options, metadata_buffer_size) == false)
+            {
+                return false;
+            }
+
+            return start_background_threads_now ? start_background_threads() : true;
+        }
+
+        // Starts the background purging thread if enabled , should be called when malloc calls can be served as creating a thread allocates
+        bool start_background_threads()
+        {
+            if (m_background_purging == false)
+            {
+                return true;
+            }
+
+            bool expected = false;
+
+            if (m_background_threads_started.compare_exchange_strong(expected, true) == false)
+            {
+                return true;
+            }
+
+            // Children inherit the handlers , so they are registered only once
+            if (m_fork_handlers_registered == false)
+            {
+                if (ThreadUtilities::register_fork_handlers(&ScalableMalloc::on_fork_prepare, &ScalableMalloc::on_fork_parent, &ScalableMalloc::on_fork_child) == false)
+                {
+                    return false;
+                }
+
+                m_fork_handlers_registered = true;
+            }
+
+            return ThreadUtilities::create_detached_thread(&ScalableMalloc::background_purging_thread_function, this);
         }
 
         #ifndef USE_ALLOC_HEADERS
@@ -4187,85 +8210,247 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             void* ptr = ScalableMallocType::get_instance().allocate(size);
 
-            if(llmalloc_unlikely(size > m_max_small_object_size))
+            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
+            return ptr;
+        }
+
+        // Same as allocate , also reports whether the returned memory is known to be zeroed
+        void* allocate(std::size_t size, bool& is_zeroed)
+        {
+            if (llmalloc_unlikely( size > m_max_allocation_size ))
             {
-                register_unpadded_medium_object(ptr, size);
+                return allocate_large_object(size, &is_zeroed);
             }
 
-            llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
-            return ptr;
+            return ScalableMallocType::get_instance().allocate(size, is_zeroed);
         }
 
         // Slow path removal function
-        void* allocate_large_object(std::size_t size)
+        void* allocate_large_object(std::size_t size, bool* is_zeroed = nullptr)
         {
-            auto ptr = VirtualMemory::allocate(size, false);
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { size, 0 });
+            auto mapping_size = m_large_object_cache.get_mapping_size(size);
+            auto ptr = allocate_large_mapping(mapping_size, is_zeroed);
+
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
+            if (llmalloc_unlikely(m_large_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { mapping_size, 0 }) == false))
+            {
+                deallocate_large_mapping(ptr, mapping_size);
+                return nullptr;
+            }
+
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ptr, AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
             return ptr;
         }
 
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate(void*ptr)
+        {
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return;
+            }
+
+            // Small and medium objects live in logical pages which are registered to the page map by segments
+            auto logical_page_size_shift = m_page_map.get(ptr);
+
+            if (llmalloc_unlikely(logical_page_size_shift == 0))
+            {
+                deallocate_large_object(ptr);
+                return;
+            }
+
+            // Chunk start address lookup is needed for aligned objects as they are padded
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            ScalableMallocType::get_instance().deallocate(logical_page->get_chunk_start_address(ptr), logical_page_size_shift == m_small_object_logical_page_size_shift);
+        }
+
         // Slow path removal function
-        void register_unpadded_medium_object(void* ptr, std::size_t size)
+        void deallocate_large_object(void* ptr)
         {
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ptr), { size, 0 });
+            AllocationMetadata metadata;
+
+            // Erasing so that the map size tracks only live large objects
+            if (m_large_objects_map.erase(reinterpret_cast<uint64_t>(ptr), metadata))
+            {
+                uint64_t unpadded_pointer = reinterpret_cast<uint64_t>(ptr) - metadata.padding_bytes;
+                deallocate_large_mapping(reinterpret_cast<void*>(unpadded_pointer), metadata.size); // Large object with or without padding bytes
+            }
+        }
+
+        // Slow path removal function
+        // Resizes large objects with mremap instead of copying them , returns nullptr if not possible
+        void* reallocate_large_object(void* ptr, std::size_t size)
+        {
+            if (m_page_map.get(ptr) != 0)
+            {
+                return nullptr; // Small or medium object
+            }
+
+            AllocationMetadata metadata;
+
+            // Aligned large objects are excluded as moving their mappings would break their alignments
+            if (m_large_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata) == false || metadata.padding_bytes != 0)
+            {
+                return nullptr;
+            }
+
+            // The entry is detached before mremap , otherwise another thread could map the released address and insert its own entry for it in between.
+            // Its node is reattached to the new address or back to the old one if mremap fails , so the entry can't be lost
+            auto node = m_large_objects_map.detach(reinterpret_cast<uint64_t>(ptr), metadata);
+
+            if (node == nullptr)
+            {
+                return nullptr;
+            }
+
+            // Rounding up to a bucket size keeps the mapping cachable after it is freed
+            auto mapping_size = m_large_object_cache.get_mapping_size(size);
+            void* new_ptr = VirtualMemory::reallocate(ptr, metadata.size, mapping_size);
+
+            if (new_ptr == nullptr)
+            {
+                m_large_objects_map.attach(node, reinterpret_cast<uint64_t>(ptr), metadata);
+                return nullptr;
+            }
+
+            m_large_objects_map.attach(node, reinterpret_cast<uint64_t>(new_ptr), { mapping_size, 0 });
+            on_large_mapping_resized(metadata.size, mapping_size);
+
+            return new_ptr;
         }
 
+        // For sized deletes and free_sized , the size should be the one passed to the allocation call
+        // Small/medium classification comes from the size so the page map lookup is skipped. Unaligned pointers are always chunk start addresses
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
-        void deallocate(void*ptr)
+        void deallocate_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
         {
             if (llmalloc_unlikely(ptr == nullptr))
             {
                 return;
             }
 
-            AllocationMetadata metadata;
-            if (llmalloc_unlikely(m_non_small_and_aligned_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata)))
+            if (llmalloc_likely(alignment <= AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT))
+            {
+                if (llmalloc_unlikely(size > m_max_allocation_size))
+                {
+                    deallocate_large_object(ptr);
+                    return;
+                }
+
+                ScalableMallocType::get_instance().deallocate(ptr, size <= m_max_small_object_size);
+                return;
+            }
+
+            std::size_t adjusted_size = size + alignment; // Same as allocate_aligned
+
+            if (llmalloc_unlikely(adjusted_size > m_max_allocation_size))
             {
-                deallocate_non_small_or_aligned_object(metadata, ptr);
+                deallocate_large_object(ptr);
                 return;
             }
 
-            ScalableMallocType::get_instance().deallocate(ptr, true); // Small object without padding bytes
+            bool is_small_object = adjusted_size <= m_max_small_object_size;
+            auto logical_page_size_shift = is_small_object ? m_small_object_logical_page_size_shift : m_medium_object_logical_page_size_shift;
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            ScalableMallocType::get_instance().deallocate(logical_page->get_chunk_start_address(ptr), is_small_object);
         }
 
-        // Slow path removal function
-        void deallocate_non_small_or_aligned_object(const AllocationMetadata& metadata, void* ptr)
+        // Resolves the thread local heap and the bin once , returns the number of allocated objects which can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
         {
-            uint64_t unpadded_pointer = reinterpret_cast<uint64_t>(ptr) - metadata.padding_bytes;
-
-            if (metadata.size <= m_max_small_object_size)
+            if (llmalloc_unlikely( size > m_max_allocation_size ))
             {
-                ScalableMallocType::get_instance().deallocate(reinterpret_cast<void*>(unpadded_pointer), true); // Small object with padding bytes
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    out[i] = allocate_large_object(size);
+
+                    if (out[i] == nullptr)
+                    {
+                        return i;
+                    }
+                }
+
+                return count;
             }
-            else if (metadata.size <= m_max_allocation_size)
+
+            return ScalableMallocType::get_instance().allocate_batch(size, count, out);
+        }
+
+        // Pointers can be of any size and nullptr , runs of small or medium ones are passed to heaps in batches
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            void* chunks[DEALLOCATION_BATCH_CAPACITY];
+            std::size_t chunk_count{ 0 };
+            bool chunks_are_small = true;
+
+            for (std::size_t i = 0; i < count; i++)
             {
-                ScalableMallocType::get_instance().deallocate(reinterpret_cast<void*>(unpadded_pointer), false); // Medium object with or without padding bytes
+                if (llmalloc_unlikely(ptrs[i] == nullptr))
+                {
+                    continue;
+                }
+
+                auto logical_page_size_shift = m_page_map.get(ptrs[i]);
+
+                if (llmalloc_unlikely(logical_page_size_shift == 0))
+                {
+                    deallocate_large_object(ptrs[i]);
+                    continue;
+                }
+
+                bool is_small_object = logical_page_size_shift == m_small_object_logical_page_size_shift;
+
+                if (chunk_count == DEALLOCATION_BATCH_CAPACITY || (chunk_count > 0 && is_small_object != chunks_are_small))
+                {
+                    ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
+                    chunk_count = 0;
+                }
+
+                auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptrs[i], static_cast<std::size_t>(1) << logical_page_size_shift);
+                chunks[chunk_count++] = logical_page->get_chunk_start_address(ptrs[i]);
+                chunks_are_small = is_small_object;
             }
-            else
+
+            if (chunk_count > 0)
             {
-                VirtualMemory::deallocate(reinterpret_cast<void*>(unpadded_pointer), metadata.size); // Large object with or without padding bytes
+                ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
             }
         }
 
         std::size_t get_usable_size(void* ptr)
         {
-            AllocationMetadata metadata;
+            auto logical_page_size_shift = m_page_map.get(ptr);
 
-            if (llmalloc_unlikely(m_non_small_and_aligned_objects_map.get( reinterpret_cast<uint64_t>(ptr), metadata)))
+            if (llmalloc_unlikely(logical_page_size_shift == 0))
             {
-                return metadata.size;
+                AllocationMetadata metadata;
+
+                if (m_large_objects_map.get(reinterpret_cast<uint64_t>(ptr), metadata))
+                {
+                    return metadata.size - metadata.padding_bytes;
+                }
+
+                return 0;
             }
 
-            // In case of a small object, we simply access to its page header to find its size quickly
-            auto target_logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, m_small_object_logical_page_size);
-            auto size_class = target_logical_page->get_size_class();
-            return size_class;
+            // In case of a small or medium object, we simply access to its page header to find its size quickly
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+            auto chunk_start_address = reinterpret_cast<uint64_t>(logical_page->get_chunk_start_address(ptr));
+            return static_cast<std::size_t>(chunk_start_address + logical_page->get_size_class() - reinterpret_cast<uint64_t>(ptr));
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
         void* allocate_aligned(std::size_t size, std::size_t alignment)
         {
+            if (alignment <= AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT)
+            {
+                return allocate(size);
+            }
+
             std::size_t adjusted_size = size + alignment; // Adding padding bytes
             
             if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
@@ -4275,13 +8460,17 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             auto ptr = ScalableMallocType::get_instance().allocate(adjusted_size);
 
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
+            // No need to store padding bytes , deallocations find chunk start addresses via logical page headers
             std::size_t remainder = reinterpret_cast<std::uint64_t>(ptr) - ((reinterpret_cast<std::uint64_t>(ptr) / alignment) * alignment);
-            std::size_t offset = alignment - remainder;
+            std::size_t offset = remainder == 0 ? 0 : alignment - remainder;
 
             void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(ptr) + offset);
 
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ret), {adjusted_size , offset});
-
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
             return ret;
         }
@@ -4289,12 +8478,23 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         // Slow path removal function
         void* allocate_aligned_large_object(std::size_t adjusted_size, std::size_t alignment)
         {
-            auto ptr = VirtualMemory::allocate(adjusted_size, false);
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto ptr = allocate_large_mapping(mapping_size);
+
+            if (llmalloc_unlikely(ptr == nullptr))
+            {
+                return nullptr;
+            }
+
             std::size_t remainder = reinterpret_cast<std::uint64_t>(ptr) - ((reinterpret_cast<std::uint64_t>(ptr) / alignment) * alignment);
             std::size_t offset = alignment - remainder;
             void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(ptr) + offset);
 
-            m_non_small_and_aligned_objects_map.insert(reinterpret_cast<uint64_t>(ret), { adjusted_size , offset });
+            if (llmalloc_unlikely(m_large_objects_map.insert(reinterpret_cast<uint64_t>(ret), { mapping_size , offset }) == false))
+            {
+                deallocate_large_mapping(ptr, mapping_size);
+                return nullptr;
+            }
 
             llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
 
@@ -4327,14 +8527,39 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             }
         }
 
-        // Slow path removal function
-        void* allocate_large_object(std::size_t adjusted_size)
+        // Same as allocate , also reports whether the returned memory is known to be zeroed. Headers don't overlap with the returned memory
+        void* allocate(std::size_t size, bool& is_zeroed)
         {
-            auto header_address = reinterpret_cast<char*>(VirtualMemory::allocate(adjusted_size, false));
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
+            {
+                return allocate_large_object(adjusted_size, &is_zeroed);
+            }
+
+            char* header_address = reinterpret_cast<char*>(ScalableMallocType::get_instance().allocate(adjusted_size, is_zeroed));
+
             if(llmalloc_likely(header_address))
             {
                 reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
                 reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
+                return  header_address + sizeof(AllocationMetadata);
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        // Slow path removal function
+        void* allocate_large_object(std::size_t adjusted_size, bool* is_zeroed = nullptr)
+        {
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto header_address = reinterpret_cast<char*>(allocate_large_mapping(mapping_size, is_zeroed));
+            if(llmalloc_likely(header_address))
+            {
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = mapping_size; // Large objects store their mapping sizes
+                reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
                 llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(header_address + sizeof(AllocationMetadata), AlignmentAndSizeUtils::CPP_DEFAULT_ALLOCATION_ALIGNMENT), "Allocation address should be aligned to at least 16 bytes.");
                 return header_address + sizeof(AllocationMetadata);
             }
@@ -4366,14 +8591,142 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             }
             else
             {
-                VirtualMemory::deallocate(reinterpret_cast<void*>(orig_ptr), size);
+                deallocate_large_mapping(reinterpret_cast<void*>(orig_ptr), size);
+            }
+        }
+
+        // Slow path removal function
+        // Resizes large objects with mremap instead of copying them , returns nullptr if not possible
+        void* reallocate_large_object(void* ptr, std::size_t size)
+        {
+            auto header_address = reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata);
+            auto old_adjusted_size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+
+            // Aligned large objects are excluded as moving their mappings would break their alignments
+            if (old_adjusted_size <= m_max_allocation_size || reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes != 0)
+            {
+                return nullptr;
+            }
+
+            // Rounding up to a bucket size keeps the mapping cachable after it is freed
+            auto mapping_size = m_large_object_cache.get_mapping_size(size + sizeof(AllocationMetadata));
+            auto new_header_address = reinterpret_cast<char*>(VirtualMemory::reallocate(header_address, old_adjusted_size, mapping_size));
+
+            if (new_header_address == nullptr)
+            {
+                return nullptr;
+            }
+
+            on_large_mapping_resized(old_adjusted_size, mapping_size);
+
+            reinterpret_cast<AllocationMetadata*>(new_header_address)->size = mapping_size;
+            return new_header_address + sizeof(AllocationMetadata);
+        }
+
+        // For sized deletes and free_sized , the size should be the one passed to the allocation call
+        // Unaligned small and medium objects are classified from the size without reading their headers
+        LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
+        void deallocate_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
+        {
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            // Aligned objects need padding bytes from their headers and large objects need their mapping sizes
+            if (llmalloc_unlikely(ptr == nullptr || alignment > 0 || adjusted_size > m_max_allocation_size))
+            {
+                deallocate(ptr);
+                return;
+            }
+
+            ScalableMallocType::get_instance().deallocate(reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata), adjusted_size <= m_max_small_object_size);
+        }
+
+        // Resolves the thread local heap and the bin once , returns the number of allocated objects which can be less than count only if out of memory
+        std::size_t allocate_batch(std::size_t size, std::size_t count, void** out)
+        {
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (llmalloc_unlikely( adjusted_size > m_max_allocation_size ))
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    out[i] = allocate_large_object(adjusted_size);
+
+                    if (out[i] == nullptr)
+                    {
+                        return i;
+                    }
+                }
+
+                return count;
+            }
+
+            auto allocated = ScalableMallocType::get_instance().allocate_batch(adjusted_size, count, out);
+
+            for (std::size_t i = 0; i < allocated; i++)
+            {
+                char* header_address = reinterpret_cast<char*>(out[i]);
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
+                reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = 0;
+                out[i] = header_address + sizeof(AllocationMetadata);
+            }
+
+            return allocated;
+        }
+
+        // Pointers can be of any size and nullptr , runs of small or medium ones are passed to heaps in batches
+        void deallocate_batch(void** ptrs, std::size_t count)
+        {
+            void* chunks[DEALLOCATION_BATCH_CAPACITY];
+            std::size_t chunk_count{ 0 };
+            bool chunks_are_small = true;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (llmalloc_unlikely(ptrs[i] == nullptr))
+                {
+                    continue;
+                }
+
+                auto header_address = reinterpret_cast<char*>(ptrs[i]) - sizeof(AllocationMetadata);
+                auto size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+                auto orig_ptr = header_address - reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes;
+
+                if (llmalloc_unlikely(size > m_max_allocation_size))
+                {
+                    deallocate_large_mapping(reinterpret_cast<void*>(orig_ptr), size);
+                    continue;
+                }
+
+                bool is_small_object = size <= m_max_small_object_size;
+
+                if (chunk_count == DEALLOCATION_BATCH_CAPACITY || (chunk_count > 0 && is_small_object != chunks_are_small))
+                {
+                    ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
+                    chunk_count = 0;
+                }
+
+                chunks[chunk_count++] = orig_ptr;
+                chunks_are_small = is_small_object;
+            }
+
+            if (chunk_count > 0)
+            {
+                ScalableMallocType::get_instance().deallocate_batch(chunks, chunk_count, chunks_are_small);
             }
         }
 
         std::size_t get_usable_size(void* ptr)
         {
             auto header_address = reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata);
-            return reinterpret_cast<AllocationMetadata*>(header_address)->size - sizeof(AllocationMetadata);
+            auto size = reinterpret_cast<AllocationMetadata*>(header_address)->size;
+
+            if (llmalloc_likely(size <= m_max_allocation_size))
+            {
+                // Capacity of the chunk rather than the requested size , so that reallocations can grow in place
+                size = LocalHeapType::SizeClassesType::get_size_class(LocalHeapType::SizeClassesType::get_bin_index(size));
+            }
+
+            return size - sizeof(AllocationMetadata) - reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes;
         }
 
         LLMALLOC_ALIGN_CODE(AlignmentConstants::CPU_CACHE_LINE_SIZE)
@@ -4412,7 +8765,8 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         // Slow path removal function
         void* allocate_aligned_large_object(std::size_t adjusted_size, std::size_t alignment)
         {
-            auto base = VirtualMemory::allocate(adjusted_size, false);
+            auto mapping_size = m_large_object_cache.get_mapping_size(adjusted_size);
+            auto base = allocate_large_mapping(mapping_size);
 
             if(llmalloc_likely(base))
             {
@@ -4423,7 +8777,7 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
                 void* header_address = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(base) + offset);
                 void* ret = reinterpret_cast<void*>(reinterpret_cast<std::uint64_t>(header_address) + sizeof(AllocationMetadata));
 
-                reinterpret_cast<AllocationMetadata*>(header_address)->size = adjusted_size;
+                reinterpret_cast<AllocationMetadata*>(header_address)->size = mapping_size; // Large objects store their mapping sizes
                 reinterpret_cast<AllocationMetadata*>(header_address)->padding_bytes = offset;
 
                 llmalloc_assert_msg(AlignmentAndSizeUtils::is_address_aligned(ret, alignment), "Aligned allocation failed to meet the alignment requirement.");
@@ -4473,9 +8827,11 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
         [[nodiscard]] void* allocate_and_zero_memory(std::size_t num, std::size_t size)
         {       
             auto total_size = num * size;
-            void* ret = allocate(total_size);
+            bool is_zeroed = false;
+            void* ret = allocate(total_size, is_zeroed);
 
-            if (ret != nullptr)
+            // Never used chunks and large objects come zeroed from the OS , touching them would also commit their pages
+            if (ret != nullptr && is_zeroed == false)
             {
                 llmalloc_builtin_memset(ret, 0, total_size);
             }
@@ -4495,10 +8851,22 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
                 deallocate(ptr);
                 return nullptr;
             }
+
+            if (llmalloc_unlikely(size > m_max_allocation_size))
+            {
+                // Large to large reallocations avoid copying and transient doubling of RSS
+                void* remapped_ptr = reallocate_large_object(ptr, size);
+
+                if (remapped_ptr != nullptr)
+                {
+                    return remapped_ptr;
+                }
+            }
             
             std::size_t old_size = get_usable_size(ptr);
             
-            if(size <= old_size)
+            // Growing within the capacity of the chunk happens in place
+            if(size <= old_size && can_be_deallocated_with_size(ptr, size) && should_shrink_to_fit(size, old_size) == false)
             {
                 return ptr;
             }
@@ -4507,7 +8875,7 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             if (new_ptr != nullptr)
             {
-                llmalloc_builtin_memcpy(new_ptr, ptr, old_size);
+                llmalloc_builtin_memcpy(new_ptr, ptr, size < old_size ? size : old_size);
                 deallocate(ptr);
             }
 
@@ -4554,7 +8922,8 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
 
             std::size_t old_size = get_usable_size(ptr);
 
-            if(size <= old_size)
+            // Same as reallocate , the pointer should remain deallocatable with the new size
+            if(size <= old_size && can_be_deallocated_with_size(ptr, size) && should_shrink_to_fit(size, old_size) == false)
             {
                 return ptr;
             }
@@ -4564,23 +8933,217 @@ class ScalableMalloc : public Lockable<LockPolicy::USERSPACE_LOCK>
             if (new_ptr != nullptr)
             {
 
-                llmalloc_builtin_memcpy(new_ptr, ptr, old_size);
+                llmalloc_builtin_memcpy(new_ptr, ptr, size < old_size ? size : old_size);
                 deallocate(ptr);
             }
 
             return new_ptr;
         }
         ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // TRIMMING AND MEMORY USAGE
+
+        // Returns true if any memory was released. Thread local heaps of other threads which can't be accessed directly trim themselves in their next allocations , see ScalableAllocator
+        bool trim()
+        {
+            auto arena = ScalableMallocType::get_instance().get_arena();
+            auto heap_size_before_trim = arena->get_allocated_size();
+            std::size_t released_size{ 0 };
+
+            ScalableMallocType::get_instance().trim();
+
+            if (m_background_purging)
+            {
+                released_size += m_page_purger.purge(true);
+            }
+
+            released_size += m_large_object_cache.release_all_mappings();
+            released_size += arena->trim();
+
+            return released_size > 0 || arena->get_allocated_size() < heap_size_before_trim;
+        }
+
+        // Used sizes of thread local heaps of other threads which can't be accessed directly are as of their last snapshots , see ScalableAllocator
+        MemoryUsage get_memory_usage()
+        {
+            MemoryUsage usage;
+            std::size_t pooled_size{ 0 };
+
+            ScalableMallocType::get_instance().get_heap_usage(usage.heap_used_size, pooled_size);
+            usage.heap_size = ScalableMallocType::get_instance().get_arena()->get_allocated_size();
+            usage.heap_used_size = usage.heap_used_size < usage.heap_size ? usage.heap_used_size : usage.heap_size; // Snapshots can be older than the arena size
+            usage.retained_size = pooled_size + (m_background_purging ? m_page_purger.get_pending_size() : 0) + m_large_object_cache.get_cached_size();
+            usage.large_object_count = m_large_object_count.load(std::memory_order_relaxed);
+            usage.large_object_size = m_large_object_size.load(std::memory_order_relaxed);
+
+            return usage;
+        }
+
+        // Per size class counters need ENABLE_STATS , page sizes follow the same scheme as used sizes in get_memory_usage
+        Stats get_stats()
+        {
+            Stats stats;
+            ScalableMallocType::get_instance().get_stats(stats);
+            return stats;
+        }
+        ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     private:
+        static constexpr std::size_t DEALLOCATION_BATCH_CAPACITY = 64; // Stack buffer size for chunk start addresses in deallocate_batch
+
         #ifndef USE_ALLOC_HEADERS
-        HashmapType m_non_small_and_aligned_objects_map;
-        std::size_t m_small_object_logical_page_size = 0;
+        HashmapType m_large_objects_map;
+        PageMapType m_page_map;
+        uint8_t m_small_object_logical_page_size_shift = 0;
+        uint8_t m_medium_object_logical_page_size_shift = 0;
+        #endif
+        LargeObjectCache m_large_object_cache;
+        PagePurger m_page_purger;
+        bool m_background_purging = false;
+        uint64_t m_background_purging_period = 0;
+        std::atomic<bool> m_background_threads_started = false;
+        bool m_fork_handlers_registered = false;
+        UserspaceSpinlock<> m_background_thread_lock; // Held during each purging period so that fork doesn't copy a purge in progress
+        static constexpr uint64_t MIN_BACKGROUND_PURGING_PERIOD = 10; // Milliseconds
+
+        // Releases recycled logical pages and expired large object mappings so that application threads don't have to. Exits once ScalableAllocator shutdown starts
+        #ifdef __linux__
+        static void* background_purging_thread_function(void* argument)
+        #elif _WIN32
+        static DWORD WINAPI background_purging_thread_function(LPVOID argument)
         #endif
+        {
+            ScalableMalloc* instance = static_cast<ScalableMalloc*>(argument);
+            ThreadUtilities::set_current_thread_priority_to_low();
+            bool running = true;
+
+            while (running)
+            {
+                TimeUtilities::sleep_in_milliseconds(instance->m_background_purging_period);
+
+                instance->m_background_thread_lock.lock();
+                ////////////////////////////////////////////////////////////////////
+                running = ScalableMallocType::get_instance().enter_background_task();
+
+                if (running)
+                {
+                    instance->m_page_purger.purge();
+                    instance->m_large_object_cache.release_expired_mappings();
+                    ScalableMallocType::get_instance().leave_background_task();
+                }
+                ////////////////////////////////////////////////////////////////////
+                instance->m_background_thread_lock.unlock();
+            }
+
+            return 0;
+        }
+
+        static void on_fork_prepare()
+        {
+            get_instance().m_background_thread_lock.lock();
+        }
+
+        static void on_fork_parent()
+        {
+            get_instance().m_background_thread_lock.unlock();
+        }
+
+        // Only the forking thread exists in the child , so the purging thread is started again
+        static void on_fork_child()
+        {
+            ScalableMalloc& instance = get_instance();
+            instance.m_background_thread_lock.unlock();
+            instance.m_background_threads_started.store(false);
+            instance.start_background_threads();
+        }
         std::size_t m_max_allocation_size = 0;
         std::size_t m_max_small_object_size = 0;
+        double m_reallocation_shrink_ratio = 0.5;
+        std::atomic<std::size_t> m_large_object_count = 0;
+        std::atomic<std::size_t> m_large_object_size = 0;
+
+        void on_large_mapping_resized(std::size_t old_mapping_size, std::size_t new_mapping_size)
+        {
+            m_large_object_size.fetch_add(new_mapping_size, std::memory_order_relaxed);
+            m_large_object_size.fetch_sub(old_mapping_size, std::memory_order_relaxed);
+        }
+
+        // Mapping sizes should come from the large object cache so that freed mappings can be cached
+        void* allocate_large_mapping(std::size_t mapping_size, bool* is_zeroed = nullptr)
+        {
+            void* ret = m_large_object_cache.allocate(mapping_size);
+
+            if (is_zeroed != nullptr)
+            {
+                *is_zeroed = ret == nullptr; // Fresh mappings are zeroed by the OS , cached ones are reused as they are
+            }
+
+            if (ret == nullptr)
+            {
+                ret = VirtualMemory::allocate(mapping_size, false);
+            }
+
+            if (ret != nullptr)
+            {
+                m_large_object_count.fetch_add(1, std::memory_order_relaxed);
+                m_large_object_size.fetch_add(mapping_size, std::memory_order_relaxed);
+            }
+
+            return ret;
+        }
+
+        void deallocate_large_mapping(void* address, std::size_t mapping_size)
+        {
+            m_large_object_count.fetch_sub(1, std::memory_order_relaxed);
+            m_large_object_size.fetch_sub(mapping_size, std::memory_order_relaxed);
+
+            if (m_large_object_cache.deallocate(address, mapping_size) == false)
+            {
+                VirtualMemory::deallocate(address, mapping_size);
+            }
+        }
+
+        // Shrinking reallocations keep their chunks unless the new size wastes most of them
+        bool should_shrink_to_fit(std::size_t size, std::size_t capacity) const
+        {
+            return static_cast<double>(size) < static_cast<double>(capacity) * m_reallocation_shrink_ratio;
+        }
+
+        // Reallocations may be followed by free_sized with the new size , so a pointer can be returned as is only if deallocate_sized can handle it
+        #ifndef USE_ALLOC_HEADERS
+        bool can_be_deallocated_with_size(void* ptr, std::size_t size)
+        {
+            auto logical_page_size_shift = m_page_map.get(ptr);
+
+            if (logical_page_size_shift == 0)
+            {
+                return size > m_max_allocation_size; // Large objects are found via the map
+            }
+
+            auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << logical_page_size_shift);
+
+            return logical_page->get_chunk_start_address(ptr) == ptr && (logical_page_size_shift == m_small_object_logical_page_size_shift) == (size <= m_max_small_object_size);
+        }
+        #else
+        bool can_be_deallocated_with_size(void* ptr, std::size_t size)
+        {
+            auto header = reinterpret_cast<AllocationMetadata*>(reinterpret_cast<char*>(ptr) - sizeof(AllocationMetadata));
+            auto adjusted_size = size + sizeof(AllocationMetadata);
+
+            if (header->size > m_max_allocation_size)
+            {
+                return adjusted_size > m_max_allocation_size; // Large objects are deallocated via their headers
+            }
+
+            return header->padding_bytes == 0 && (header->size <= m_max_small_object_size) == (adjusted_size <= m_max_small_object_size);
+        }
+        #endif
 };
 
+inline ScalableMalloc::Stats get_stats()
+{
+    return ScalableMalloc::get_instance().get_stats();
+}
+
 } // NAMESPACE END 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OVERRIDES
@@ -4593,7 +9156,8 @@ void llmalloc_initialise()
 {
     if(g_scalable_malloc_initialised.load() == false)
     {
-        auto success = llmalloc::ScalableMalloc::get_instance().create();
+        // Creating background threads allocates , so they are started after initialisation
+        auto success = llmalloc::ScalableMalloc::get_instance().create(llmalloc::ScalableMallocOptions(), false);
 
         if(success == false)
         {
@@ -4601,6 +9165,8 @@ void llmalloc_initialise()
         }
 
         g_scalable_malloc_initialised.store(true);
+
+        llmalloc::ScalableMalloc::get_instance().start_background_threads();
     }
 }
 #endif
@@ -4648,6 +9214,12 @@ void llmalloc_free(void* ptr)
     return llmalloc::ScalableMalloc::get_instance().deallocate(ptr);
 }
 
+LLMALLOC_ALIGN_CODE(llmalloc::AlignmentConstants::CPU_CACHE_LINE_SIZE)
+void llmalloc_free_sized(void* ptr, std::size_t size, std::size_t alignment = 0)
+{
+    return llmalloc::ScalableMalloc::get_instance().deallocate_sized(ptr, size, alignment);
+}
+
 LLMALLOC_ALIGN_CODE(llmalloc::AlignmentConstants::CPU_CACHE_LINE_SIZE)
 void* llmalloc_calloc(std::size_t num, std::size_t size)
 {
@@ -4697,21 +9269,88 @@ struct mallinfo
     int keepcost; // top-most, releasable space (in bytes)
 };
 
+// Same as mallinfo with size_t fields , available since glibc 2.33
+struct mallinfo2
+{
+    std::size_t arena;
+    std::size_t ordblks;
+    std::size_t smblks;
+    std::size_t hblks;
+    std::size_t hblkhd;
+    std::size_t usmblks;
+    std::size_t fsmblks;
+    std::size_t uordblks;
+    std::size_t fordblks;
+    std::size_t keepcost;
+};
+
+// Arena is the memory heaps hold and mmapped regions are large objects. Keepcost is the memory malloc_trim can release
+mallinfo2 llmalloc_mallinfo2()
+{
+    #ifndef DISABLE_OVERRIDE_AUTO_INITIALISATIONS
+    llmalloc_initialise();
+    #endif
+    auto usage = llmalloc::ScalableMalloc::get_instance().get_memory_usage();
+
+    struct mallinfo2 info = {0};
+    info.arena = usage.heap_size;
+    info.hblks = usage.large_object_count;
+    info.hblkhd = usage.large_object_size;
+    info.uordblks = usage.heap_used_size;
+    info.fordblks = usage.heap_size - usage.heap_used_size;
+    info.keepcost = usage.retained_size;
+    return info;
+}
+
+// Fields are clamped as they are int
 mallinfo llmalloc_mallinfo()
 {
+    auto info2 = llmalloc_mallinfo2();
+    auto clamp = [](std::size_t value) { return value > static_cast<std::size_t>(INT_MAX) ? INT_MAX : static_cast<int>(value); };
+
     struct mallinfo info = {0};
+    info.arena = clamp(info2.arena);
+    info.hblks = clamp(info2.hblks);
+    info.hblkhd = clamp(info2.hblkhd);
+    info.uordblks = clamp(info2.uordblks);
+    info.fordblks = clamp(info2.fordblks);
+    info.keepcost = clamp(info2.keepcost);
     return info;
 }
 
+void llmalloc_malloc_stats()
+{
+    auto info = llmalloc_mallinfo2();
+    fprintf(stderr, "Total (incl. mmap):\nsystem bytes     = %10zu\nin use bytes     = %10zu\nmmap regions     = %10zu\nmmap bytes       = %10zu\nreleasable bytes = %10zu\n", info.arena + info.hblkhd, info.uordblks + info.hblkhd, info.hblks, info.hblkhd, info.keepcost);
+
+    // Per size class counters are collected only with ENABLE_STATS , and get_stats walks segments of all heaps
+    #ifdef ENABLE_STATS
+    auto stats = llmalloc::ScalableMalloc::get_instance().get_stats();
+    fprintf(stderr, "%10s %12s %12s %12s %10s %8s %8s %14s %14s\n", "size class", "allocs", "frees", "remote frees", "overflows", "grows", "recycles", "resident bytes", "virtual bytes");
+
+    for (std::size_t i = 0; i < stats.bins.size(); i++)
+    {
+        const auto& bin = stats.bins[i];
+        fprintf(stderr, "%10zu %12zu %12zu %12zu %10zu %8zu %8zu %14zu %14zu\n", llmalloc::ScalableMalloc::LocalHeapType::SizeClassesType::get_size_class(i), bin.allocation_count, bin.deallocation_count, bin.cross_thread_deallocation_count, bin.queue_overflow_count, bin.segment_grow_count, bin.recycled_logical_page_count, bin.resident_size, bin.virtual_size);
+    }
+
+    fprintf(stderr, "central heap fallbacks = %zu\narena chunk builds     = %zu\n", stats.central_heap_fallback_count, stats.arena_chunk_build_count);
+    #endif
+}
+
 int llmalloc_mallopt(int param, int value)
 {
     return 0;
 }
 
+// Pad is ignored as there is no single top chunk. Returns 1 if any memory was released
 int llmalloc_malloc_trim(std::size_t pad)
 {
-    // Does not support trimming, it returns 0 to indicate success.
-    return 0;
+    #ifndef DISABLE_OVERRIDE_AUTO_INITIALISATIONS
+    llmalloc_initialise();
+    #endif
+    LLMALLOC_UNUSED(pad);
+    return llmalloc::ScalableMalloc::get_instance().trim() ? 1 : 0;
 }
 
 void *llmalloc_valloc(std::size_t size)
@@ -4826,7 +9465,9 @@ void* llmalloc_reallocarray(void *ptr, size_t nelem, size_t elsize)
 #define memalign(alignment, size) llmalloc_aligned_malloc(size, alignment)
 #define reallocf(ptr, size) llmalloc_realloc(ptr, size)
 #define reallocarray(ptr, nelem, elsize) llmalloc_reallocarray(ptr, nelem,elsize)
-#define mallinfo llmalloc_mallinfo
+#define mallinfo() llmalloc_mallinfo()
+#define mallinfo2() llmalloc_mallinfo2()
+#define malloc_stats() llmalloc_malloc_stats()
 #define mallopt(param, value) llmalloc_mallopt(param, value)
 #define malloc_trim(pad) llmalloc_malloc_trim(pad)
 #define valloc(size) llmalloc_valloc(size)
@@ -4969,42 +9610,32 @@ void operator delete[](void* ptr, std::size_t, const std::nothrow_t &) noexcept
 // DELETES WITH SIZES
 void operator delete(void* ptr, std::size_t size) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size);
 }
 
 void operator delete[](void* ptr, std::size_t size) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size);
 }
 
 void operator delete(void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete[](void* ptr, std::size_t size, std::align_val_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, static_cast<std::size_t>(align));
 }
 
 void operator delete(void* ptr, std::size_t size, std::size_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, align);
 }
 
 void operator delete[](void* ptr, std::size_t size, std::size_t align) noexcept
 {
-    LLMALLOC_UNUSED(size);
-    LLMALLOC_UNUSED(align);
-    llmalloc_free(ptr);
+    llmalloc_free_sized(ptr, size, align);
 }
 
 #endif
@@ -119,6 +119,145 @@ int main(int argc, char* argv[])
         }
     }
 
+    // COMMIT ON DEMAND
+    for (bool prefault_commits : { false, true })
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 64;
+        options.page_alignment = 65536;
+        options.commit_on_demand = true;
+        options.commit_chunk_size = 65536 * 3;
+        options.prefault_commits = prefault_commits;
+
+        bool success = arena.create(options);
+        if (!success) { std::cout << "COMMIT ON DEMAND ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        std::string test_case_suffix = prefault_commits ? " with prefaulting" : " without prefaulting";
+        bool all_zeroed = true;
+        bool all_valid = true;
+
+        // Spans partial chunks , the end of the cache and a rebuilt cache
+        for (std::size_t i = 0; i < 80; i++)
+        {
+            std::size_t size = 65536 * (1 + i % 2);
+            auto ptr = arena.allocate(size);
+
+            if (ptr == nullptr)
+            {
+                std::cout << "ALLOCATION FAILED !!!" << std::endl;
+                return -1;
+            }
+
+            for (std::size_t j = 0; j < size; j++)
+            {
+                all_zeroed = all_zeroed && ptr[j] == 0;
+            }
+
+            all_valid = all_valid && validate_buffer(ptr, size);
+        }
+
+        unit_test.test_equals(all_zeroed, true, "arena", "committed memory is zeroed" + test_case_suffix);
+        unit_test.test_equals(all_valid, true, "arena", "committed memory is usable" + test_case_suffix);
+    }
+
+    // GROWTH CHUNKS
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 4;
+        options.page_alignment = 65536;
+
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        auto first_chunk = arena.allocate(65536 * 3);
+        auto second_chunk = arena.allocate(65536 * 2); // Doesn't fit to the remaining 64KB , a growth chunk is added
+        unit_test.test_equals(arena.get_chunk_count(), 2, "arena", "growth chunk added");
+        unit_test.test_equals(second_chunk != nullptr && validate_buffer(second_chunk, 65536 * 2), true, "arena", "growth chunk usable");
+
+        auto tail = arena.allocate(65536); // Fits to the tail of the first chunk
+        unit_test.test_equals(tail == first_chunk + 65536 * 3, true, "arena", "tail of the previous chunk reused");
+        unit_test.test_equals(arena.get_chunk_count(), 1, "arena", "exhausted chunk removed");
+
+        auto next = arena.allocate(65536);
+        unit_test.test_equals(next == second_chunk + 65536 * 2, true, "arena", "allocation continues from the growth chunk");
+        unit_test.test_equals(AlignmentAndSizeUtils::is_address_aligned(arena.allocate(100), 65536) && AlignmentAndSizeUtils::is_address_aligned(arena.allocate(65536), 65536), true, "arena", "sizes are rounded up to page alignment");
+    }
+
+    // ALIGNED ALLOCATIONS
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 32;
+        options.page_alignment = 65536;
+
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        auto first = arena.allocate(65536);
+        auto aligned = arena.allocate_aligned(65536 * 8, 65536 * 8);
+        unit_test.test_equals(AlignmentAndSizeUtils::is_address_aligned(aligned, 65536 * 8), true, "arena", "aligned allocation");
+        unit_test.test_equals(validate_buffer(aligned, 65536 * 8), true, "arena", "aligned allocation usable");
+
+        // Pages between the first allocation and the aligned one are kept as a gap
+        std::size_t gap_size = static_cast<std::size_t>(aligned - first) - 65536;
+        unit_test.test_equals(arena.get_gap_count(), gap_size > 0 ? 1 : 0, "arena", "skipped pages kept as a gap");
+
+        if (gap_size > 0)
+        {
+            auto from_gap = arena.allocate(65536);
+            unit_test.test_equals(from_gap == first + 65536, true, "arena", "page aligned request served from the gap");
+            unit_test.test_equals(validate_buffer(from_gap, 65536), true, "arena", "gap memory usable");
+        }
+
+        auto next = arena.allocate_aligned(65536 * 8, 65536 * 8);
+        unit_test.test_equals(next == aligned + 65536 * 8, true, "arena", "consecutive aligned allocations don't waste space");
+    }
+
+    // PAGE RELEASE POLICIES
+    for (auto policy : { PageReleasePolicy::ADVISE_DONTNEED, PageReleasePolicy::ADVISE_FREE })
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 8;
+        options.page_alignment = 65536;
+        options.page_release_policy = policy;
+
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        std::string test_case_suffix = policy == PageReleasePolicy::ADVISE_DONTNEED ? " with MADV_DONTNEED" : " with MADV_FREE";
+
+        auto first = arena.allocate(65536);
+        auto second = arena.allocate(65536);
+        validate_buffer(first, 65536);
+        validate_buffer(second, 65536);
+
+        arena.release_to_system(first, 65536);
+        arena.release_to_system(second, 65536);
+        unit_test.test_equals(arena.get_gap_count(), 1, "arena", "released pages kept and merged as a gap" + test_case_suffix);
+
+        auto reused = arena.allocate(65536 * 2);
+        unit_test.test_equals(reused == first, true, "arena", "released pages reused" + test_case_suffix);
+        unit_test.test_equals(validate_buffer(reused, 65536 * 2), true, "arena", "reused pages usable" + test_case_suffix);
+
+        if (arena.are_reused_pages_zeroed())
+        {
+            arena.release_to_system(reused, 65536 * 2);
+            reused = arena.allocate(65536 * 2);
+
+            bool all_zeroed = true;
+
+            for (std::size_t i = 0; i < 65536 * 2; i++)
+            {
+                all_zeroed = all_zeroed && reused[i] == 0;
+            }
+
+            unit_test.test_equals(all_zeroed, true, "arena", "reused pages zeroed" + test_case_suffix);
+        }
+    }
+
     // HUGE PAGES
     {
         // CHECK IF WE CAN USE HUGE PAGE IN THE TEST
@@ -0,0 +1,162 @@
+#include "../unit_test.h" // Always should be the 1st one as it defines UNIT_TEST macro
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include "../../include/large_object_cache.h"
+
+using namespace std;
+
+UnitTest unit_test;
+
+int main(int argc, char* argv[])
+{
+    constexpr std::size_t KB = 1024;
+    constexpr std::size_t MB = 1024 * KB;
+
+    // MAPPING SIZES
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        cache.create(options);
+
+        unit_test.test_equals(cache.get_mapping_size(256 * KB), 256 * KB, "mapping sizes", "heap sizes are not rounded");
+        unit_test.test_equals(cache.get_mapping_size(256 * KB + 1), 320 * KB, "mapping sizes", "first bucket");
+        unit_test.test_equals(cache.get_mapping_size(320 * KB), 320 * KB, "mapping sizes", "exact bucket size");
+        unit_test.test_equals(cache.get_mapping_size(400 * KB), 448 * KB, "mapping sizes", "third bucket");
+        unit_test.test_equals(cache.get_mapping_size(MB + 1), MB + 256 * KB, "mapping sizes", "first bucket of 1MB");
+        unit_test.test_equals(cache.get_mapping_size(7 * MB), 7 * MB, "mapping sizes", "7MB");
+        unit_test.test_equals(cache.get_mapping_size(32 * MB), 32 * MB, "mapping sizes", "max object size");
+        unit_test.test_equals(cache.get_mapping_size(32 * MB + 1), 32 * MB + 1, "mapping sizes", "bigger than max object size");
+    }
+
+    // REUSE
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        cache.create(options);
+
+        std::size_t mapping_size = cache.get_mapping_size(MB + 100);
+        void* ptr = VirtualMemory::allocate(mapping_size, false);
+
+        unit_test.test_equals(cache.allocate(mapping_size) == nullptr, true, "reuse", "empty cache");
+        unit_test.test_equals(cache.deallocate(ptr, mapping_size), true, "reuse", "cache a mapping");
+        unit_test.test_equals(cache.get_cached_mapping_count(mapping_size), 1, "reuse", "cached mapping count");
+        unit_test.test_equals(cache.allocate(cache.get_mapping_size(MB + 200 * KB)) == ptr, true, "reuse", "mapping reused by a similar size");
+        unit_test.test_equals(cache.get_cached_mapping_count(mapping_size), 0, "reuse", "cached mapping count after reuse");
+        unit_test.test_equals(cache.deallocate(ptr, MB + 100), false, "reuse", "sizes which are not bucket sizes are not cached");
+
+        VirtualMemory::deallocate(ptr, mapping_size);
+    }
+
+    // CAPACITY
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        options.capacity = 2 * MB;
+        options.decay_period = 0;
+        cache.create(options);
+
+        void* ptrs[3];
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            ptrs[i] = VirtualMemory::allocate(MB, false);
+            cache.deallocate(ptrs[i], MB);
+        }
+
+        unit_test.test_equals(cache.get_cached_mapping_count(MB), 2, "capacity", "oldest mapping released");
+        unit_test.test_equals(cache.allocate(MB) == ptrs[2], true, "capacity", "most recent mapping reused first");
+        unit_test.test_equals(cache.allocate(MB) == ptrs[1], true, "capacity", "second most recent mapping");
+        unit_test.test_equals(cache.allocate(MB) == nullptr, true, "capacity", "empty bucket");
+        unit_test.test_equals(cache.deallocate(ptrs[1], 4 * MB), false, "capacity", "mappings bigger than capacity");
+
+        // The budget is shared by all buckets , a mapping which doesn't fit is not cached if its bucket has nothing to release
+        std::size_t other_mapping_size = cache.get_mapping_size(MB + 100);
+        void* other_ptr = VirtualMemory::allocate(other_mapping_size, false);
+
+        unit_test.test_equals(cache.deallocate(ptrs[1], MB), true, "capacity", "cache within capacity");
+        unit_test.test_equals(cache.get_cached_size(), MB, "capacity", "cached size");
+        unit_test.test_equals(cache.deallocate(other_ptr, other_mapping_size), false, "capacity", "capacity is shared by buckets");
+        unit_test.test_equals(cache.get_cached_size(), MB, "capacity", "cached size after a rejected mapping");
+        unit_test.test_equals(cache.release_all_mappings(), MB, "capacity", "release all mappings");
+        unit_test.test_equals(cache.get_cached_size(), 0, "capacity", "cached size after releasing all mappings");
+
+        VirtualMemory::deallocate(other_ptr, other_mapping_size);
+        VirtualMemory::deallocate(ptrs[2], MB);
+    }
+
+    // DECAY
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        options.decay_period = 10;
+        cache.create(options);
+
+        void* ptr = VirtualMemory::allocate(MB, false);
+        cache.deallocate(ptr, MB);
+
+        unit_test.test_equals(cache.get_cached_mapping_count(MB), 1, "decay", "mapping cached");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cache.release_expired_mappings();
+
+        unit_test.test_equals(cache.get_cached_mapping_count(MB), 0, "decay", "expired mapping released");
+        unit_test.test_equals(cache.allocate(MB) == nullptr, true, "decay", "no reuse after decay");
+    }
+
+    // BACKGROUND SWEEPING : Frees don't release expired mappings
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        options.decay_period = 10;
+        options.background_sweeping = true;
+        cache.create(options);
+
+        void* ptr = VirtualMemory::allocate(MB, false);
+        void* other_ptr = VirtualMemory::allocate(MB, false);
+        cache.deallocate(ptr, MB);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cache.deallocate(other_ptr, MB);
+
+        unit_test.test_equals(cache.get_cached_mapping_count(MB), 2, "background sweeping", "expired mapping not released by a free");
+
+        cache.release_expired_mappings();
+        unit_test.test_equals(cache.get_cached_mapping_count(MB), 1, "background sweeping", "expired mapping released by a sweep");
+
+        cache.release_all_mappings();
+    }
+
+    // DISABLED
+    {
+        LargeObjectCache cache;
+        LargeObjectCacheOptions options;
+        options.max_object_size = 0;
+        cache.create(options);
+
+        unit_test.test_equals(cache.get_mapping_size(MB + 1), MB + 1, "disabled", "sizes are not rounded");
+        unit_test.test_equals(cache.deallocate(reinterpret_cast<void*>(4096), MB), false, "disabled", "nothing is cached");
+    }
+
+    ////////////////////////////////////// PRINT THE REPORT
+    std::cout << unit_test.get_summary_report("LargeObjectCache");
+    std::cout.flush();
+
+    #if _WIN32
+    bool pause = true;
+    if(argc > 1)
+    {
+        if (std::strcmp(argv[1], "no_pause") == 0)
+            pause = false;
+    }
+    if(pause)
+        std::system("pause");
+    #endif
+
+    return unit_test.did_all_pass();
+}
\ No newline at end of file
@@ -26,6 +26,12 @@ bool test_exhaustion(std::size_t buffer_size, std::size_t allocation_count, std:
 template <typename LogicalPageType>
 bool test_general(std::size_t buffer_size);
 
+template <typename LogicalPageType>
+void test_remote_frees(std::size_t buffer_size, std::size_t allocation_size);
+
+template <typename LogicalPageType>
+void test_zeroed_chunks(std::size_t buffer_size, std::size_t allocation_size);
+
 bool validate_buffer(void* buffer, std::size_t buffer_size);
 
 int main(int argc, char* argv[])
@@ -50,6 +56,12 @@ int main(int argc, char* argv[])
 
         // GENERAL TESTS
         test_general<LogicalPage>(65536);
+
+        // REMOTE FREES
+        test_remote_frees<LogicalPage>(65536, 128);
+
+        // NEVER USED CHUNKS
+        test_zeroed_chunks<LogicalPage>(65536, 128);
     }
 
     //// PRINT THE REPORT
@@ -83,6 +95,8 @@ bool test_exhaustion(std::size_t buffer_size, std::size_t allocation_count, std:
         return false;
     }
 
+    unit_test.test_equals(true, logical_page.get_head_node() == nullptr, "logical page exhaustion", "Never used chunks are not threaded to the freelist at creation");
+
     std::vector<std::size_t> pointers;
 
     // WE ALLOCATE ALL THE BUFFER
@@ -176,6 +190,47 @@ bool test_general(std::size_t buffer_size)
     return true;
 }
 
+template <typename LogicalPageType>
+void test_zeroed_chunks(std::size_t buffer_size, std::size_t allocation_size)
+{
+    std::string test_category = "zeroed chunks";
+
+    Arena arena;
+    LogicalPageType logical_page;
+
+    // Arena memory comes fresh from the OS
+    bool success = logical_page.create(arena.allocate(buffer_size), buffer_size, static_cast<uint16_t>(allocation_size));
+    unit_test.test_equals(success, true, test_category, "creation");
+
+    std::vector<void*> pointers;
+    bool all_zeroed = true;
+    bool is_zeroed = false;
+
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        auto ptr = logical_page.allocate(allocation_size, is_zeroed);
+
+        if (ptr == nullptr || is_zeroed == false || std::memcmp(ptr, std::string(allocation_size, '\0').data(), allocation_size) != 0)
+        {
+            all_zeroed = false;
+        }
+
+        pointers.push_back(ptr);
+        std::memset(ptr, 0xAB, allocation_size);
+    }
+
+    unit_test.test_equals(all_zeroed, true, test_category, "never used chunks are zeroed");
+
+    logical_page.deallocate(pointers.back());
+    auto recycled_ptr = logical_page.allocate(allocation_size, is_zeroed);
+    unit_test.test_equals(recycled_ptr, pointers.back(), test_category, "recycled chunk");
+    unit_test.test_equals(is_zeroed, false, test_category, "recycled chunk is not reported as zeroed");
+
+    auto never_used_ptr = logical_page.allocate(allocation_size, is_zeroed);
+    unit_test.test_equals(is_zeroed, true, test_category, "never used chunk after a recycled one");
+    LLMALLOC_UNUSED(never_used_ptr);
+}
+
 bool validate_buffer(void* buffer, std::size_t buffer_size)
 {
     char* char_buffer = static_cast<char*>(buffer);
@@ -198,4 +253,71 @@ bool validate_buffer(void* buffer, std::size_t buffer_size)
     }
 
     return true;
+}
+
+template <typename LogicalPageType>
+void test_remote_frees(std::size_t buffer_size, std::size_t allocation_size)
+{
+    std::string test_category = "remote frees";
+
+    Arena arena;
+    ArenaOptions options;
+    options.cache_capacity = buffer_size;
+    options.page_alignment = 65536;
+
+    bool success = arena.create(options);
+    if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return; }
+
+    void* buffer = arena.allocate(buffer_size);
+    LogicalPageType logical_page;
+    success = logical_page.create(buffer, buffer_size, static_cast<uint32_t>(allocation_size));
+    if (!success) { std::cout << "LOGICAL PAGE CREATION FAILED !!!" << std::endl; return; }
+
+    std::vector<void*> pointers;
+
+    while (true)
+    {
+        void* ptr = logical_page.allocate(allocation_size);
+
+        if (ptr == nullptr)
+        {
+            break;
+        }
+
+        pointers.push_back(ptr);
+    }
+
+    unit_test.test_equals(logical_page.reclaim_remote_frees(), false, test_category, "nothing to reclaim");
+
+    constexpr std::size_t thread_count = 4;
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back([&, i]()
+            {
+                for (std::size_t j = i; j < pointers.size(); j += thread_count)
+                {
+                    logical_page.deallocate_remotely(pointers[j]);
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    unit_test.test_equals(logical_page.allocate(allocation_size) == nullptr, true, test_category, "remote frees are not available before reclaim");
+    unit_test.test_equals(logical_page.reclaim_remote_frees(), true, test_category, "reclaim");
+    unit_test.test_equals(logical_page.get_used_size(), 0, test_category, "page is empty after reclaim");
+
+    std::size_t reallocation_count = 0;
+
+    while (logical_page.allocate(allocation_size) != nullptr)
+    {
+        reallocation_count++;
+    }
+
+    unit_test.test_equals(reallocation_count, pointers.size(), test_category, "all chunks are reusable after reclaim");
 }
\ No newline at end of file
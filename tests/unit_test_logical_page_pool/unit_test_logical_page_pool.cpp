@@ -0,0 +1,130 @@
+#include "../unit_test.h" // Always should be the 1st one as it defines UNIT_TEST macro
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "../../include/arena.h"
+#include "../../include/segment.h"
+#include "../../include/logical_page_pool.h"
+
+using namespace std;
+
+UnitTest unit_test;
+
+int main(int argc, char* argv[])
+{
+    constexpr std::size_t PAGE_SIZE = 65536;
+
+    // HYSTERESIS
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = PAGE_SIZE * 8;
+        options.page_alignment = PAGE_SIZE;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        LogicalPagePool pool;
+        success = pool.create(PAGE_SIZE, 4, &arena);
+        if (!success) { std::cout << "POOL CREATION FAILED !!!" << std::endl; return -1; }
+
+        char* pages[5] = {};
+
+        for (std::size_t i = 0; i < 5; i++)
+        {
+            pages[i] = arena.allocate(PAGE_SIZE);
+            pool.add(pages[i]);
+        }
+
+        unit_test.test_equals(pool.get_page_count(), 2, "hysteresis", "older half released when the capacity is exceeded");
+        unit_test.test_equals(pool.get() == pages[4], true, "hysteresis", "most recently added page reused first");
+        unit_test.test_equals(pool.get() == pages[3], true, "hysteresis", "second most recently added page kept");
+        unit_test.test_equals(pool.get() == nullptr, true, "hysteresis", "empty pool");
+
+        LogicalPagePool disabled_pool;
+        success = disabled_pool.create(PAGE_SIZE, 0, &arena);
+        unit_test.test_equals(success && disabled_pool.add(pages[4]) == false, true, "hysteresis", "zero capacity disables pooling");
+
+        arena.release_to_system(pages[3], PAGE_SIZE);
+        arena.release_to_system(pages[4], PAGE_SIZE);
+    }
+
+    // REUSE ACROSS SIZE CLASSES
+    {
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = PAGE_SIZE * 8;
+        options.page_alignment = PAGE_SIZE;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        LogicalPagePool pool;
+        success = pool.create(PAGE_SIZE, 4, &arena);
+        if (!success) { std::cout << "POOL CREATION FAILED !!!" << std::endl; return -1; }
+
+        SegmentCreationParameters params;
+        params.m_logical_page_count = 1;
+        params.m_logical_page_size = PAGE_SIZE;
+        params.m_page_recycling_threshold = 1;
+        params.m_grow_coefficient = 0;
+        params.m_logical_page_pool = &pool;
+
+        Segment<LockPolicy::NO_LOCK> small_segment;
+        params.m_size_class = 2048;
+        success = small_segment.create(arena.allocate(PAGE_SIZE), &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        Segment<LockPolicy::NO_LOCK> large_segment;
+        params.m_size_class = 8192;
+        success = large_segment.create(arena.allocate(PAGE_SIZE), &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        // 31 objects per logical page , the 32nd one grows the segment
+        void* ptrs[32] = {};
+
+        for (std::size_t i = 0; i < 32; i++)
+        {
+            ptrs[i] = small_segment.allocate(2048);
+            std::memset(ptrs[i], 0xAB, 2048);
+        }
+
+        auto grown_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptrs[31], PAGE_SIZE);
+        small_segment.deallocate(ptrs[31]);
+        unit_test.test_equals(pool.get_page_count(), 1, "reuse across size classes", "recycled logical page pooled");
+        unit_test.test_equals(small_segment.get_logical_page_count(), 1, "reuse across size classes", "recycled logical page removed from its segment");
+
+        // 7 objects per logical page , the 8th one grows the segment
+        bool is_zeroed = true;
+        void* ptr = nullptr;
+
+        for (std::size_t i = 0; i < 8; i++)
+        {
+            ptr = large_segment.allocate(8192, &is_zeroed);
+        }
+
+        unit_test.test_equals(Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, PAGE_SIZE) == grown_page, true, "reuse across size classes", "pooled logical page reused by another size class");
+        unit_test.test_equals(pool.get_page_count(), 0, "reuse across size classes", "pooled logical page taken");
+        unit_test.test_equals(grown_page->get_size_class(), 8192, "reuse across size classes", "logical page recreated for the new size class");
+        unit_test.test_equals(grown_page->is_dirty(), true, "reuse across size classes", "logical page built on a pooled page is dirty");
+        unit_test.test_equals(is_zeroed, false, "reuse across size classes", "never used chunks of a dirty page are not reported as zeroed");
+    }
+
+    ////////////////////////////////////// PRINT THE REPORT
+    std::cout << unit_test.get_summary_report("LogicalPagePool");
+    std::cout.flush();
+
+    #if _WIN32
+    bool pause = true;
+    if(argc > 1)
+    {
+        if (std::strcmp(argv[1], "no_pause") == 0)
+            pause = false;
+    }
+    if(pause)
+        std::system("pause");
+    #endif
+
+    return unit_test.did_all_pass();
+}
\ No newline at end of file
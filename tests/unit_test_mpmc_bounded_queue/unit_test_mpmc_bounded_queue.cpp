@@ -2,6 +2,8 @@
 
 #include "../../include/compiler/unused.h"
 #include "../../include/utilities/mpmc_bounded_queue.h"
+#include "../../include/utilities/mpmc_pointer_queue.h"
+#include "../../include/utilities/intrusive_lifo_queue.h"
 
 #include <cstdlib>
 #include <cstring>
@@ -168,6 +170,143 @@ int main(int argc, char* argv[])
         delete consumer_thread;
     }
     
+    // POINTER QUEUE SINGLE THREAD
+    {
+        MPMCPointerQueue<uint64_t, QueueAllocator> q;
+
+        if (q.create(100) == false)
+        {
+            return -1;
+        }
+
+        std::size_t pushed = 0;
+
+        while (q.try_push(static_cast<uint64_t>(pushed + 1)))
+        {
+            pushed++;
+        }
+
+        unit_test.test_equals(pushed, 104, "mpmc_pointer_queue", "capacity rounded up to cache lines");
+
+        uint64_t popped[64];
+        unit_test.test_equals(q.try_pop_batch(popped, 64), 64, "mpmc_pointer_queue", "batch pop");
+
+        bool fifo = true;
+
+        for (std::size_t i = 0; i < 64; i++)
+        {
+            fifo = fifo && popped[i] == i + 1;
+        }
+
+        unit_test.test_equals(fifo, true, "mpmc_pointer_queue", "batch pop order");
+        unit_test.test_equals(q.try_pop_batch(popped, 64), 40, "mpmc_pointer_queue", "partial batch pop");
+        unit_test.test_equals(q.try_pop_batch(popped, 64), 0, "mpmc_pointer_queue", "empty queue");
+    }
+
+    // POINTER QUEUE CONCURRENCY
+    {
+        MPMCPointerQueue<uint64_t, QueueAllocator> q;
+
+        constexpr std::size_t producer_thread_count = 16;
+        constexpr std::size_t consumer_thread_count = 16;
+        constexpr std::size_t production_count_per_producer_thread = 100000;
+
+        if (q.create(1024) == false) // Small so that producers wrap around and see a full queue
+        {
+            return -1;
+        }
+
+        std::atomic<uint64_t> consumed_sum{ 0 };
+        std::atomic<std::size_t> consumed_count{ 0 };
+        std::vector<std::unique_ptr<std::thread>> threads;
+
+        for (std::size_t i{ 0 }; i < producer_thread_count; i++)
+        {
+            threads.emplace_back(new std::thread([&]()
+            {
+                for (std::size_t j = 1; j <= production_count_per_producer_thread; j++)
+                {
+                    while (q.try_push(static_cast<uint64_t>(j)) == false) {}
+                }
+            }));
+        }
+
+        for (std::size_t i{ 0 }; i < consumer_thread_count; i++)
+        {
+            threads.emplace_back(new std::thread([&, i]()
+            {
+                uint64_t popped[16];
+
+                while (consumed_count.load() < producer_thread_count * production_count_per_producer_thread)
+                {
+                    std::size_t count = q.try_pop_batch(popped, 1 + i % 16);
+                    uint64_t sum = 0;
+
+                    for (std::size_t j = 0; j < count; j++)
+                    {
+                        sum += popped[j];
+                    }
+
+                    consumed_sum.fetch_add(sum);
+                    consumed_count.fetch_add(count);
+                }
+            }));
+        }
+
+        for (auto& thread : threads)
+        {
+            thread->join();
+        }
+
+        uint64_t expected_sum = producer_thread_count * (production_count_per_producer_thread * (production_count_per_producer_thread + 1) / 2);
+
+        unit_test.test_equals(consumed_count.load(), producer_thread_count * production_count_per_producer_thread, "mpmc_pointer_queue", "thread safety count");
+        unit_test.test_equals(consumed_sum.load(), expected_sum, "mpmc_pointer_queue", "thread safety sum");
+    }
+
+    // INTRUSIVE LIFO QUEUE , ITEMS ARE LINKED THROUGH THEIR OWN MEMORY
+    {
+        IntrusiveLIFOQueue<uint64_t> q;
+        q.create(0);
+
+        constexpr std::size_t item_count = 100;
+        std::vector<uint64_t> items(item_count); // Each item is 8 bytes of writable memory
+
+        uint64_t item = 0;
+        unit_test.test_equals(q.try_pop(item), false, "intrusive_lifo_queue", "empty queue pop");
+        unit_test.test_equals(q.try_pop_batch(&item, 1), 0, "intrusive_lifo_queue", "empty queue batch pop");
+
+        bool all_pushed = true;
+
+        for (std::size_t i = 0; i < item_count; i++)
+        {
+            all_pushed = all_pushed && q.try_push(reinterpret_cast<uint64_t>(&items[i]));
+        }
+
+        unit_test.test_equals(all_pushed, true, "intrusive_lifo_queue", "push never fails");
+
+        unit_test.test_equals(q.try_pop(item) && item == reinterpret_cast<uint64_t>(&items[item_count - 1]), true, "intrusive_lifo_queue", "pop order");
+
+        uint64_t popped[64];
+        unit_test.test_equals(q.try_pop_batch(popped, 64), 64, "intrusive_lifo_queue", "batch pop");
+
+        bool lifo = true;
+
+        for (std::size_t i = 0; i < 64; i++)
+        {
+            lifo = lifo && popped[i] == reinterpret_cast<uint64_t>(&items[item_count - 2 - i]);
+        }
+
+        unit_test.test_equals(lifo, true, "intrusive_lifo_queue", "batch pop order");
+        unit_test.test_equals(q.try_pop_batch(popped, 64), item_count - 65, "intrusive_lifo_queue", "partial batch pop");
+        unit_test.test_equals(popped[item_count - 66] == reinterpret_cast<uint64_t>(&items[0]), true, "intrusive_lifo_queue", "first pushed item popped last");
+        unit_test.test_equals(q.try_pop(item), false, "intrusive_lifo_queue", "empty queue after pops");
+
+        // Items can be pushed again after they are popped
+        q.try_push(reinterpret_cast<uint64_t>(&items[0]));
+        unit_test.test_equals(q.try_pop(item) && item == reinterpret_cast<uint64_t>(&items[0]), true, "intrusive_lifo_queue", "push after empty");
+    }
+
     ////////////////////////////////////// PRINT THE REPORT
     std::cout << unit_test.get_summary_report("mpmc_bounded_queue");
     std::cout.flush();
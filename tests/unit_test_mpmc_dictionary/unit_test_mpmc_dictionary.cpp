@@ -164,6 +164,159 @@ int main(int argc, char* argv[])
         }
     }
 
+    //////////////////////////////////////////////////////////////
+    // ERASE
+    {
+        HashmapType dict;
+        std::size_t dict_capacity = 655360 / sizeof(typename HashmapType::DictionaryNode);
+
+        if (dict.initialise(dict_capacity) == false)
+        {
+            std::cout << "Dict init failed\n";
+            return -1;
+        }
+
+        for (std::size_t i = 0; i < dict_capacity; i++)
+        {
+            dict.insert(i, { i, i });
+        }
+
+        AllocationMetadata metadata;
+        bool erase_result = dict.erase(7, metadata);
+
+        unit_test.test_equals(erase_result, true, "mpmc dictionary", "erase existing key");
+        unit_test.test_equals(metadata.size, 7, "mpmc dictionary", "erased value");
+        unit_test.test_equals(dict.get(7, metadata), false, "mpmc dictionary", "retrieval of erased key");
+        unit_test.test_equals(dict.erase(7, metadata), false, "mpmc dictionary", "erase erased key");
+        unit_test.test_equals(dict.get(8, metadata), true, "mpmc dictionary", "retrieval of neighbour key after erase");
+
+        // Erase all then insert new keys which will reuse the erased nodes
+        for (std::size_t i = 0; i < dict_capacity; i++)
+        {
+            dict.erase(i, metadata);
+        }
+
+        bool all_found = true;
+
+        for (std::size_t i = dict_capacity; i < dict_capacity * 2; i++)
+        {
+            dict.insert(i, { i, i });
+        }
+
+        for (std::size_t i = 0; i < dict_capacity * 2; i++)
+        {
+            bool expected = i >= dict_capacity;
+
+            if (dict.get(i, metadata) != expected || (expected && metadata.size != i))
+            {
+                all_found = false;
+                break;
+            }
+        }
+
+        unit_test.test_equals(all_found, true, "mpmc dictionary", "retrievals after node recycling");
+
+        // Moving an item to another key
+        auto node = dict.detach(dict_capacity, metadata);
+        unit_test.test_equals(node != nullptr && metadata.size == dict_capacity, true, "mpmc dictionary", "detach existing key");
+        unit_test.test_equals(dict.get(dict_capacity, metadata), false, "mpmc dictionary", "retrieval of detached key");
+        unit_test.test_equals(dict.detach(dict_capacity, metadata) == nullptr, true, "mpmc dictionary", "detach missing key");
+
+        dict.attach(node, 0, { 1, 2 });
+        unit_test.test_equals(dict.get(0, metadata) && metadata.size == 1 && metadata.padding_bytes == 2, true, "mpmc dictionary", "retrieval of attached key");
+    }
+
+    //////////////////////////////////////////////////////////////
+    // MULTI THREADED ERASE : Readers should never miss permanent keys while other nodes are being recycled
+    //                       and should never get a value of another key from a recycled node
+    {
+        HashmapType dict;
+        std::size_t dict_capacity = 1024;
+
+        if (dict.initialise(dict_capacity) == false)
+        {
+            std::cout << "Dict init failed\n";
+            return -1;
+        }
+
+        constexpr std::size_t PERMANENT_KEY_COUNT = 4096;
+        constexpr std::size_t RECYCLED_KEY_COUNT_PER_WRITER = 4096;
+
+        for (std::size_t i = 0; i < PERMANENT_KEY_COUNT; i++)
+        {
+            dict.insert(i, { i, i });
+        }
+
+        std::atomic<bool> exiting = false;
+        std::atomic<bool> missed_key = false;
+        std::atomic<bool> mixed_value = false;
+
+        auto writer_thread_function = [&](std::size_t index)
+            {
+                std::size_t key_base = PERMANENT_KEY_COUNT + index * RECYCLED_KEY_COUNT_PER_WRITER;
+                std::size_t round = 0;
+
+                while (!exiting)
+                {
+                    for (std::size_t i = 0; i < RECYCLED_KEY_COUNT_PER_WRITER; i++)
+                    {
+                        std::size_t key = key_base + ((i + round) % RECYCLED_KEY_COUNT_PER_WRITER);
+                        dict.insert(key, { key, key });
+                    }
+
+                    for (std::size_t i = 0; i < RECYCLED_KEY_COUNT_PER_WRITER; i++)
+                    {
+                        AllocationMetadata metadata;
+                        dict.erase(key_base + i, metadata);
+                    }
+
+                    round++;
+                }
+            };
+
+        auto reader_thread_function = [&]()
+            {
+                while (!exiting)
+                {
+                    for (std::size_t i = 0; i < PERMANENT_KEY_COUNT; i++)
+                    {
+                        AllocationMetadata metadata;
+
+                        if (dict.get(i, metadata) == false || metadata.size != i)
+                        {
+                            missed_key = true;
+                        }
+
+                        std::size_t recycled_key = PERMANENT_KEY_COUNT + i;
+
+                        if (dict.get(recycled_key, metadata) && (metadata.size != recycled_key || metadata.padding_bytes != recycled_key))
+                        {
+                            mixed_value = true;
+                        }
+                    }
+                }
+            };
+
+        std::vector<std::unique_ptr<std::thread>> threads;
+
+        for (std::size_t i = 0; i < 4; i++)
+        {
+            threads.emplace_back(new std::thread(writer_thread_function, i));
+            threads.emplace_back(new std::thread(reader_thread_function));
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        exiting = true;
+
+        for (auto& thread : threads)
+        {
+            thread->join();
+        }
+
+        unit_test.test_equals(missed_key.load(), false, "mpmc dictionary", "concurrent retrievals during node recycling");
+        unit_test.test_equals(mixed_value.load(), false, "mpmc dictionary", "consistent values of recycled nodes");
+    }
+
     ////////////////////////////////////// PRINT THE REPORT
     std::cout << unit_test.get_summary_report("mpmc dictionary");
     std::cout.flush();
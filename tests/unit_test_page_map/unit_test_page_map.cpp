@@ -0,0 +1,113 @@
+#include "../unit_test.h" // Always should be the 1st one as it defines UNIT_TEST macro
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "../../include/arena.h"
+#include "../../include/segment.h"
+#include "../../include/utilities/page_map.h"
+
+using namespace std;
+
+UnitTest unit_test;
+
+int main(int argc, char* argv[])
+{
+    constexpr std::size_t granularity = VirtualMemory::PAGE_ALLOCATION_GRANULARITY;
+    constexpr std::size_t leaf_coverage = PageMapType::LEAF_SIZE * granularity;
+
+    // BASIC SET GET CLEAR
+    {
+        PageMapType page_map;
+        bool success = page_map.initialise();
+        if (!success) { std::cout << "PAGE MAP INITIALISATION FAILED !!!" << std::endl; return -1; }
+
+        void* address = reinterpret_cast<void*>(static_cast<uint64_t>(leaf_coverage * 7));
+
+        unit_test.test_equals(page_map.get(address), 0, "page map", "empty lookup");
+
+        page_map.set(address, granularity * 16, 16);
+
+        unit_test.test_equals(page_map.get(address), 16, "page map", "lookup of first granule");
+        unit_test.test_equals(page_map.get(reinterpret_cast<char*>(address) + granularity * 16 - 1), 16, "page map", "lookup of last byte");
+        unit_test.test_equals(page_map.get(reinterpret_cast<char*>(address) + granularity * 16), 0, "page map", "lookup after range");
+        unit_test.test_equals(page_map.get(reinterpret_cast<char*>(address) - 1), 0, "page map", "lookup before range");
+
+        page_map.clear(address, granularity * 16);
+
+        unit_test.test_equals(page_map.get(address), 0, "page map", "lookup after clear");
+    }
+
+    // RANGE SPANNING 2 LEAVES
+    {
+        PageMapType page_map;
+        bool success = page_map.initialise();
+        if (!success) { std::cout << "PAGE MAP INITIALISATION FAILED !!!" << std::endl; return -1; }
+
+        char* address = reinterpret_cast<char*>(static_cast<uint64_t>(leaf_coverage * 9 - granularity * 2));
+
+        page_map.set(address, granularity * 4, 19);
+
+        unit_test.test_equals(page_map.get(address), 19, "page map", "cross leaf first granule");
+        unit_test.test_equals(page_map.get(address + granularity * 3), 19, "page map", "cross leaf last granule");
+        unit_test.test_equals(page_map.get(address + granularity * 4), 0, "page map", "cross leaf after range");
+    }
+
+    // SEGMENT REGISTRATION
+    {
+        PageMapType page_map;
+        bool success = page_map.initialise();
+        if (!success) { std::cout << "PAGE MAP INITIALISATION FAILED !!!" << std::endl; return -1; }
+
+        Arena arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 32;
+        options.page_alignment = 65536;
+
+        success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return -1; }
+
+        SegmentCreationParameters params;
+        params.m_size_class = 256;
+        params.m_logical_page_size = 65536;
+        params.m_logical_page_count = 2;
+        params.m_page_recycling_threshold = 0;
+        params.m_page_map = &page_map;
+
+        Segment<LockPolicy::NO_LOCK> segment;
+        success = segment.create(arena.allocate(65536 * 2), &arena, params);
+        if (!success) { std::cout << "SEGMENT CREATION FAILED !!!" << std::endl; return -1; }
+
+        void* ptr = segment.allocate(256);
+
+        unit_test.test_equals(page_map.get(ptr), 16, "page map", "segment registered log2 of logical page size");
+
+        auto logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, static_cast<std::size_t>(1) << page_map.get(ptr));
+        void* padded_ptr = reinterpret_cast<char*>(ptr) + 100;
+
+        unit_test.test_equals(logical_page->get_chunk_start_address(padded_ptr) == ptr, true, "page map", "chunk start lookup of a padded pointer");
+
+        segment.deallocate(ptr); // Page recycling threshold is zero so the page will be released
+
+        unit_test.test_equals(page_map.get(ptr), 0, "page map", "recycled logical page unregistered");
+    }
+
+    ////////////////////////////////////// PRINT THE REPORT
+    std::cout << unit_test.get_summary_report("PageMap");
+    std::cout.flush();
+    
+    #if _WIN32
+    bool pause = true;
+    if(argc > 1)
+    {
+        if (std::strcmp(argv[1], "no_pause") == 0)
+            pause = false;
+    }
+    if(pause)
+        std::system("pause");
+    #endif
+
+    return unit_test.did_all_pass();
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "../unit_test.h" // Always should be the 1st one as it defines UNIT_TEST macro
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include "../../include/page_purger.h"
+
+using namespace std;
+
+UnitTest unit_test;
+
+int main(int argc, char* argv[])
+{
+    constexpr std::size_t PAGE_SIZE = 65536;
+
+    // DECAY
+    {
+        PagePurger purger;
+        PagePurgerOptions options;
+        options.decay_period = 50;
+        purger.create(options);
+
+        for (std::size_t i = 0; i < 4; i++)
+        {
+            purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+        }
+
+        unit_test.test_equals(purger.get_pending_size(), 4 * PAGE_SIZE, "decay", "pending size");
+        unit_test.test_equals(purger.purge(), 0, "decay", "pages are not released before the decay period");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        unit_test.test_equals(purger.purge(), 4 * PAGE_SIZE, "decay", "expired pages released");
+        unit_test.test_equals(purger.get_pending_size(), 0, "decay", "pending size after release");
+    }
+
+    // RATE LIMIT
+    {
+        PagePurger purger;
+        PagePurgerOptions options;
+        options.decay_period = 0;
+        options.max_bytes_per_purge = 2 * PAGE_SIZE;
+        purger.create(options);
+
+        for (std::size_t i = 0; i < 5; i++)
+        {
+            purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+        }
+
+        unit_test.test_equals(purger.purge(), 2 * PAGE_SIZE, "rate limit", "first purge limited by the budget");
+        unit_test.test_equals(purger.purge(), 2 * PAGE_SIZE, "rate limit", "second purge limited by the budget");
+        unit_test.test_equals(purger.purge(), PAGE_SIZE, "rate limit", "remaining page");
+        unit_test.test_equals(purger.purge(), 0, "rate limit", "nothing left");
+    }
+
+    // IGNORING DECAY
+    {
+        PagePurger purger;
+        PagePurgerOptions options;
+        options.decay_period = 1000000;
+        options.max_bytes_per_purge = PAGE_SIZE;
+        purger.create(options);
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+        }
+
+        unit_test.test_equals(purger.purge(true), 3 * PAGE_SIZE, "ignoring decay", "all pages released without budget");
+    }
+
+    // MAX PENDING SIZE
+    {
+        PagePurger purger;
+        PagePurgerOptions options;
+        options.decay_period = 1000000;
+        options.max_pending_size = 3 * PAGE_SIZE;
+        purger.create(options);
+
+        for (std::size_t i = 0; i < 3; i++)
+        {
+            purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+        }
+
+        unit_test.test_equals(purger.get_pending_size(), 3 * PAGE_SIZE, "max pending size", "pages within the bound are kept");
+
+        purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+
+        unit_test.test_equals(purger.get_pending_size(), 3 * PAGE_SIZE, "max pending size", "adding thread released the oldest page before its decay");
+        unit_test.test_equals(purger.purge(true), 3 * PAGE_SIZE, "max pending size", "remaining pages");
+    }
+
+    // CONCURRENT ADDS
+    {
+        PagePurger purger;
+        PagePurgerOptions options;
+        options.decay_period = 0;
+        options.max_bytes_per_purge = 0;
+        purger.create(options);
+
+        constexpr std::size_t thread_count = 4;
+        constexpr std::size_t page_count_per_thread = 64;
+        std::size_t released = 0;
+        std::thread threads[thread_count];
+
+        for (std::size_t i = 0; i < thread_count; i++)
+        {
+            threads[i] = std::thread([&purger]()
+            {
+                for (std::size_t j = 0; j < page_count_per_thread; j++)
+                {
+                    purger.add(VirtualMemory::allocate(PAGE_SIZE, false), PAGE_SIZE);
+                }
+            });
+        }
+
+        for (std::size_t i = 0; i < 16; i++)
+        {
+            released += purger.purge();
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        released += purger.purge();
+
+        unit_test.test_equals(released, thread_count * page_count_per_thread * PAGE_SIZE, "concurrent adds", "all pages released");
+    }
+
+    ////////////////////////////////////// PRINT THE REPORT
+    std::cout << unit_test.get_summary_report("PagePurger");
+    std::cout.flush();
+
+    #if _WIN32
+    bool pause = true;
+    if(argc > 1)
+    {
+        if (std::strcmp(argv[1], "no_pause") == 0)
+            pause = false;
+    }
+    if(pause)
+        std::system("pause");
+    #endif
+
+    return unit_test.did_all_pass();
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../llmalloc.h"
 using namespace llmalloc;
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
@@ -113,7 +114,7 @@ int main(int argc, char* argv[])
 
         PerThreadCachingAllocatorType::get_instance().set_thread_local_heap_cache_count(8);
 
-        success = PerThreadCachingAllocatorType::get_instance().create(central_heap_params, local_heap_params, options, 262144);
+        success = PerThreadCachingAllocatorType::get_instance().create(central_heap_params, local_heap_params, options, 524288); // 32 thread local heaps no longer fit in 256KB as remote free notifications and counters grew segments
         
         if (!success) { std::cout << "per thread caching allocator creation failed !!!" << std::endl; return -1; }
 
@@ -209,6 +210,445 @@ int main(int argc, char* argv[])
         unit_test.test_equals(PerThreadCachingAllocatorType::get_instance().get_observed_unique_thread_count(), thread_count, "scalable allocator", "per thread caching - observed unique thread count");
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // BATCH ALLOCATIONS AND DEALLOCATIONS , HALF OF THEM FROM ANOTHER THREAD
+    {
+        constexpr std::size_t batch_size = 512;
+        constexpr std::size_t allocation_size = 128;
+        std::array<void*, batch_size> ptrs{};
+
+        auto allocated = PerThreadCachingAllocatorType::get_instance().allocate_batch(allocation_size, batch_size, ptrs.data());
+        unit_test.test_equals(allocated, batch_size, "scalable allocator", "batch allocation count");
+
+        bool all_valid = true;
+
+        for (std::size_t i = 0; i < allocated; i++)
+        {
+            if (ptrs[i] == nullptr || validate_buffer(ptrs[i], allocation_size) == false)
+            {
+                all_valid = false;
+            }
+        }
+
+        unit_test.test_equals(all_valid, true, "scalable allocator", "batch allocation buffer validation");
+
+        std::thread remote_thread([&]()
+        {
+            PerThreadCachingAllocatorType::get_instance().deallocate_batch(ptrs.data(), batch_size / 2);
+        });
+        remote_thread.join();
+
+        PerThreadCachingAllocatorType::get_instance().deallocate_batch(ptrs.data() + batch_size / 2, batch_size / 2);
+
+        allocated = PerThreadCachingAllocatorType::get_instance().allocate_batch(allocation_size, batch_size, ptrs.data());
+        unit_test.test_equals(allocated, batch_size, "scalable allocator", "batch allocation count after batch deallocation");
+
+        PerThreadCachingAllocatorType::get_instance().deallocate_batch(ptrs.data(), allocated);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // TRIM AND HEAP USAGE
+    {
+        constexpr std::size_t allocation_count = 4096;
+        constexpr std::size_t allocation_size = 256;
+        std::vector<void*> ptrs(allocation_count, nullptr);
+        auto& allocator = PerThreadCachingAllocatorType::get_instance();
+
+        std::size_t used_size{ 0 };
+        std::size_t pooled_size{ 0 };
+        std::size_t initial_used_size{ 0 };
+
+        allocator.get_heap_usage(initial_used_size, pooled_size); // Previous tests left chunks in queues of exited threads' heaps
+
+        for (auto& ptr : ptrs) { ptr = allocator.allocate(allocation_size); }
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size >= initial_used_size + allocation_count * allocation_size, true, "scalable allocator", "used size of the own heap");
+
+        for (auto& ptr : ptrs) { allocator.deallocate(ptr); }
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size, initial_used_size, "scalable allocator", "chunks in deallocation queues are not counted as used");
+
+        auto allocated_size_before_trim = allocator.get_arena()->get_allocated_size();
+        allocator.trim();
+        unit_test.test_equals(allocator.get_arena()->get_allocated_size() < allocated_size_before_trim, true, "scalable allocator", "trim releases empty logical pages of the own heap");
+
+        // Heaps of exited threads are measured and trimmed directly
+        std::thread([&]() { for (auto& ptr : ptrs) { ptr = allocator.allocate(allocation_size); } }).join();
+
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size >= initial_used_size + allocation_count * allocation_size, true, "scalable allocator", "used size of an exited thread's heap");
+
+        for (auto& ptr : ptrs) { allocator.deallocate(ptr); } // Cross thread frees
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size, initial_used_size, "scalable allocator", "cross thread frees to an exited thread's heap are not counted as used");
+
+        allocated_size_before_trim = allocator.get_arena()->get_allocated_size();
+        allocator.trim();
+        unit_test.test_equals(allocator.get_arena()->get_allocated_size() < allocated_size_before_trim, true, "scalable allocator", "trim releases empty logical pages of an exited thread's heap");
+
+        #ifdef ENABLE_EXTERNAL_HEAP_ACCESS
+        // Heaps of idle threads are measured and trimmed without their cooperation
+        std::atomic<int> stage{ 0 };
+
+        std::thread other_thread([&]()
+        {
+            for (auto& ptr : ptrs) { ptr = allocator.allocate(allocation_size); }
+            stage.store(1);
+            while (stage.load() != 2) { std::this_thread::yield(); }
+        });
+
+        while (stage.load() != 1) { std::this_thread::yield(); }
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size >= initial_used_size + allocation_count * allocation_size, true, "scalable allocator", "used size of an idle thread's heap in the first query");
+
+        for (auto& ptr : ptrs) { allocator.deallocate(ptr); } // Cross thread frees
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size, initial_used_size, "scalable allocator", "cross thread frees to an idle thread's heap are not counted as used");
+
+        allocated_size_before_trim = allocator.get_arena()->get_allocated_size();
+        allocator.trim();
+        unit_test.test_equals(allocator.get_arena()->get_allocated_size() < allocated_size_before_trim, true, "scalable allocator", "trim releases empty logical pages of an idle thread's heap");
+
+        stage.store(2);
+        other_thread.join();
+        #endif
+
+        // Queries and trims while another thread is calling the allocator
+        std::atomic<bool> done{ false };
+
+        std::thread busy_thread([&]()
+        {
+            std::vector<void*> local_ptrs(allocation_count, nullptr);
+
+            while (done.load() == false)
+            {
+                for (auto& ptr : local_ptrs) { ptr = allocator.allocate(allocation_size); std::memset(ptr, 0xFF, allocation_size); }
+                for (auto& ptr : local_ptrs) { allocator.deallocate(ptr); }
+            }
+        });
+
+        for (std::size_t i = 0; i < 256; i++)
+        {
+            allocator.get_heap_usage(used_size, pooled_size);
+            allocator.trim();
+        }
+
+        done.store(true);
+        busy_thread.join();
+
+        allocator.get_heap_usage(used_size, pooled_size);
+        unit_test.test_equals(used_size, initial_used_size, "scalable allocator", "used size after concurrent queries and trims");
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // STATS , built by unit_test_scalable_allocator_with_stats
+    #ifdef ENABLE_STATS
+    {
+        constexpr std::size_t allocation_count = 1024;
+        constexpr std::size_t allocation_size = 64;
+        std::vector<void*> ptrs(allocation_count, nullptr);
+        auto& allocator = PerThreadCachingAllocatorType::get_instance();
+        auto bin_index = LocalHeapType::SizeClassesType::get_bin_index(allocation_size);
+
+        PerThreadCachingAllocatorType::Stats before;
+        PerThreadCachingAllocatorType::Stats after;
+
+        allocator.get_stats(before);
+        for (auto& ptr : ptrs) { ptr = allocator.allocate(allocation_size); }
+        for (auto& ptr : ptrs) { allocator.deallocate(ptr); }
+        allocator.get_stats(after);
+
+        unit_test.test_equals(after.bins[bin_index].allocation_count - before.bins[bin_index].allocation_count, allocation_count, "scalable allocator", "stats allocation count");
+        unit_test.test_equals(after.bins[bin_index].deallocation_count - before.bins[bin_index].deallocation_count, allocation_count, "scalable allocator", "stats deallocation count");
+        unit_test.test_equals(after.bins[bin_index].resident_size >= allocation_count * allocation_size, true, "scalable allocator", "stats resident size of the own heap");
+        unit_test.test_equals(after.bins[bin_index].virtual_size >= after.bins[bin_index].resident_size, true, "scalable allocator", "stats virtual size covers resident size");
+
+        // Chunks allocated by another thread and freed here
+        std::thread other_thread([&]() { for (auto& ptr : ptrs) { ptr = allocator.allocate(allocation_size); } });
+        other_thread.join();
+
+        allocator.get_stats(before);
+        for (auto& ptr : ptrs) { allocator.deallocate(ptr); }
+        allocator.get_stats(after);
+
+        unit_test.test_equals(after.bins[bin_index].cross_thread_deallocation_count - before.bins[bin_index].cross_thread_deallocation_count, allocation_count, "scalable allocator", "stats cross thread deallocation count");
+        unit_test.test_equals(after.bins[bin_index].deallocation_count - before.bins[bin_index].deallocation_count, 0, "scalable allocator", "stats cross thread frees are not counted as own frees");
+
+        // Failed allocations are counted by the heap which serves them instead , ex: the central heap
+        Arena arena;
+        ArenaOptions arena_options;
+        arena_options.cache_capacity = 6553600;
+        arena_options.page_alignment = 65536;
+        bool arena_created = arena.create(arena_options);
+
+        LocalHeapType heap;
+        typename LocalHeapType::HeapCreationParams heap_params;
+        heap_params.segments_can_grow = false;
+        bool heap_created = arena_created && heap.create(heap_params, &arena);
+        unit_test.test_equals(heap_created, true, "scalable allocator", "non growing heap creation");
+
+        std::size_t successful_count{ 0 };
+        std::size_t failed_count{ 0 };
+
+        while (failed_count < 4 && successful_count < 1048576)
+        {
+            if (heap.allocate(allocation_size) != nullptr) { successful_count++; } else { failed_count++; }
+        }
+
+        BinStats heap_stats;
+        heap.add_bin_stats(bin_index, heap_stats);
+        unit_test.test_equals(heap_stats.allocation_count, successful_count, "scalable allocator", "stats allocation count excludes failed allocations");
+
+        heap.count_central_heap_fallbacks(failed_count);
+        unit_test.test_equals(heap.get_central_heap_fallback_count(), failed_count, "scalable allocator", "stats central heap fallbacks are counted by the local heap");
+    }
+    #endif
+
+    ////////////////////////////////////////////////////////////////////////////
+    // LARGE OBJECT REALLOCATIONS , MREMAP ON LINUX AND COPYING ELSEWHERE
+    {
+        auto& scalable_malloc = ScalableMalloc::get_instance();
+        bool created = scalable_malloc.create();
+        unit_test.test_equals(created, true, "scalable allocator", "scalable malloc creation");
+
+        auto pattern_matches = [](void* ptr, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; i += 4096)
+            {
+                if (static_cast<char*>(ptr)[i] != static_cast<char>(i / 4096)) { return false; }
+            }
+
+            return true;
+        };
+
+        auto write_pattern = [](void* ptr, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; i += 4096) { static_cast<char*>(ptr)[i] = static_cast<char>(i / 4096); }
+        };
+
+        constexpr std::size_t large_size = 1024 * 1024;
+        void* ptr = scalable_malloc.allocate(large_size);
+        write_pattern(ptr, large_size);
+
+        void* grown_ptr = scalable_malloc.reallocate(ptr, large_size * 8);
+        unit_test.test_equals(grown_ptr != nullptr && pattern_matches(grown_ptr, large_size), true, "scalable allocator", "large object reallocation grow keeps contents");
+        unit_test.test_equals(scalable_malloc.get_usable_size(grown_ptr) >= large_size * 8, true, "scalable allocator", "usable size of a grown large object");
+        write_pattern(grown_ptr, large_size * 8);
+
+        void* shrunk_ptr = scalable_malloc.reallocate(grown_ptr, large_size * 2);
+        unit_test.test_equals(shrunk_ptr != nullptr && pattern_matches(shrunk_ptr, large_size * 2), true, "scalable allocator", "large object reallocation shrink keeps contents");
+        unit_test.test_equals(scalable_malloc.get_usable_size(shrunk_ptr) >= large_size * 2, true, "scalable allocator", "usable size of a shrunk large object");
+
+        void* same_mapping_ptr = scalable_malloc.reallocate(shrunk_ptr, large_size * 2 - 64);
+        unit_test.test_equals(same_mapping_ptr != nullptr && pattern_matches(same_mapping_ptr, large_size * 2 - 64), true, "scalable allocator", "large object reallocation within its mapping keeps contents");
+
+        #ifdef __linux__
+        // mremap never moves shrinking mappings
+        unit_test.test_equals(shrunk_ptr == grown_ptr, true, "scalable allocator", "large object shrink is in place");
+        unit_test.test_equals(same_mapping_ptr == shrunk_ptr, true, "scalable allocator", "large object reallocation within its mapping is in place");
+        #endif
+
+        scalable_malloc.deallocate(same_mapping_ptr);
+
+        // Resized mappings are released and remapped concurrently , entries of other threads' objects should stay intact
+        std::atomic<bool> all_valid{ true };
+        std::vector<std::thread> threads;
+
+        for (std::size_t t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (std::size_t i = 0; i < 256; i++)
+                {
+                    std::size_t size = large_size / 2 + (t * 64 + i) * 4096;
+                    void* p = scalable_malloc.allocate(size);
+                    write_pattern(p, size);
+
+                    p = scalable_malloc.reallocate(p, size * 3);
+                    if (p == nullptr || pattern_matches(p, size) == false || scalable_malloc.get_usable_size(p) < size * 3) { all_valid = false; break; }
+                    write_pattern(p, size * 3);
+
+                    p = scalable_malloc.reallocate(p, size);
+                    if (p == nullptr || pattern_matches(p, size) == false || scalable_malloc.get_usable_size(p) < size) { all_valid = false; break; }
+
+                    scalable_malloc.deallocate(p);
+                }
+            });
+        }
+
+        for (auto& thread : threads) { thread.join(); }
+        unit_test.test_equals(all_valid.load(), true, "scalable allocator", "concurrent large object reallocations");
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // SMALL AND MEDIUM OBJECT REALLOCATIONS , IN PLACE WITHIN CHUNK CAPACITIES AND SHRINK TO FIT BELOW THE RATIO
+    {
+        auto& scalable_malloc = ScalableMalloc::get_instance(); // Created by the previous test with the default shrink ratio , 0.5
+        using SizeClasses = ScalableMalloc::LocalHeapType::SizeClassesType;
+
+        constexpr std::size_t requested_size = 100;
+        #ifdef USE_ALLOC_HEADERS
+        std::size_t expected_usable_size = SizeClasses::get_size_class(SizeClasses::get_bin_index(requested_size + sizeof(AllocationMetadata))) - sizeof(AllocationMetadata);
+        #else
+        std::size_t expected_usable_size = SizeClasses::get_size_class(SizeClasses::get_bin_index(requested_size));
+        #endif
+
+        void* ptr = scalable_malloc.allocate(requested_size);
+        unit_test.test_equals(scalable_malloc.get_usable_size(ptr), expected_usable_size, "scalable allocator", "usable size is the chunk capacity");
+
+        std::memset(ptr, 0x5A, requested_size);
+        void* grown_ptr = scalable_malloc.reallocate(ptr, expected_usable_size);
+        unit_test.test_equals(grown_ptr, ptr, "scalable allocator", "growing within the chunk capacity is in place");
+
+        void* slightly_shrunk_ptr = scalable_malloc.reallocate(grown_ptr, expected_usable_size * 3 / 4);
+        unit_test.test_equals(slightly_shrunk_ptr, ptr, "scalable allocator", "shrinking above the shrink ratio is in place");
+
+        void* shrunk_ptr = scalable_malloc.reallocate(slightly_shrunk_ptr, expected_usable_size / 4);
+        unit_test.test_equals(shrunk_ptr != ptr, true, "scalable allocator", "shrinking below the shrink ratio moves to a smaller chunk");
+        unit_test.test_equals(scalable_malloc.get_usable_size(shrunk_ptr) < expected_usable_size, true, "scalable allocator", "usable size after shrink to fit");
+
+        bool contents_kept = true;
+        for (std::size_t i = 0; i < expected_usable_size / 4; i++) { if (static_cast<unsigned char*>(shrunk_ptr)[i] != 0x5A) { contents_kept = false; } }
+        unit_test.test_equals(contents_kept, true, "scalable allocator", "shrink to fit keeps contents");
+
+        scalable_malloc.deallocate(shrunk_ptr);
+
+        // Medium objects and padded aligned objects
+        constexpr std::size_t medium_size = 100000;
+        void* medium_ptr = scalable_malloc.allocate(medium_size);
+        unit_test.test_equals(scalable_malloc.get_usable_size(medium_ptr) >= medium_size && scalable_malloc.reallocate(medium_ptr, scalable_malloc.get_usable_size(medium_ptr)) == medium_ptr, true, "scalable allocator", "medium object grows within its chunk");
+        scalable_malloc.deallocate(medium_ptr);
+
+        // Shrinking a medium object to a small size should move it as free_sized would look for it in a small object page
+        std::size_t max_small_object_size = ScalableMalloc::LocalHeapType::get_max_small_object_size();
+        #ifdef USE_ALLOC_HEADERS
+        std::size_t small_size = max_small_object_size - sizeof(AllocationMetadata);
+        #else
+        std::size_t small_size = max_small_object_size;
+        #endif
+        void* crossing_ptr = scalable_malloc.allocate(max_small_object_size + 1);
+        void* reallocated_crossing_ptr = scalable_malloc.reallocate(crossing_ptr, small_size);
+        unit_test.test_equals(reallocated_crossing_ptr != crossing_ptr, true, "scalable allocator", "shrinking a medium object to a small size moves it");
+        scalable_malloc.deallocate_sized(reallocated_crossing_ptr, small_size);
+
+        crossing_ptr = scalable_malloc.allocate_aligned(max_small_object_size + 1, 16);
+        reallocated_crossing_ptr = scalable_malloc.aligned_reallocate(crossing_ptr, small_size, 16);
+        unit_test.test_equals(reallocated_crossing_ptr != crossing_ptr, true, "scalable allocator", "aligned shrinking of a medium object to a small size moves it");
+        scalable_malloc.deallocate_sized(reallocated_crossing_ptr, small_size);
+
+        void* aligned_ptr = scalable_malloc.allocate_aligned(requested_size, 256);
+        unit_test.test_equals(reinterpret_cast<uint64_t>(aligned_ptr) % 256 == 0 && scalable_malloc.get_usable_size(aligned_ptr) >= requested_size, true, "scalable allocator", "usable size of an aligned object");
+        scalable_malloc.deallocate(aligned_ptr);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // SCALABLE POOL , OBJECTS FREED BY THEIR OWN AND BY OTHER THREADS
+    {
+        struct PoolObject { uint64_t values[6]; };
+
+        ScalablePoolOptions pool_options;
+        pool_options.arena_initial_size = 1024 * 1024 * 8;
+        pool_options.central_pool_initial_size = 1024 * 1024;
+        pool_options.local_pool_initial_size = 1024 * 1024;
+        pool_options.thread_local_cached_heap_count = 4;
+
+        ScalablePool<PoolObject> pool;
+        bool created = pool.create(pool_options);
+        unit_test.test_equals(created, true, "scalable pool", "creation");
+
+        constexpr std::size_t thread_count = 4;
+        constexpr std::size_t object_count_per_thread = 4096;
+        std::vector<std::vector<PoolObject*>> objects(thread_count, std::vector<PoolObject*>(object_count_per_thread, nullptr));
+        std::atomic<std::size_t> failure_count{ 0 };
+        std::vector<std::thread> threads;
+
+        for (std::size_t i = 0; i < thread_count; i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                for (std::size_t j = 0; j < object_count_per_thread; j++)
+                {
+                    objects[i][j] = static_cast<PoolObject*>(pool.allocate());
+
+                    if (objects[i][j] == nullptr) { failure_count++; continue; }
+
+                    for (auto& value : objects[i][j]->values) { value = i * object_count_per_thread + j; }
+                }
+
+                // Frees half of its own objects , the other half is freed by the main thread
+                for (std::size_t j = 0; j < object_count_per_thread / 2; j++)
+                {
+                    pool.deallocate(objects[i][j]);
+                }
+            });
+        }
+
+        for (auto& thread : threads) { thread.join(); }
+
+        unit_test.test_equals(failure_count.load(), 0, "scalable pool", "allocations from multiple threads");
+
+        bool contents_intact = true;
+
+        for (std::size_t i = 0; i < thread_count; i++)
+        {
+            for (std::size_t j = object_count_per_thread / 2; j < object_count_per_thread; j++)
+            {
+                for (auto& value : objects[i][j]->values) { if (value != i * object_count_per_thread + j) { contents_intact = false; } }
+                pool.deallocate(objects[i][j]);
+            }
+        }
+
+        unit_test.test_equals(contents_intact, true, "scalable pool", "objects don't overlap");
+
+        PoolObject* object = static_cast<PoolObject*>(pool.allocate());
+        unit_test.test_equals(object != nullptr, true, "scalable pool", "allocation after cross thread frees");
+        pool.deallocate(object);
+
+        // BATCH
+        constexpr std::size_t batch_size = 1000;
+        std::vector<void*> batch(batch_size, nullptr);
+
+        std::size_t allocated = pool.allocate_batch(batch_size, batch.data());
+        unit_test.test_equals(allocated, batch_size, "scalable pool", "allocate_batch count");
+
+        for (std::size_t i = 0; i < allocated; i++)
+        {
+            std::memset(batch[i], static_cast<int>(i & 0xFF), sizeof(PoolObject));
+        }
+
+        bool batch_contents_intact = true;
+
+        for (std::size_t i = 0; i < allocated; i++)
+        {
+            auto bytes = static_cast<unsigned char*>(batch[i]);
+            for (std::size_t j = 0; j < sizeof(PoolObject); j++) { if (bytes[j] != (i & 0xFF)) { batch_contents_intact = false; } }
+        }
+
+        unit_test.test_equals(batch_contents_intact, true, "scalable pool", "allocate_batch pointers are writable");
+
+        std::vector<void*> sorted_batch(batch.begin(), batch.begin() + allocated);
+        std::sort(sorted_batch.begin(), sorted_batch.end());
+        unit_test.test_equals(std::adjacent_find(sorted_batch.begin(), sorted_batch.end()) == sorted_batch.end(), true, "scalable pool", "allocate_batch pointers are distinct");
+
+        pool.deallocate_batch(batch.data(), allocated);
+
+        std::vector<void*> second_batch(batch_size, nullptr);
+        std::size_t reallocated = pool.allocate_batch(batch_size, second_batch.data());
+        unit_test.test_equals(reallocated, batch_size, "scalable pool", "allocate_batch after deallocate_batch");
+
+        std::sort(second_batch.begin(), second_batch.end());
+        std::size_t recycled_count = 0;
+
+        for (auto ptr : second_batch)
+        {
+            if (std::binary_search(sorted_batch.begin(), sorted_batch.end(), ptr)) { recycled_count++; }
+        }
+
+        unit_test.test_equals(recycled_count > 0, true, "scalable pool", "deallocate_batch returns objects for reuse");
+
+        pool.deallocate_batch(second_batch.data(), reallocated);
+    }
+
     ////////////////////////////////////// PRINT THE REPORT
     std::cout << unit_test.get_summary_report("ScalableAllocator");
     std::cout.flush();
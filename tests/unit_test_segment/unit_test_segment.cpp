@@ -7,6 +7,7 @@
 #include <cstring>
 #include <cstddef>
 #include <cstdlib>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -133,6 +134,220 @@ int main(int argc, char* argv[])
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    // BATCH ALLOCATIONS
+    {
+        Arena  arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 10;
+        options.page_alignment = 65536;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return false; }
+
+        Segment<LockPolicy::NO_LOCK> segment;
+
+        char* initial_buffer = static_cast <char*>(arena.allocate(65536));
+
+        SegmentCreationParameters params;
+        params.m_size_class = 2048;
+        params.m_logical_page_count = 1;
+        params.m_logical_page_size = 65536;
+        params.m_page_recycling_threshold = 1;
+        params.m_grow_coefficient = 0;
+
+        success = segment.create(initial_buffer, &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        // 31 objects per logical page , a batch of 70 should span 3 logical pages
+        void* ptrs[70] = {};
+        auto allocated = segment.allocate_batch(2048, 70, ptrs);
+        unit_test.test_equals(allocated, 70, "segment batch", "allocation count");
+        unit_test.test_equals(segment.get_logical_page_count(), 3, "segment batch", "logical page count after grow");
+
+        bool all_valid = true;
+
+        for (std::size_t i = 0; i < allocated; i++)
+        {
+            if (ptrs[i] == nullptr || validate_buffer(ptrs[i], 2048) == false)
+            {
+                all_valid = false;
+            }
+        }
+
+        unit_test.test_equals(all_valid, true, "segment batch", "buffer validation");
+
+        for (std::size_t i = 0; i < allocated; i++)
+        {
+            segment.deallocate(ptrs[i]);
+        }
+
+        unit_test.test_equals(segment.get_logical_page_count(), 1, "segment batch", "logical page count after recycling");
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // FULL LOGICAL PAGES ARE KEPT AT THE TAIL
+    {
+        Arena  arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 10;
+        options.page_alignment = 65536;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return false; }
+
+        Segment<LockPolicy::NO_LOCK> segment;
+
+        char* initial_buffer = static_cast <char*>(arena.allocate(65536));
+
+        SegmentCreationParameters params;
+        params.m_size_class = 2048;
+        params.m_logical_page_count = 1;
+        params.m_logical_page_size = 65536;
+        params.m_page_recycling_threshold = 8;
+        params.m_grow_coefficient = 0;
+
+        success = segment.create(initial_buffer, &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        // 31 objects per logical page , fills 3 logical pages
+        void* ptrs[93] = {};
+
+        for (std::size_t i = 0; i < 93; i++)
+        {
+            ptrs[i] = segment.allocate(2048);
+        }
+
+        unit_test.test_equals(segment.get_logical_page_count(), 3, "segment available pages", "logical page count");
+
+        auto first_logical_page = Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptrs[0], 65536);
+        unit_test.test_equals(first_logical_page->is_full(), true, "segment available pages", "exhausted logical page is marked as full");
+        unit_test.test_equals(segment.get_head_logical_page() != first_logical_page, true, "segment available pages", "exhausted logical page is not at the head");
+
+        segment.deallocate(ptrs[5]);
+        unit_test.test_equals(segment.get_head_logical_page() == first_logical_page, true, "segment available pages", "logical page moved to the head after deallocation");
+        unit_test.test_equals(first_logical_page->is_full(), false, "segment available pages", "logical page no longer marked as full");
+
+        ptrs[5] = segment.allocate(2048);
+        unit_test.test_equals(Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptrs[5], 65536) == first_logical_page, true, "segment available pages", "allocation from the head");
+
+        // The head becomes full again , the next allocation should grow rather than reusing a full page
+        auto ptr = segment.allocate(2048);
+        unit_test.test_equals(ptr != nullptr, true, "segment available pages", "allocation after all logical pages are full");
+        unit_test.test_equals(segment.get_logical_page_count(), 4, "segment available pages", "grow when all logical pages are full");
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // CACHE COLORING
+    {
+        Arena  arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 10;
+        options.page_alignment = 65536;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return false; }
+
+        Segment<LockPolicy::NO_LOCK> segment;
+
+        char* initial_buffer = static_cast <char*>(arena.allocate(65536 * 5));
+
+        SegmentCreationParameters params;
+        params.m_size_class = 2048;
+        params.m_logical_page_count = 5;
+        params.m_logical_page_size = 65536;
+        params.m_page_recycling_threshold = 8;
+        params.m_cache_color_count = 4;
+
+        success = segment.create(initial_buffer, &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        // Chunks of the nth logical page start (n % 4) cache lines after the header
+        bool offsets_staggered = true;
+        auto iter = segment.get_head_logical_page();
+
+        for (std::size_t i = 0; i < 5; i++)
+        {
+            void* ptr = iter->allocate(2048);
+            std::size_t chunk_offset = reinterpret_cast<std::size_t>(ptr) - reinterpret_cast<std::size_t>(iter) - sizeof(LogicalPageHeader);
+
+            if (chunk_offset % 2048 != (i % 4) * 64)
+            {
+                offsets_staggered = false;
+            }
+
+            unit_test.test_equals(Segment<LockPolicy::NO_LOCK>::get_logical_page_from_address(ptr, 65536) == iter, true, "segment cache coloring", "logical page lookup of a colored chunk " + std::to_string(i));
+
+            iter->deallocate(ptr);
+            iter = reinterpret_cast<LogicalPage*>(iter->get_next_logical_page());
+        }
+
+        unit_test.test_equals(offsets_staggered, true, "segment cache coloring", "chunk start offsets are staggered");
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // REMOTE FREE NOTIFICATIONS
+    {
+        Arena  arena;
+        ArenaOptions options;
+        options.cache_capacity = 65536 * 20;
+        options.page_alignment = 65536;
+        bool success = arena.create(options);
+        if (!success) { std::cout << "ARENA CREATION FAILED !!!" << std::endl; return false; }
+
+        using SegmentType = Segment<LockPolicy::NO_LOCK>;
+        SegmentType segment;
+
+        constexpr std::size_t logical_page_count = RemoteFreeNotifications::CAPACITY + 2;
+        constexpr std::size_t chunk_count = logical_page_count * 31; // 31 objects per logical page
+        char* initial_buffer = static_cast <char*>(arena.allocate(65536 * logical_page_count));
+
+        SegmentCreationParameters params;
+        params.m_size_class = 2048;
+        params.m_logical_page_count = logical_page_count;
+        params.m_logical_page_size = 65536;
+        params.m_page_recycling_threshold = 32;
+        params.m_grow_coefficient = 0;
+
+        success = segment.create(initial_buffer, &arena, params);
+        if (!success) { std::cout << "Segment creation failed"; return -1; }
+
+        std::vector<void*> ptrs(chunk_count, nullptr);
+
+        for (std::size_t i = 0; i < chunk_count; i++)
+        {
+            ptrs[i] = segment.allocate(2048);
+        }
+
+        // A single notified logical page
+        std::thread([&]() { SegmentType::deallocate_remotely(SegmentType::get_logical_page_from_address(ptrs[0], 65536), ptrs[0], ptrs[0]); }).join();
+
+        unit_test.test_equals(segment.allocate(2048) == ptrs[0], true, "segment remote free notifications", "notified full logical page is reclaimed");
+        unit_test.test_equals(segment.get_logical_page_count(), logical_page_count, "segment remote free notifications", "no grow after reclaiming a notified logical page");
+
+        // More notified logical pages than the capacity , the segment falls back to searching all logical pages
+        std::thread([&]()
+        {
+            for (std::size_t i = 0; i < logical_page_count; i++)
+            {
+                void* ptr = ptrs[i * 31 + 1];
+                SegmentType::deallocate_remotely(SegmentType::get_logical_page_from_address(ptr, 65536), ptr, ptr);
+            }
+        }).join();
+
+        std::size_t reused_count = 0;
+
+        for (std::size_t i = 0; i < logical_page_count; i++)
+        {
+            void* ptr = segment.allocate(2048);
+
+            for (std::size_t j = 0; j < logical_page_count; j++)
+            {
+                if (ptr == ptrs[j * 31 + 1]) { reused_count++; }
+            }
+        }
+
+        unit_test.test_equals(reused_count, logical_page_count, "segment remote free notifications", "all logical pages are reclaimed after dropped notifications");
+        unit_test.test_equals(segment.get_logical_page_count(), logical_page_count, "segment remote free notifications", "no grow after dropped notifications");
+    }
+
     ////////////////////////////////////// PRINT THE REPORT
     std::cout << unit_test.get_summary_report("Segment");
     std::cout.flush();
@@ -0,0 +1,195 @@
+#include "../unit_test.h" // Always should be the 1st one as it defines UNIT_TEST macro
+
+#include "../../include/arena.h"
+#include "../../include/size_classes.h"
+#include "../../include/heap_pow2.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+UnitTest unit_test;
+
+// Every size should map to the smallest size class that can hold it
+template <typename SizeClasses>
+bool validate_size_class_mapping()
+{
+    for (std::size_t size = 0; size <= SizeClasses::LARGEST_SIZE_CLASS; size++)
+    {
+        auto bin_index = SizeClasses::get_bin_index(size);
+        auto size_class = SizeClasses::get_size_class(bin_index);
+
+        if (size_class < size || (bin_index > 0 && SizeClasses::get_size_class(bin_index - 1) >= size))
+        {
+            std::cout << "Wrong mapping for size " << size << " : " << size_class << "\n";
+            return false;
+        }
+
+        if (SizeClasses::get_bin_index_from_size_class(size_class) != bin_index)
+        {
+            std::cout << "Wrong mapping for size class " << size_class << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Bins of a group should share its value without exceeding it , unless the value is smaller than the bin count as every bin gets at least 1
+template <typename HeapType>
+bool validate_bin_shares(std::size_t group_value)
+{
+    using SizeClasses = typename HeapType::SizeClassesType;
+
+    std::size_t group_values[SizeClasses::GROUP_COUNT];
+
+    for (std::size_t i = 0; i < SizeClasses::GROUP_COUNT; i++)
+    {
+        group_values[i] = group_value;
+    }
+
+    std::size_t group_sums[SizeClasses::GROUP_COUNT] = {};
+
+    for (std::size_t i = 0; i < HeapType::BIN_COUNT; i++)
+    {
+        auto share = HeapType::get_bin_share(group_values, i);
+        auto group_bin_count = SizeClasses::get_group_bin_count(SizeClasses::get_group_index(i));
+
+        if (share < 1 || share > (group_value + group_bin_count - 1) / group_bin_count)
+        {
+            std::cout << "Wrong share for bin " << i << " : " << share << "\n";
+            return false;
+        }
+
+        group_sums[SizeClasses::get_group_index(i)] += share;
+    }
+
+    for (std::size_t i = 0; i < SizeClasses::GROUP_COUNT; i++)
+    {
+        auto group_bin_count = SizeClasses::get_group_bin_count(i);
+
+        if (group_sums[i] != (group_value > group_bin_count ? group_value : group_bin_count))
+        {
+            std::cout << "Wrong share sum for group " << i << " : " << group_sums[i] << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename HeapType>
+bool validate_heap(std::size_t repeat_count)
+{
+    Arena arena;
+    ArenaOptions arena_options;
+    arena_options.cache_capacity = 1024 * 1024 * 64;
+    arena_options.page_alignment = 65536;
+
+    if (arena.create(arena_options) == false)
+    {
+        std::cout << "ARENA CREATION FAILED !!!" << std::endl;
+        return false;
+    }
+
+    HeapType heap;
+    typename HeapType::HeapCreationParams params;
+
+    if (heap.create(params, &arena) == false)
+    {
+        std::cout << "HEAP CREATION FAILED !!!" << std::endl;
+        return false;
+    }
+
+    std::vector<std::pair<void*, std::size_t>> allocations;
+
+    for (std::size_t i = 0; i < repeat_count; i++)
+    {
+        for (std::size_t size = 1; size <= HeapType::get_max_allocation_size(); size = size * 5 / 4 + 1)
+        {
+            void* ptr = heap.allocate(size);
+
+            if (ptr == nullptr)
+            {
+                std::cout << "ALLOCATION FAILED !!!" << std::endl;
+                return false;
+            }
+
+            std::memset(ptr, 0xAB, size);
+            allocations.push_back({ ptr, size });
+        }
+    }
+
+    for (auto& allocation : allocations)
+    {
+        bool is_small_object = allocation.second <= HeapType::get_max_small_object_size();
+        auto logical_page_size = is_small_object ? params.small_object_logical_page_size : params.medium_object_logical_page_size;
+        auto logical_page = HeapType::SegmentType::get_logical_page_from_address(allocation.first, logical_page_size);
+
+        if (logical_page->get_size_class() != HeapType::SizeClassesType::get_size_class(HeapType::SizeClassesType::get_bin_index(allocation.second)))
+        {
+            std::cout << "WRONG SIZE CLASS !!!" << std::endl;
+            return false;
+        }
+
+        // Padded pointers should resolve to their chunk starts
+        void* padded_ptr = reinterpret_cast<char*>(allocation.first) + allocation.second - 1;
+
+        if (logical_page->get_chunk_start_address(padded_ptr) != allocation.first)
+        {
+            std::cout << "WRONG CHUNK START ADDRESS !!!" << std::endl;
+            return false;
+        }
+
+        if (heap.deallocate(allocation.first, is_small_object) == false)
+        {
+            std::cout << "DEALLOCATION FAILED !!!" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    unit_test.test_equals(validate_size_class_mapping<Pow2SizeClasses>(), true, "size classes", "pow2 size class mapping");
+    unit_test.test_equals(validate_size_class_mapping<QuarterPow2SizeClasses>(), true, "size classes", "quarter pow2 size class mapping");
+
+    unit_test.test_equals(QuarterPow2SizeClasses::get_size_class(QuarterPow2SizeClasses::get_bin_index(2049)), 2560, "size classes", "quarter pow2 2049 bytes");
+    unit_test.test_equals(QuarterPow2SizeClasses::get_size_class(QuarterPow2SizeClasses::get_bin_index(33 * 1024)), 40960, "size classes", "quarter pow2 33KB");
+    unit_test.test_equals(QuarterPow2SizeClasses::get_size_class(QuarterPow2SizeClasses::MIN_MEDIUM_OBJECT_BIN_INDEX - 1), QuarterPow2SizeClasses::LARGEST_SMALL_OBJECT_SIZE_CLASS, "size classes", "quarter pow2 largest small object size class");
+
+    bool shares_valid = true;
+
+    for (std::size_t group_value : { 1, 2, 3, 5, 7, 8, 101 })
+    {
+        shares_valid = shares_valid && validate_bin_shares<HeapPow2<>>(group_value) && validate_bin_shares<HeapQuarterPow2<>>(group_value);
+    }
+
+    unit_test.test_equals(shares_valid, true, "size classes", "bin shares of group params");
+
+    unit_test.test_equals(validate_heap<HeapPow2<>>(4), true, "size classes", "pow2 heap allocations");
+    unit_test.test_equals(validate_heap<HeapQuarterPow2<>>(4), true, "size classes", "quarter pow2 heap allocations");
+
+    ////////////////////////////////////// PRINT THE REPORT
+    std::cout << unit_test.get_summary_report("Size classes");
+    std::cout.flush();
+    
+    #if _WIN32
+    bool pause = true;
+    if(argc > 1)
+    {
+        if (std::strcmp(argv[1], "no_pause") == 0)
+            pause = false;
+    }
+    if(pause)
+        std::system("pause");
+    #endif
+
+    return unit_test.did_all_pass();
+}
\ No newline at end of file
@@ -37,25 +37,36 @@ int main(int argc, char* argv[])
     bool success = AllocatorType::get_instance().create(params_central, params_local, arena_options);
     if (!success) { std::cout << "Creation failed !!!\n"; }
 
-    auto thread_function = [&](unsigned int cpu_id)
-    {
-        auto ptr = AllocatorType::get_instance().allocate(5);
-        LLMALLOC_UNUSED(ptr);
-    };
+    void* first_thread_ptr = nullptr;
+    void* second_thread_ptr = nullptr;
 
     auto central_heap = AllocatorType::get_instance().get_central_heap();
 
-    unit_test.test_equals(central_heap->get_bin_logical_page_count(11), 32, "thread exit handling", "logical page count before transfer");
+    unit_test.test_equals(central_heap->get_bin_logical_page_count(11), 32, "thread exit handling", "central heap logical page count before thread exits");
+
+    // Heap of the exited thread should be handed to the next thread with its pages , so the freed chunk is reused
+    std::thread first_thread([&]() { first_thread_ptr = AllocatorType::get_instance().allocate(5); AllocatorType::get_instance().deallocate(first_thread_ptr); });
+    first_thread.join();
+
+    unit_test.test_equals(AllocatorType::get_instance().get_idle_local_heap_count(), 1, "thread exit handling", "heap of the exited thread is idle");
+
+    std::thread second_thread([&]() { second_thread_ptr = AllocatorType::get_instance().allocate(5); });
+    second_thread.join();
+
+    unit_test.test_equals(second_thread_ptr == first_thread_ptr, true, "thread exit handling", "next thread reuses the warm heap");
+    unit_test.test_equals(central_heap->get_bin_logical_page_count(11), 32, "thread exit handling", "logical pages stay with the idle heap");
 
-    std::vector<std::unique_ptr<std::thread>> threads;
-    threads.emplace_back(new std::thread(thread_function, 0));
+    // Thread churn beyond the max heap count should not drop threads to the central heap
+    std::size_t thread_count = AllocatorType::get_instance().get_max_thread_local_heap_count() * 2;
 
-    for (auto& thread : threads)
+    for (std::size_t i = 0; i < thread_count; i++)
     {
-        thread->join();
+        std::thread thread([&]() { AllocatorType::get_instance().deallocate(AllocatorType::get_instance().allocate(5)); });
+        thread.join();
     }
 
-    unit_test.test_equals(central_heap->get_bin_logical_page_count(11), 64, "thread exit handling", "logical page count after transfer");
+    unit_test.test_equals(AllocatorType::get_instance().get_active_local_heap_count(), 1, "thread exit handling", "exited threads don't consume new heaps");
+    unit_test.test_equals(central_heap->get_bin_logical_page_count(0), 1, "thread exit handling", "central heap is not used after thread churn");
 
     ////////////////////////////////////// PRINT THE REPORT
     std::cout << unit_test.get_summary_report("ThreadExitHandling");